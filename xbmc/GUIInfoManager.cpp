@@ -184,6 +184,9 @@ const infomap player_labels[] =  {{ "hasmedia",         PLAYER_HAS_MEDIA },
                                   { "hasduration",      PLAYER_HASDURATION },
                                   { "passthrough",      PLAYER_PASSTHROUGH },
                                   { "cachelevel",       PLAYER_CACHELEVEL },          // labels from here
+                                  { "cachebufferlevel", PLAYER_CACHE_BUFFER_LEVEL },
+                                  { "cachefillrate",    PLAYER_CACHE_FILL_RATE },
+                                  { "cacheconsumerate", PLAYER_CACHE_CONSUME_RATE },
                                   { "seekbar",          PLAYER_SEEKBAR },
                                   { "progress",         PLAYER_PROGRESS },
                                   { "progresscache",    PLAYER_PROGRESS_CACHE },
@@ -1326,6 +1329,24 @@ CStdString CGUIInfoManager::GetLabel(int info, int contextWindow, CStdString *fa
         strLabel.Format("%i", iLevel);
     }
     break;
+  case PLAYER_CACHE_BUFFER_LEVEL:
+    {
+      int iLevel = 0;
+      if(g_application.IsPlaying() && GetInt(iLevel, PLAYER_CACHE_BUFFER_LEVEL) && iLevel >= 0)
+        strLabel.Format("%i", iLevel);
+    }
+    break;
+  case PLAYER_CACHE_FILL_RATE:
+  case PLAYER_CACHE_CONSUME_RATE:
+    {
+      XFILE::SCacheStatus status;
+      if(g_application.IsPlaying() && g_application.m_pPlayer && g_application.m_pPlayer->GetCacheStatus(status))
+      {
+        unsigned rate = info == PLAYER_CACHE_FILL_RATE ? status.currate : status.consumerate;
+        strLabel = StringUtils::SizeToString(rate) + "/s";
+      }
+    }
+    break;
   case PLAYER_TIME:
     if(g_application.IsPlaying() && g_application.m_pPlayer)
       strLabel = GetCurrentPlayTime(TIME_FORMAT_HH_MM);
@@ -1876,6 +1897,7 @@ bool CGUIInfoManager::GetInt(int &value, int info, int contextWindow, const CGUI
     case PLAYER_PROGRESS_CACHE:
     case PLAYER_SEEKBAR:
     case PLAYER_CACHELEVEL:
+    case PLAYER_CACHE_BUFFER_LEVEL:
     case PLAYER_CHAPTER:
     case PLAYER_CHAPTERCOUNT:
       {
@@ -1895,6 +1917,15 @@ bool CGUIInfoManager::GetInt(int &value, int info, int contextWindow, const CGUI
           case PLAYER_CACHELEVEL:
             value = (int)(g_application.m_pPlayer->GetCacheLevel());
             break;
+          case PLAYER_CACHE_BUFFER_LEVEL:
+            {
+              /* how much of what the cache reads ahead is there */
+              XFILE::SCacheStatus status;
+              if (!g_application.m_pPlayer->GetCacheStatus(status) || !status.readahead)
+                return false;
+              value = (int)std::min((uint64_t)100, status.forward * 100 / status.readahead);
+            }
+            break;
           case PLAYER_CHAPTER:
             value = g_application.m_pPlayer->GetChapter();
             break;
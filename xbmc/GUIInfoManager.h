@@ -104,6 +104,9 @@ namespace INFO
 #define PLAYER_SEEKOFFSET            47
 #define PLAYER_PROGRESS_CACHE        48
 #define PLAYER_ITEM_PROPERTY         49
+#define PLAYER_CACHE_BUFFER_LEVEL    50
+#define PLAYER_CACHE_FILL_RATE       51
+#define PLAYER_CACHE_CONSUME_RATE    52
 
 #define WEATHER_CONDITIONS          100
 #define WEATHER_TEMPERATURE         101
@@ -29,6 +29,7 @@
 #include "utils/DownloadQueueManager.h"
 #include "GUIInfoManager.h"
 #include "filesystem/DllLibCurl.h"
+#include "filesystem/BlockCache.h"
 #include "filesystem/DirectoryCache.h"
 #include "GUIPassword.h"
 #include "LangInfo.h"
@@ -66,6 +67,7 @@
 
   CGUIWindowManager  g_windowManager;
   XFILE::CDirectoryCache g_directoryCache;
+  XFILE::CBlockCache     g_blockCache;
 
   CGUITextureManager g_TextureManager;
   CGUILargeTextureManager g_largeTextureManager;
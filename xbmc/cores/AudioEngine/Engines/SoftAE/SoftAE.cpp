@@ -71,6 +71,9 @@ CSoftAE::CSoftAE():
   m_converted          (NULL        ),
   m_convertedSize      (0           ),
   m_masterStream       (NULL        ),
+  m_rawData            (NULL        ),
+  m_rawFrames          (0           ),
+  m_rawSinkFrames      (0           ),
   m_outputStageFn      (NULL        ),
   m_streamStageFn      (NULL        )
 {
@@ -189,6 +192,11 @@ void CSoftAE::InternalOpenSink()
 
   LoadSettings();
 
+  /* the streams may be re-initialized, so drop anything still pointing into them */
+  m_rawData       = NULL;
+  m_rawFrames     = 0;
+  m_rawSinkFrames = 0;
+
   /* initialize for analog output */
   m_rawPassthrough = false;
   m_streamStageFn = &CSoftAE::RunStreamStage;
@@ -861,7 +869,7 @@ double CSoftAE::GetDelay()
     delayTranscoder = m_encoder->GetDelay((double)m_encodedBuffer.Used() * m_encoderFrameSizeMul);
   }
   else
-    delayBuffer = (double)m_buffer.Used() * m_sinkFormatFrameSizeMul *m_sinkFormatSampleRateMul;
+    delayBuffer = ((double)m_buffer.Used() * m_sinkFormatFrameSizeMul + m_rawFrames) * m_sinkFormatSampleRateMul;
 
   //CLog::Log(LOGNOTICE, "Buffer:%f  Sink:%f  Transcoder:%f  Total:%f", (float)delaybuffer, (float)delaysink, (float)delaytranscoder,
        //(float)(delaybuffer + delaysink + delaytranscoder));
@@ -884,7 +892,7 @@ double CSoftAE::GetCacheTime()
     timeTranscoder = m_encoder->GetDelay((double)m_encodedBuffer.Used() * m_encoderFrameSizeMul);
   }
   else
-    timeBuffer = (double)m_buffer.Used() * m_sinkFormatFrameSizeMul *m_sinkFormatSampleRateMul;
+    timeBuffer = ((double)m_buffer.Used() * m_sinkFormatFrameSizeMul + m_rawFrames) * m_sinkFormatSampleRateMul;
 
   return timeBuffer + timeSink + timeTranscoder;
 }
@@ -972,8 +980,11 @@ void CSoftAE::Run()
     if ((this->*m_outputStageFn)(hasAudio) > 0)
       hasAudio = false; /* taken some audio - reset our silence flag */
 
+    /* passthrough is handed to the sink by the output stage, this only services the other streams */
+    if (m_rawPassthrough)
+      (this->*m_streamStageFn)(m_chLayout.Count(), NULL, restart);
     /* if we have enough room in the buffer */
-    if (m_buffer.Free() >= m_frameSize)
+    else if (m_buffer.Free() >= m_frameSize)
     {
       /* take some data for our use from the buffer */
       uint8_t *out = (uint8_t*)m_buffer.Take(m_frameSize);
@@ -1170,32 +1181,63 @@ int CSoftAE::RunOutputStage(bool hasAudio)
 
 int CSoftAE::RunRawOutputStage(bool hasAudio)
 {
-  if(m_buffer.Used() < m_sinkBlockSize)
+  if (!m_sink)
     return 0;
 
-  void *data = m_buffer.Raw(m_sinkBlockSize);
+  /* take the next run of frames straight out of the master stream's packet queue */
+  if (!m_rawFrames)
+  {
+    StreamList resumeStreams;
+    CSingleLock streamLock(m_streamLock);
+
+    CSoftAEStream *stream = m_masterStream;
+    m_rawFrames = m_sinkFormat.m_frames;
+    m_rawData   = stream ? stream->GetFrames(m_rawFrames) : NULL;
+    if (!m_rawData)
+    {
+      m_rawFrames = 0;
+
+      /* flag the stream's slave to be resumed if it has drained */
+      if (stream && stream->IsDrained() && stream->m_slave && stream->m_slave->IsPaused())
+        resumeStreams.push_back(stream);
+    }
+
+    ResumeSlaveStreams(resumeStreams);
+  }
 
-  if (CAEUtil::S16NeedsByteSwap(AE_FMT_S16NE, m_sinkFormat.m_dataFormat))
+  void        *data;
+  unsigned int frames;
+  if (m_rawFrames)
   {
-    /*
-     * It would really be preferable to handle this at packing stage, so that
-     * it could byteswap the data efficiently without wasting CPU time on
-     * swapping the huge IEC 61937 zero padding between frames (or not
-     * byteswap at all, if there are two byteswaps).
-     *
-     * Unfortunately packing is done on a higher level and we can't easily
-     * tell it the needed format from here, so do it here for now (better than
-     * nothing)...
-     */
-    AllocateConvIfNeeded(m_sinkBlockSize, !hasAudio);
-    if (hasAudio)
-      Endian_Swap16_buf((uint16_t *)m_converted, (uint16_t *)data, m_sinkBlockSize / 2);
-    data = m_converted;
+    data   = m_rawData;
+    frames = m_rawFrames;
+    if (CAEUtil::S16NeedsByteSwap(AE_FMT_S16NE, m_sinkFormat.m_dataFormat))
+    {
+      /*
+       * It would really be preferable to handle this at packing stage, so that
+       * it could byteswap the data efficiently without wasting CPU time on
+       * swapping the huge IEC 61937 zero padding between frames (or not
+       * byteswap at all, if there are two byteswaps).
+       *
+       * Unfortunately packing is done on a higher level and we can't easily
+       * tell it the needed format from here, so do it here for now (better than
+       * nothing)...
+       */
+      AllocateConvIfNeeded(frames * m_sinkFormat.m_frameSize);
+      Endian_Swap16_buf((uint16_t *)m_converted, (uint16_t *)data, frames * m_sinkFormat.m_frameSize / 2);
+      CAEUtil::CountRawCopy(frames * m_sinkFormat.m_frameSize);
+      data = m_converted;
+    }
+  }
+  else
+  {
+    /* nothing to play, keep the sink fed with silence */
+    AllocateConvIfNeeded(m_sinkBlockSize, true);
+    data   = m_converted;
+    frames = m_sinkFormat.m_frames;
   }
 
-  int wroteFrames = 0;
-  if (m_sink)
-    wroteFrames = m_sink->AddPackets((uint8_t *)data, m_sinkFormat.m_frames, hasAudio);
+  int wroteFrames = m_sink->AddPackets((uint8_t *)data, frames, m_rawFrames > 0);
 
   /* Return value of INT_MAX signals error in sink - restart */
   if (wroteFrames == INT_MAX)
@@ -1205,8 +1247,18 @@ int CSoftAE::RunRawOutputStage(bool hasAudio)
     m_reOpen = true;
   }
 
-  m_buffer.Shift(NULL, wroteFrames * m_sinkFormat.m_frameSize);
-  return wroteFrames;
+  /* silence counts too, the other streams would have been mixed into it */
+  m_rawSinkFrames += wroteFrames;
+
+  /* whatever the sink did not take is written on the next pass */
+  if (m_rawFrames)
+  {
+    m_rawData   += wroteFrames * m_sinkFormat.m_frameSize;
+    m_rawFrames -= std::min((unsigned int)wroteFrames, m_rawFrames);
+    return wroteFrames;
+  }
+
+  return 0;
 }
 
 int CSoftAE::RunTranscodeStage(bool hasAudio)
@@ -1270,7 +1322,13 @@ unsigned int CSoftAE::RunRawStreamStage(unsigned int channelCount, void *out, bo
   static StreamList::iterator itt;
   CSingleLock streamLock(m_streamLock);
 
-  /* handle playing streams */
+  /* the other streams can't be heard, drop as much of them as the sink took of the master */
+  const unsigned int sinkFrames = m_rawSinkFrames;
+  m_rawSinkFrames = 0;
+  if (!sinkFrames)
+    return 0;
+
+  /* handle playing streams, the master stream is read by RunRawOutputStage */
   for (itt = m_playingStreams.begin(); itt != m_playingStreams.end(); ++itt)
   {
     CSoftAEStream *sitt = *itt;
@@ -1278,34 +1336,22 @@ unsigned int CSoftAE::RunRawStreamStage(unsigned int channelCount, void *out, bo
       continue;
 
     /* consume data from streams even though we cant use it */
-    uint8_t *frame = sitt->GetFrame();
+    unsigned int left = sinkFrames;
+    uint8_t *frame;
+    do
+    {
+      unsigned int frames = left;
+      frame = sitt->GetFrames(frames);
+      left -= frames;
+    } while (frame && left);
 
     /* flag the stream's slave to be resumed if it has drained */
     if (!frame && sitt->IsDrained() && sitt->m_slave && sitt->m_slave->IsPaused())
       resumeStreams.push_back(sitt);
   }
 
-  /* nothing to do if we dont have a master stream */
-  if (!m_masterStream)
-    return 0;
-
-  /* get the frame and append it to the output */
-  uint8_t *frame = m_masterStream->GetFrame();
-  unsigned int mixed;
-  if (frame)
-  {
-    mixed = 1;
-    memcpy(out, frame, m_sinkFormat.m_frameSize);
-  }
-  else
-  {
-    mixed = 0;
-    if (m_masterStream->IsDrained() && m_masterStream->m_slave && m_masterStream->m_slave->IsPaused())
-      resumeStreams.push_back(m_masterStream);
-  }
-
   ResumeSlaveStreams(resumeStreams);
-  return mixed;
+  return 0;
 }
 
 unsigned int CSoftAE::RunStreamStage(unsigned int channelCount, void *out, bool &restart)
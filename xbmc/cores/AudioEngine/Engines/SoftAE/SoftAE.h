@@ -41,11 +41,13 @@
 /* forward declarations */
 class IAESink;
 class IAEEncoder;
+class TestSoftAEHelper;
 
 class CSoftAE : public IThreadedAE
 {
 protected:
   friend class CAEFactory;
+  friend class ::TestSoftAEHelper;
   CSoftAE();
   virtual ~CSoftAE();
 
@@ -216,6 +218,12 @@ private:
 
   CSoftAEStream *m_masterStream;
 
+  /* passthrough frames taken from the master stream but not yet accepted by the sink */
+  uint8_t       *m_rawData;
+  unsigned int   m_rawFrames;
+  /* frames the sink took since the last stream stage, the other streams are drained at that pace */
+  unsigned int   m_rawSinkFrames;
+
   /*! \brief Run the output stage on the audio.
    Prepares streamed data, mixes in any UI sounds, converts to a format suitable
    for the sink, then outputs to the sink.
@@ -25,6 +25,7 @@
 
 #include "AEFactory.h"
 #include "Utils/AEUtil.h"
+#include "Resamplers/AEResampleFactory.h"
 
 #include "SoftAE.h"
 #include "SoftAEStream.h"
@@ -44,10 +45,21 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_rgain           (1.0f ),
   m_refillBuffer    (0    ),
   m_convertFn       (NULL ),
-  m_ssrc            (NULL ),
-  m_framesBuffered  (0    ),
+  m_resampler       (NULL ),
+  m_resampleBuffer  (NULL ),
+  m_resampleFrames  (0    ),
   m_newPacket       (NULL ),
   m_packet          (NULL ),
+  m_rawPacket       (NULL ),
+  m_rawPending      (0    ),
+  m_framesAdded     (0    ),
+  m_framesRead      (0    ),
+  m_framesFlushed   (0    ),
+  m_flushPos        (0    ),
+  m_flushCount      (0    ),
+  m_flushSeen       (0    ),
+  m_underruns       (0    ),
+  m_highWater       (0    ),
   m_vizPacketPos    (NULL ),
   m_draining        (false),
   m_vizBufferSamples(0    ),
@@ -55,8 +67,6 @@ CSoftAEStream::CSoftAEStream(enum AEDataFormat dataFormat, unsigned int sampleRa
   m_fadeRunning     (false),
   m_slave           (NULL )
 {
-  m_ssrcData.data_out = NULL;
-
   m_initDataFormat        = dataFormat;
   m_initSampleRate        = sampleRate;
   m_initEncodedSampleRate = encodedSampleRate;
@@ -90,6 +100,9 @@ void CSoftAEStream::InitializeRemap()
       m_aeChannelLayout = AE.GetChannelLayout();
       m_samplesPerFrame = AE.GetChannelLayout().Count();
       m_aeBytesPerFrame = AE_IS_RAW(m_initDataFormat) ? m_bytesPerFrame : (m_samplesPerFrame * sizeof(float));
+
+      /* the engine holds its stream lock, so the mix thread is not reading */
+      AllocPackets();
     }
   }
 }
@@ -107,8 +120,11 @@ void CSoftAEStream::Initialize()
 
     if (m_resample)
     {
-      _aligned_free(m_ssrcData.data_out);
-      m_ssrcData.data_out = NULL;
+      _aligned_free(m_resampleBuffer);
+      m_resampleBuffer = NULL;
+      m_resampleFrames = 0;
+      delete m_resampler;
+      m_resampler = NULL;
     }
   }
 
@@ -164,8 +180,6 @@ void CSoftAEStream::Initialize()
     m_newPacket->data.Alloc(m_format.m_frameSamples * sizeof(float));
   }
 
-  m_packet = NULL;
-
   m_inputBuffer.Alloc(m_format.m_frames * m_format.m_frameSize);
 
   m_resample      = (m_forceResample || m_initSampleRate != AE.GetSampleRate()) && !AE_IS_RAW(m_initDataFormat);
@@ -188,20 +202,65 @@ void CSoftAEStream::Initialize()
   /* if we need to resample, set it up */
   if (m_resample)
   {
-    int err;
-    m_ssrc                   = src_new(SRC_SINC_MEDIUM_QUALITY, m_initChannelLayout.Count(), &err);
-    m_ssrcData.data_in       = m_convertBuffer;
-    m_internalRatio          = (double)AE.GetSampleRate() / (double)m_initSampleRate;
-    m_ssrcData.src_ratio     = m_internalRatio;
-    m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
-    m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
-    m_ssrcData.end_of_input  = 0;
+    AEResampleQuality quality = CAEResampleFactory::GetQuality();
+    m_internalRatio = (double)AE.GetSampleRate() / (double)m_initSampleRate;
+    m_resampler     = CAEResampleFactory::Create(quality);
+    if (!m_resampler->Initialize(m_initChannelLayout.Count(), m_internalRatio * m_resampleRatio))
+    {
+      CLog::Log(LOGERROR, "CSoftAEStream::Initialize - Failed to initialize the %s resampler", m_resampler->GetName());
+      delete m_resampler;
+      m_resampler = NULL;
+      m_resample  = false;
+      m_valid     = false;
+      return;
+    }
+
+    CLog::Log(LOGDEBUG, "CSoftAEStream::Initialize - Resampling from %u to %u using the %s resampler", m_initSampleRate, AE.GetSampleRate(), m_resampler->GetName());
+    AllocResampleBuffer();
   }
 
   m_chLayoutCount = m_format.m_channelLayout.Count();
+  AllocPackets();
   m_valid = true;
 }
 
+void CSoftAEStream::AllocPackets()
+{
+  /*
+    preallocate enough packets for the water level plus a full input buffer
+    once resampled, with some spare for resample ratio adjustments, so
+    neither side ever has to allocate
+  */
+  const double       ratio  = m_resample ? m_internalRatio : 1.0;
+  const unsigned int frames = m_format.m_frames;
+  const unsigned int slots  = (unsigned int)std::ceil((m_waterLevel + frames * ratio) / frames) + 2;
+
+  m_outBuffer.Create(slots);
+  for (unsigned int i = 0; i < slots; ++i)
+  {
+    PPacket *pkt = m_outBuffer.GetSlot(i);
+    if (AE_IS_RAW(m_initDataFormat))
+      pkt->data.Alloc(frames * m_format.m_frameSize);
+    else
+    {
+      pkt->data   .Alloc(frames * m_aeChannelLayout.Count() * sizeof(float));
+      pkt->vizData.Alloc(frames * 2 * sizeof(float));
+    }
+  }
+
+  m_packet        = NULL;
+  m_rawPacket     = NULL;
+  m_rawPending    = 0;
+  m_framesAdded   = 0;
+  m_framesRead    = 0;
+  m_framesFlushed = 0;
+  m_flushPos      = 0;
+  m_flushCount    = 0;
+  m_flushSeen     = 0;
+
+  CLog::Log(LOGDEBUG, "CSoftAEStream::AllocPackets - %u packets of %u frames", slots, frames);
+}
+
 void CSoftAEStream::Destroy()
 {
   CExclusiveLock lock(m_lock);
@@ -219,12 +278,22 @@ CSoftAEStream::~CSoftAEStream()
 
   if (m_resample)
   {
-    _aligned_free(m_ssrcData.data_out);
-    src_delete(m_ssrc);
-    m_ssrc = NULL;
+    _aligned_free(m_resampleBuffer);
+    delete m_resampler;
+    m_resampler = NULL;
   }
 
-  CLog::Log(LOGDEBUG, "CSoftAEStream::~CSoftAEStream - Destructed");
+  CLog::Log(LOGDEBUG, "CSoftAEStream::~CSoftAEStream - Destructed, %u underruns, high water level %u frames", m_underruns, m_highWater);
+}
+
+unsigned int CSoftAEStream::GetFramesBuffered()
+{
+  /* anything added before the last flush is gone, even if GetFrame has not got to discarding it yet */
+  const unsigned long added   = AtomicAdd(&m_framesAdded, 0);
+  const unsigned long read    = AtomicAdd(&m_framesRead , 0);
+  const unsigned long flushed = m_framesFlushed;
+  const unsigned long base    = (long)(read - flushed) > 0 ? read : flushed;
+  return (unsigned int)(added - base);
 }
 
 unsigned int CSoftAEStream::GetSpace()
@@ -232,10 +301,16 @@ unsigned int CSoftAEStream::GetSpace()
   if (!m_valid || m_draining)
     return 0;
 
-  if (m_framesBuffered >= m_waterLevel)
+  const unsigned int framesBuffered = GetFramesBuffered();
+  if (framesBuffered >= m_waterLevel)
     return 0;
 
-  return m_inputBuffer.Free() + (std::max(0U, (m_waterLevel - m_framesBuffered)) * m_format.m_frameSize);
+  /* the water level is in output frames, dont take more input than the packet queue was sized for */
+  unsigned int frames = m_waterLevel - framesBuffered;
+  if (m_resample)
+    frames = (unsigned int)(frames / m_resampler->GetRatio());
+
+  return m_inputBuffer.Free() + (frames * m_format.m_frameSize);
 }
 
 unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
@@ -248,7 +323,7 @@ unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
   if (m_draining)
   {
     /* if the stream has finished draining, cork it */
-    if (m_packet && !m_packet->data.Used() && m_outBuffer.empty())
+    if (!m_packet && m_outBuffer.GetReadSize() == 0)
       m_draining = false;
     else
       return 0;
@@ -260,6 +335,14 @@ unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
     return 0;
 
   unsigned int taken = 0;
+
+  /* passthrough needs no conversion, so it goes straight into the packet queue */
+  if (AE_IS_RAW(m_initDataFormat))
+  {
+    taken = AddRawData((uint8_t*)data, size);
+    size  = 0;
+  }
+
   while(size)
   {
     unsigned int copy = std::min((unsigned int)m_inputBuffer.Free(), size);
@@ -281,7 +364,7 @@ unsigned int CSoftAEStream::AddData(void *data, unsigned int size)
   lock.Leave();
 
   /* if the stream is flagged to autoStart when the buffer is full, then do it */
-  if (m_autoStart && m_framesBuffered >= m_waterLevel)
+  if (m_autoStart && GetFramesBuffered() >= m_waterLevel)
     Resume();
 
   return taken;
@@ -317,12 +400,10 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
   /* resample it if we need to */
   if (m_resample)
   {
-    m_ssrcData.input_frames = samples / m_chLayoutCount;
-    if (src_process(m_ssrc, &m_ssrcData) != 0)
-      return 0;
-    data     = (uint8_t*)m_ssrcData.data_out;
-    frames   = m_ssrcData.output_frames_gen;
-    consumed = m_ssrcData.input_frames_used * m_bytesPerFrame;
+    unsigned int used;
+    frames   = m_resampler->Resample(m_convertBuffer, samples / m_chLayoutCount, m_resampleBuffer, m_resampleFrames, used);
+    data     = (uint8_t*)m_resampleBuffer;
+    consumed = used * m_bytesPerFrame;
     if (!frames)
       return consumed;
 
@@ -335,18 +416,8 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     consumed = frames * m_bytesPerFrame;
   }
 
-  if (m_refillBuffer)
-  {
-    if (frames > m_refillBuffer)
-      m_refillBuffer = 0;
-    else
-      m_refillBuffer -= frames;
-  }
-
   /* buffer the data */
-  m_framesBuffered += frames;
-  const unsigned int inputBlockSize = m_format.m_frames * m_format.m_channelLayout.Count() * sampleSize;
-
+  AddFramesBuffered(frames);
   size_t remaining = samples * sampleSize;
   while (remaining)
   {
@@ -359,22 +430,25 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     if ((!m_draining || remaining) && m_newPacket->data.Free() > 0)
       continue;
 
-    /* if we have a full block of data */
-    if (AE_IS_RAW(m_initDataFormat))
+    /* take a free packet from the queue */
+    PPacket *pkt = m_outBuffer.GetWriteSlot();
+    if (!pkt)
     {
-      m_outBuffer.push_back(m_newPacket);
-      m_newPacket = new PPacket();
-      m_newPacket->data.Alloc(inputBlockSize);
+      /* GetSpace should never let this happen, drop the data rather than block */
+      CLog::Log(LOGERROR, "CSoftAEStream::ProcessFrameBuffer - Packet queue overrun, dropping data");
+      AtomicAdd(&m_framesRead, m_newPacket->data.Used() / m_format.m_channelLayout.Count() / sizeof(float));
+      m_newPacket->data.Empty();
       continue;
     }
 
-    /* make a new packet for downmix/remap */
-    PPacket *pkt = new PPacket();
+    pkt->data   .Empty();
+    pkt->data   .CursorReset();
+    pkt->vizData.Empty();
+    pkt->vizData.CursorReset();
 
     /* downmix/remap the data */
     size_t frames = m_newPacket->data.Used() / m_format.m_channelLayout.Count() / sizeof(float);
     size_t used   = frames * m_aeChannelLayout.Count() * sizeof(float);
-    pkt->data.Alloc(used);
     m_remap.Remap(
       (float*)m_newPacket->data.Raw (m_newPacket->data.Used()),
       (float*)pkt        ->data.Take(used),
@@ -385,7 +459,6 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
     if (m_audioCallback)
     {
       size_t vizUsed = frames * 2 * sizeof(float);
-      pkt->vizData.Alloc(vizUsed);
       m_vizRemap.Remap(
         (float*)m_newPacket->data   .Raw (m_newPacket->data.Used()),
         (float*)pkt        ->vizData.Take(vizUsed),
@@ -393,17 +466,97 @@ unsigned int CSoftAEStream::ProcessFrameBuffer()
       );
     }
 
-    /* add the packet to the output */
-    m_outBuffer.push_back(pkt);
+    /* hand the packet to the mix thread */
+    m_outBuffer.Commit();
     m_newPacket->data.Empty();
   }
 
   return consumed;
 }
 
+void CSoftAEStream::AddFramesBuffered(unsigned int frames)
+{
+  /* GetFrame may flag an underrun at any time, so update this atomically */
+  long refill;
+  while ((refill = m_refillBuffer) > 0)
+  {
+    const long remain = (long)frames >= refill ? 0 : refill - (long)frames;
+    if (cas(&m_refillBuffer, refill, remain) == refill)
+      break;
+  }
+
+  AtomicAdd(&m_framesAdded, frames);
+  m_highWater = std::max(m_highWater, GetFramesBuffered());
+}
+
+unsigned int CSoftAEStream::AddRawData(uint8_t *data, unsigned int size)
+{
+  /* only take whole frames, the caller keeps the remainder for the next call */
+  size -= size % m_format.m_frameSize;
+
+  unsigned int taken = 0;
+  while (taken < size)
+  {
+    if (!m_rawPacket)
+    {
+      m_rawPacket = m_outBuffer.GetWriteSlot();
+      if (!m_rawPacket)
+      {
+        /* GetSpace should never let this happen, dont take any more rather than block */
+        CLog::Log(LOGERROR, "CSoftAEStream::AddRawData - Packet queue overrun");
+        break;
+      }
+
+      m_rawPacket->data.Empty();
+      m_rawPacket->data.CursorReset();
+    }
+
+    /* this is the only copy passthrough data gets, GetFrames hands the packet to the sink */
+    const unsigned int copy = std::min((unsigned int)m_rawPacket->data.Free(), size - taken);
+    m_rawPacket->data.Push(data + taken, copy);
+    CAEUtil::CountRawCopy(copy);
+    taken        += copy;
+    m_rawPending += copy / m_format.m_frameSize;
+
+    if (m_rawPacket->data.Free() == 0)
+      CommitRawPacket();
+  }
+
+  return taken;
+}
+
+void CSoftAEStream::CommitRawPacket()
+{
+  AddFramesBuffered(m_rawPending);
+  m_outBuffer.Commit();
+  m_rawPacket  = NULL;
+  m_rawPending = 0;
+}
+
+void CSoftAEStream::DiscardFlushed()
+{
+  /* the flush position is stored before the count is incremented */
+  m_flushSeen = AtomicAdd(&m_flushCount, 0);
+  const long flushPos = m_flushPos;
+
+  /* drop the packets that were queued before the flush, including the one we are reading */
+  while (m_outBuffer.GetDistance(m_outBuffer.GetReadPos(), flushPos) > 0)
+  {
+    PPacket *pkt = m_packet ? m_packet : m_outBuffer.GetReadSlot();
+    AtomicAdd(&m_framesRead, (pkt->data.Used() - pkt->data.CursorOffset()) / m_aeBytesPerFrame);
+    m_outBuffer.Release();
+    m_packet = NULL;
+  }
+}
+
 uint8_t* CSoftAEStream::GetFrame()
 {
-  CExclusiveLock lock(m_lock);
+  /*
+    this runs on the mix thread and must never block, it takes no locks and
+    only touches the consumer side of m_outBuffer. Initialize and
+    InitializeRemap are only ever called while the engine holds its stream
+    lock, so they can not run at the same time as this.
+  */
 
   /* if we are fading, this runs even if we have underrun as it is time based */
   if (m_fadeRunning)
@@ -422,36 +575,9 @@ uint8_t* CSoftAEStream::GetFrame()
     }
   }
 
-  /* if we have been deleted or are refilling but not draining */
-  if (!m_valid || m_delete || (m_refillBuffer && !m_draining))
+  if (!NextPacket())
     return NULL;
 
-  /* if the packet is empty, advance to the next one */
-  if (!m_packet || m_packet->data.CursorEnd())
-  {
-    delete m_packet;
-    m_packet = NULL;
-
-    /* no more packets, return null */
-    if (m_outBuffer.empty())
-    {
-      if (m_draining)
-        return NULL;
-      else
-      {
-        /* underrun, we need to refill our buffers */
-        CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrame - Underrun");
-        ASSERT(m_waterLevel > m_framesBuffered);
-        m_refillBuffer = m_waterLevel - m_framesBuffered;
-        return NULL;
-      }
-    }
-
-    /* get the next packet */
-    m_packet = m_outBuffer.front();
-    m_outBuffer.pop_front();
-  }
-
   /* fetch one frame of data */
   uint8_t *ret = (uint8_t*)m_packet->data.CursorRead(m_aeBytesPerFrame);
 
@@ -463,23 +589,88 @@ uint8_t* CSoftAEStream::GetFrame()
     m_vizBufferSamples += 2;
     if (m_vizBufferSamples == 512)
     {
-      m_audioCallback->OnAudioData(m_vizBuffer, 512);
+      /* only contends with (un)registering the callback */
+      CSingleLock vizLock(m_vizLock);
+      if (m_audioCallback)
+        m_audioCallback->OnAudioData(m_vizBuffer, 512);
       m_vizBufferSamples = 0;
     }
   }
 
-  --m_framesBuffered;
+  AtomicIncrement(&m_framesRead);
   return ret;
 }
 
+uint8_t* CSoftAEStream::GetFrames(unsigned int &frames)
+{
+  /*
+    used on the passthrough path, returns up to "frames" frames straight out
+    of the packet so the engine can hand them to the sink without copying, the
+    viz is not fed. The data stays valid until the next call as the packet is
+    not released before then.
+  */
+  if (!NextPacket())
+  {
+    frames = 0;
+    return NULL;
+  }
+
+  const unsigned int avail = (m_packet->data.Used() - m_packet->data.CursorOffset()) / m_aeBytesPerFrame;
+  frames = std::min(frames, avail);
+
+  uint8_t *ret = (uint8_t*)m_packet->data.CursorRead(frames * m_aeBytesPerFrame);
+  AtomicAdd(&m_framesRead, frames);
+  return ret;
+}
+
+bool CSoftAEStream::NextPacket()
+{
+  /* a flush may have happened since the last frame */
+  if (m_flushCount != m_flushSeen)
+    DiscardFlushed();
+
+  /* if we have been deleted or are refilling but not draining */
+  if (!m_valid || m_delete || (m_refillBuffer && !m_draining))
+    return false;
+
+  /* if the packet is empty, hand it back and advance to the next one */
+  if (m_packet && !m_packet->data.CursorEnd())
+    return true;
+
+  if (m_packet)
+  {
+    m_outBuffer.Release();
+    m_packet = NULL;
+  }
+
+  /* no more packets */
+  m_packet = m_outBuffer.GetReadSlot();
+  if (m_packet)
+    return true;
+
+  if (!m_draining)
+  {
+    /* underrun, we need to refill our buffers, unless AddData just did */
+    const unsigned int framesBuffered = GetFramesBuffered();
+    ASSERT(m_waterLevel > framesBuffered);
+    if (cas(&m_refillBuffer, 0, m_waterLevel - framesBuffered) == 0)
+    {
+      ++m_underruns;
+      CLog::Log(LOGDEBUG, "CSoftAEStream::GetFrame - Underrun");
+    }
+  }
+
+  return false;
+}
+
 double CSoftAEStream::GetDelay()
 {
   if (m_delete)
     return 0.0;
 
   double delay = AE.GetDelay();
-  delay += (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
-  delay += (double)m_framesBuffered                              / (double)AE.GetSampleRate();
+  delay += (double)(m_inputBuffer.Used() / m_format.m_frameSize + m_rawPending) / (double)m_format.m_sampleRate;
+  delay += (double)GetFramesBuffered()                           / (double)AE.GetSampleRate();
 
   return delay;
 }
@@ -490,8 +681,8 @@ double CSoftAEStream::GetCacheTime()
     return 0.0;
 
   double time;
-  time  = (double)(m_inputBuffer.Used() / m_format.m_frameSize) / (double)m_format.m_sampleRate;
-  time += (double)(m_waterLevel - m_framesBuffered)             / (double)AE.GetSampleRate();
+  time  = (double)(m_inputBuffer.Used() / m_format.m_frameSize + m_rawPending) / (double)m_format.m_sampleRate;
+  time += (double)(m_waterLevel - GetFramesBuffered())          / (double)AE.GetSampleRate();
   time += AE.GetCacheTime();
   return time;
 }
@@ -529,12 +720,16 @@ void CSoftAEStream::Drain()
 {
   CSharedLock lock(m_lock);
   m_draining = true;
+
+  /* nothing more is coming to fill the passthrough packet, so hand it over as it is */
+  if (m_rawPacket && m_rawPending)
+    CommitRawPacket();
 }
 
 bool CSoftAEStream::IsDrained()
 {
-  CSharedLock lock(m_lock);
-  return (m_draining && !m_packet && m_outBuffer.empty());
+  /* called from the mix thread, so this must not take m_lock */
+  return (m_draining && !m_packet && m_outBuffer.GetReadSize() == 0);
 }
 
 void CSoftAEStream::Flush()
@@ -551,31 +746,25 @@ void CSoftAEStream::InternalFlush()
 {
   /* reset the resampler */
   if (m_resample)
-  {
-    m_ssrcData.end_of_input = 0;
-    src_reset(m_ssrc);
-  }
+    m_resampler->Reset();
 
   /* invalidate any incoming samples */
   m_newPacket->data.Empty();
+  if (m_rawPacket)
+  {
+    m_rawPacket->data.Empty();
+    m_rawPending = 0;
+  }
 
   /*
-    clear the current buffered packet, we cant delete the data as it may be
-    in use by the AE thread, so we just seek to the end of the buffer
+    the queued packets belong to the mix thread, so just mark everything
+    queued so far as flushed and let GetFrame discard it
   */
-  if (m_packet)
-    m_packet->data.CursorSeek(m_packet->data.Size());
-
-  /* clear any other buffered packets */
-  while (!m_outBuffer.empty())
-  {
-    PPacket *p = m_outBuffer.front();
-    m_outBuffer.pop_front();
-    delete p;
-  }
+  m_framesFlushed = m_framesAdded;
+  m_flushPos      = m_outBuffer.GetWritePos();
+  AtomicIncrement(&m_flushCount);
 
   /* reset our counts */
-  m_framesBuffered = 0;
   m_refillBuffer   = m_waterLevel;
   m_draining       = false;
 }
@@ -586,7 +775,7 @@ double CSoftAEStream::GetResampleRatio()
     return 1.0f;
 
   CSharedLock lock(m_lock);
-  return m_ssrcData.src_ratio;
+  return m_resampler->GetRatio();
 }
 
 bool CSoftAEStream::SetResampleRatio(double ratio)
@@ -596,26 +785,29 @@ bool CSoftAEStream::SetResampleRatio(double ratio)
 
   CSharedLock lock(m_lock);
 
-  int oldRatioInt = (int)std::ceil(m_ssrcData.src_ratio);
-
   m_resampleRatio = ratio;
-
-  src_set_ratio(m_ssrc, m_resampleRatio * m_internalRatio);
-  m_ssrcData.src_ratio = m_resampleRatio * m_internalRatio;
+  if (!m_resampler->SetRatio(m_resampleRatio * m_internalRatio))
+    return false;
 
   //Check the resample buffer size and resize if necessary.
-  if (oldRatioInt < std::ceil(m_ssrcData.src_ratio))
-  {
-    _aligned_free(m_ssrcData.data_out);
-    m_ssrcData.data_out      = (float*)_aligned_malloc(m_format.m_frameSamples * (int)std::ceil(m_ssrcData.src_ratio) * sizeof(float), 16);
-    m_ssrcData.output_frames = m_format.m_frames * (long)std::ceil(m_ssrcData.src_ratio);
-  }
+  AllocResampleBuffer();
   return true;
 }
 
+void CSoftAEStream::AllocResampleBuffer()
+{
+  const unsigned int frames = m_format.m_frames * (unsigned int)std::ceil(m_resampler->GetRatio());
+  if (frames <= m_resampleFrames && m_resampleBuffer)
+    return;
+
+  _aligned_free(m_resampleBuffer);
+  m_resampleBuffer = (float*)_aligned_malloc(frames * m_initChannelLayout.Count() * sizeof(float), 16);
+  m_resampleFrames = frames;
+}
+
 void CSoftAEStream::RegisterAudioCallback(IAudioCallback* pCallback)
 {
-  CExclusiveLock lock(m_lock);
+  CSingleLock lock(m_vizLock);
   m_vizBufferSamples = 0;
   m_audioCallback = pCallback;
   if (m_audioCallback)
@@ -624,7 +816,7 @@ void CSoftAEStream::RegisterAudioCallback(IAudioCallback* pCallback)
 
 void CSoftAEStream::UnRegisterAudioCallback()
 {
-  CExclusiveLock lock(m_lock);
+  CSingleLock lock(m_vizLock);
   m_audioCallback = NULL;
   m_vizBufferSamples = 0;
 }
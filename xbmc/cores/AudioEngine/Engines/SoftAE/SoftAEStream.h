@@ -19,22 +19,27 @@
  *
  */
 
-#include <samplerate.h>
 #include <list>
 
+#include "threads/CriticalSection.h"
 #include "threads/SharedSection.h"
 
 #include "AEAudioFormat.h"
 #include "Interfaces/AEStream.h"
+#include "Interfaces/AEResample.h"
 #include "Utils/AEConvert.h"
 #include "Utils/AERemap.h"
 #include "Utils/AEBuffer.h"
+#include "Utils/AERingBuffer.h"
 
 class IAEPostProc;
+class TestSoftAEHelper;
+
 class CSoftAEStream : public IAEStream
 {
 protected:
   friend class CSoftAE;
+  friend class ::TestSoftAEHelper;
   CSoftAEStream(enum AEDataFormat format, unsigned int sampleRate, unsigned int encodedSamplerate, CAEChannelInfo channelLayout, unsigned int options);
   virtual ~CSoftAEStream();
 
@@ -42,6 +47,7 @@ protected:
   void InitializeRemap();
   void Destroy();
   uint8_t* GetFrame();
+  uint8_t* GetFrames(unsigned int &frames);
 
   bool IsPaused   () { return m_paused; }
   bool IsDestroyed() { return m_delete; }
@@ -82,9 +88,20 @@ public:
   virtual void              FadeVolume(float from, float to, unsigned int time);
   virtual bool              IsFading();
   virtual void              RegisterSlave(IAEStream *stream);
+
+  /* queue statistics, to verify the mix thread is kept fed */
+  unsigned int              GetUnderruns     () const { return m_underruns; }
+  unsigned int              GetHighWaterLevel() const { return m_highWater; }
 private:
   void InternalFlush();
   void CheckResampleBuffers();
+  void AllocPackets();
+  void DiscardFlushed();
+  bool NextPacket();
+  unsigned int GetFramesBuffered();
+  void AddFramesBuffered(unsigned int frames);
+  unsigned int AddRawData(uint8_t *data, unsigned int size);
+  void CommitRawPacket();
 
   CSharedSection    m_lock;
   enum AEDataFormat m_initDataFormat;
@@ -93,11 +110,11 @@ private:
   CAEChannelInfo    m_initChannelLayout;
   unsigned int      m_chLayoutCount;
   
-  typedef struct
+  struct PPacket
   {
     CAEBuffer data;
     CAEBuffer vizData;
-  } PPacket;
+  };
 
   AEAudioFormat m_format;
 
@@ -113,7 +130,7 @@ private:
   float                   m_volume;        /* the volume level */
   float                   m_rgain;         /* replay gain level */
   unsigned int            m_waterLevel;    /* the fill level to fall below before calling the data callback */
-  unsigned int            m_refillBuffer;  /* how many frames that need to be buffered before we return any frames */
+  volatile long           m_refillBuffer;  /* how many frames that need to be buffered before we return any frames */
 
   CAEConvert::AEConvertToFn m_convertFn;
 
@@ -123,13 +140,30 @@ private:
   unsigned int        m_samplesPerFrame;
   CAEChannelInfo      m_aeChannelLayout;
   unsigned int        m_aeBytesPerFrame;
-  SRC_STATE          *m_ssrc;
-  SRC_DATA            m_ssrcData;
-  unsigned int        m_framesBuffered;
-  std::list<PPacket*> m_outBuffer;
+  IAEResample        *m_resampler;
+  float              *m_resampleBuffer; /* output of m_resampler */
+  unsigned int        m_resampleFrames; /* frames m_resampleBuffer can hold */
   unsigned int        ProcessFrameBuffer();
+  void                AllocResampleBuffer();
   PPacket            *m_newPacket;
-  PPacket            *m_packet;
+
+  /*
+    the packets are handed to the mix thread through m_outBuffer without any
+    locking, the producer side is only touched by AddData while holding
+    m_lock, the consumer side only by GetFrame on the mix thread
+  */
+  AESlotRing<PPacket> m_outBuffer;
+  PPacket            *m_packet;         /* the packet the mix thread is reading from */
+  PPacket            *m_rawPacket;      /* the write slot AddData is filling with passthrough data */
+  unsigned int        m_rawPending;     /* frames in m_rawPacket */
+  volatile long       m_framesAdded;    /* frames buffered by AddData */
+  volatile long       m_framesRead;     /* frames taken or discarded by GetFrame */
+  volatile long       m_framesFlushed;  /* m_framesAdded at the last flush */
+  volatile long       m_flushPos;       /* m_outBuffer write position at the last flush */
+  volatile long       m_flushCount;     /* incremented by each flush */
+  long                m_flushSeen;      /* m_flushCount as last seen by GetFrame */
+  unsigned int        m_underruns;
+  unsigned int        m_highWater;      /* most frames buffered at any time */
   uint8_t            *m_packetPos;
   float              *m_vizPacketPos;
   bool                m_paused;
@@ -137,6 +171,7 @@ private:
   bool                m_draining;
 
   /* vizualization internals */
+  CCriticalSection   m_vizLock;
   CAERemap           m_vizRemap;
   float              m_vizBuffer[512];
   unsigned int       m_vizBufferSamples;
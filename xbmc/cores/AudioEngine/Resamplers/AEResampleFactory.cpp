@@ -0,0 +1,94 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEResampleFactory.h"
+#include "AEResampleLinear.h"
+#include "AEResamplePolyphase.h"
+#include "AEResampleSRC.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/log.h"
+#include "utils/StdString.h"
+
+static const char *QualityNames[AE_RESAMPLE_MAX] =
+{
+  "linear",
+  "polyphase",
+  "fastest",
+  "medium",
+  "best"
+};
+
+IAEResample *CAEResampleFactory::Create(AEResampleQuality quality)
+{
+  switch (quality)
+  {
+    case AE_RESAMPLE_LINEAR     : return new CAEResampleLinear();
+    case AE_RESAMPLE_POLYPHASE  : return new CAEResamplePolyphase();
+    case AE_RESAMPLE_SINC_FAST  : return new CAEResampleSRC(SRC_SINC_FASTEST);
+    case AE_RESAMPLE_SINC_MEDIUM: return new CAEResampleSRC(SRC_SINC_MEDIUM_QUALITY);
+    case AE_RESAMPLE_SINC_BEST  : return new CAEResampleSRC(SRC_SINC_BEST_QUALITY);
+    default                     : return NULL;
+  }
+}
+
+bool CAEResampleFactory::ParseQuality(const std::string &name, AEResampleQuality &quality)
+{
+  CStdString str(name);
+  for (int i = 0; i < AE_RESAMPLE_MAX; ++i)
+    if (str.Equals(QualityNames[i]))
+    {
+      quality = (AEResampleQuality)i;
+      return true;
+    }
+
+  return false;
+}
+
+const char *CAEResampleFactory::GetQualityName(AEResampleQuality quality)
+{
+  if (quality < 0 || quality >= AE_RESAMPLE_MAX)
+    return "unknown";
+  return QualityNames[quality];
+}
+
+AEResampleQuality CAEResampleFactory::GetDefaultQuality()
+{
+  /* the sinc converters are too heavy for most ARM boxes */
+#if defined(__arm__)
+  return AE_RESAMPLE_POLYPHASE;
+#else
+  return AE_RESAMPLE_SINC_MEDIUM;
+#endif
+}
+
+AEResampleQuality CAEResampleFactory::GetQuality()
+{
+  const CStdString &name = g_advancedSettings.m_audioResampleQuality;
+
+  AEResampleQuality quality;
+  if (!name.empty())
+  {
+    if (ParseQuality(name, quality))
+      return quality;
+    CLog::Log(LOGWARNING, "CAEResampleFactory::GetQuality - unknown resample quality \"%s\", using the default", name.c_str());
+  }
+
+  return GetDefaultQuality();
+}
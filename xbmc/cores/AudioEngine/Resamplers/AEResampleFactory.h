@@ -0,0 +1,48 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <string>
+
+class IAEResample;
+
+enum AEResampleQuality
+{
+  AE_RESAMPLE_LINEAR,     /* linear interpolation, aliases */
+  AE_RESAMPLE_POLYPHASE,  /* short windowed sinc filter bank */
+  AE_RESAMPLE_SINC_FAST,  /* libsamplerate SRC_SINC_FASTEST */
+  AE_RESAMPLE_SINC_MEDIUM,/* libsamplerate SRC_SINC_MEDIUM_QUALITY */
+  AE_RESAMPLE_SINC_BEST,  /* libsamplerate SRC_SINC_BEST_QUALITY */
+
+  AE_RESAMPLE_MAX
+};
+
+class CAEResampleFactory
+{
+public:
+  static IAEResample       *Create(AEResampleQuality quality);
+  static bool               ParseQuality(const std::string &name, AEResampleQuality &quality);
+  static const char        *GetQualityName(AEResampleQuality quality);
+  static AEResampleQuality  GetDefaultQuality();
+  /* the quality requested in advancedsettings.xml, or the default for this platform */
+  static AEResampleQuality  GetQuality();
+};
+
@@ -0,0 +1,109 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEResampleLinear.h"
+
+#include <algorithm>
+
+#define FRAC_BITS 32
+#define FRAC_ONE  ((uint64_t)1 << FRAC_BITS)
+#define FRAC_MUL  (1.0f / (float)FRAC_ONE)
+
+CAEResampleLinear::CAEResampleLinear() :
+  m_channels(0  ),
+  m_ratio   (1.0),
+  m_step    (0  ),
+  m_pos     (0  )
+{
+}
+
+CAEResampleLinear::~CAEResampleLinear()
+{
+}
+
+bool CAEResampleLinear::Initialize(unsigned int channels, double ratio)
+{
+  if (!channels)
+    return false;
+
+  m_channels = channels;
+  m_last.resize(channels);
+  Reset();
+  return SetRatio(ratio);
+}
+
+void CAEResampleLinear::Reset()
+{
+  std::fill(m_last.begin(), m_last.end(), 0.0f);
+  m_pos = FRAC_ONE;
+}
+
+bool CAEResampleLinear::SetRatio(double ratio)
+{
+  if (ratio <= 0.0)
+    return false;
+
+  m_ratio = ratio;
+  m_step  = (uint64_t)((double)FRAC_ONE / ratio);
+  return true;
+}
+
+unsigned int CAEResampleLinear::Resample(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed)
+{
+  /*
+    frame 0 is the last frame of the previous call, so input frame n is at
+    position n + 1 and each output frame needs the frames either side of it
+  */
+  unsigned int gen = 0;
+  while (gen < outFrames)
+  {
+    const unsigned int index = (unsigned int)(m_pos >> FRAC_BITS);
+    if (index > inFrames)
+      break;
+
+    const float  frac = (float)(uint32_t)m_pos * FRAC_MUL;
+    const float *a    = index == 0 ? &m_last[0] : in + (index - 1) * m_channels;
+    const float *b    = index == inFrames ? NULL : in + index * m_channels;
+
+    /* exactly on the last input frame, no need for the next one */
+    if (!b)
+    {
+      if ((uint32_t)m_pos)
+        break;
+      b = a;
+    }
+
+    for (unsigned int c = 0; c < m_channels; ++c)
+      *out++ = a[c] + (b[c] - a[c]) * frac;
+
+    m_pos += m_step;
+    ++gen;
+  }
+
+  /* keep the last frame we stepped past for the next call */
+  inUsed = std::min((unsigned int)(m_pos >> FRAC_BITS), inFrames);
+  if (inUsed)
+  {
+    std::copy(in + (inUsed - 1) * m_channels, in + inUsed * m_channels, m_last.begin());
+    m_pos -= (uint64_t)inUsed << FRAC_BITS;
+  }
+
+  return gen;
+}
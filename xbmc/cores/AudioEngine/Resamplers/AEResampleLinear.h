@@ -0,0 +1,51 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <vector>
+
+#include "Interfaces/AEResample.h"
+
+/**
+ * Linear interpolation, the cheapest possible resampler. There is no low pass
+ * filtering so it aliases, only meant for very slow hardware.
+ */
+class CAEResampleLinear : public IAEResample
+{
+public:
+  CAEResampleLinear();
+  virtual ~CAEResampleLinear();
+
+  virtual const char  *GetName() { return "linear"; }
+  virtual bool         Initialize(unsigned int channels, double ratio);
+  virtual void         Reset();
+  virtual bool         SetRatio(double ratio);
+  virtual double       GetRatio() { return m_ratio; }
+  virtual unsigned int Resample(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed);
+
+private:
+  unsigned int       m_channels;
+  double             m_ratio;
+  uint64_t           m_step; /* input frames per output frame, 32.32 fixed point */
+  uint64_t           m_pos;  /* position of the next output frame, 0 is m_last */
+  std::vector<float> m_last; /* the last frame of the previous call */
+};
+
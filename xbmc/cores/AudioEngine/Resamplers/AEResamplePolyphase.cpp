@@ -0,0 +1,271 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "AEResamplePolyphase.h"
+#include "utils/log.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#define FRAC_BITS  32
+#define FRAC_ONE   ((uint64_t)1 << FRAC_BITS)
+#define BLEND_BITS (FRAC_BITS - AE_POLYPHASE_PHASE_BITS)
+#define BLEND_MUL  (1.0f / (float)(1 << BLEND_BITS))
+
+/* half the filter length, each output uses this many inputs either side */
+#define HALF_TAPS  (AE_POLYPHASE_TAPS / 2)
+/* frames per channel in m_buffer, room for a block plus the filter history */
+#define BUFFER_LEN (AE_POLYPHASE_BLOCK + AE_POLYPHASE_TAPS)
+
+/* kaiser window shape, about 70dB of stop band rejection */
+#define KAISER_BETA 7.0
+/* pass band as a fraction of the lower nyquist frequency */
+#define PASS_BAND   0.9
+
+static const double PI = 3.14159265358979323846;
+
+/* zeroth order modified bessel function of the first kind */
+static double BesselI0(double x)
+{
+  double sum  = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; ++k)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum  += term;
+    if (term < sum * 1e-12)
+      break;
+  }
+  return sum;
+}
+
+CAEResamplePolyphase::CAEResamplePolyphase() :
+  m_channels(0   ),
+  m_ratio   (1.0 ),
+  m_cutoff  (0.0 ),
+  m_step    (0   ),
+  m_pos     (0   ),
+  m_buffered(0   ),
+  m_bank    (NULL),
+  m_buffer  (NULL)
+{
+}
+
+CAEResamplePolyphase::~CAEResamplePolyphase()
+{
+  Free();
+}
+
+void CAEResamplePolyphase::Free()
+{
+  if (m_bank)
+    _aligned_free(m_bank);
+  if (m_buffer)
+    _aligned_free(m_buffer);
+
+  m_bank   = NULL;
+  m_buffer = NULL;
+}
+
+bool CAEResamplePolyphase::Initialize(unsigned int channels, double ratio)
+{
+  Free();
+  if (!channels || ratio <= 0.0)
+    return false;
+
+  m_channels = channels;
+  m_bank     = (float*)_aligned_malloc((AE_POLYPHASE_PHASES + 1) * AE_POLYPHASE_TAPS * sizeof(float), 16);
+  m_buffer   = (float*)_aligned_malloc(m_channels * BUFFER_LEN * sizeof(float), 16);
+  m_cutoff   = 0.0;
+
+  Reset();
+  return SetRatio(ratio);
+}
+
+void CAEResamplePolyphase::Reset()
+{
+  if (!m_buffer)
+    return;
+
+  /* prime the history with silence so the first output lines up with the first input */
+  memset(m_buffer, 0, m_channels * BUFFER_LEN * sizeof(float));
+  m_buffered = HALF_TAPS - 1;
+  m_pos      = (uint64_t)(HALF_TAPS - 1) << FRAC_BITS;
+}
+
+bool CAEResamplePolyphase::SetRatio(double ratio)
+{
+  if (ratio <= 0.0 || !m_bank)
+    return false;
+
+  m_ratio = ratio;
+  m_step  = (uint64_t)((double)FRAC_ONE / ratio);
+
+  /* when downsampling the cutoff has to follow the ratio, only rebuild for real changes */
+  const double cutoff = PASS_BAND * std::min(1.0, ratio);
+  if (fabs(cutoff - m_cutoff) > m_cutoff * 0.01)
+    BuildBank(cutoff);
+
+  return true;
+}
+
+void CAEResamplePolyphase::BuildBank(double cutoff)
+{
+  CLog::Log(LOGDEBUG, "CAEResamplePolyphase::BuildBank - %d taps, %d phases, cutoff %f", AE_POLYPHASE_TAPS, AE_POLYPHASE_PHASES, cutoff);
+
+  const double i0Beta = BesselI0(KAISER_BETA);
+  for (int p = 0; p <= AE_POLYPHASE_PHASES; ++p)
+  {
+    float  *h   = m_bank + p * AE_POLYPHASE_TAPS;
+    double  sum = 0.0;
+    for (int k = 0; k < AE_POLYPHASE_TAPS; ++k)
+    {
+      /* distance in input frames from the output position to tap k */
+      const double t = (double)p / AE_POLYPHASE_PHASES + (HALF_TAPS - 1) - k;
+      const double x = cutoff * t;
+      const double w = t / HALF_TAPS;
+
+      double sinc = x == 0.0 ? 1.0 : sin(PI * x) / (PI * x);
+      double win  = w * w >= 1.0 ? 0.0 : BesselI0(KAISER_BETA * sqrt(1.0 - w * w)) / i0Beta;
+      double v    = cutoff * sinc * win;
+
+      h[k] = (float)v;
+      sum += v;
+    }
+
+    /* unity gain at DC for every phase */
+    for (int k = 0; k < AE_POLYPHASE_TAPS; ++k)
+      h[k] = (float)(h[k] / sum);
+  }
+
+  m_cutoff = cutoff;
+}
+
+unsigned int CAEResamplePolyphase::Resample(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed)
+{
+#ifdef __SSE__
+  __m128 coef[AE_POLYPHASE_TAPS / 4];
+#else
+  float  coef[AE_POLYPHASE_TAPS];
+#endif
+
+  unsigned int gen = 0;
+  inUsed = 0;
+
+  for (;;)
+  {
+    /* generate while the filter window is covered by buffered input */
+    while (gen < outFrames)
+    {
+      const unsigned int index = (unsigned int)(m_pos >> FRAC_BITS);
+      if (index + HALF_TAPS >= m_buffered)
+        break;
+
+      /* blend the two closest sub filters */
+      const uint32_t frac  = (uint32_t)m_pos;
+      const float   *h0    = m_bank + (frac >> BLEND_BITS) * AE_POLYPHASE_TAPS;
+      const float   *h1    = h0 + AE_POLYPHASE_TAPS;
+      const float    blend = (float)(frac & ((1 << BLEND_BITS) - 1)) * BLEND_MUL;
+      const unsigned int start = index - (HALF_TAPS - 1);
+
+#ifdef __SSE__
+      const __m128 vblend = _mm_set1_ps(blend);
+      for (int k = 0; k < AE_POLYPHASE_TAPS / 4; ++k)
+      {
+        const __m128 a = _mm_load_ps(h0 + (k << 2));
+        const __m128 b = _mm_load_ps(h1 + (k << 2));
+        coef[k] = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), vblend));
+      }
+
+      for (unsigned int c = 0; c < m_channels; ++c)
+      {
+        const float *src  = m_buffer + c * BUFFER_LEN + start;
+        __m128       acc1 = _mm_setzero_ps();
+        __m128       acc2 = _mm_setzero_ps();
+        for (int k = 0; k < AE_POLYPHASE_TAPS / 4; k += 2)
+        {
+          acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(src + (k << 2)    ), coef[k    ]));
+          acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(src + (k << 2) + 4), coef[k + 1]));
+        }
+        acc1 = _mm_add_ps(acc1, acc2);
+        acc1 = _mm_add_ps(acc1, _mm_movehl_ps(acc1, acc1));
+        acc1 = _mm_add_ss(acc1, _mm_shuffle_ps(acc1, acc1, 1));
+        _mm_store_ss(out++, acc1);
+      }
+#else
+      for (int k = 0; k < AE_POLYPHASE_TAPS; ++k)
+        coef[k] = h0[k] + (h1[k] - h0[k]) * blend;
+
+      for (unsigned int c = 0; c < m_channels; ++c)
+      {
+        const float *src = m_buffer + c * BUFFER_LEN + start;
+        float acc = 0.0f;
+        for (int k = 0; k < AE_POLYPHASE_TAPS; ++k)
+          acc += src[k] * coef[k];
+        *out++ = acc;
+      }
+#endif
+
+      m_pos += m_step;
+      ++gen;
+    }
+
+    if (gen == outFrames || inUsed == inFrames)
+      break;
+
+    /* drop the input that is no longer under the filter window */
+    unsigned int drop = std::min((unsigned int)(m_pos >> FRAC_BITS) - (HALF_TAPS - 1), m_buffered);
+    if (drop)
+    {
+      for (unsigned int c = 0; c < m_channels; ++c)
+      {
+        float *buf = m_buffer + c * BUFFER_LEN;
+        memmove(buf, buf + drop, (m_buffered - drop) * sizeof(float));
+      }
+      m_buffered -= drop;
+      m_pos      -= (uint64_t)drop << FRAC_BITS;
+    }
+
+    /* deinterleave more input into the planar buffer */
+    const unsigned int take = std::min(inFrames - inUsed, BUFFER_LEN - m_buffered);
+    if (!take)
+      break;
+
+    const float *src = in + inUsed * m_channels;
+    for (unsigned int c = 0; c < m_channels; ++c)
+    {
+      float       *dst = m_buffer + c * BUFFER_LEN + m_buffered;
+      const float *s   = src + c;
+      for (unsigned int f = 0; f < take; ++f, s += m_channels)
+        dst[f] = *s;
+    }
+
+    m_buffered += take;
+    inUsed     += take;
+  }
+
+  return gen;
+}
@@ -0,0 +1,67 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+#include "Interfaces/AEResample.h"
+
+/* number of filter taps, must be a multiple of 4 for the SSE dot product */
+#define AE_POLYPHASE_TAPS       32
+/* number of sub filters per input sample, as a power of two */
+#define AE_POLYPHASE_PHASE_BITS 8
+#define AE_POLYPHASE_PHASES     (1 << AE_POLYPHASE_PHASE_BITS)
+/* how many input frames are buffered per channel */
+#define AE_POLYPHASE_BLOCK      1024
+
+/**
+ * Windowed sinc resampler using a precomputed polyphase filter bank. The bank
+ * is built once for the ratio so the inner loop is a short fixed length dot
+ * product per channel, small ratio adjustments are handled by interpolating
+ * between neighbouring sub filters.
+ */
+class CAEResamplePolyphase : public IAEResample
+{
+public:
+  CAEResamplePolyphase();
+  virtual ~CAEResamplePolyphase();
+
+  virtual const char  *GetName() { return "polyphase"; }
+  virtual bool         Initialize(unsigned int channels, double ratio);
+  virtual void         Reset();
+  virtual bool         SetRatio(double ratio);
+  virtual double       GetRatio() { return m_ratio; }
+  virtual unsigned int Resample(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed);
+
+private:
+  unsigned int  m_channels;
+  double        m_ratio;
+  double        m_cutoff;   /* the cutoff the filter bank was built for */
+  uint64_t      m_step;     /* input frames per output frame, 32.32 fixed point */
+  uint64_t      m_pos;      /* position of the next output frame in m_buffer */
+  unsigned int  m_buffered; /* frames in m_buffer */
+
+  float        *m_bank;     /* (phases + 1) sub filters */
+  float        *m_buffer;   /* planar input, one block per channel */
+
+  void BuildBank(double cutoff);
+  void Free();
+};
+
@@ -0,0 +1,97 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEResampleSRC.h"
+#include "utils/log.h"
+
+CAEResampleSRC::CAEResampleSRC(int quality) :
+  m_quality(quality),
+  m_ratio  (1.0    ),
+  m_state  (NULL   )
+{
+}
+
+CAEResampleSRC::~CAEResampleSRC()
+{
+  if (m_state)
+    src_delete(m_state);
+}
+
+const char *CAEResampleSRC::GetName()
+{
+  switch (m_quality)
+  {
+    case SRC_SINC_FASTEST       : return "sinc fastest";
+    case SRC_SINC_MEDIUM_QUALITY: return "sinc medium";
+    case SRC_SINC_BEST_QUALITY  : return "sinc best";
+    default                     : return "sinc";
+  }
+}
+
+bool CAEResampleSRC::Initialize(unsigned int channels, double ratio)
+{
+  if (m_state)
+    src_delete(m_state);
+
+  int err;
+  m_state = src_new(m_quality, channels, &err);
+  if (!m_state)
+  {
+    CLog::Log(LOGERROR, "CAEResampleSRC::Initialize - src_new failed: %s", src_strerror(err));
+    return false;
+  }
+
+  return SetRatio(ratio);
+}
+
+void CAEResampleSRC::Reset()
+{
+  if (m_state)
+    src_reset(m_state);
+}
+
+bool CAEResampleSRC::SetRatio(double ratio)
+{
+  if (!m_state || src_set_ratio(m_state, ratio) != 0)
+    return false;
+
+  m_ratio = ratio;
+  return true;
+}
+
+unsigned int CAEResampleSRC::Resample(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed)
+{
+  SRC_DATA data;
+  data.data_in       = const_cast<float*>(in);
+  data.data_out      = out;
+  data.input_frames  = inFrames;
+  data.output_frames = outFrames;
+  data.end_of_input  = 0;
+  data.src_ratio     = m_ratio;
+
+  if (src_process(m_state, &data) != 0)
+  {
+    inUsed = 0;
+    return 0;
+  }
+
+  inUsed = data.input_frames_used;
+  return data.output_frames_gen;
+}
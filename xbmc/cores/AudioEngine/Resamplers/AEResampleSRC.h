@@ -0,0 +1,49 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include <samplerate.h>
+
+#include "Interfaces/AEResample.h"
+
+/**
+ * Band limited sinc interpolation provided by libsamplerate, the quality is
+ * one of the SRC_SINC_* converter types.
+ */
+class CAEResampleSRC : public IAEResample
+{
+public:
+  CAEResampleSRC(int quality);
+  virtual ~CAEResampleSRC();
+
+  virtual const char  *GetName();
+  virtual bool         Initialize(unsigned int channels, double ratio);
+  virtual void         Reset();
+  virtual bool         SetRatio(double ratio);
+  virtual double       GetRatio() { return m_ratio; }
+  virtual unsigned int Resample(const float *in, unsigned int inFrames, float *out, unsigned int outFrames, unsigned int &inUsed);
+
+private:
+  int        m_quality;
+  double     m_ratio;
+  SRC_STATE *m_state;
+};
+
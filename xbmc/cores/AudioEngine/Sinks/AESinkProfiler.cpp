@@ -30,7 +30,12 @@
 #include "utils/TimeUtils.h"
 #include "settings/GUISettings.h"
 
-CAESinkProfiler::CAESinkProfiler()
+CAESinkProfiler::CAESinkProfiler() :
+  m_ts        (0),
+  m_frameSize (0),
+  m_reportTs  (0),
+  m_bytesAdded(0),
+  m_rawCopied (0)
 {
 }
 
@@ -41,14 +46,28 @@ CAESinkProfiler::~CAESinkProfiler()
 bool CAESinkProfiler::Initialize(AEAudioFormat &format, std::string &device)
 {
   if (AE_IS_RAW(format.m_dataFormat))
-    return false;
+  {
+    /* take the bitstream as 16 bit words at the rate and layout asked for, like a real passthrough sink */
+    format.m_dataFormat    = AE_FMT_S16NE;
+    format.m_frames        = format.m_sampleRate / 50;
+    format.m_frameSamples  = format.m_channelLayout.Count();
+    format.m_frameSize     = format.m_frameSamples * sizeof(int16_t);
+  }
+  else
+  {
+    format.m_sampleRate    = 192000;
+    format.m_channelLayout = AE_CH_LAYOUT_7_1;
+    format.m_dataFormat    = AE_FMT_S32LE;
+    format.m_frames        = 30720;
+    format.m_frameSamples  = format.m_channelLayout.Count();
+    format.m_frameSize     = format.m_frameSamples * sizeof(float);
+  }
 
-  format.m_sampleRate    = 192000;
-  format.m_channelLayout = AE_CH_LAYOUT_7_1;
-  format.m_dataFormat    = AE_FMT_S32LE;
-  format.m_frames        = 30720;
-  format.m_frameSamples  = format.m_channelLayout.Count();
-  format.m_frameSize     = format.m_frameSamples * sizeof(float);
+  m_frameSize  = format.m_frameSize;
+  m_ts         = CurrentHostCounter();
+  m_reportTs   = m_ts;
+  m_bytesAdded = 0;
+  m_rawCopied  = CAEUtil::GetRawCopied();
   return true;
 }
 
@@ -77,6 +96,22 @@ unsigned int CAESinkProfiler::AddPackets(uint8_t *data, unsigned int frames, boo
   int64_t ts = CurrentHostCounter();
   CLog::Log(LOGDEBUG, "CAESinkProfiler::AddPackets - latency %f ms", (float)(ts - m_ts) / 1000000.0f);
   m_ts = ts;
+
+  /* report how many bytes the engine copied for each byte that reached us */
+  m_bytesAdded += frames * m_frameSize;
+  const int64_t elapsed = ts - m_reportTs;
+  if (elapsed >= CurrentHostFrequency())
+  {
+    const unsigned long copied  = CAEUtil::GetRawCopied();
+    const double        seconds = (double)elapsed / (double)CurrentHostFrequency();
+    CLog::Log(LOGDEBUG, "CAESinkProfiler::AddPackets - %.0f bytes/s delivered, %.0f bytes/s copied on the passthrough path",
+      (double)m_bytesAdded / seconds, (double)(copied - m_rawCopied) / seconds);
+
+    m_reportTs   = ts;
+    m_bytesAdded = 0;
+    m_rawCopied  = copied;
+  }
+
   return frames;
 }
 
@@ -43,5 +43,11 @@ public:
   virtual void         Drain           ();
   static void          EnumerateDevices(AEDeviceList &devices, bool passthrough);
 private:
-  int64_t m_ts;
+  int64_t       m_ts;
+  unsigned int  m_frameSize;
+
+  /* passthrough copy accounting, reported once a second */
+  int64_t       m_reportTs;
+  uint64_t      m_bytesAdded;
+  unsigned long m_rawCopied;
 };
@@ -21,6 +21,7 @@
 #include "AEBitstreamPacker.h"
 #include "AEPackIEC61937.h"
 #include "AEStreamInfo.h"
+#include "AEUtil.h"
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
@@ -47,6 +48,9 @@ CAEBitstreamPacker::~CAEBitstreamPacker()
 
 void CAEBitstreamPacker::Pack(CAEStreamInfo &info, uint8_t* data, int size)
 {
+  /* every packer copies the frame into the burst once, the HD ones go through a staging buffer first */
+  CAEUtil::CountRawCopy(size);
+
   switch (info.GetDataType())
   {
     case CAEStreamInfo::STREAM_TYPE_TRUEHD:
@@ -128,6 +132,7 @@ void CAEBitstreamPacker::PackTrueHD(CAEStreamInfo &info, uint8_t* data, int size
   {
     m_trueHDPos = 0;
     m_dataSize  = CAEPackIEC61937::PackTrueHD(m_trueHD, MAT_FRAME_SIZE, m_packedBuffer);
+    CAEUtil::CountRawCopy(MAT_FRAME_SIZE);
   }
 }
 
@@ -149,5 +154,6 @@ void CAEBitstreamPacker::PackDTSHD(CAEStreamInfo &info, uint8_t* data, int size)
   memcpy(m_dtsHD + sizeof(dtshd_start_code) + 2, data, size);
 
   m_dataSize = CAEPackIEC61937::PackDTSHD(m_dtsHD, dataSize, m_packedBuffer, info.GetDTSPeriod());
+  CAEUtil::CountRawCopy(dataSize);
 }
 
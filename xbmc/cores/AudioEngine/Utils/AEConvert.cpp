@@ -22,7 +22,9 @@
 #endif
 
 #include "AEConvert.h"
+#include "AEConvertSIMD.h"
 #include "AEUtil.h"
+#include "utils/CPUInfo.h"
 #include "utils/MathUtils.h"
 #include "utils/EndianSwap.h"
 #include <stdint.h>
@@ -42,7 +44,7 @@
 #include <arm_neon.h>
 #endif
 
-#define CLAMP(x) std::min(-1.0f, std::max(1.0f, (float)(x)))
+#define CLAMP(x) std::min(1.0f, std::max(-1.0f, (float)(x)))
 
 #ifndef INT24_MAX
 #define INT24_MAX (0x7FFFFF)
@@ -67,6 +69,23 @@ static inline int safeRound(double f)
 
 CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat)
 {
+  return ToFloat(dataFormat, g_cpuInfo.GetCPUFeatures());
+}
+
+CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures)
+{
+  /* prefer the widest SIMD kernel the CPU supports, each tier returns NULL for
+   * formats it has no kernel for so we fall through to the next one */
+  AEConvertToFn fn = NULL;
+  if (cpuFeatures & CPU_FEATURE_AVX2)
+    fn = CAEConvertSIMD::ToFloatAVX2(dataFormat);
+  if (!fn && (cpuFeatures & CPU_FEATURE_SSSE3))
+    fn = CAEConvertSIMD::ToFloatSSSE3(dataFormat);
+  if (!fn && (cpuFeatures & CPU_FEATURE_SSE2))
+    fn = CAEConvertSIMD::ToFloatSSE2(dataFormat);
+  if (fn)
+    return fn;
+
   switch (dataFormat)
   {
     case AE_FMT_U8    : return &U8_Float;
@@ -103,6 +122,21 @@ CAEConvert::AEConvertToFn CAEConvert::ToFloat(enum AEDataFormat dataFormat)
 
 CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat)
 {
+  return FrFloat(dataFormat, g_cpuInfo.GetCPUFeatures());
+}
+
+CAEConvert::AEConvertFrFn CAEConvert::FrFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures)
+{
+  AEConvertFrFn fn = NULL;
+  if (cpuFeatures & CPU_FEATURE_AVX2)
+    fn = CAEConvertSIMD::FrFloatAVX2(dataFormat);
+  if (!fn && (cpuFeatures & CPU_FEATURE_SSSE3))
+    fn = CAEConvertSIMD::FrFloatSSSE3(dataFormat);
+  if (!fn && (cpuFeatures & CPU_FEATURE_SSE2))
+    fn = CAEConvertSIMD::FrFloatSSE2(dataFormat);
+  if (fn)
+    return fn;
+
   switch (dataFormat)
   {
     case AE_FMT_U8    : return &Float_U8;
@@ -176,7 +210,7 @@ unsigned int CAEConvert::S16LE_Float(uint8_t* data, const unsigned int samples,
   }
 #else
   for (unsigned int i = 0; i < samples; ++i, data += 2)
-    *dest++ = Endian_SwapLE16(*(int16_t*)data) * mul;
+    *dest++ = (int16_t)Endian_SwapLE16(*(int16_t*)data) * mul;
 #endif
 
   return samples;
@@ -207,7 +241,7 @@ unsigned int CAEConvert::S16BE_Float(uint8_t* data, const unsigned int samples,
   }
 #else
   for (unsigned int i = 0; i < samples; ++i, data += 2)
-    *dest++ = Endian_SwapBE16(*(int16_t*)data) * mul;
+    *dest++ = (int16_t)Endian_SwapBE16(*(int16_t*)data) * mul;
 #endif
 
   return samples;
@@ -247,7 +281,7 @@ unsigned int CAEConvert::S24BE3_Float(uint8_t *data, const unsigned int samples,
 {
   for (unsigned int i = 0; i < samples; ++i, data += 3)
   {
-    int s = (data[1] << 24) | (data[2] << 16) | (data[3] << 8);
+    int s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8);
     *dest++ = (float)s * INT32_SCALE;
   }
   return samples;
@@ -261,15 +295,15 @@ unsigned int CAEConvert::S32LE_Float(uint8_t *data, const unsigned int samples,
   /* do this in groups of 4 to give the compiler a better chance of optimizing this */
   for (float *end = dest + (samples & ~0x3); dest < end;)
   {
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
   }
 
   /* process any remaining samples */
   for (float *end = dest + (samples & 0x3); dest < end;)
-    *dest++ = (float)Endian_SwapLE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapLE32(*src++) * factor;
 
   return samples;
 }
@@ -320,15 +354,15 @@ unsigned int CAEConvert::S32BE_Float(uint8_t *data, const unsigned int samples,
   /* do this in groups of 4 to give the compiler a better chance of optimizing this */
   for (float *end = dest + (samples & ~0x3); dest < end;)
   {
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
   }
 
   /* process any remaining samples */
   for (float *end = dest + (samples & 0x3); dest < end;)
-    *dest++ = (float)Endian_SwapBE32(*src++) * factor;
+    *dest++ = (float)(int32_t)Endian_SwapBE32(*src++) * factor;
 
   return samples;
 }
@@ -375,7 +409,7 @@ unsigned int CAEConvert::DOUBLE_Float(uint8_t *data, const unsigned int samples,
 {
   double *src = (double*)data;
   for (unsigned int i = 0; i < samples; ++i)
-    *dest++ = CLAMP(*src++ / (float)INT32_MAX);
+    *dest++ = CLAMP(*src++);
 
   return samples;
 }
@@ -774,7 +808,7 @@ unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, ui
     *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + rand[3])));
   }
 
-  for(; i < samples; ++i, data++, dst++)
+  for(; i < samples; ++i)
     *dst++ = Endian_SwapBE16(safeRound(*data++ * ((float)INT16_MAX + CAEUtil::FloatRand1(-0.5f, 0.5f))));
 
   #endif
@@ -785,60 +819,8 @@ unsigned int CAEConvert::Float_S16BE(float *data, const unsigned int samples, ui
 unsigned int CAEConvert::Float_S24NE4(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-
-  const __m128 mul = _mm_set_ps1((float)INT24_MAX+.5f);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f));
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    con         = _mm_slli_epi32(con, 8);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-      dst[0] = safeRound(data[0] * ((float)INT24_MAX+.5f));
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        con       = _mm_slli_pi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        con         = _mm_slli_epi32(con, 8);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-      }
-    }
-  }
-  _mm_empty();
-  #else /* no SSE */
   for (uint32_t i = 0; i < samples; ++i)
     *dst++ = (safeRound(*data++ * ((float)INT24_MAX+.5f)) & 0xFFFFFF) << 8;
-  #endif
 
   return samples << 2;
 }
@@ -925,73 +907,11 @@ unsigned int CAEConvert::Float_S24NE3(float *data, const unsigned int samples, u
 unsigned int CAEConvert::Float_S32LE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    dst[0] = Endian_SwapLE32(dst[0]);
-    dst[1] = Endian_SwapLE32(dst[1]);
-    dst[2] = Endian_SwapLE32(dst[2]);
-    dst[3] = Endian_SwapLE32(dst[3]);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-    {
-      dst[0] = safeRound(data[0] * (float)INT32_MAX);
-      dst[0] = Endian_SwapLE32(dst[0]);
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        dst[0] = Endian_SwapLE32(dst[0]);
-        dst[1] = Endian_SwapLE32(dst[1]);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        dst[0] = Endian_SwapLE32(dst[0]);
-        dst[1] = Endian_SwapLE32(dst[1]);
-        dst[2] = Endian_SwapLE32(dst[2]);
-      }
-    }
-  }
-  _mm_empty();
-  #else
-
-  /* no SIMD */
   for (uint32_t i = 0; i < samples; ++i, ++data, ++dst)
   {
     dst[0] = safeRound(data[0] * (float)INT32_MAX);
     dst[0] = Endian_SwapLE32(dst[0]);
   }
-  #endif
   return samples << 2;
 }
 
@@ -1034,72 +954,11 @@ unsigned int CAEConvert::Float_S32LE_Neon(float *data, const unsigned int sample
 unsigned int CAEConvert::Float_S32BE(float *data, const unsigned int samples, uint8_t *dest)
 {
   int32_t *dst = (int32_t*)dest;
-  #ifdef __SSE__
-  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
-  unsigned int count = samples;
-
-  /* work around invalid alignment */
-  while ((((uintptr_t)data & 0xF) || ((uintptr_t)dest & 0xF)) && count > 0)
-  {
-    dst[0] = safeRound(data[0] * (float)INT32_MAX);
-    ++data;
-    ++dst;
-    --count;
-  }
-
-  const uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i += 4, data += 4, dst += 4)
-  {
-    __m128  in  = _mm_mul_ps(_mm_load_ps(data), mul);
-    __m128i con = _mm_cvtps_epi32(in);
-    memcpy(dst, &con, sizeof(int32_t) * 4);
-    dst[0] = Endian_SwapBE32(dst[0]);
-    dst[1] = Endian_SwapBE32(dst[1]);
-    dst[2] = Endian_SwapBE32(dst[2]);
-    dst[3] = Endian_SwapBE32(dst[3]);
-  }
-
-  if (samples != even)
-  {
-    const uint32_t odd = samples - even;
-    if (odd == 1)
-    {
-      dst[0] = safeRound(data[0] * (float)INT32_MAX);
-      dst[0] = Endian_SwapBE32(dst[0]);
-    }
-    else
-    {
-      __m128 in;
-      if (odd == 2)
-      {
-        in = _mm_setr_ps(data[0], data[1], 0, 0);
-        in = _mm_mul_ps(in, mul);
-        __m64 con = _mm_cvtps_pi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 2);
-        dst[0] = Endian_SwapBE32(dst[0]);
-        dst[1] = Endian_SwapBE32(dst[1]);
-      }
-      else
-      {
-        in = _mm_setr_ps(data[0], data[1], data[2], 0);
-        in = _mm_mul_ps(in, mul);
-        __m128i con = _mm_cvtps_epi32(in);
-        memcpy(dst, &con, sizeof(int32_t) * 3);
-        dst[0] = Endian_SwapBE32(dst[0]);
-        dst[1] = Endian_SwapBE32(dst[1]);
-        dst[2] = Endian_SwapBE32(dst[2]);
-      }
-    }
-  }
-  _mm_empty();
-  #else
-  /* no SIMD */
   for (uint32_t i = 0; i < samples; ++i, ++data, ++dst)
   {
     dst[0] = safeRound(data[0] * (float)INT32_MAX);
     dst[0] = Endian_SwapBE32(dst[0]);
   }
-  #endif
 
   return samples << 2;
 }
@@ -57,5 +57,12 @@ public:
 
   static AEConvertToFn ToFloat(enum AEDataFormat dataFormat);
   static AEConvertFrFn FrFloat(enum AEDataFormat dataFormat);
+
+  /**
+   * Returns the best conversion function for the given CPU_FEATURE_* mask,
+   * passing 0 selects the generic implementation.
+   */
+  static AEConvertToFn ToFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures);
+  static AEConvertFrFn FrFloat(enum AEDataFormat dataFormat, unsigned int cpuFeatures);
 };
 
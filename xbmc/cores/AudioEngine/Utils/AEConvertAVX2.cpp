@@ -0,0 +1,205 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEConvertSIMD.h"
+
+#include <stdint.h>
+#include <limits.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__) && !defined(__BIG_ENDIAN__)
+
+#define INT32_SCALE (-1.0f / INT_MIN)
+
+/*
+ * 256 bit versions of the hot conversions, the tails are handled with the
+ * same expressions as the generic code so the output is identical.
+ */
+
+static inline void s16_to_float(__m128i in, const __m256 mul, float *dest)
+{
+  _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(in)), mul));
+}
+
+static unsigned int S16LE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  mul  = 1.0f / (INT16_MAX + 0.5f);
+  const __m256 vmul = _mm256_set1_ps(mul);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 32, dest += 16)
+  {
+    s16_to_float(_mm_loadu_si128((const __m128i*)data       ), vmul, dest    );
+    s16_to_float(_mm_loadu_si128((const __m128i*)(data + 16)), vmul, dest + 8);
+  }
+
+  for (; i < samples; ++i, data += 2)
+    *dest++ = *(int16_t*)data * mul;
+
+  return samples;
+}
+
+static unsigned int S16BE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float   mul  = 1.0f / (INT16_MAX + 0.5f);
+  const __m256  vmul = _mm256_set1_ps(mul);
+  const __m128i shuf = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 32, dest += 16)
+  {
+    s16_to_float(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data       ), shuf), vmul, dest    );
+    s16_to_float(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), shuf), vmul, dest + 8);
+  }
+
+  for (; i < samples; ++i, data += 2)
+    *dest++ = (int16_t)((data[0] << 8) | data[1]) * mul;
+
+  return samples;
+}
+
+static unsigned int S24LE4_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256 vmul = _mm256_set1_ps(INT32_SCALE);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 32, dest += 8)
+  {
+    __m256i in = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)data), 8);
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int s = (data[2] << 24) | (data[1] << 16) | (data[0] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S24LE3_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m256  vmul = _mm256_set1_ps(INT32_SCALE);
+  const __m256i shuf = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+
+  /* 8 samples per iteration from two 16 byte loads 12 bytes apart, the
+   * second load reads 4 bytes past the 24 we consume */
+  unsigned int i = 0;
+  for (; i + 10 <= samples; i += 8, data += 24, dest += 8)
+  {
+    __m256i in = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)data));
+    in = _mm256_inserti128_si256(in, _mm_loadu_si128((const __m128i*)(data + 12)), 1);
+    in = _mm256_shuffle_epi8(in, shuf);
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 3)
+  {
+    int s = (data[2] << 24) | (data[1] << 16) | (data[0] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S32LE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  factor = 1.0f / (float)INT32_MAX;
+  const __m256 vmul   = _mm256_set1_ps(factor);
+  int32_t *src = (int32_t*)data;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, src += 8, dest += 8)
+  {
+    __m256i in = _mm256_loadu_si256((const __m256i*)src);
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = (float)*src++ * factor;
+
+  return samples;
+}
+
+static unsigned int S32BE_Float_AVX2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float   factor = 1.0f / (float)INT32_MAX;
+  const __m256  vmul   = _mm256_set1_ps(factor);
+  const __m256i shuf   = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 32, dest += 8)
+  {
+    __m256i in = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)data), shuf);
+    _mm256_storeu_ps(dest, _mm256_mul_ps(_mm256_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int32_t s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    *dest++ = (float)s * factor;
+  }
+
+  return samples;
+}
+
+CAEConvert::AEConvertToFn CAEConvertSIMD::ToFloatAVX2(enum AEDataFormat dataFormat)
+{
+  switch (dataFormat)
+  {
+    case AE_FMT_S16NE :
+    case AE_FMT_S16LE : return &S16LE_Float_AVX2;
+    case AE_FMT_S16BE : return &S16BE_Float_AVX2;
+    case AE_FMT_S24NE4:
+    case AE_FMT_S24LE4: return &S24LE4_Float_AVX2;
+    case AE_FMT_S24NE3:
+    case AE_FMT_S24LE3: return &S24LE3_Float_AVX2;
+    case AE_FMT_S32NE :
+    case AE_FMT_S32LE : return &S32LE_Float_AVX2;
+    case AE_FMT_S32BE : return &S32BE_Float_AVX2;
+    default:
+      return NULL;
+  }
+}
+
+CAEConvert::AEConvertFrFn CAEConvertSIMD::FrFloatAVX2(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+#else /* !__AVX2__ */
+
+CAEConvert::AEConvertToFn CAEConvertSIMD::ToFloatAVX2(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+CAEConvert::AEConvertFrFn CAEConvertSIMD::FrFloatAVX2(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEConvert.h"
+
+/**
+ * SIMD conversion kernels used by CAEConvert.
+ *
+ * Each instruction set lives in its own translation unit which is built with
+ * the matching compiler flags, the lookup functions return NULL if the unit
+ * was built without support for the instruction set or if there is no kernel
+ * for the requested format. The caller is responsible for checking the CPU
+ * features before using the result, see CAEConvert::ToFloat.
+ */
+class CAEConvertSIMD
+{
+public:
+  static CAEConvert::AEConvertToFn ToFloatSSE2 (enum AEDataFormat dataFormat);
+  static CAEConvert::AEConvertFrFn FrFloatSSE2 (enum AEDataFormat dataFormat);
+
+  static CAEConvert::AEConvertToFn ToFloatSSSE3(enum AEDataFormat dataFormat);
+  static CAEConvert::AEConvertFrFn FrFloatSSSE3(enum AEDataFormat dataFormat);
+
+  static CAEConvert::AEConvertToFn ToFloatAVX2 (enum AEDataFormat dataFormat);
+  static CAEConvert::AEConvertFrFn FrFloatAVX2 (enum AEDataFormat dataFormat);
+};
@@ -0,0 +1,407 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef __STDC_LIMIT_MACROS
+  #define __STDC_LIMIT_MACROS
+#endif
+
+#include "AEConvertSIMD.h"
+
+#include <stdint.h>
+#include <limits.h>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AE_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(AE_HAVE_SSE2) && !defined(__BIG_ENDIAN__)
+
+#ifndef INT24_MAX
+#define INT24_MAX (0x7FFFFF)
+#endif
+
+#define INT32_SCALE (-1.0f / INT_MIN)
+
+/*
+ * The kernels below must produce exactly the same output as the generic
+ * versions in AEConvert.cpp, so the tails are handled with the same
+ * expressions the generic code uses.
+ */
+
+/* swap the bytes of each 16 bit word */
+static inline __m128i bswap16(__m128i x)
+{
+  return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+/* swap the bytes of each 32 bit word */
+static inline __m128i bswap32(__m128i x)
+{
+  x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+  x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+  return bswap16(x);
+}
+
+/* sign extend 8 int16 to two vectors of 4 floats and scale them */
+static inline void s16_to_float(__m128i in, const __m128 mul, float *dest)
+{
+  __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16);
+  __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(in, in), 16);
+  _mm_storeu_ps(dest    , _mm_mul_ps(_mm_cvtepi32_ps(lo), mul));
+  _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), mul));
+}
+
+static unsigned int U8_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  mul  = 2.0f / UINT8_MAX;
+  const __m128 vmul = _mm_set_ps1(mul);
+  const __m128 vsub = _mm_set_ps1(1.0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  unsigned int i = 0;
+  for (; i + 16 <= samples; i += 16, data += 16, dest += 16)
+  {
+    __m128i in = _mm_loadu_si128((const __m128i*)data);
+    __m128i lo = _mm_unpacklo_epi8(in, zero);
+    __m128i hi = _mm_unpackhi_epi8(in, zero);
+
+    _mm_storeu_ps(dest     , _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), vmul), vsub));
+    _mm_storeu_ps(dest +  4, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), vmul), vsub));
+    _mm_storeu_ps(dest +  8, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), vmul), vsub));
+    _mm_storeu_ps(dest + 12, _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), vmul), vsub));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = *data++ * mul - 1.0f;
+
+  return samples;
+}
+
+static unsigned int S16LE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  mul  = 1.0f / (INT16_MAX + 0.5f);
+  const __m128 vmul = _mm_set_ps1(mul);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 16, dest += 8)
+    s16_to_float(_mm_loadu_si128((const __m128i*)data), vmul, dest);
+
+  for (; i < samples; ++i, data += 2)
+    *dest++ = *(int16_t*)data * mul;
+
+  return samples;
+}
+
+static unsigned int S16BE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  mul  = 1.0f / (INT16_MAX + 0.5f);
+  const __m128 vmul = _mm_set_ps1(mul);
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, data += 16, dest += 8)
+    s16_to_float(bswap16(_mm_loadu_si128((const __m128i*)data)), vmul, dest);
+
+  for (; i < samples; ++i, data += 2)
+    *dest++ = (int16_t)((data[0] << 8) | data[1]) * mul;
+
+  return samples;
+}
+
+static unsigned int S24LE4_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 vmul = _mm_set_ps1(INT32_SCALE);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_slli_epi32(_mm_loadu_si128((const __m128i*)data), 8);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int s = (data[2] << 24) | (data[1] << 16) | (data[0] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S24BE4_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  vmul = _mm_set_ps1(INT32_SCALE);
+  const __m128i mask = _mm_set1_epi32(0xFFFFFF00);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_and_si128(bswap32(_mm_loadu_si128((const __m128i*)data)), mask);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S32LE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  factor = 1.0f / (float)INT32_MAX;
+  const __m128 vmul   = _mm_set_ps1(factor);
+  int32_t *src = (int32_t*)data;
+
+  unsigned int i = 0;
+  for (; i + 8 <= samples; i += 8, src += 8, dest += 8)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)src);
+    __m128i b = _mm_loadu_si128((const __m128i*)(src + 4));
+    _mm_storeu_ps(dest    , _mm_mul_ps(_mm_cvtepi32_ps(a), vmul));
+    _mm_storeu_ps(dest + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), vmul));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = (float)*src++ * factor;
+
+  return samples;
+}
+
+static unsigned int S32BE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float  factor = 1.0f / (float)INT32_MAX;
+  const __m128 vmul   = _mm_set_ps1(factor);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = bswap32(_mm_loadu_si128((const __m128i*)data));
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int32_t s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    *dest++ = (float)s * factor;
+  }
+
+  return samples;
+}
+
+static unsigned int DOUBLE_Float_SSE2(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128 vmin = _mm_set_ps1(-1.0f);
+  const __m128 vmax = _mm_set_ps1( 1.0f);
+  double *src = (double*)data;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, src += 4, dest += 4)
+  {
+    __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src    ));
+    __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + 2));
+    __m128 in = _mm_movelh_ps(lo, hi);
+    _mm_storeu_ps(dest, _mm_min_ps(vmax, _mm_max_ps(vmin, in)));
+  }
+
+  for (; i < samples; ++i)
+    *dest++ = std::min(1.0f, std::max(-1.0f, (float)*src++));
+
+  return samples;
+}
+
+/*
+ * Round four floats to int32 the same way safeRound() in AEConvert.cpp does,
+ * half way cases are rounded towards +inf like MathUtils::round_int and the
+ * bias is added in double precision so it is exact. Positive overflow is
+ * clamped to INT32_MAX, cvttpd2dq already returns INT32_MIN for the rest.
+ */
+static inline __m128i round_pd(__m128d in)
+{
+  const __m128d up    = _mm_set1_pd(0.5);
+  const __m128d down  = _mm_set1_pd(-(double)0.4999999f);
+  const __m128d limit = _mm_set1_pd(2147483648.0);
+
+  __m128d pos  = _mm_cmpgt_pd(in, _mm_setzero_pd());
+  __m128d bias = _mm_or_pd(_mm_and_pd(pos, up), _mm_andnot_pd(pos, down));
+  __m128i ret  = _mm_cvttpd_epi32(_mm_add_pd(in, bias));
+  __m128i over = _mm_shuffle_epi32(_mm_castpd_si128(_mm_cmpge_pd(in, limit)), _MM_SHUFFLE(3, 3, 2, 0));
+  return _mm_xor_si128(ret, over);
+}
+
+static inline __m128i round_ps(__m128 in)
+{
+  __m128i lo = round_pd(_mm_cvtps_pd(in));
+  __m128i hi = round_pd(_mm_cvtps_pd(_mm_movehl_ps(in, in)));
+  return _mm_unpacklo_epi64(lo, hi);
+}
+
+static inline int32_t round_ss(float in)
+{
+  return _mm_cvtsi128_si32(round_pd(_mm_set_sd(in)));
+}
+
+static unsigned int Float_S24NE4_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const float   mul   = (float)INT24_MAX + .5f;
+  const __m128  vmul  = _mm_set_ps1(mul);
+  const __m128i vmask = _mm_set1_epi32(0xFFFFFF);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dst += 4)
+  {
+    __m128i con = _mm_and_si128(round_ps(_mm_mul_ps(_mm_loadu_ps(data), vmul)), vmask);
+    _mm_storeu_si128((__m128i*)dst, _mm_slli_epi32(con, 8));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = (round_ss(*data++ * mul) & 0xFFFFFF) << 8;
+
+  return samples << 2;
+}
+
+static unsigned int Float_S24NE3_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const float  mul  = (float)INT24_MAX + .5f;
+  const __m128 vmul = _mm_set_ps1(mul);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4)
+  {
+    int32_t con[4];
+    _mm_storeu_si128((__m128i*)con, round_ps(_mm_mul_ps(_mm_loadu_ps(data), vmul)));
+    for (int j = 0; j < 4; ++j, dest += 3)
+    {
+      dest[0] = con[j]      ;
+      dest[1] = con[j] >>  8;
+      dest[2] = con[j] >> 16;
+    }
+  }
+
+  for (; i < samples; ++i, dest += 3)
+  {
+    int32_t con = round_ss(*data++ * mul);
+    dest[0] = con      ;
+    dest[1] = con >>  8;
+    dest[2] = con >> 16;
+  }
+
+  return samples * 3;
+}
+
+static unsigned int Float_S32LE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dst += 4)
+    _mm_storeu_si128((__m128i*)dst, round_ps(_mm_mul_ps(_mm_loadu_ps(data), mul)));
+
+  for (; i < samples; ++i)
+    *dst++ = round_ss(*data++ * (float)INT32_MAX);
+
+  return samples << 2;
+}
+
+static unsigned int Float_S32BE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  const __m128 mul = _mm_set_ps1((float)INT32_MAX);
+  int32_t *dst = (int32_t*)dest;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dst += 4)
+    _mm_storeu_si128((__m128i*)dst, bswap32(round_ps(_mm_mul_ps(_mm_loadu_ps(data), mul))));
+
+  for (; i < samples; ++i)
+    *dst++ = _mm_cvtsi128_si32(bswap32(_mm_cvtsi32_si128(round_ss(*data++ * (float)INT32_MAX))));
+
+  return samples << 2;
+}
+
+static unsigned int Float_DOUBLE_SSE2(float *data, const unsigned int samples, uint8_t *dest)
+{
+  double *dst = (double*)dest;
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 4, dst += 4)
+  {
+    __m128 in = _mm_loadu_ps(data);
+    _mm_storeu_pd(dst    , _mm_cvtps_pd(in));
+    _mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(in, in)));
+  }
+
+  for (; i < samples; ++i)
+    *dst++ = *data++;
+
+  return samples * sizeof(double);
+}
+
+CAEConvert::AEConvertToFn CAEConvertSIMD::ToFloatSSE2(enum AEDataFormat dataFormat)
+{
+  switch (dataFormat)
+  {
+    case AE_FMT_U8    : return &U8_Float_SSE2;
+    case AE_FMT_S16NE :
+    case AE_FMT_S16LE : return &S16LE_Float_SSE2;
+    case AE_FMT_S16BE : return &S16BE_Float_SSE2;
+    case AE_FMT_S24NE4:
+    case AE_FMT_S24LE4: return &S24LE4_Float_SSE2;
+    case AE_FMT_S24BE4: return &S24BE4_Float_SSE2;
+    case AE_FMT_S32NE :
+    case AE_FMT_S32LE : return &S32LE_Float_SSE2;
+    case AE_FMT_S32BE : return &S32BE_Float_SSE2;
+    case AE_FMT_DOUBLE: return &DOUBLE_Float_SSE2;
+    default:
+      return NULL;
+  }
+}
+
+CAEConvert::AEConvertFrFn CAEConvertSIMD::FrFloatSSE2(enum AEDataFormat dataFormat)
+{
+  switch (dataFormat)
+  {
+    case AE_FMT_S24NE4: return &Float_S24NE4_SSE2;
+    case AE_FMT_S24NE3: return &Float_S24NE3_SSE2;
+    case AE_FMT_S32NE :
+    case AE_FMT_S32LE : return &Float_S32LE_SSE2;
+    case AE_FMT_S32BE : return &Float_S32BE_SSE2;
+    case AE_FMT_DOUBLE: return &Float_DOUBLE_SSE2;
+    default:
+      return NULL;
+  }
+}
+
+#else /* !AE_HAVE_SSE2 */
+
+CAEConvert::AEConvertToFn CAEConvertSIMD::ToFloatSSE2(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+CAEConvert::AEConvertFrFn CAEConvertSIMD::FrFloatSSE2(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ *      Copyright (C) 2010-2012 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AEConvertSIMD.h"
+
+#include <stdint.h>
+#include <limits.h>
+
+#if defined(__SSSE3__) || defined(_MSC_VER)
+#define AE_HAVE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(AE_HAVE_SSSE3) && !defined(__BIG_ENDIAN__)
+
+#define INT32_SCALE (-1.0f / INT_MIN)
+
+/*
+ * pshufb based kernels for the formats that need byte shuffling, the rest
+ * are already as fast as they get with SSE2.
+ */
+
+static unsigned int S24BE4_Float_SSSE3(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  vmul = _mm_set_ps1(INT32_SCALE);
+  const __m128i shuf = _mm_setr_epi8(-1, 2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), shuf);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S24LE3_Float_SSSE3(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  vmul = _mm_set_ps1(INT32_SCALE);
+  const __m128i shuf = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+
+  /* each load reads 16 bytes but only consumes 12, stop early enough to
+   * never read past the end of the input */
+  unsigned int i = 0;
+  for (; i + 6 <= samples; i += 4, data += 12, dest += 4)
+  {
+    __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), shuf);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 3)
+  {
+    int s = (data[2] << 24) | (data[1] << 16) | (data[0] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S24BE3_Float_SSSE3(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const __m128  vmul = _mm_set_ps1(INT32_SCALE);
+  const __m128i shuf = _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+
+  unsigned int i = 0;
+  for (; i + 6 <= samples; i += 4, data += 12, dest += 4)
+  {
+    __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), shuf);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 3)
+  {
+    int s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8);
+    *dest++ = (float)s * INT32_SCALE;
+  }
+
+  return samples;
+}
+
+static unsigned int S32BE_Float_SSSE3(uint8_t *data, const unsigned int samples, float *dest)
+{
+  const float   factor = 1.0f / (float)INT32_MAX;
+  const __m128  vmul   = _mm_set_ps1(factor);
+  const __m128i shuf   = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+  unsigned int i = 0;
+  for (; i + 4 <= samples; i += 4, data += 16, dest += 4)
+  {
+    __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), shuf);
+    _mm_storeu_ps(dest, _mm_mul_ps(_mm_cvtepi32_ps(in), vmul));
+  }
+
+  for (; i < samples; ++i, data += 4)
+  {
+    int32_t s = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+    *dest++ = (float)s * factor;
+  }
+
+  return samples;
+}
+
+CAEConvert::AEConvertToFn CAEConvertSIMD::ToFloatSSSE3(enum AEDataFormat dataFormat)
+{
+  switch (dataFormat)
+  {
+    case AE_FMT_S24BE4: return &S24BE4_Float_SSSE3;
+    case AE_FMT_S24NE3:
+    case AE_FMT_S24LE3: return &S24LE3_Float_SSSE3;
+    case AE_FMT_S24BE3: return &S24BE3_Float_SSSE3;
+    case AE_FMT_S32BE : return &S32BE_Float_SSSE3;
+    default:
+      return NULL;
+  }
+}
+
+CAEConvert::AEConvertFrFn CAEConvertSIMD::FrFloatSSSE3(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+#else /* !AE_HAVE_SSSE3 */
+
+CAEConvert::AEConvertToFn CAEConvertSIMD::ToFloatSSSE3(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+CAEConvert::AEConvertFrFn CAEConvertSIMD::FrFloatSSSE3(enum AEDataFormat dataFormat)
+{
+  return NULL;
+}
+
+#endif
@@ -18,8 +18,13 @@
  *
  */
 #include <math.h>
+#include <string.h>
 #include <sstream>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 #include "AERemap.h"
 #include "AEFactory.h"
 #include "AEUtil.h"
@@ -28,9 +33,14 @@
 
 using namespace std;
 
-CAERemap::CAERemap() : m_inChannels(0), m_outChannels(0) 
+CAERemap::CAERemap() :
+  m_inChannels (0            ),
+  m_outChannels(0            ),
+  m_remapFn    (&RemapGeneric),
+  m_identity   (false        )
 {
   memset(m_mixInfo, 0, sizeof(m_mixInfo));
+  memset(m_matrix , 0, sizeof(m_matrix ));
 }
 
 CAERemap::~CAERemap()
@@ -87,7 +97,10 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
 
   /* the final stage does not need any down/upmix */
   if (finalStage)
+  {
+    BuildMatrix();
     return true;
+  }
 
   /* downmix from the specified channel to the specified list of channels */
   #define RM(from, ...) \
@@ -239,6 +252,7 @@ bool CAERemap::Initialize(CAEChannelInfo input, CAEChannelInfo output, bool fina
   CLog::Log(LOGINFO, "====================\n");
 #endif
 
+  BuildMatrix();
   return true;
 }
 
@@ -279,91 +293,143 @@ void CAERemap::ResolveMix(const AEChannel from, CAEChannelInfo to)
   fromInfo->in_src   = false;
 }
 
-/* This method has unrolled loop for higher performance */
-void CAERemap::Remap(float * const in, float * const out, const unsigned int frames) const
+void CAERemap::BuildMatrix()
 {
-  const unsigned int frameBlocks = frames & ~0x3;
-
+  /* flatten the mix table into a dense matrix, outputs that are not in the
+   * destination stay zero and single source outputs are a straight copy so we
+   * dont break DPL */
+  memset(m_matrix, 0, sizeof(m_matrix));
   for (int o = 0; o < m_outChannels; ++o)
   {
     const AEMixInfo *info = &m_mixInfo[m_output[o]];
     if (!info->in_dst)
-    {
-      unsigned int f = 0;
-      unsigned int odx = 0;
-      for(; f < frameBlocks; f += 4)
-      {
-        out[odx + o] = 0.0f, odx += m_outChannels;
-        out[odx + o] = 0.0f, odx += m_outChannels;
-        out[odx + o] = 0.0f, odx += m_outChannels;
-        out[odx + o] = 0.0f, odx += m_outChannels;
-      }
-
-      switch (frames & 0x3)
-      {
-        case 3: out[odx + o] = 0.0f, odx += m_outChannels;
-        case 2: out[odx + o] = 0.0f, odx += m_outChannels;
-        case 1: out[odx + o] = 0.0f;
-      }
       continue;
-    }
 
-    /* if there is only 1 source, just copy it so we dont break DPL */
     if (info->srcCount == 1)
     {
-      unsigned int f = 0;
-      unsigned int idx = 0;
-      unsigned int odx = 0;
-      unsigned int srcIndex = info->srcIndex[0].index;
-      /* the compiler has a better chance of optimizing this if it is done in parallel */
-      for (; f < frameBlocks; f += 4)
+      m_matrix[info->srcIndex[0].index * AE_REMAP_STRIDE + o] = 1.0f;
+      continue;
+    }
+
+    for (int i = 0; i < info->srcCount; ++i)
+      m_matrix[info->srcIndex[i].index * AE_REMAP_STRIDE + o] += info->srcIndex[i].level;
+  }
+
+  /* if the matrix does nothing we can just copy the samples */
+  m_identity = m_inChannels == m_outChannels;
+  for (int i = 0; i < m_inChannels && m_identity; ++i)
+    for (int o = 0; o < m_outChannels; ++o)
+      if (m_matrix[i * AE_REMAP_STRIDE + o] != (i == o ? 1.0f : 0.0f))
       {
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
+        m_identity = false;
+        break;
       }
 
-      switch (frames & 0x3)
+  /* pick a kernel with the channel counts fixed at compile time for the
+   * common layouts so the inner loops get fully unrolled */
+  #define RF(inCh, outCh) \
+    if (m_inChannels == inCh && m_outChannels == outCh) \
+      m_remapFn = &RemapFixed<inCh, outCh>; \
+    else
+
+  RF(2, 2) RF(2, 6) RF(2, 8)
+  RF(6, 2) RF(6, 6) RF(6, 8)
+  RF(8, 2) RF(8, 6) RF(8, 8)
+    m_remapFn = &RemapGeneric;
+
+  #undef RF
+}
+
+#ifdef __SSE__
+static inline void StorePartial(float *out, const __m128 value, const int count)
+{
+  switch (count)
+  {
+    case 3: _mm_store_ss(out + 2, _mm_movehl_ps(value, value));
+    case 2: _mm_storel_pi((__m64*)out, value); break;
+    case 1: _mm_store_ss(out, value); break;
+  }
+}
+#endif
+
+/*
+ * Each frame is a matrix * vector product, every input sample is broadcast
+ * and multiplied into its matrix column which is accumulated into the output
+ * frame. When called with constant channel counts the compiler unrolls all the
+ * inner loops and keeps the accumulators in registers.
+ */
+static inline void RemapKernel(const float *matrix, const float *in, float *out, const unsigned int frames, const int inChannels, const int outChannels)
+{
+#ifdef __SSE__
+  const int blocks = outChannels >> 2;
+  const int rest   = outChannels & 0x3;
+
+  for (unsigned int f = 0; f < frames; ++f, in += inChannels, out += outChannels)
+  {
+    for (int b = 0; b < blocks + (rest ? 1 : 0); ++b)
+    {
+      /* two accumulators to halve the add dependency chain */
+      const float *column = matrix + (b << 2);
+      __m128 acc1 = _mm_setzero_ps();
+      __m128 acc2 = _mm_setzero_ps();
+      int i = 0;
+      for (; i + 1 < inChannels; i += 2, column += AE_REMAP_STRIDE * 2)
       {
-        case 3: out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        case 2: out[odx + o] = in[idx + srcIndex], idx += m_inChannels, odx += m_outChannels;
-        case 1: out[odx + o] = in[idx + srcIndex];
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_load1_ps(in + i    ), _mm_loadu_ps(column                  )));
+        acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_load1_ps(in + i + 1), _mm_loadu_ps(column + AE_REMAP_STRIDE)));
       }
+      if (i < inChannels)
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_load1_ps(in + i), _mm_loadu_ps(column)));
+      const __m128 acc = _mm_add_ps(acc1, acc2);
+
+      if (b < blocks)
+        _mm_storeu_ps(out + (b << 2), acc);
+      else
+        StorePartial(out + (b << 2), acc, rest);
     }
-    else
+  }
+#else
+  float acc[AE_REMAP_STRIDE];
+
+  for (unsigned int f = 0; f < frames; ++f, in += inChannels, out += outChannels)
+  {
+    for (int o = 0; o < outChannels; ++o)
+      acc[o] = 0.0f;
+
+    for (int i = 0; i < inChannels; ++i)
     {
-      for (unsigned int f = 0; f < frames; ++f)
-      {
-        float *outOffset = out + (f * m_outChannels) + o;
-        float *inOffset  = in  + (f * m_inChannels);
-        *outOffset = 0.0f;
+      const float  sample = in[i];
+      const float *column = matrix + i * AE_REMAP_STRIDE;
+      for (int o = 0; o < outChannels; ++o)
+        acc[o] += sample * column[o];
+    }
 
-        int blocks = info->srcCount & ~0x3;
+    for (int o = 0; o < outChannels; ++o)
+      out[o] = acc[o];
+  }
+#endif
+}
 
-        /* the compiler has a better chance of optimizing this if it is done in parallel */
-        int i = 0;
-        float f1 = 0.0, f2 = 0.0, f3 = 0.0, f4 = 0.0;
-        for (; i < blocks; i += 4)
-        {
-          f1 += inOffset[info->srcIndex[i].index] * info->srcIndex[i].level;
-          f2 += inOffset[info->srcIndex[i+1].index] * info->srcIndex[i+1].level;
-          f3 += inOffset[info->srcIndex[i+2].index] * info->srcIndex[i+2].level;
-          f4 += inOffset[info->srcIndex[i+3].index] * info->srcIndex[i+3].level;
-        }
+void CAERemap::RemapGeneric(const float *matrix, const float *in, float *out, const unsigned int frames, const int inChannels, const int outChannels)
+{
+  RemapKernel(matrix, in, out, frames, inChannels, outChannels);
+}
 
-        /* unrolled loop for higher performance */
-        switch (info->srcCount & 0x3)
-        {
-          case 3: f3 += inOffset[info->srcIndex[i+2].index] * info->srcIndex[i+2].level;
-          case 2: f2 += inOffset[info->srcIndex[i+1].index] * info->srcIndex[i+1].level;
-          case 1: f1 += inOffset[info->srcIndex[i].index] * info->srcIndex[i].level;
-        }
+template<int IN_CH, int OUT_CH>
+void CAERemap::RemapFixed(const float *matrix, const float *in, float *out, const unsigned int frames, const int inChannels, const int outChannels)
+{
+  RemapKernel(matrix, in, out, frames, IN_CH, OUT_CH);
+}
 
-        *outOffset += (f1+f2+f3+f4);
-      }
-    }
+void CAERemap::Remap(float * const in, float * const out, const unsigned int frames) const
+{
+  if (m_identity)
+  {
+    memcpy(out, in, frames * m_outChannels * sizeof(float));
+    return;
   }
+
+  m_remapFn(m_matrix, in, out, frames, m_inChannels, m_outChannels);
 }
 
 inline void CAERemap::BuildUpmixMatrix(const CAEChannelInfo& input, const CAEChannelInfo& output)
@@ -21,6 +21,9 @@
 
 #include "AEAudioFormat.h"
 
+/* stride of a matrix column, padded so each column can be loaded in SSE blocks */
+#define AE_REMAP_STRIDE ((AE_CH_MAX + 3) & ~0x3)
+
 class CAERemap {
 public:
   CAERemap();
@@ -29,6 +32,14 @@ public:
   bool Initialize(CAEChannelInfo input, CAEChannelInfo output, bool finalStage, bool forceNormalize = false, enum AEStdChLayout stdChLayout = AE_CH_LAYOUT_INVALID);
   void Remap(float * const in, float * const out, const unsigned int frames) const;
 
+  /**
+   * Returns the level input channel "in" is mixed into output channel "out"
+   * with, this is the compiled matrix used by Remap
+   */
+  float GetMixLevel(const unsigned int out, const unsigned int in) const { return m_matrix[in * AE_REMAP_STRIDE + out]; }
+  unsigned int GetInChannels () const { return m_inChannels;  }
+  unsigned int GetOutChannels() const { return m_outChannels; }
+
 private:
   typedef struct {
     int       index;
@@ -44,12 +55,24 @@ private:
     int               cpyCount; /* the number of times the channel has been cloned */
   } AEMixInfo;
 
+  typedef void (*RemapFn)(const float *matrix, const float *in, float *out, const unsigned int frames, const int inChannels, const int outChannels);
+
   AEMixInfo      m_mixInfo[AE_CH_MAX+1];
   CAEChannelInfo m_output;
   int            m_inChannels;
   int            m_outChannels;
 
+  /* the mix table compiled into a dense column major matrix, column "i" holds
+   * the levels input channel "i" is mixed into each output channel with */
+  float          m_matrix[AE_CH_MAX * AE_REMAP_STRIDE];
+  RemapFn        m_remapFn;
+  bool           m_identity;
+
   void ResolveMix(const AEChannel from, CAEChannelInfo to);
   void BuildUpmixMatrix(const CAEChannelInfo& input, const CAEChannelInfo& output);
-};
+  void BuildMatrix();
 
+  static void RemapGeneric(const float *matrix, const float *in, float *out, const unsigned int frames, const int inChannels, const int outChannels);
+  template<int IN_CH, int OUT_CH>
+  static void RemapFixed  (const float *matrix, const float *in, float *out, const unsigned int frames, const int inChannels, const int outChannels);
+};
@@ -26,7 +26,9 @@
 
 //#define AE_RING_BUFFER_DEBUG
 
+#include "system.h"     //_aligned_malloc
 #include "utils/log.h"  //CLog
+#include "threads/Atomics.h" //AtomicAdd, cas
 #include <string.h>     //memset, memcpy
 
 /**
@@ -251,3 +253,171 @@ private:
   unsigned int m_iSize;
   unsigned char *m_Buffer;
 };
+
+/**
+ * A ring of preallocated slots that can be used by one producer and one
+ * consumer thread at the same time without any locking.
+ * The producer fills the slot returned by GetWriteSlot() and publishes it with
+ * Commit(), the consumer uses the slot returned by GetReadSlot() and hands it
+ * back with Release(). As the slots are reused nothing is allocated after
+ * Create().
+ * Create() and Reset() are not thread-safe, please use Locks.
+ */
+template <typename T>
+class AESlotRing {
+
+public:
+  AESlotRing() :
+    m_iRead(0),
+    m_iWritten(0),
+    m_iSize(0),
+    m_Slots(NULL)
+  {
+  }
+
+  ~AESlotRing()
+  {
+    delete[] m_Slots;
+  }
+
+  /**
+   * Allocates the slots and resets the positions.
+   *
+   * @return true on success, false otherwise
+   */
+  bool Create(unsigned int size)
+  {
+    delete[] m_Slots;
+    m_Slots = size ? new T[size] : NULL;
+    m_iSize = size;
+    Reset();
+    return m_Slots != NULL;
+  }
+
+  /**
+   * Empties the ring, the slots themselves are left as they are.
+   * This method is not thread-safe.
+   */
+  void Reset()
+  {
+    m_iRead    = 0;
+    m_iWritten = 0;
+  }
+
+  /**
+   * Producer side, returns the next free slot or NULL if the ring is full.
+   * The slot is not visible to the consumer until Commit() is called.
+   */
+  T* GetWriteSlot()
+  {
+    if (GetWriteSize() == 0)
+      return NULL;
+    return &m_Slots[m_iWritten % m_iSize];
+  }
+
+  /**
+   * Producer side, publishes the slot returned by GetWriteSlot().
+   */
+  void Commit()
+  {
+    Advance(&m_iWritten);
+  }
+
+  /**
+   * Consumer side, returns the oldest published slot or NULL if the ring is
+   * empty. The slot stays owned by the consumer until Release() is called.
+   */
+  T* GetReadSlot()
+  {
+    if (GetReadSize() == 0)
+      return NULL;
+    return &m_Slots[m_iRead % m_iSize];
+  }
+
+  /**
+   * Consumer side, hands the slot returned by GetReadSlot() back to the producer.
+   */
+  void Release()
+  {
+    Advance(&m_iRead);
+  }
+
+  /**
+   * Returns the number of published slots.
+   */
+  unsigned int GetReadSize()
+  {
+    return Distance(Load(&m_iRead), Load(&m_iWritten));
+  }
+
+  /**
+   * Returns the number of free slots.
+   */
+  unsigned int GetWriteSize()
+  {
+    return m_iSize - GetReadSize();
+  }
+
+  /**
+   * Returns the positions, these wrap at twice the number of slots so a
+   * position can be compared to another one with GetDistance().
+   */
+  long GetReadPos () { return Load(&m_iRead   ); }
+  long GetWritePos() { return Load(&m_iWritten); }
+
+  /**
+   * Returns how many slots "to" is ahead of "from".
+   */
+  unsigned int GetDistance(long from, long to)
+  {
+    return Distance(from, to);
+  }
+
+  /**
+   * Returns the number of slots.
+   */
+  unsigned int GetMaxSize()
+  {
+    return m_iSize;
+  }
+
+  /**
+   * Returns a slot by index, for setting up the slots after Create().
+   */
+  T* GetSlot(unsigned int index)
+  {
+    return &m_Slots[index];
+  }
+
+private:
+  /* positions run over [0, 2 * size) so a full ring can be told from an empty one */
+  unsigned int Distance(long from, long to)
+  {
+    long distance = to - from;
+    if (distance < 0)
+      distance += 2 * (long)m_iSize;
+    return (unsigned int)distance;
+  }
+
+  /* AtomicAdd acts as a full barrier, this is a load with acquire semantics */
+  static long Load(volatile long *pos)
+  {
+    return AtomicAdd(pos, 0);
+  }
+
+  /* only one thread ever advances each position, so the cas can not fail,
+   * it is used for the barrier so the slot contents are visible first */
+  void Advance(volatile long *pos)
+  {
+    long current = *pos;
+    long next    = current + 1;
+    if (next == (long)(2 * m_iSize))
+      next = 0;
+    cas(pos, current, next);
+  }
+
+  volatile long m_iRead;
+  volatile long m_iWritten;
+  unsigned int  m_iSize;
+  T            *m_Slots;
+};
@@ -25,6 +25,7 @@
 #include "AEUtil.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "threads/Atomics.h"
 
 using namespace std;
 
@@ -35,6 +36,8 @@ unsigned int CAEUtil::m_seed = (unsigned int)(CurrentHostCounter() / 1000.0f);
   MEMALIGN(16, __m128i CAEUtil::m_sseSeed) = _mm_set_epi32(CAEUtil::m_seed, CAEUtil::m_seed+1, CAEUtil::m_seed, CAEUtil::m_seed+1);
 #endif
 
+volatile long CAEUtil::m_rawCopied = 0;
+
 CAEChannelInfo CAEUtil::GuessChLayout(const unsigned int channels)
 {
   CLog::Log(LOGWARNING, "CAEUtil::GuessChLayout - This method should really never be used, please fix the code that called this");
@@ -471,3 +474,13 @@ bool CAEUtil::S16NeedsByteSwap(AEDataFormat in, AEDataFormat out)
 
   return in != out;
 }
+
+void CAEUtil::CountRawCopy(unsigned int bytes)
+{
+  AtomicAdd(&m_rawCopied, (long)bytes);
+}
+
+unsigned long CAEUtil::GetRawCopied()
+{
+  return (unsigned long)AtomicAdd(&m_rawCopied, 0);
+}
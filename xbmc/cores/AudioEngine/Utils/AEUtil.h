@@ -52,6 +52,8 @@ private:
 
   static float SoftClamp(const float x);
 
+  static volatile long m_rawCopied;
+
 public:
   static CAEChannelInfo          GuessChLayout     (const unsigned int channels);
   static const char*             GetStdChLayoutName(const enum AEStdChLayout layout);
@@ -97,4 +99,13 @@ public:
   static void  FloatRand4(const float min, const float max, float result[4], __m128 *sseresult = NULL);
 
   static bool S16NeedsByteSwap(AEDataFormat in, AEDataFormat out);
+
+  /*! \brief account for bytes copied on the passthrough path
+   Lets the profiler sink report how much copying it takes to deliver a
+   bitstream, the counter wraps so only differences are meaningful.
+   \param bytes the number of bytes that were copied
+   \sa GetRawCopied
+   */
+  static void          CountRawCopy(unsigned int bytes);
+  static unsigned long GetRawCopied();
 };
@@ -0,0 +1,36 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "test/TestUtils.h"
+
+#include <stdlib.h>
+#include <vector>
+
+/* random samples in [-1, 1], starting with the extremes and silence */
+inline void FillRandomSamples(std::vector<float> &buffer)
+{
+  for (size_t i = 0; i < buffer.size(); ++i)
+    buffer[i] = (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+
+  const float extremes[] = { 1.0f, -1.0f, 0.0f };
+  for (size_t i = 0; i < buffer.size() && i < XBMC_ARRAY_SIZE(extremes); ++i)
+    buffer[i] = extremes[i];
+}
@@ -0,0 +1,194 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AETestUtils.h"
+#include "cores/AudioEngine/Utils/AEConvert.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+#include "utils/CPUInfo.h"
+#include "utils/Stopwatch.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* odd sized so every kernel has to run its tail code */
+#define TEST_SAMPLES 1027
+/* offsets to check the kernels handle unaligned buffers */
+#define TEST_OFFSETS 4
+
+static const enum AEDataFormat toFloatFormats[] =
+{
+  AE_FMT_U8,
+  AE_FMT_S16LE, AE_FMT_S16BE,
+  AE_FMT_S24LE4, AE_FMT_S24BE4,
+  AE_FMT_S24LE3, AE_FMT_S24BE3,
+  AE_FMT_S32LE, AE_FMT_S32BE,
+  AE_FMT_DOUBLE
+};
+
+static const enum AEDataFormat frFloatFormats[] =
+{
+  AE_FMT_S24NE4, AE_FMT_S24NE3,
+  AE_FMT_S32LE, AE_FMT_S32BE,
+  AE_FMT_DOUBLE
+};
+
+/* each tier also enables the ones below it, like a real CPU would */
+static const struct
+{
+  const char   *name;
+  unsigned int  feature;
+  unsigned int  mask;
+} simdTiers[] =
+{
+  { "SSE2" , CPU_FEATURE_SSE2 , CPU_FEATURE_SSE2                                       },
+  { "SSSE3", CPU_FEATURE_SSSE3, CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3                    },
+  { "AVX2" , CPU_FEATURE_AVX2 , CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_AVX2 }
+};
+
+static unsigned int BytesPerSample(enum AEDataFormat format)
+{
+  return CAEUtil::DataFormatToBits(format) >> 3;
+}
+
+static void FillRandom(std::vector<uint8_t> &buffer, enum AEDataFormat format)
+{
+  if (format == AE_FMT_DOUBLE)
+  {
+    double *d = (double*)&buffer[0];
+    for (size_t i = 0; i < buffer.size() / sizeof(double); ++i)
+      d[i] = (rand() / (double)RAND_MAX) * 2.2 - 1.1;
+    return;
+  }
+
+  for (size_t i = 0; i < buffer.size(); ++i)
+    buffer[i] = rand() & 0xFF;
+}
+
+TEST(TestAEConvert, ToFloatMatchesGeneric)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+
+  for (size_t f = 0; f < XBMC_ARRAY_SIZE(toFloatFormats); ++f)
+  {
+    const enum AEDataFormat format = toFloatFormats[f];
+    const unsigned int bytes = BytesPerSample(format);
+
+    CAEConvert::AEConvertToFn generic = CAEConvert::ToFloat(format, 0);
+    ASSERT_TRUE(generic != NULL) << CAEUtil::DataFormatToStr(format);
+
+    for (size_t t = 0; t < XBMC_ARRAY_SIZE(simdTiers); ++t)
+    {
+      if (!(cpuFeatures & simdTiers[t].feature))
+        continue;
+
+      CAEConvert::AEConvertToFn simd = CAEConvert::ToFloat(format, cpuFeatures & simdTiers[t].mask);
+      for (unsigned int offset = 0; offset < TEST_OFFSETS; ++offset)
+      {
+        std::vector<uint8_t> in((TEST_SAMPLES + offset) * bytes);
+        FillRandom(in, format);
+
+        const unsigned int samples = TEST_SAMPLES - offset;
+        std::vector<float> ref(samples), out(samples);
+        EXPECT_EQ(samples, generic(&in[offset * bytes], samples, &ref[0]));
+        EXPECT_EQ(samples, simd   (&in[offset * bytes], samples, &out[0]));
+        EXPECT_EQ(0, memcmp(&ref[0], &out[0], samples * sizeof(float)))
+          << CAEUtil::DataFormatToStr(format) << " " << simdTiers[t].name
+          << " offset " << offset;
+      }
+    }
+  }
+}
+
+TEST(TestAEConvert, FrFloatMatchesGeneric)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+
+  for (size_t f = 0; f < XBMC_ARRAY_SIZE(frFloatFormats); ++f)
+  {
+    const enum AEDataFormat format = frFloatFormats[f];
+    const unsigned int bytes = BytesPerSample(format);
+
+    CAEConvert::AEConvertFrFn generic = CAEConvert::FrFloat(format, 0);
+    ASSERT_TRUE(generic != NULL) << CAEUtil::DataFormatToStr(format);
+
+    for (size_t t = 0; t < XBMC_ARRAY_SIZE(simdTiers); ++t)
+    {
+      if (!(cpuFeatures & simdTiers[t].feature))
+        continue;
+
+      CAEConvert::AEConvertFrFn simd = CAEConvert::FrFloat(format, cpuFeatures & simdTiers[t].mask);
+      for (unsigned int offset = 0; offset < TEST_OFFSETS; ++offset)
+      {
+        std::vector<float> in(TEST_SAMPLES);
+        FillRandomSamples(in);
+
+        /* one spare sample as the generic S24NE3 code writes 4 bytes at a time */
+        const unsigned int samples = TEST_SAMPLES - offset;
+        std::vector<uint8_t> ref((samples + 1) * bytes), out((samples + 1) * bytes);
+        EXPECT_EQ(samples * bytes, generic(&in[offset], samples, &ref[0]));
+        EXPECT_EQ(samples * bytes, simd   (&in[offset], samples, &out[0]));
+        EXPECT_EQ(0, memcmp(&ref[0], &out[0], samples * bytes))
+          << CAEUtil::DataFormatToStr(format) << " " << simdTiers[t].name
+          << " offset " << offset;
+      }
+    }
+  }
+}
+
+TEST(TestAEConvert, Throughput)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+  const unsigned int samples     = 8 * 48000;
+  const int          iterations  = 20;
+
+  std::vector<float> fbuf(samples);
+  for (size_t f = 0; f < XBMC_ARRAY_SIZE(toFloatFormats); ++f)
+  {
+    const enum AEDataFormat format = toFloatFormats[f];
+    std::vector<uint8_t> buf(samples * BytesPerSample(format));
+    FillRandom(buf, format);
+
+    std::cout << CAEUtil::DataFormatToStr(format) << " ToFloat Msamples/s:";
+    for (int t = -1; t < (int)XBMC_ARRAY_SIZE(simdTiers); ++t)
+    {
+      unsigned int features = 0;
+      if (t >= 0)
+      {
+        if (!(cpuFeatures & simdTiers[t].feature))
+          continue;
+        features = cpuFeatures & simdTiers[t].mask;
+      }
+
+      CAEConvert::AEConvertToFn fn = CAEConvert::ToFloat(format, features);
+      CStopWatch watch;
+      watch.StartZero();
+      for (int i = 0; i < iterations; ++i)
+        fn(&buf[0], samples, &fbuf[0]);
+      float elapsed = watch.GetElapsedSeconds();
+
+      std::cout << " " << (t < 0 ? "C" : simdTiers[t].name) << "="
+                << testing::PrintToString(XBMC_MILLIONS_PER_SECOND(samples * iterations, elapsed));
+    }
+    std::cout << "\n";
+  }
+}
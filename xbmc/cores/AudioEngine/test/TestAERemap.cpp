@@ -0,0 +1,261 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AETestUtils.h"
+#include "cores/AudioEngine/Utils/AERemap.h"
+#include "cores/AudioEngine/Utils/AEChannelInfo.h"
+#include "utils/Stopwatch.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* odd sized so the fixed kernels dont only see nicely sized blocks */
+#define TEST_FRAMES 1023
+
+static const struct
+{
+  const char          *name;
+  enum AEStdChLayout   layout;
+} testLayouts[] =
+{
+  { "2.0", AE_CH_LAYOUT_2_0 },
+  { "2.1", AE_CH_LAYOUT_2_1 },
+  { "5.1", AE_CH_LAYOUT_5_1 },
+  { "7.1", AE_CH_LAYOUT_7_1 }
+};
+
+/*
+ * Normalized downmix levels as the sparse mix table worked them out before it
+ * was compiled into a matrix. Each dropped channel is split evenly in power
+ * (1/sqrt(n)) over the channels it resolves to, levels that meet are combined
+ * as (a + b) / sqrt(n + 1), then every output is scaled by the loudest sum.
+ * Outputs with a single source are copied as is. Rows are outputs in the
+ * order of the output layout, columns are inputs.
+ *
+ *   2.1 -> 2.0: FL = FL + LFE/sqrt(2),                        a = 1 / (1 + 1/sqrt(2))
+ *   5.1 -> 2.0: FL = FL + BL + (FC + LFE)/sqrt(2),            b = 1 / (2 + sqrt(2))
+ *   7.1 -> 2.0: FL = FL + BL + SL + (FC + LFE)/sqrt(2),       c = 1 / (3 + sqrt(2))
+ *   7.1 -> 5.1: FL = FL + SL/sqrt(2), BL = BL + SL/sqrt(2),   a as above
+ */
+#define LVL_A  0.5857864f /* a             */
+#define LVL_AS 0.4142136f /* a / sqrt(2)   */
+#define LVL_B  0.2928932f /* b             */
+#define LVL_BS 0.2071068f /* b / sqrt(2)   */
+#define LVL_C  0.2265409f /* c             */
+#define LVL_CS 0.1601886f /* c / sqrt(2)   */
+
+static const struct
+{
+  enum AEStdChLayout  input;
+  enum AEStdChLayout  output;
+  float               levels[8][8];
+} knownMixes[] =
+{
+  { AE_CH_LAYOUT_2_1, AE_CH_LAYOUT_2_0, {
+    /*       FL     FR     LFE   */
+    /* FL */ { LVL_A, 0    , LVL_AS },
+    /* FR */ { 0    , LVL_A, LVL_AS } } },
+  { AE_CH_LAYOUT_5_1, AE_CH_LAYOUT_2_0, {
+    /*       FL     FR     FC      BL     BR     LFE   */
+    /* FL */ { LVL_B, 0    , LVL_BS, LVL_B, 0    , LVL_BS },
+    /* FR */ { 0    , LVL_B, LVL_BS, 0    , LVL_B, LVL_BS } } },
+  { AE_CH_LAYOUT_7_1, AE_CH_LAYOUT_2_0, {
+    /*       FL     FR     FC      BL     BR     SL     SR     LFE   */
+    /* FL */ { LVL_C, 0    , LVL_CS, LVL_C, 0    , LVL_C, 0    , LVL_CS },
+    /* FR */ { 0    , LVL_C, LVL_CS, 0    , LVL_C, 0    , LVL_C, LVL_CS } } },
+  { AE_CH_LAYOUT_7_1, AE_CH_LAYOUT_5_1, {
+    /*        FL     FR     FC  BL     BR     SL      SR      LFE */
+    /* FL  */ { LVL_A, 0    , 0 , 0    , 0    , LVL_AS, 0     , 0 },
+    /* FR  */ { 0    , LVL_A, 0 , 0    , 0    , 0     , LVL_AS, 0 },
+    /* FC  */ { 0    , 0    , 1 , 0    , 0    , 0     , 0     , 0 },
+    /* BL  */ { 0    , 0    , 0 , LVL_A, 0    , LVL_AS, 0     , 0 },
+    /* BR  */ { 0    , 0    , 0 , 0    , LVL_A, 0     , LVL_AS, 0 },
+    /* LFE */ { 0    , 0    , 0 , 0    , 0    , 0     , 0     , 1 } } },
+  { AE_CH_LAYOUT_2_0, AE_CH_LAYOUT_5_1, {
+    /*        FL FR */
+    /* FL  */ { 1, 0 },
+    /* FR  */ { 0, 1 } } }
+};
+
+/*
+ * A sparse list of (input, level) pairs per output channel, the way the remap
+ * was done before the matrix was made dense. Used as the reference for the
+ * kernels and as the baseline for the throughput numbers.
+ */
+class CSparseRemap
+{
+public:
+  CSparseRemap(unsigned int inChannels, unsigned int outChannels, const float levels[8][8]) :
+    m_inChannels (inChannels ),
+    m_outChannels(outChannels),
+    m_sources    (outChannels)
+  {
+    for (unsigned int o = 0; o < m_outChannels; ++o)
+      for (unsigned int i = 0; i < m_inChannels; ++i)
+        if (levels[o][i] != 0.0f)
+          m_sources[o].push_back(std::make_pair(i, levels[o][i]));
+  }
+
+  void Remap(const float *in, float *out, const unsigned int frames) const
+  {
+    for (unsigned int o = 0; o < m_outChannels; ++o)
+    {
+      const std::vector<std::pair<unsigned int, float> > &src = m_sources[o];
+      for (unsigned int f = 0; f < frames; ++f)
+      {
+        const float *inOffset = in + f * m_inChannels;
+        float sum = 0.0f;
+        for (size_t i = 0; i < src.size(); ++i)
+          sum += inOffset[src[i].first] * src[i].second;
+        out[f * m_outChannels + o] = sum;
+      }
+    }
+  }
+
+private:
+  unsigned int m_inChannels;
+  unsigned int m_outChannels;
+  std::vector<std::vector<std::pair<unsigned int, float> > > m_sources;
+};
+
+TEST(TestAERemap, IdentityIsExact)
+{
+  for (size_t l = 0; l < XBMC_ARRAY_SIZE(testLayouts); ++l)
+  {
+    CAEChannelInfo layout(testLayouts[l].layout);
+    CAERemap remap;
+    ASSERT_TRUE(remap.Initialize(layout, layout, true));
+
+    std::vector<float> in(TEST_FRAMES * layout.Count()), out(in.size());
+    FillRandomSamples(in);
+    remap.Remap(&in[0], &out[0], TEST_FRAMES);
+    EXPECT_EQ(0, memcmp(&in[0], &out[0], in.size() * sizeof(float))) << testLayouts[l].name;
+  }
+}
+
+TEST(TestAERemap, FinalStageCopiesAndSilences)
+{
+  /* stereo into 5.1 on the final stage, FL/FR pass and the rest are silent */
+  CAEChannelInfo input (AE_CH_LAYOUT_2_0);
+  CAEChannelInfo output(AE_CH_LAYOUT_5_1);
+  CAERemap remap;
+  ASSERT_TRUE(remap.Initialize(input, output, true));
+
+  std::vector<float> in(TEST_FRAMES * input.Count()), out(TEST_FRAMES * output.Count(), 1.0f);
+  FillRandomSamples(in);
+  remap.Remap(&in[0], &out[0], TEST_FRAMES);
+
+  for (unsigned int f = 0; f < TEST_FRAMES; ++f)
+    for (unsigned int o = 0; o < output.Count(); ++o)
+    {
+      float expected = 0.0f;
+      for (unsigned int i = 0; i < input.Count(); ++i)
+        if (input[i] == output[o])
+          expected = in[f * input.Count() + i];
+      ASSERT_EQ(expected, out[f * output.Count() + o]) << "frame " << f << " channel " << o;
+    }
+}
+
+TEST(TestAERemap, KnownMixLevels)
+{
+  for (size_t m = 0; m < XBMC_ARRAY_SIZE(knownMixes); ++m)
+  {
+    CAEChannelInfo input (knownMixes[m].input );
+    CAEChannelInfo output(knownMixes[m].output);
+    CAERemap remap;
+    ASSERT_TRUE(remap.Initialize(input, output, false, true));
+    ASSERT_EQ(input .Count(), remap.GetInChannels ());
+    ASSERT_EQ(output.Count(), remap.GetOutChannels());
+
+    for (unsigned int o = 0; o < output.Count(); ++o)
+      for (unsigned int i = 0; i < input.Count(); ++i)
+        EXPECT_NEAR(knownMixes[m].levels[o][i], remap.GetMixLevel(o, i), 1e-6f)
+          << (std::string)input << " -> " << (std::string)output
+          << " " << CAEChannelInfo::GetChName(output[o]) << " from " << CAEChannelInfo::GetChName(input[i]);
+  }
+}
+
+TEST(TestAERemap, MatchesSparse)
+{
+  for (size_t m = 0; m < XBMC_ARRAY_SIZE(knownMixes); ++m)
+  {
+    CAEChannelInfo input (knownMixes[m].input );
+    CAEChannelInfo output(knownMixes[m].output);
+    CAERemap remap;
+    ASSERT_TRUE(remap.Initialize(input, output, false, true));
+    CSparseRemap sparse(input.Count(), output.Count(), knownMixes[m].levels);
+
+    std::vector<float> in(TEST_FRAMES * input.Count());
+    std::vector<float> ref(TEST_FRAMES * output.Count()), out(ref.size());
+    FillRandomSamples(in);
+
+    sparse.Remap(&in[0], &ref[0], TEST_FRAMES);
+    remap .Remap(&in[0], &out[0], TEST_FRAMES);
+
+    /* the summation order differs so allow for rounding */
+    for (size_t s = 0; s < ref.size(); ++s)
+      ASSERT_NEAR(ref[s], out[s], 1e-5f)
+        << (std::string)input << " -> " << (std::string)output << " sample " << s;
+  }
+}
+
+TEST(TestAERemap, Throughput)
+{
+  const unsigned int frames     = 48000;
+  const int          iterations = 20;
+
+  for (size_t i = 0; i < XBMC_ARRAY_SIZE(testLayouts); ++i)
+    for (size_t o = 0; o < XBMC_ARRAY_SIZE(testLayouts); ++o)
+    {
+      CAEChannelInfo input (testLayouts[i].layout);
+      CAEChannelInfo output(testLayouts[o].layout);
+      CAERemap remap;
+      ASSERT_TRUE(remap.Initialize(input, output, false, true));
+
+      /* the same levels, only looked up the old way */
+      float levels[8][8];
+      for (unsigned int c = 0; c < output.Count(); ++c)
+        for (unsigned int n = 0; n < input.Count(); ++n)
+          levels[c][n] = remap.GetMixLevel(c, n);
+      CSparseRemap sparse(input.Count(), output.Count(), levels);
+
+      std::vector<float> in(frames * input.Count()), out(frames * output.Count());
+      FillRandomSamples(in);
+
+      CStopWatch watch;
+      watch.StartZero();
+      for (int n = 0; n < iterations; ++n)
+        sparse.Remap(&in[0], &out[0], frames);
+      float sparseElapsed = watch.GetElapsedSeconds();
+
+      watch.StartZero();
+      for (int n = 0; n < iterations; ++n)
+        remap.Remap(&in[0], &out[0], frames);
+      float denseElapsed = watch.GetElapsedSeconds();
+
+      std::cout << testLayouts[i].name << " -> " << testLayouts[o].name << " Mframes/s:"
+                << " sparse=" << testing::PrintToString(XBMC_MILLIONS_PER_SECOND(frames * iterations, sparseElapsed))
+                << " dense="  << testing::PrintToString(XBMC_MILLIONS_PER_SECOND(frames * iterations, denseElapsed ))
+                << "\n";
+    }
+}
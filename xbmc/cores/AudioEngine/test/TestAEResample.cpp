@@ -0,0 +1,266 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Resamplers/AEResampleFactory.h"
+#include "cores/AudioEngine/Interfaces/AEResample.h"
+#include "utils/Stopwatch.h"
+#include "AETestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/* the input is fed in blocks of this size like SoftAEStream does */
+#define TEST_BLOCK 1024
+/* frames at the start and end of the output not used for the measurements */
+#define TEST_SETTLE 2048
+
+static const struct
+{
+  unsigned int from;
+  unsigned int to;
+} testRates[] =
+{
+  { 44100, 48000 },
+  { 48000, 44100 },
+  { 48000, 96000 },
+  { 96000, 44100 }
+};
+
+/* the sweep, tones in Hz */
+static const double testTones[] = { 50.0, 440.0, 1000.0, 3000.0, 6000.0, 10000.0, 15000.0 };
+
+/* the worst THD+N each tier may have on the sweep in dB, loose floors to catch breakage */
+static const double testLimits[AE_RESAMPLE_MAX] =
+{
+  -10.0, /* linear    */
+  -70.0, /* polyphase */
+  -75.0, /* fastest   */
+  -85.0, /* medium    */
+  -85.0  /* best      */
+};
+
+static const double PI = 3.14159265358979323846;
+
+static void Sine(std::vector<float> &buf, unsigned int channels, double freq, unsigned int rate)
+{
+  const unsigned int frames = buf.size() / channels;
+  for (unsigned int f = 0; f < frames; ++f)
+    for (unsigned int c = 0; c < channels; ++c)
+      buf[f * channels + c] = (float)(0.5 * sin(2.0 * PI * freq * f / rate + c));
+}
+
+/* push all of "in" through the resampler the way SoftAEStream does */
+static void Process(IAEResample *resampler, const std::vector<float> &in, unsigned int channels, std::vector<float> &out)
+{
+  const unsigned int frames = in.size() / channels;
+  const unsigned int space  = (unsigned int)ceil(TEST_BLOCK * resampler->GetRatio()) + 1;
+  std::vector<float> block(space * channels);
+
+  out.clear();
+  unsigned int pos = 0;
+  while (pos < frames)
+  {
+    const unsigned int count = std::min(frames - pos, (unsigned int)TEST_BLOCK);
+    unsigned int used;
+    unsigned int gen = resampler->Resample(&in[pos * channels], count, &block[0], space, used);
+    out.insert(out.end(), block.begin(), block.begin() + gen * channels);
+    pos += used;
+    ASSERT_TRUE(used || gen) << "resampler stalled";
+  }
+}
+
+/*
+ * THD+N of a single channel, least squares fit of the expected tone plus DC
+ * and take everything that is left over as distortion and noise
+ */
+static double THDN(const std::vector<float> &buf, unsigned int channels, unsigned int channel, double freq, unsigned int rate)
+{
+  const unsigned int frames = buf.size() / channels;
+  const unsigned int start  = TEST_SETTLE;
+  const unsigned int end    = frames - TEST_SETTLE;
+  const double       w      = 2.0 * PI * freq / rate;
+
+  /* normal equations for [sin cos 1] */
+  double m[3][4] = { { 0 } };
+  for (unsigned int f = start; f < end; ++f)
+  {
+    const double b[3] = { sin(w * f), cos(w * f), 1.0 };
+    const double y    = buf[f * channels + channel];
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+        m[i][j] += b[i] * b[j];
+      m[i][3] += b[i] * y;
+    }
+  }
+
+  for (int i = 0; i < 3; ++i)
+    for (int j = i + 1; j < 3; ++j)
+    {
+      const double k = m[j][i] / m[i][i];
+      for (int n = i; n < 4; ++n)
+        m[j][n] -= k * m[i][n];
+    }
+
+  double x[3];
+  for (int i = 2; i >= 0; --i)
+  {
+    double v = m[i][3];
+    for (int j = i + 1; j < 3; ++j)
+      v -= m[i][j] * x[j];
+    x[i] = v / m[i][i];
+  }
+
+  double signal = 0.0, residual = 0.0;
+  for (unsigned int f = start; f < end; ++f)
+  {
+    const double tone = x[0] * sin(w * f) + x[1] * cos(w * f);
+    const double r    = buf[f * channels + channel] - tone - x[2];
+    signal   += tone * tone;
+    residual += r * r;
+  }
+
+  return 10.0 * log10(std::max(residual, 1e-30) / signal);
+}
+
+TEST(TestAEResample, FrameCount)
+{
+  const unsigned int channels = 2;
+  for (int q = 0; q < AE_RESAMPLE_MAX; ++q)
+    for (size_t r = 0; r < XBMC_ARRAY_SIZE(testRates); ++r)
+    {
+      const double ratio = (double)testRates[r].to / testRates[r].from;
+      std::auto_ptr<IAEResample> resampler(CAEResampleFactory::Create((AEResampleQuality)q));
+      ASSERT_TRUE(resampler.get() != NULL);
+      ASSERT_TRUE(resampler->Initialize(channels, ratio));
+
+      std::vector<float> in(testRates[r].from * channels, 0.0f), out;
+      Process(resampler.get(), in, channels, out);
+
+      /* the filters may hold back up to their length in frames */
+      const double expected = testRates[r].to;
+      EXPECT_NEAR(expected, out.size() / channels, 256.0)
+        << CAEResampleFactory::GetQualityName((AEResampleQuality)q) << " " << testRates[r].from << " -> " << testRates[r].to;
+    }
+}
+
+TEST(TestAEResample, DCPassthrough)
+{
+  const unsigned int channels = 2;
+  for (int q = 0; q < AE_RESAMPLE_MAX; ++q)
+  {
+    std::auto_ptr<IAEResample> resampler(CAEResampleFactory::Create((AEResampleQuality)q));
+    ASSERT_TRUE(resampler->Initialize(channels, 48000.0 / 44100.0));
+
+    std::vector<float> in(44100 * channels, 0.5f), out;
+    Process(resampler.get(), in, channels, out);
+
+    for (size_t i = TEST_SETTLE * channels; i < out.size() - TEST_SETTLE * channels; ++i)
+      ASSERT_NEAR(0.5f, out[i], 0.001f) << CAEResampleFactory::GetQualityName((AEResampleQuality)q) << " at sample " << i;
+  }
+}
+
+TEST(TestAEResample, ResetAndSetRatio)
+{
+  const unsigned int channels = 2;
+  for (int q = 0; q < AE_RESAMPLE_MAX; ++q)
+  {
+    std::auto_ptr<IAEResample> resampler(CAEResampleFactory::Create((AEResampleQuality)q));
+    ASSERT_TRUE(resampler->Initialize(channels, 48000.0 / 44100.0));
+
+    /* small adjustments like the ones dvdplayer makes for sync must not upset the output */
+    std::vector<float> in(44100 * channels), out;
+    Sine(in, channels, 1000.0, 44100);
+    Process(resampler.get(), in, channels, out);
+    resampler->Reset();
+    EXPECT_TRUE(resampler->SetRatio(48000.0 / 44100.0 * 1.001));
+    EXPECT_NEAR(48000.0 / 44100.0 * 1.001, resampler->GetRatio(), 1e-9);
+
+    Process(resampler.get(), in, channels, out);
+    EXPECT_NEAR(48048.0, out.size() / channels, 256.0);
+    EXPECT_LT(THDN(out, channels, 0, 1000.0, 48048), testLimits[q] + 10.0)
+      << CAEResampleFactory::GetQualityName((AEResampleQuality)q);
+  }
+}
+
+TEST(TestAEResample, SweepTHDN)
+{
+  const unsigned int channels = 2;
+  for (int q = 0; q < AE_RESAMPLE_MAX; ++q)
+    for (size_t r = 0; r < XBMC_ARRAY_SIZE(testRates); ++r)
+    {
+      const unsigned int from  = testRates[r].from;
+      const unsigned int to    = testRates[r].to;
+      const double       ratio = (double)to / from;
+      double             worst = -1000.0;
+
+      std::auto_ptr<IAEResample> resampler(CAEResampleFactory::Create((AEResampleQuality)q));
+      ASSERT_TRUE(resampler->Initialize(channels, ratio));
+
+      std::cout << CAEResampleFactory::GetQualityName((AEResampleQuality)q) << " " << from << " -> " << to << " THD+N dB:";
+      for (size_t t = 0; t < XBMC_ARRAY_SIZE(testTones); ++t)
+      {
+        /* only the tones inside the pass band of every tier */
+        if (testTones[t] > 0.35 * std::min(from, to))
+          continue;
+
+        std::vector<float> in(from / 2 * channels), out;
+        Sine(in, channels, testTones[t], from);
+        resampler->Reset();
+        Process(resampler.get(), in, channels, out);
+
+        const double thdn = THDN(out, channels, 1, testTones[t], to);
+        worst = std::max(worst, thdn);
+        std::cout << " " << testTones[t] << "Hz=" << testing::PrintToString((int)thdn);
+      }
+      std::cout << "\n";
+
+      EXPECT_LT(worst, testLimits[q]) << CAEResampleFactory::GetQualityName((AEResampleQuality)q) << " " << from << " -> " << to;
+    }
+}
+
+TEST(TestAEResample, CPUPerSecond)
+{
+  const unsigned int channels = 6;
+  const unsigned int seconds  = 10;
+
+  std::vector<float> in(44100 * seconds * channels), out;
+  Sine(in, channels, 1000.0, 44100);
+
+  for (int q = 0; q < AE_RESAMPLE_MAX; ++q)
+  {
+    std::auto_ptr<IAEResample> resampler(CAEResampleFactory::Create((AEResampleQuality)q));
+    ASSERT_TRUE(resampler->Initialize(channels, 48000.0 / 44100.0));
+    out.reserve(48000 * seconds * channels + TEST_BLOCK * 2 * channels);
+
+    CStopWatch watch;
+    watch.StartZero();
+    Process(resampler.get(), in, channels, out);
+    float elapsed = watch.GetElapsedSeconds();
+
+    std::cout << CAEResampleFactory::GetQualityName((AEResampleQuality)q) << " 44100 -> 48000 5.1:"
+              << " ms of CPU per second of audio=" << testing::PrintToString(elapsed * 1000.0f / seconds)
+              << "\n";
+  }
+}
@@ -0,0 +1,134 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AERingBuffer.h"
+#include "threads/test/TestHelpers.h"
+
+#include "gtest/gtest.h"
+
+/* not a power of two so the position wrapping is exercised */
+#define TEST_SLOTS 7
+
+struct TestPacket
+{
+  unsigned int serial;
+  unsigned int payload[16];
+};
+
+TEST(TestAESlotRing, FillAndDrain)
+{
+  AESlotRing<TestPacket> ring;
+  ASSERT_TRUE(ring.Create(TEST_SLOTS));
+  EXPECT_EQ((unsigned int)TEST_SLOTS, ring.GetMaxSize());
+
+  /* go round a few times so the positions wrap */
+  unsigned int serial = 0;
+  for (int round = 0; round < 5; ++round)
+  {
+    EXPECT_TRUE(ring.GetReadSlot() == NULL);
+    EXPECT_EQ(0U, ring.GetReadSize());
+
+    for (unsigned int i = 0; i < TEST_SLOTS; ++i)
+    {
+      TestPacket *pkt = ring.GetWriteSlot();
+      ASSERT_TRUE(pkt != NULL);
+      pkt->serial = serial + i;
+      ring.Commit();
+    }
+
+    EXPECT_TRUE(ring.GetWriteSlot() == NULL);
+    EXPECT_EQ((unsigned int)TEST_SLOTS, ring.GetReadSize());
+    EXPECT_EQ((unsigned int)TEST_SLOTS, ring.GetDistance(ring.GetReadPos(), ring.GetWritePos()));
+
+    for (unsigned int i = 0; i < TEST_SLOTS; ++i)
+    {
+      TestPacket *pkt = ring.GetReadSlot();
+      ASSERT_TRUE(pkt != NULL);
+      EXPECT_EQ(serial++, pkt->serial);
+      ring.Release();
+    }
+  }
+
+  ring.Reset();
+  EXPECT_EQ(0U, ring.GetReadSize());
+  EXPECT_EQ((unsigned int)TEST_SLOTS, ring.GetWriteSize());
+}
+
+class SlotRingProducer : public IRunnable
+{
+public:
+  AESlotRing<TestPacket> &ring;
+  unsigned int count;
+
+  SlotRingProducer(AESlotRing<TestPacket> &r, unsigned int c) : ring(r), count(c) {}
+
+  void Run()
+  {
+    for (unsigned int serial = 0; serial < count; )
+    {
+      TestPacket *pkt = ring.GetWriteSlot();
+      if (!pkt)
+      {
+        SleepMillis(0);
+        continue;
+      }
+
+      pkt->serial = serial;
+      for (unsigned int i = 0; i < 16; ++i)
+        pkt->payload[i] = serial * 16 + i;
+      ring.Commit();
+      ++serial;
+    }
+  }
+};
+
+TEST(TestAESlotRing, ProducerConsumer)
+{
+  const unsigned int count = 200000;
+  AESlotRing<TestPacket> ring;
+  ASSERT_TRUE(ring.Create(TEST_SLOTS));
+
+  SlotRingProducer producer(ring, count);
+  thread producerThread(producer);
+
+  /* every packet must arrive once, in order and fully written */
+  unsigned int errors = 0;
+  for (unsigned int serial = 0; serial < count; )
+  {
+    TestPacket *pkt = ring.GetReadSlot();
+    if (!pkt)
+    {
+      SleepMillis(0);
+      continue;
+    }
+
+    if (pkt->serial != serial)
+      ++errors;
+    for (unsigned int i = 0; i < 16; ++i)
+      if (pkt->payload[i] != serial * 16 + i)
+        ++errors;
+    ring.Release();
+    ++serial;
+  }
+
+  EXPECT_TRUE(producerThread.timed_join(MILLIS(10000)));
+  EXPECT_EQ(0U, errors);
+  EXPECT_EQ(0U, ring.GetReadSize());
+}
@@ -0,0 +1,238 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+
+#if !defined(TARGET_DARWIN)
+#include "cores/AudioEngine/AEFactory.h"
+#include "cores/AudioEngine/Engines/SoftAE/SoftAE.h"
+#include "cores/AudioEngine/Engines/SoftAE/SoftAEStream.h"
+#include "cores/AudioEngine/Interfaces/AESink.h"
+#include "cores/AudioEngine/Utils/AEUtil.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <vector>
+
+/* frames the engine hands the sink at once */
+#define SINK_FRAMES 1024
+
+/* takes up to a limit of frames per call and keeps what it got */
+class CTestRawSink : public IAESink
+{
+public:
+  CTestRawSink(unsigned int frameSize, unsigned int limit)
+    : m_frameSize(frameSize), m_limit(limit), m_silence(0)
+  {
+  }
+
+  virtual const char *GetName() { return "TEST"; }
+  virtual bool Initialize(AEAudioFormat &format, std::string &device) { return true; }
+  virtual void Deinitialize() {}
+  virtual bool IsCompatible(const AEAudioFormat format, const std::string device) { return true; }
+  virtual double GetDelay() { return 0.0; }
+  virtual double GetCacheTime() { return 0.0; }
+  virtual double GetCacheTotal() { return 0.0; }
+
+  virtual unsigned int AddPackets(uint8_t *data, unsigned int frames, bool hasAudio)
+  {
+    frames = std::min(frames, m_limit);
+    if (hasAudio)
+      m_data.insert(m_data.end(), data, data + frames * m_frameSize);
+    else
+      m_silence += frames;
+    return frames;
+  }
+
+  std::vector<uint8_t> m_data;
+  unsigned int         m_frameSize;
+  unsigned int         m_limit;
+  unsigned int         m_silence;
+};
+
+/* runs the passthrough stages of a soft engine that has a test sink instead of a thread */
+class TestSoftAEHelper
+{
+public:
+  TestSoftAEHelper(unsigned int limit)
+  {
+#if defined(TARGET_LINUX)
+    setenv("AE_ENGINE", "SOFT", 1);
+#endif
+    CAEFactory::LoadEngine();
+    m_ae = dynamic_cast<CSoftAE*>(CAEFactory::GetEngine());
+    m_sink = NULL;
+    if (!m_ae)
+      return;
+
+    AEAudioFormat &format = m_ae->m_sinkFormat;
+    format.m_dataFormat    = AE_FMT_S16NE;
+    format.m_sampleRate    = 48000;
+    format.m_encodedRate   = 48000;
+    format.m_channelLayout = CAEChannelInfo(AE_CH_LAYOUT_2_0);
+    format.m_frames        = SINK_FRAMES;
+    format.m_frameSamples  = SINK_FRAMES * 2;
+    format.m_frameSize     = 2 * sizeof(int16_t);
+    m_ae->m_chLayout       = format.m_channelLayout;
+    m_ae->m_sinkBlockSize  = SINK_FRAMES * format.m_frameSize;
+    m_ae->m_rawPassthrough = true;
+
+    m_sink = new CTestRawSink(format.m_frameSize, limit);
+    m_ae->m_sink = m_sink;
+  }
+
+  ~TestSoftAEHelper()
+  {
+    if (m_ae)
+    {
+      m_ae->m_playingStreams.clear();
+      m_ae->m_masterStream = NULL;
+    }
+    for (std::vector<CSoftAEStream*>::iterator it = m_streams.begin(); it != m_streams.end(); ++it)
+      delete *it;
+    CAEFactory::UnLoadEngine();
+  }
+
+  bool IsLoaded() { return m_ae != NULL; }
+  CTestRawSink &GetSink() { return *m_sink; }
+
+  /* a playing AC3 stream with a second of frames queued, frame n holds n */
+  CSoftAEStream *AddStream(bool master)
+  {
+    CSoftAEStream *stream = new CSoftAEStream(AE_FMT_AC3, 48000, 48000, CAEChannelInfo(AE_CH_LAYOUT_2_0), 0);
+    stream->Initialize();
+    m_streams.push_back(stream);
+    m_ae->m_playingStreams.push_back(stream);
+    if (master)
+      m_ae->m_masterStream = stream;
+
+    std::vector<uint8_t> data;
+    for (unsigned int frame = 0; stream->GetSpace() >= stream->GetFrameSize(); frame++)
+    {
+      data.resize(stream->GetFrameSize());
+      for (unsigned int i = 0; i < data.size(); i++)
+        data[i] = Expected(frame * data.size() + i);
+      stream->AddData(&data[0], data.size());
+    }
+    return stream;
+  }
+
+  static uint8_t Expected(unsigned int offset) { return (uint8_t)(offset % 251); }
+
+  unsigned int GetFramesBuffered(CSoftAEStream *stream) { return stream->GetFramesBuffered(); }
+
+  int RunOutputStage() { return m_ae->RunRawOutputStage(false); }
+
+  void RunStreamStage()
+  {
+    bool restart = false;
+    m_ae->RunRawStreamStage(m_ae->m_chLayout.Count(), NULL, restart);
+  }
+
+private:
+  CSoftAE                    *m_ae;
+  CTestRawSink               *m_sink;
+  std::vector<CSoftAEStream*> m_streams;
+};
+
+static void CheckData(const std::vector<uint8_t> &data)
+{
+  for (unsigned int i = 0; i < data.size(); i++)
+  {
+    ASSERT_EQ(TestSoftAEHelper::Expected(i), data[i]) << "byte " << i;
+  }
+}
+
+TEST(TestSoftAE, RawPassthroughNoCopy)
+{
+  TestSoftAEHelper helper(SINK_FRAMES);
+  ASSERT_TRUE(helper.IsLoaded());
+  CSoftAEStream *stream = helper.AddStream(true);
+  const unsigned int frames = helper.GetFramesBuffered(stream);
+  ASSERT_LT(0u, frames);
+
+  // the sink gets the frames out of the packets as they were queued, without a copy
+  const unsigned long copied = CAEUtil::GetRawCopied();
+  while (helper.GetSink().m_data.size() < frames * stream->GetFrameSize())
+    ASSERT_LT(0, helper.RunOutputStage());
+  EXPECT_EQ(copied, CAEUtil::GetRawCopied());
+  EXPECT_EQ(0u, helper.GetSink().m_silence);
+  EXPECT_EQ(frames * stream->GetFrameSize(), helper.GetSink().m_data.size());
+  CheckData(helper.GetSink().m_data);
+
+  // then it is kept fed with silence
+  EXPECT_EQ(0, helper.RunOutputStage());
+  EXPECT_EQ((unsigned int)SINK_FRAMES, helper.GetSink().m_silence);
+}
+
+TEST(TestSoftAE, RawPassthroughShortWrites)
+{
+  // what the sink doesn't take is written first on the next pass
+  TestSoftAEHelper helper(100);
+  ASSERT_TRUE(helper.IsLoaded());
+  CSoftAEStream *stream = helper.AddStream(true);
+  const unsigned int frames = helper.GetFramesBuffered(stream);
+
+  while (helper.GetSink().m_data.size() < frames * stream->GetFrameSize())
+  {
+    int wrote = helper.RunOutputStage();
+    ASSERT_LT(0, wrote);
+    ASSERT_GE(100, wrote);
+  }
+  EXPECT_EQ(0u, helper.GetSink().m_silence);
+  CheckData(helper.GetSink().m_data);
+}
+
+TEST(TestSoftAE, RawPassthroughPacesOtherStreams)
+{
+  TestSoftAEHelper helper(SINK_FRAMES);
+  ASSERT_TRUE(helper.IsLoaded());
+  CSoftAEStream *master = helper.AddStream(true);
+  CSoftAEStream *other  = helper.AddStream(false);
+  const unsigned int frames = helper.GetFramesBuffered(other);
+
+  // nothing is dropped from the other streams until the sink takes frames
+  helper.RunStreamStage();
+  helper.RunStreamStage();
+  EXPECT_EQ(frames, helper.GetFramesBuffered(other));
+
+  // then as much as it took, for both passes
+  ASSERT_EQ(SINK_FRAMES, helper.RunOutputStage());
+  ASSERT_EQ(SINK_FRAMES, helper.RunOutputStage());
+  helper.RunStreamStage();
+  EXPECT_EQ(frames - 2 * SINK_FRAMES, helper.GetFramesBuffered(other));
+  EXPECT_EQ(frames - 2 * SINK_FRAMES, helper.GetFramesBuffered(master));
+}
+
+TEST(TestSoftAE, RawPassthroughSilencePacesOtherStreams)
+{
+  // without a master stream the sink is fed silence, at the same pace
+  TestSoftAEHelper helper(SINK_FRAMES);
+  ASSERT_TRUE(helper.IsLoaded());
+  CSoftAEStream *other = helper.AddStream(false);
+  const unsigned int frames = helper.GetFramesBuffered(other);
+
+  EXPECT_EQ(0, helper.RunOutputStage());
+  EXPECT_EQ((unsigned int)SINK_FRAMES, helper.GetSink().m_silence);
+  helper.RunStreamStage();
+  EXPECT_EQ(frames - SINK_FRAMES, helper.GetFramesBuffered(other));
+}
+#endif
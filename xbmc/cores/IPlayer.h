@@ -23,6 +23,7 @@
 #include "system.h" // until we get sane int types used here
 #include "IAudioCallback.h"
 #include "utils/StdString.h"
+#include "filesystem/IFileTypes.h"
 
 struct TextCacheStruct_t;
 class TiXmlElement;
@@ -166,6 +167,8 @@ public:
   virtual bool IsCaching() const {return false;};
   //Cache filled in Percent
   virtual int GetCacheLevel() const {return -1;};
+  //State of the file cache the player reads through, false if there is none
+  virtual bool GetCacheStatus(XFILE::SCacheStatus &status) const {return false;};
 
   virtual bool IsInMenu() const {return false;};
   virtual bool HasMenu() { return false; };
@@ -21,10 +21,303 @@
 #include "DVDCodecUtils.h"
 #include "DVDClock.h"
 #include "cores/VideoRenderers/RenderManager.h"
+#include "threads/Condition.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #include "utils/fastmemcpy.h"
 #include "DllSwScale.h"
 
+#include <algorithm>
+#include <vector>
+
+/* pictures from this size on are split in stripes over a few threads */
+#define STRIPE_MIN_PIXELS  (2560 * 1440)
+#define STRIPE_MAX_THREADS 4
+
+static void CopyPlaneC(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width, int height)
+{
+  if (width == dstStride && width == srcStride)
+  {
+    fast_memcpy(dst, src, width * height);
+    return;
+  }
+
+  for (int y = 0; y < height; y++)
+  {
+    fast_memcpy(dst, src, width);
+    src += srcStride;
+    dst += dstStride;
+  }
+}
+
+static void InterleaveC(uint8_t* dst, int dstStride, const uint8_t* u, int uStride,
+                        const uint8_t* v, int vStride, int width, int height)
+{
+  for (int y = 0; y < height; y++)
+  {
+    uint8_t*       d  = dst + y * dstStride;
+    const uint8_t* su = u   + y * uStride;
+    const uint8_t* sv = v   + y * vStride;
+    for (int x = 0; x < width; x++)
+    {
+      *d++ = *su++;
+      *d++ = *sv++;
+    }
+  }
+}
+
+static void PackC(uint8_t* dst, int dstStride, const uint8_t* y, int yStride,
+                  const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+                  int width, int height, bool uyvy)
+{
+  for (int row = 0; row < height; row++)
+  {
+    uint8_t*       d  = dst + row * dstStride;
+    const uint8_t* sy = y   + row * yStride;
+    const uint8_t* su = u   + (row >> 1) * uStride;
+    const uint8_t* sv = v   + (row >> 1) * vStride;
+    for (int x = 0; x + 1 < width; x += 2, d += 4)
+    {
+      if (uyvy)
+      {
+        d[0] = su[x / 2]; d[1] = sy[x]; d[2] = sv[x / 2]; d[3] = sy[x + 1];
+      }
+      else
+      {
+        d[0] = sy[x]; d[1] = su[x / 2]; d[2] = sy[x + 1]; d[3] = sv[x / 2];
+      }
+    }
+  }
+}
+
+/* a conversion that can be done in independent groups of rows */
+class IStripe
+{
+public:
+  virtual ~IStripe() {}
+  virtual void Run(int first, int count) = 0;
+};
+
+/* A few threads kept around to share the rows of big pictures. Only one
+ * picture is striped at a time, a second caller just does all of its rows
+ * on its own thread.
+ */
+class CStripePool
+{
+public:
+  CStripePool() : m_job(NULL), m_size(0), m_rows(0), m_generation(0), m_pending(0), m_stop(false) {}
+  ~CStripePool() { Stop(); }
+
+  void Run(IStripe& job, int rows, int align);
+
+private:
+  class CWorker : public CThread
+  {
+  public:
+    CWorker(CStripePool& pool, int index) : CThread("CStripePool"), m_pool(pool), m_index(index) {}
+  protected:
+    virtual void Process() { m_pool.Work(m_index); }
+    CStripePool& m_pool;
+    int          m_index;
+  };
+
+  bool Start();
+  void Stop();
+  void Work(int index);
+
+  CCriticalSection               m_busy;
+  CCriticalSection               m_section;
+  XbmcThreads::ConditionVariable m_started;
+  XbmcThreads::ConditionVariable m_done;
+  std::vector<CWorker*>          m_workers;
+
+  IStripe*     m_job;
+  int          m_size;
+  int          m_rows;
+  unsigned int m_generation;
+  unsigned int m_pending;
+  bool         m_stop;
+};
+
+static CStripePool g_stripePool;
+
+bool CStripePool::Start()
+{
+  if (m_workers.empty() && !m_stop)
+  {
+    int threads = std::min(g_cpuInfo.getCPUCount(), STRIPE_MAX_THREADS);
+    for (int i = 1; i < threads; i++)
+    {
+      CWorker* worker = new CWorker(*this, i);
+      worker->Create();
+      m_workers.push_back(worker);
+    }
+  }
+  return !m_workers.empty();
+}
+
+void CStripePool::Stop()
+{
+  { CSingleLock lock(m_section);
+    m_stop = true;
+    m_started.notifyAll();
+  }
+
+  for (std::vector<CWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+  {
+    (*it)->StopThread();
+    delete *it;
+  }
+  m_workers.clear();
+}
+
+void CStripePool::Run(IStripe& job, int rows, int align)
+{
+  CSingleTryLock busy(m_busy);
+  if (!busy.IsOwner() || !Start())
+  {
+    job.Run(0, rows);
+    return;
+  }
+
+  int stripes = m_workers.size() + 1;
+  int size    = ((rows + stripes - 1) / stripes + align - 1) / align * align;
+
+  { CSingleLock lock(m_section);
+    m_job     = &job;
+    m_size    = size;
+    m_rows    = rows;
+    m_pending = m_workers.size();
+    m_generation++;
+    m_started.notifyAll();
+  }
+
+  job.Run(0, std::min(size, rows));
+
+  CSingleLock lock(m_section);
+  while (m_pending)
+    m_done.wait(lock);
+  m_job = NULL;
+}
+
+void CStripePool::Work(int index)
+{
+  unsigned int generation = 0;
+  CSingleLock lock(m_section);
+  while (true)
+  {
+    while (!m_stop && m_generation == generation)
+      m_started.wait(lock);
+    if (m_stop)
+      break;
+
+    generation = m_generation;
+    IStripe* job   = m_job;
+    int      first = index * m_size;
+    int      count = std::min(m_size, m_rows - first);
+
+    if (count > 0)
+    {
+      lock.Leave();
+      job->Run(first, count);
+      lock.Enter();
+    }
+
+    if (--m_pending == 0)
+      m_done.notifyAll();
+  }
+}
+
+static void RunStriped(IStripe& job, int rows, int align, bool big)
+{
+  if (big && rows >= align * 2)
+    g_stripePool.Run(job, rows, align);
+  else
+    job.Run(0, rows);
+}
+
+static bool IsBig(const DVDVideoPicture* pSrc)
+{
+  return pSrc->iWidth * pSrc->iHeight >= STRIPE_MIN_PIXELS;
+}
+
+class CCopyStripe : public IStripe
+{
+public:
+  CCopyStripe(DVDCopyPlaneFn fn, uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width)
+    : m_fn(fn), m_dst(dst), m_dstStride(dstStride), m_src(src), m_srcStride(srcStride), m_width(width) {}
+
+  virtual void Run(int first, int count)
+  {
+    m_fn(m_dst + first * m_dstStride, m_dstStride, m_src + first * m_srcStride, m_srcStride, m_width, count);
+  }
+
+private:
+  DVDCopyPlaneFn m_fn;
+  uint8_t*       m_dst;
+  int            m_dstStride;
+  const uint8_t* m_src;
+  int            m_srcStride;
+  int            m_width;
+};
+
+static void CopyPlane(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width, int height, bool big, bool uswc = false)
+{
+  CCopyStripe job(CDVDCodecUtils::GetCopyPlane(g_cpuInfo.GetCPUFeatures(), uswc), dst, dstStride, src, srcStride, width);
+  RunStriped(job, height, 1, big);
+}
+
+class CInterleaveStripe : public IStripe
+{
+public:
+  CInterleaveStripe(uint8_t* dst, int dstStride, const uint8_t* u, int uStride, const uint8_t* v, int vStride, int width)
+    : m_fn(CDVDCodecUtils::GetInterleave(g_cpuInfo.GetCPUFeatures()))
+    , m_dst(dst), m_dstStride(dstStride), m_u(u), m_uStride(uStride), m_v(v), m_vStride(vStride), m_width(width) {}
+
+  virtual void Run(int first, int count)
+  {
+    m_fn(m_dst + first * m_dstStride, m_dstStride,
+         m_u + first * m_uStride, m_uStride,
+         m_v + first * m_vStride, m_vStride, m_width, count);
+  }
+
+private:
+  DVDInterleaveFn m_fn;
+  uint8_t*        m_dst;
+  int             m_dstStride;
+  const uint8_t*  m_u;
+  int             m_uStride;
+  const uint8_t*  m_v;
+  int             m_vStride;
+  int             m_width;
+};
+
+class CPackStripe : public IStripe
+{
+public:
+  CPackStripe(uint8_t* dst, int dstStride, DVDVideoPicture* pSrc, bool uyvy)
+    : m_fn(CDVDCodecUtils::GetPack(g_cpuInfo.GetCPUFeatures())), m_dst(dst), m_dstStride(dstStride), m_src(pSrc), m_uyvy(uyvy) {}
+
+  /* first is always even, the stripes are aligned to two rows */
+  virtual void Run(int first, int count)
+  {
+    m_fn(m_dst + first * m_dstStride, m_dstStride,
+         m_src->data[0] + first * m_src->iLineSize[0], m_src->iLineSize[0],
+         m_src->data[1] + (first >> 1) * m_src->iLineSize[1], m_src->iLineSize[1],
+         m_src->data[2] + (first >> 1) * m_src->iLineSize[2], m_src->iLineSize[2],
+         m_src->iWidth, count, m_uyvy);
+  }
+
+private:
+  DVDPackFn        m_fn;
+  uint8_t*         m_dst;
+  int              m_dstStride;
+  DVDVideoPicture* m_src;
+  bool             m_uyvy;
+};
+
 // allocate a new picture (PIX_FMT_YUV420P)
 DVDVideoPicture* CDVDCodecUtils::AllocatePicture(int iWidth, int iHeight)
 {
@@ -68,94 +361,33 @@ void CDVDCodecUtils::FreePicture(DVDVideoPicture* pPicture)
 
 bool CDVDCodecUtils::CopyPicture(DVDVideoPicture* pDst, DVDVideoPicture* pSrc)
 {
-  BYTE *s, *d;
-  int w = pSrc->iWidth;
-  int h = pSrc->iHeight;
-
-  s = pSrc->data[0];
-  d = pDst->data[0];
+  int  w   = pSrc->iWidth;
+  int  h   = pSrc->iHeight;
+  bool big = IsBig(pSrc);
 
-  for (int y = 0; y < h; y++)
-  {
-    fast_memcpy(d, s, w);
-    s += pSrc->iLineSize[0];
-    d += pDst->iLineSize[0];
-  }
+  CopyPlane(pDst->data[0], pDst->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0], w, h, big);
 
   w >>= 1;
   h >>= 1;
 
-  s = pSrc->data[1];
-  d = pDst->data[1];
-  for (int y = 0; y < h; y++)
-  {
-    fast_memcpy(d, s, w);
-    s += pSrc->iLineSize[1];
-    d += pDst->iLineSize[1];
-  }
-
-  s = pSrc->data[2];
-  d = pDst->data[2];
-  for (int y = 0; y < h; y++)
-  {
-    fast_memcpy(d, s, w);
-    s += pSrc->iLineSize[2];
-    d += pDst->iLineSize[2];
-  }
+  CopyPlane(pDst->data[1], pDst->iLineSize[1], pSrc->data[1], pSrc->iLineSize[1], w, h, big);
+  CopyPlane(pDst->data[2], pDst->iLineSize[2], pSrc->data[2], pSrc->iLineSize[2], w, h, big);
   return true;
 }
 
 bool CDVDCodecUtils::CopyPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  BYTE *s = pSrc->data[0];
-  BYTE *d = pImage->plane[0];
-  int w = pImage->width * pImage->bpp;
-  int h = pImage->height;
-  if ((w == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  s = pSrc->data[1];
-  d = pImage->plane[1];
+  bool big = IsBig(pSrc);
+  int  w   = pImage->width * pImage->bpp;
+  int  h   = pImage->height;
+
+  CopyPlane(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], w, h, big);
+
   w =(pImage->width  >> pImage->cshift_x) * pImage->bpp;
   h =(pImage->height >> pImage->cshift_y);
-  if ((w==pSrc->iLineSize[1]) && ((unsigned int) pSrc->iLineSize[1]==pImage->stride[1]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[1];
-      d += pImage->stride[1];
-    }
-  }
-  s = pSrc->data[2];
-  d = pImage->plane[2];
-  if ((w==pSrc->iLineSize[2]) && ((unsigned int) pSrc->iLineSize[2]==pImage->stride[2]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[2];
-      d += pImage->stride[2];
-    }
-  }
+
+  CopyPlane(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], w, h, big);
+  CopyPlane(pImage->plane[2], pImage->stride[2], pSrc->data[2], pSrc->iLineSize[2], w, h, big);
   return true;
 }
 
@@ -183,29 +415,17 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToNV12Picture(DVDVideoPicture *pSrc)
       pPicture->iLineSize[2] = 0;
       pPicture->iLineSize[3] = 0;
       pPicture->format = RENDER_FMT_NV12;
-      
+
+      bool big = IsBig(pSrc);
+
       // copy luma
-      uint8_t *s = pSrc->data[0];
-      uint8_t *d = pPicture->data[0];
-      for (int y = 0; y < (int)pSrc->iHeight; y++)
-      {
-        fast_memcpy(d, s, pSrc->iWidth);
-        s += pSrc->iLineSize[0];
-        d += pPicture->iLineSize[0];
-      }
+      CopyPlane(pPicture->data[0], pPicture->iLineSize[0], pSrc->data[0], pSrc->iLineSize[0], pSrc->iWidth, pSrc->iHeight, big);
 
       //copy chroma
-      uint8_t *s_u, *s_v, *d_uv;
-      for (int y = 0; y < (int)pSrc->iHeight/2; y++) {
-        s_u = pSrc->data[1] + (y * pSrc->iLineSize[1]);
-        s_v = pSrc->data[2] + (y * pSrc->iLineSize[2]);
-        d_uv = pPicture->data[1] + (y * pPicture->iLineSize[1]);
-        for (int x = 0; x < (int)pSrc->iWidth/2; x++) {
-          *d_uv++ = *s_u++;
-          *d_uv++ = *s_v++;
-        }
-      }
-      
+      CInterleaveStripe job(pPicture->data[1], pPicture->iLineSize[1],
+                            pSrc->data[1], pSrc->iLineSize[1],
+                            pSrc->data[2], pSrc->iLineSize[2], pSrc->iWidth / 2);
+      RunStriped(job, pSrc->iHeight / 2, 1, big);
     }
     else
     {
@@ -240,33 +460,9 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToYUV422PackedPicture(DVDVideoPicture *p
       pPicture->iLineSize[3] = 0;
       pPicture->format = format;
 
-      //if this is going to be used for anything else than testing the renderer
-      //the library should not be loaded on every function call
-      DllSwScale  dllSwScale;
-      if (!dllSwScale.Load())
-      {
-        CLog::Log(LOGERROR,"CDVDCodecUtils::ConvertToYUY2Picture - failed to load rescale libraries!");
-      }
-      else
-      {
-        // Perform the scaling.
-        uint8_t* src[] =       { pSrc->data[0],          pSrc->data[1],      pSrc->data[2],      NULL };
-        int      srcStride[] = { pSrc->iLineSize[0],     pSrc->iLineSize[1], pSrc->iLineSize[2], 0    };
-        uint8_t* dst[] =       { pPicture->data[0],      NULL,               NULL,               NULL };
-        int      dstStride[] = { pPicture->iLineSize[0], 0,                  0,                  0    };
-
-        int dstformat;
-        if (format == RENDER_FMT_UYVY422)
-          dstformat = PIX_FMT_UYVY422;
-        else
-          dstformat = PIX_FMT_YUYV422;
-
-        struct SwsContext *ctx = dllSwScale.sws_getContext(pSrc->iWidth, pSrc->iHeight, PIX_FMT_YUV420P,
-                                                           pPicture->iWidth, pPicture->iHeight, dstformat,
-                                                           SWS_FAST_BILINEAR | SwScaleCPUFlags(), NULL, NULL, NULL);
-        dllSwScale.sws_scale(ctx, src, srcStride, 0, pSrc->iHeight, dst, dstStride);
-        dllSwScale.sws_freeContext(ctx);
-      }
+      // each chroma row is used for two luma rows, so stripes start on even rows
+      CPackStripe job(pPicture->data[0], pPicture->iLineSize[0], pSrc, format == RENDER_FMT_UYVY422);
+      RunStriped(job, pSrc->iHeight, 2, IsBig(pSrc));
     }
     else
     {
@@ -280,69 +476,22 @@ DVDVideoPicture* CDVDCodecUtils::ConvertToYUV422PackedPicture(DVDVideoPicture *p
 
 bool CDVDCodecUtils::CopyNV12Picture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  BYTE *s = pSrc->data[0];
-  BYTE *d = pImage->plane[0];
-  int w = pSrc->iWidth;
-  int h = pSrc->iHeight;
+  bool big = IsBig(pSrc);
+
   // Copy Y
-  if ((w == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  
-  s = pSrc->data[1];
-  d = pImage->plane[1];
-  w = pSrc->iWidth;
-  h = pSrc->iHeight >> 1;
+  CopyPlane(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], pSrc->iWidth, pSrc->iHeight, big);
+
   // Copy packed UV (width is same as for Y as it's both U and V components)
-  if ((w==pSrc->iLineSize[1]) && ((unsigned int) pSrc->iLineSize[1]==pImage->stride[1]))
-  {
-    fast_memcpy(d, s, w*h);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w);
-      s += pSrc->iLineSize[1];
-      d += pImage->stride[1];
-    }
-  }
+  CopyPlane(pImage->plane[1], pImage->stride[1], pSrc->data[1], pSrc->iLineSize[1], pSrc->iWidth, pSrc->iHeight >> 1, big);
 
   return true;
 }
 
 bool CDVDCodecUtils::CopyYUV422PackedPicture(YV12Image* pImage, DVDVideoPicture *pSrc)
 {
-  BYTE *s = pSrc->data[0];
-  BYTE *d = pImage->plane[0];
-  int w = pSrc->iWidth;
-  int h = pSrc->iHeight;
-
   // Copy YUYV
-  if ((w * 2 == pSrc->iLineSize[0]) && ((unsigned int) pSrc->iLineSize[0] == pImage->stride[0]))
-  {
-    fast_memcpy(d, s, w*h*2);
-  }
-  else
-  {
-    for (int y = 0; y < h; y++)
-    {
-      fast_memcpy(d, s, w*2);
-      s += pSrc->iLineSize[0];
-      d += pImage->stride[0];
-    }
-  }
-  
+  CopyPlane(pImage->plane[0], pImage->stride[0], pSrc->data[0], pSrc->iLineSize[0], pSrc->iWidth * 2, pSrc->iHeight, IsBig(pSrc));
+
   return true;
 }
 
@@ -360,15 +509,10 @@ bool CDVDCodecUtils::CopyDXVA2Picture(YV12Image* pImage, DVDVideoPicture *pSrc)
         if (FAILED(surface->LockRect(&rectangle, NULL, 0)))
           return false;
 
-        // Copy Y
+        // Copy Y, the surface is write combined memory
+        bool big = IsBig(pSrc);
         uint8_t* bits = (uint8_t*)(rectangle.pBits);
-        uint8_t* d = pImage->plane[0];
-        for (unsigned y = 0; y < pSrc->iHeight; y++)
-        {
-          memcpy(d, bits, pSrc->iWidth);
-          bits += rectangle.Pitch;
-          d += pImage->stride[0];
-        }
+        CopyPlane(pImage->plane[0], pImage->stride[0], bits, rectangle.Pitch, pSrc->iWidth, pSrc->iHeight, big, true);
 
         D3DSURFACE_DESC desc;
         if (FAILED(surface->GetDesc(&desc)))
@@ -376,13 +520,7 @@ bool CDVDCodecUtils::CopyDXVA2Picture(YV12Image* pImage, DVDVideoPicture *pSrc)
         
         // Copy packed UV
         uint8_t *s_uv = ((uint8_t*)(rectangle.pBits)) + desc.Height * rectangle.Pitch;
-        uint8_t *d_uv = pImage->plane[1];
-        for (unsigned y = 0; y < pSrc->iHeight >> 1; y++)
-        {
-          memcpy(d_uv, s_uv, pSrc->iWidth);
-          s_uv += rectangle.Pitch;
-          d_uv += pImage->stride[1];
-        }
+        CopyPlane(pImage->plane[1], pImage->stride[1], s_uv, rectangle.Pitch, pSrc->iWidth, pSrc->iHeight >> 1, big, true);
 
         if (FAILED(surface->UnlockRect()))
           return false;
@@ -481,3 +619,35 @@ int CDVDCodecUtils::PixfmtFromEFormat(ERenderFormat fmt)
   }
   return PIX_FMT_NONE;
 }
+
+DVDCopyPlaneFn CDVDCodecUtils::GetCopyPlane(unsigned int cpuFeatures, bool uswc)
+{
+  DVDCopyPlaneFn fn = NULL;
+  if (uswc && (cpuFeatures & CPU_FEATURE_SSE4))
+    fn = CDVDCodecUtilsSIMD::CopyPlaneSSE41();
+  if (!fn && (cpuFeatures & CPU_FEATURE_SSE2))
+    fn = CDVDCodecUtilsSIMD::CopyPlaneSSE2();
+  if (!fn && (cpuFeatures & CPU_FEATURE_NEON))
+    fn = CDVDCodecUtilsSIMD::CopyPlaneNEON();
+  return fn ? fn : &CopyPlaneC;
+}
+
+DVDInterleaveFn CDVDCodecUtils::GetInterleave(unsigned int cpuFeatures)
+{
+  DVDInterleaveFn fn = NULL;
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+    fn = CDVDCodecUtilsSIMD::InterleaveSSE2();
+  if (!fn && (cpuFeatures & CPU_FEATURE_NEON))
+    fn = CDVDCodecUtilsSIMD::InterleaveNEON();
+  return fn ? fn : &InterleaveC;
+}
+
+DVDPackFn CDVDCodecUtils::GetPack(unsigned int cpuFeatures)
+{
+  DVDPackFn fn = NULL;
+  if (cpuFeatures & CPU_FEATURE_SSE2)
+    fn = CDVDCodecUtilsSIMD::PackSSE2();
+  if (!fn && (cpuFeatures & CPU_FEATURE_NEON))
+    fn = CDVDCodecUtilsSIMD::PackNEON();
+  return fn ? fn : &PackC;
+}
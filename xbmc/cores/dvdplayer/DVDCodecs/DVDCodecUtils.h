@@ -21,6 +21,7 @@
  */
 
 #include "Video/DVDVideoCodec.h"
+#include "DVDCodecUtilsSIMD.h"
 #include "cores/VideoRenderers/RenderFormats.h"
 
 struct YV12Image;
@@ -45,5 +46,11 @@ public:
 
   static ERenderFormat EFormatFromPixfmt(int fmt);
   static int           PixfmtFromEFormat(ERenderFormat format);
+
+  /* the plane kernels for the given CPU features, uswc picks the one for
+   * sources in write combined memory */
+  static DVDCopyPlaneFn  GetCopyPlane(unsigned int cpuFeatures, bool uswc = false);
+  static DVDInterleaveFn GetInterleave(unsigned int cpuFeatures);
+  static DVDPackFn       GetPack(unsigned int cpuFeatures);
 };
 
@@ -0,0 +1,130 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDCodecUtilsSIMD.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+static void CopyPlaneNEON(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width, int height)
+{
+  for (int y = 0; y < height; y++)
+  {
+    uint8_t*       d = dst + y * dstStride;
+    const uint8_t* s = src + y * srcStride;
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+      uint8x16_t a = vld1q_u8(s + x);
+      uint8x16_t b = vld1q_u8(s + x + 16);
+      vst1q_u8(d + x,      a);
+      vst1q_u8(d + x + 16, b);
+    }
+    memcpy(d + x, s + x, width - x);
+  }
+}
+
+static void InterleaveNEON(uint8_t* dst, int dstStride, const uint8_t* u, int uStride,
+                           const uint8_t* v, int vStride, int width, int height)
+{
+  for (int y = 0; y < height; y++)
+  {
+    uint8_t*       d  = dst + y * dstStride;
+    const uint8_t* su = u   + y * uStride;
+    const uint8_t* sv = v   + y * vStride;
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+      uint8x16x2_t uv;
+      uv.val[0] = vld1q_u8(su + x);
+      uv.val[1] = vld1q_u8(sv + x);
+      vst2q_u8(d + 2 * x, uv);
+    }
+    for (; x < width; x++)
+    {
+      d[2 * x]     = su[x];
+      d[2 * x + 1] = sv[x];
+    }
+  }
+}
+
+static void PackNEON(uint8_t* dst, int dstStride, const uint8_t* y, int yStride,
+                     const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+                     int width, int height, bool uyvy)
+{
+  for (int row = 0; row < height; row++)
+  {
+    uint8_t*       d  = dst + row * dstStride;
+    const uint8_t* sy = y   + row * yStride;
+    const uint8_t* su = u   + (row >> 1) * uStride;
+    const uint8_t* sv = v   + (row >> 1) * vStride;
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+      /* even and odd luma apart, then all four components back in order */
+      uint8x8x2_t  yy = vld2_u8(sy + x);
+      uint8x8x4_t  px;
+      if (uyvy)
+      {
+        px.val[0] = vld1_u8(su + x / 2);
+        px.val[1] = yy.val[0];
+        px.val[2] = vld1_u8(sv + x / 2);
+        px.val[3] = yy.val[1];
+      }
+      else
+      {
+        px.val[0] = yy.val[0];
+        px.val[1] = vld1_u8(su + x / 2);
+        px.val[2] = yy.val[1];
+        px.val[3] = vld1_u8(sv + x / 2);
+      }
+      vst4_u8(d + 2 * x, px);
+    }
+    for (; x + 1 < width; x += 2)
+    {
+      uint8_t* p = d + 2 * x;
+      if (uyvy)
+      {
+        p[0] = su[x / 2]; p[1] = sy[x]; p[2] = sv[x / 2]; p[3] = sy[x + 1];
+      }
+      else
+      {
+        p[0] = sy[x]; p[1] = su[x / 2]; p[2] = sy[x + 1]; p[3] = sv[x / 2];
+      }
+    }
+  }
+}
+
+DVDCopyPlaneFn  CDVDCodecUtilsSIMD::CopyPlaneNEON()  { return &::CopyPlaneNEON; }
+DVDInterleaveFn CDVDCodecUtilsSIMD::InterleaveNEON() { return &::InterleaveNEON; }
+DVDPackFn       CDVDCodecUtilsSIMD::PackNEON()       { return &::PackNEON; }
+
+#else
+
+DVDCopyPlaneFn  CDVDCodecUtilsSIMD::CopyPlaneNEON()  { return NULL; }
+DVDInterleaveFn CDVDCodecUtilsSIMD::InterleaveNEON() { return NULL; }
+DVDPackFn       CDVDCodecUtilsSIMD::PackNEON()       { return NULL; }
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+
+/* copies width bytes of height rows */
+typedef void (*DVDCopyPlaneFn)(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride,
+                               int width, int height);
+/* interleaves width samples of two chroma planes into one UV plane */
+typedef void (*DVDInterleaveFn)(uint8_t* dst, int dstStride, const uint8_t* u, int uStride,
+                                const uint8_t* v, int vStride, int width, int height);
+/* packs width pixels of height 4:2:0 luma rows into YUYV or UYVY rows, the
+ * chroma row used is half the luma row, so the first row has to be even */
+typedef void (*DVDPackFn)(uint8_t* dst, int dstStride, const uint8_t* y, int yStride,
+                          const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+                          int width, int height, bool uyvy);
+
+/**
+ * SIMD plane kernels used by CDVDCodecUtils.
+ *
+ * Each instruction set lives in its own translation unit which is built with
+ * the matching compiler flags, the lookup functions return NULL if the unit
+ * was built without support for it. The caller has to check the CPU features
+ * before using the result, see CDVDCodecUtils::GetCopyPlane.
+ */
+class CDVDCodecUtilsSIMD
+{
+public:
+  static DVDCopyPlaneFn  CopyPlaneSSE2();
+  static DVDInterleaveFn InterleaveSSE2();
+  static DVDPackFn       PackSSE2();
+
+  /* streaming loads, only faster for write combined sources like mapped surfaces */
+  static DVDCopyPlaneFn  CopyPlaneSSE41();
+
+  static DVDCopyPlaneFn  CopyPlaneNEON();
+  static DVDInterleaveFn InterleaveNEON();
+  static DVDPackFn       PackNEON();
+};
@@ -0,0 +1,187 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDCodecUtilsSIMD.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DVD_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(DVD_HAVE_SSE2)
+
+/* planes smaller than this stay in the cache, bigger ones are streamed past it */
+#define STREAM_MIN_BYTES (512 * 1024)
+
+static inline bool IsAligned(const void* p)
+{
+  return ((uintptr_t)p & 15) == 0;
+}
+
+static void CopyRowSSE2(uint8_t* dst, const uint8_t* src, int width, bool stream)
+{
+  /* bring the destination to 16 bytes, the source may stay unaligned */
+  int head = (16 - ((uintptr_t)dst & 15)) & 15;
+  if (head > width)
+    head = width;
+  memcpy(dst, src, head);
+  dst   += head;
+  src   += head;
+  width -= head;
+
+  int x = 0;
+  if (stream)
+  {
+    for (; x + 64 <= width; x += 64)
+    {
+      __m128i a = _mm_loadu_si128((const __m128i*)(src + x));
+      __m128i b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+      __m128i c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+      __m128i d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+      _mm_stream_si128((__m128i*)(dst + x),      a);
+      _mm_stream_si128((__m128i*)(dst + x + 16), b);
+      _mm_stream_si128((__m128i*)(dst + x + 32), c);
+      _mm_stream_si128((__m128i*)(dst + x + 48), d);
+    }
+  }
+  else
+  {
+    for (; x + 64 <= width; x += 64)
+    {
+      __m128i a = _mm_loadu_si128((const __m128i*)(src + x));
+      __m128i b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+      __m128i c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+      __m128i d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+      _mm_store_si128((__m128i*)(dst + x),      a);
+      _mm_store_si128((__m128i*)(dst + x + 16), b);
+      _mm_store_si128((__m128i*)(dst + x + 32), c);
+      _mm_store_si128((__m128i*)(dst + x + 48), d);
+    }
+  }
+  for (; x + 16 <= width; x += 16)
+    _mm_store_si128((__m128i*)(dst + x), _mm_loadu_si128((const __m128i*)(src + x)));
+
+  memcpy(dst + x, src + x, width - x);
+}
+
+static void CopyPlaneSSE2(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width, int height)
+{
+  bool stream = width * height >= STREAM_MIN_BYTES;
+  if (width == dstStride && width == srcStride)
+  {
+    CopyRowSSE2(dst, src, width * height, stream);
+    height = 0;
+  }
+
+  for (int y = 0; y < height; y++)
+    CopyRowSSE2(dst + y * dstStride, src + y * srcStride, width, stream);
+
+  if (stream)
+    _mm_sfence();
+}
+
+static void InterleaveSSE2(uint8_t* dst, int dstStride, const uint8_t* u, int uStride,
+                           const uint8_t* v, int vStride, int width, int height)
+{
+  for (int y = 0; y < height; y++)
+  {
+    uint8_t*       d  = dst + y * dstStride;
+    const uint8_t* su = u   + y * uStride;
+    const uint8_t* sv = v   + y * vStride;
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+      __m128i cu = _mm_loadu_si128((const __m128i*)(su + x));
+      __m128i cv = _mm_loadu_si128((const __m128i*)(sv + x));
+      _mm_storeu_si128((__m128i*)(d + 2 * x),      _mm_unpacklo_epi8(cu, cv));
+      _mm_storeu_si128((__m128i*)(d + 2 * x + 16), _mm_unpackhi_epi8(cu, cv));
+    }
+    for (; x < width; x++)
+    {
+      d[2 * x]     = su[x];
+      d[2 * x + 1] = sv[x];
+    }
+  }
+}
+
+static void PackSSE2(uint8_t* dst, int dstStride, const uint8_t* y, int yStride,
+                     const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+                     int width, int height, bool uyvy)
+{
+  for (int row = 0; row < height; row++)
+  {
+    uint8_t*       d  = dst + row * dstStride;
+    const uint8_t* sy = y   + row * yStride;
+    const uint8_t* su = u   + (row >> 1) * uStride;
+    const uint8_t* sv = v   + (row >> 1) * vStride;
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+      __m128i y0 = _mm_loadu_si128((const __m128i*)(sy + x));
+      __m128i y1 = _mm_loadu_si128((const __m128i*)(sy + x + 16));
+      __m128i cu = _mm_loadu_si128((const __m128i*)(su + x / 2));
+      __m128i cv = _mm_loadu_si128((const __m128i*)(sv + x / 2));
+      __m128i c0 = _mm_unpacklo_epi8(cu, cv);
+      __m128i c1 = _mm_unpackhi_epi8(cu, cv);
+      if (uyvy)
+      {
+        _mm_storeu_si128((__m128i*)(d + 2 * x),      _mm_unpacklo_epi8(c0, y0));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 16), _mm_unpackhi_epi8(c0, y0));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 32), _mm_unpacklo_epi8(c1, y1));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 48), _mm_unpackhi_epi8(c1, y1));
+      }
+      else
+      {
+        _mm_storeu_si128((__m128i*)(d + 2 * x),      _mm_unpacklo_epi8(y0, c0));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 16), _mm_unpackhi_epi8(y0, c0));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 32), _mm_unpacklo_epi8(y1, c1));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 48), _mm_unpackhi_epi8(y1, c1));
+      }
+    }
+    for (; x + 1 < width; x += 2)
+    {
+      uint8_t* p = d + 2 * x;
+      if (uyvy)
+      {
+        p[0] = su[x / 2]; p[1] = sy[x]; p[2] = sv[x / 2]; p[3] = sy[x + 1];
+      }
+      else
+      {
+        p[0] = sy[x]; p[1] = su[x / 2]; p[2] = sy[x + 1]; p[3] = sv[x / 2];
+      }
+    }
+  }
+}
+
+DVDCopyPlaneFn  CDVDCodecUtilsSIMD::CopyPlaneSSE2()  { return &::CopyPlaneSSE2; }
+DVDInterleaveFn CDVDCodecUtilsSIMD::InterleaveSSE2() { return &::InterleaveSSE2; }
+DVDPackFn       CDVDCodecUtilsSIMD::PackSSE2()       { return &::PackSSE2; }
+
+#else
+
+DVDCopyPlaneFn  CDVDCodecUtilsSIMD::CopyPlaneSSE2()  { return NULL; }
+DVDInterleaveFn CDVDCodecUtilsSIMD::InterleaveSSE2() { return NULL; }
+DVDPackFn       CDVDCodecUtilsSIMD::PackSSE2()       { return NULL; }
+
+#endif
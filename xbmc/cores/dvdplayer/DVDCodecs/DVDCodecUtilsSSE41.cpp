@@ -0,0 +1,79 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDCodecUtilsSIMD.h"
+
+#include <string.h>
+
+#if defined(__SSE4_1__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DVD_HAVE_SSE41
+#include <smmintrin.h>
+#endif
+
+#if defined(DVD_HAVE_SSE41)
+
+/* Write combined memory, like a locked hardware surface, is uncached, so
+ * every plain load is a full bus transaction. Streaming loads pull a whole
+ * line into a fill buffer at once, as long as all four parts of the line
+ * are read back to back.
+ */
+static void CopyRowSSE41(uint8_t* dst, const uint8_t* src, int width)
+{
+  /* the loads have to be aligned, the stores can't be */
+  int head = (16 - ((uintptr_t)src & 15)) & 15;
+  if (head > width)
+    head = width;
+  memcpy(dst, src, head);
+  dst   += head;
+  src   += head;
+  width -= head;
+
+  int x = 0;
+  for (; x + 64 <= width; x += 64)
+  {
+    __m128i a = _mm_stream_load_si128((__m128i*)(src + x));
+    __m128i b = _mm_stream_load_si128((__m128i*)(src + x + 16));
+    __m128i c = _mm_stream_load_si128((__m128i*)(src + x + 32));
+    __m128i d = _mm_stream_load_si128((__m128i*)(src + x + 48));
+    _mm_storeu_si128((__m128i*)(dst + x),      a);
+    _mm_storeu_si128((__m128i*)(dst + x + 16), b);
+    _mm_storeu_si128((__m128i*)(dst + x + 32), c);
+    _mm_storeu_si128((__m128i*)(dst + x + 48), d);
+  }
+  for (; x + 16 <= width; x += 16)
+    _mm_storeu_si128((__m128i*)(dst + x), _mm_stream_load_si128((__m128i*)(src + x)));
+
+  memcpy(dst + x, src + x, width - x);
+}
+
+static void CopyPlaneSSE41(uint8_t* dst, int dstStride, const uint8_t* src, int srcStride, int width, int height)
+{
+  _mm_mfence();
+  for (int y = 0; y < height; y++)
+    CopyRowSSE41(dst + y * dstStride, src + y * srcStride, width);
+}
+
+DVDCopyPlaneFn CDVDCodecUtilsSIMD::CopyPlaneSSE41() { return &::CopyPlaneSSE41; }
+
+#else
+
+DVDCopyPlaneFn CDVDCodecUtilsSIMD::CopyPlaneSSE41() { return NULL; }
+
+#endif
@@ -237,4 +237,15 @@ public:
   {
     return 0;
   }
+
+  /*
+   *
+   * How many packets the codec takes in before it returns
+   * the picture of the first one, not counting reordering.
+   * Frame threaded decoders hold one picture per thread.
+   */
+  virtual unsigned GetFrameDelay()
+  {
+    return 0;
+  }
 };
@@ -138,6 +138,7 @@ CDVDVideoCodecFFmpeg::CDVDVideoCodecFFmpeg() : CDVDVideoCodec()
   m_iScreenHeight = 0;
   m_iOrientation = 0;
   m_bSoftware = false;
+  m_bFrameThreads = false;
   m_pHardware = NULL;
   m_iLastKeyframe = 0;
   m_dts = DVD_NOPTS_VALUE;
@@ -192,8 +193,18 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
     }
   }
 
+  /* threading has to be settled before any hardware is set up, frame threads rule it out */
+  int num_threads = g_advancedSettings.m_videoDecodeThreads;
+  if (num_threads <= 0)
+    num_threads = std::min(8 /*MAX_THREADS*/, g_cpuInfo.getCPUCount());
+  if (hints.software // thumbnail extraction fails when run threaded
+  || (hints.codec != CODEC_ID_H264
+   && hints.codec != CODEC_ID_MPEG4))
+    num_threads = 1;
+  m_bFrameThreads = num_threads > 1 && UseFrameThreads();
+
 #ifdef HAVE_LIBVDPAU
-  if(g_guiSettings.GetBool("videoplayer.usevdpau") && !m_bSoftware)
+  if(g_guiSettings.GetBool("videoplayer.usevdpau") && IsHardwareAllowed())
   {
     while((pCodec = m_dllAvCodec.av_codec_next(pCodec)))
     {
@@ -245,9 +256,9 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
   m_pCodecContext->workaround_bugs = FF_BUG_AUTODETECT;
   m_pCodecContext->get_format = GetFormat;
   m_pCodecContext->codec_tag = hints.codec_tag;
-  /* Only allow slice threading, since frame threading is more
+  /* Default to slice threading, frame threading is more
    * sensitive to changes in frame sizes, and it causes crashes
-   * during HW accell */
+   * during HW accell, so it's only added when chosen above */
   m_pCodecContext->thread_type = FF_THREAD_SLICE;
 
 #if defined(TARGET_DARWIN_IOS)
@@ -282,7 +293,14 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
     m_pCodecContext->skip_loop_filter = (AVDiscard)g_advancedSettings.m_iSkipLoopFilter;
   }
 
-  // set any special options
+  if (num_threads > 1 && m_pHardware == NULL)
+  {
+    m_pCodecContext->thread_count = num_threads;
+    if (m_bFrameThreads)
+      m_pCodecContext->thread_type |= FF_THREAD_FRAME;
+  }
+
+  // set any special options, these may override the threading
   for(std::vector<CDVDCodecOption>::iterator it = options.m_keys.begin(); it != options.m_keys.end(); it++)
   {
     if (it->m_name == "surfaces")
@@ -291,18 +309,17 @@ bool CDVDVideoCodecFFmpeg::Open(CDVDStreamInfo &hints, CDVDCodecOptions &options
       m_dllAvUtil.av_opt_set(m_pCodecContext, it->m_name.c_str(), it->m_value.c_str(), 0);
   }
 
-  int num_threads = std::min(8 /*MAX_THREADS*/, g_cpuInfo.getCPUCount());
-  if( num_threads > 1 && !hints.software && m_pHardware == NULL // thumbnail extraction fails when run threaded
-  && ( pCodec->id == CODEC_ID_H264
-    || pCodec->id == CODEC_ID_MPEG4 ))
-    m_pCodecContext->thread_count = num_threads;
-
   if (m_dllAvCodec.avcodec_open2(m_pCodecContext, pCodec, NULL) < 0)
   {
     CLog::Log(LOGDEBUG,"CDVDVideoCodecFFmpeg::Open() Unable to open codec");
     return false;
   }
 
+  // go by what ffmpeg settled on, not all codecs support frame threads
+  m_bFrameThreads = (m_pCodecContext->active_thread_type & FF_THREAD_FRAME) != 0;
+  if (m_pCodecContext->thread_count > 1)
+    CLog::Log(LOGNOTICE,"CDVDVideoCodecFFmpeg::Open() Using %d %s threads", m_pCodecContext->thread_count, m_bFrameThreads ? "frame" : "slice");
+
   m_pFrame = m_dllAvCodec.avcodec_alloc_frame();
   if (!m_pFrame) return false;
 
@@ -457,13 +474,15 @@ int CDVDVideoCodecFFmpeg::Decode(BYTE* pData, int iSize, double dts, double pts)
       return result;
   }
 
-  m_dts = dts;
   m_pCodecContext->reordered_opaque = pts_dtoi(pts);
 
+  /* the dts travels with the packet, with frame threads the
+   * picture we get back belongs to an earlier packet */
   AVPacket avpkt;
   m_dllAvCodec.av_init_packet(&avpkt);
   avpkt.data = pData;
   avpkt.size = iSize;
+  avpkt.dts  = pts_dtoi(dts);
   /* We lie, but this flag is only used by pngdec.c.
    * Setting it correctly would allow CorePNG decoding. */
   avpkt.flags = AV_PKT_FLAG_KEY;
@@ -481,6 +500,11 @@ int CDVDVideoCodecFFmpeg::Decode(BYTE* pData, int iSize, double dts, double pts)
   if (!iGotPicture)
     return VC_BUFFER;
 
+  if (m_pFrame->pkt_dts == (int64_t)AV_NOPTS_VALUE)
+    m_dts = DVD_NOPTS_VALUE;
+  else
+    m_dts = pts_itod(m_pFrame->pkt_dts);
+
   if(m_pFrame->key_frame)
   {
     m_started = true;
@@ -860,3 +884,37 @@ unsigned CDVDVideoCodecFFmpeg::GetConvergeCount()
   else
     return 0;
 }
+
+unsigned CDVDVideoCodecFFmpeg::GetFrameDelay()
+{
+  if(m_bFrameThreads)
+    return m_pCodecContext->thread_count - 1;
+  else
+    return 0;
+}
+
+bool CDVDVideoCodecFFmpeg::UseFrameThreads()
+{
+  const CStdString &mode = g_advancedSettings.m_videoDecodeThreading;
+  if(mode.Equals("frame"))
+    return true;
+  if(mode.Equals("slice"))
+    return false;
+
+  /* auto, only when no hardware decoding would be tried */
+  if(m_bSoftware)
+    return true;
+#ifdef HAVE_LIBVDPAU
+  if(g_guiSettings.GetBool("videoplayer.usevdpau"))
+    return false;
+#endif
+#ifdef HAS_DX
+  if(g_guiSettings.GetBool("videoplayer.usedxva2"))
+    return false;
+#endif
+#ifdef HAVE_LIBVA
+  if(g_guiSettings.GetBool("videoplayer.usevaapi"))
+    return false;
+#endif
+  return true;
+}
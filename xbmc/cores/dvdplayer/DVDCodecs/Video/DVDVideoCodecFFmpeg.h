@@ -60,8 +60,9 @@ public:
   virtual unsigned int SetFilters(unsigned int filters);
   virtual const char* GetName() { return m_name.c_str(); }; // m_name is never changed after open
   virtual unsigned GetConvergeCount();
+  virtual unsigned GetFrameDelay();
 
-  bool               IsHardwareAllowed()                     { return !m_bSoftware; }
+  bool               IsHardwareAllowed()                     { return !m_bSoftware && !m_bFrameThreads; }
   IHardwareDecoder * GetHardware()                           { return m_pHardware; };
   void               SetHardware(IHardwareDecoder* hardware) 
   {
@@ -73,6 +74,8 @@ public:
 protected:
   static enum PixelFormat GetFormat(struct AVCodecContext * avctx, const PixelFormat * fmt);
 
+  bool UseFrameThreads();
+
   int  FilterOpen(const CStdString& filters, bool scale);
   void FilterClose();
   int  FilterProcess(AVFrame* frame);
@@ -114,6 +117,7 @@ protected:
 
   std::string m_name;
   bool              m_bSoftware;
+  bool              m_bFrameThreads;
   IHardwareDecoder *m_pHardware;
   int m_iLastKeyframe;
   double m_dts;
@@ -180,6 +180,19 @@ static int dvd_file_read(void *h, uint8_t* buf, int size)
     return -1;
 
   CDVDInputStream* pInputStream = (CDVDInputStream*)h;
+
+  // mapped streams are copied straight into the avio buffer
+  const BYTE* data;
+  int ret = pInputStream->Peek(&data, size);
+  if(ret > 0)
+  {
+    memcpy(buf, data, ret);
+    pInputStream->Consume(ret);
+    return ret;
+  }
+  if(ret == 0)
+    return 0;
+
   return pInputStream->Read(buf, size);
 }
 /*
@@ -23,7 +23,13 @@
 #endif
 #include "DVDDemuxUtils.h"
 #include "DVDClock.h"
+#include "threads/Atomics.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
+
+#include <vector>
+
 extern "C" {
 #if (defined USE_EXTERNAL_FFMPEG)
   #if (defined HAVE_LIBAVCODEC_AVCODEC_H)
@@ -36,13 +42,201 @@ extern "C" {
 #endif
 }
 
+/* payload size classes from 256 bytes to 1MB in powers of two, bigger payloads bypass the pool */
+#define POOL_MIN_SHIFT   8
+#define POOL_CLASSES     13
+/* most payload bytes kept for reuse, the rest goes back to the heap */
+#define POOL_MAX_BYTES   (16 * 1024 * 1024)
+/* most packet structs kept for reuse */
+#define POOL_MAX_PACKETS 1024
+/* in front of every payload, remembers its size class and keeps pData 16 byte aligned */
+#define POOL_HEADER      16
+
+/*
+ * Demuxer, player and decoder threads all allocate and free packets, so
+ * every size class has its own lock and the counters are atomic. The lock
+ * only covers a push or pop of the free list.
+ */
+class CDemuxPacketPool
+{
+public:
+  CDemuxPacketPool() :
+    m_allocs(0),
+    m_hits  (0),
+    m_inuse (0),
+    m_pooled(0),
+    m_peak  (0)
+  {
+  }
+
+  ~CDemuxPacketPool()
+  {
+    Release();
+  }
+
+  DemuxPacket* GetPacket(bool &hit)
+  {
+    DemuxPacket* pPacket = NULL;
+    {
+      CSingleLock lock(m_packetLock);
+      if (!m_packets.empty())
+      {
+        pPacket = m_packets.back();
+        m_packets.pop_back();
+      }
+    }
+
+    hit = pPacket != NULL;
+    if (!pPacket)
+      pPacket = new DemuxPacket;
+    return pPacket;
+  }
+
+  void PutPacket(DemuxPacket* pPacket)
+  {
+    {
+      CSingleLock lock(m_packetLock);
+      if (m_packets.size() < POOL_MAX_PACKETS)
+      {
+        m_packets.push_back(pPacket);
+        return;
+      }
+    }
+    delete pPacket;
+  }
+
+  BYTE* GetData(int size, bool &hit)
+  {
+    int cls = 0;
+    while (cls < POOL_CLASSES && (1 << (cls + POOL_MIN_SHIFT)) < size)
+      cls++;
+
+    BYTE* block    = NULL;
+    long  capacity = size;
+    if (cls < POOL_CLASSES)
+    {
+      capacity = 1 << (cls + POOL_MIN_SHIFT);
+
+      CSingleLock lock(m_classes[cls].lock);
+      if (!m_classes[cls].free.empty())
+      {
+        block = m_classes[cls].free.back();
+        m_classes[cls].free.pop_back();
+      }
+    }
+
+    hit = block != NULL;
+    if (block)
+      AtomicSubtract(&m_pooled, capacity);
+    else
+    {
+      block = (BYTE*)_aligned_malloc(POOL_HEADER + capacity + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+      if (!block)
+        return NULL;
+      ((int*)block)[0] = cls < POOL_CLASSES ? cls : -1;
+      ((int*)block)[1] = capacity;
+    }
+
+    AtomicAdd(&m_inuse, capacity);
+    UpdatePeak();
+    return block + POOL_HEADER;
+  }
+
+  void PutData(BYTE* pData)
+  {
+    BYTE* block    = pData - POOL_HEADER;
+    int   cls      = ((int*)block)[0];
+    long  capacity = ((int*)block)[1];
+
+    AtomicSubtract(&m_inuse, capacity);
+    if (cls >= 0)
+    {
+      if (AtomicAdd(&m_pooled, capacity) <= POOL_MAX_BYTES)
+      {
+        CSingleLock lock(m_classes[cls].lock);
+        m_classes[cls].free.push_back(block);
+        return;
+      }
+      AtomicSubtract(&m_pooled, capacity);
+    }
+    _aligned_free(block);
+  }
+
+  void Count(bool hit)
+  {
+    AtomicIncrement(&m_allocs);
+    if (hit)
+      AtomicIncrement(&m_hits);
+  }
+
+  void GetStats(DemuxPacketPoolStats& stats)
+  {
+    stats.allocs = m_allocs;
+    stats.hits   = m_hits;
+    stats.inuse  = m_inuse;
+    stats.pooled = m_pooled;
+    stats.peak   = m_peak;
+  }
+
+  void Release()
+  {
+    for (int cls = 0; cls < POOL_CLASSES; cls++)
+    {
+      std::vector<BYTE*> blocks;
+      {
+        CSingleLock lock(m_classes[cls].lock);
+        blocks.swap(m_classes[cls].free);
+      }
+      for (std::vector<BYTE*>::iterator it = blocks.begin(); it != blocks.end(); ++it)
+      {
+        AtomicSubtract(&m_pooled, ((int*)*it)[1]);
+        _aligned_free(*it);
+      }
+    }
+
+    std::vector<DemuxPacket*> packets;
+    {
+      CSingleLock lock(m_packetLock);
+      packets.swap(m_packets);
+    }
+    for (std::vector<DemuxPacket*>::iterator it = packets.begin(); it != packets.end(); ++it)
+      delete *it;
+  }
+
+private:
+  void UpdatePeak()
+  {
+    long total = m_inuse + m_pooled;
+    long peak;
+    while ((peak = m_peak) < total && cas(&m_peak, peak, total) != peak) {}
+  }
+
+  struct SizeClass
+  {
+    CCriticalSection   lock;
+    std::vector<BYTE*> free;
+  };
+
+  SizeClass                 m_classes[POOL_CLASSES];
+  CCriticalSection          m_packetLock;
+  std::vector<DemuxPacket*> m_packets;
+
+  volatile long m_allocs;
+  volatile long m_hits;
+  volatile long m_inuse;
+  volatile long m_pooled;
+  volatile long m_peak;
+};
+
+static CDemuxPacketPool g_demuxPacketPool;
+
 void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 {
   if (pPacket)
   {
     try {
-      if (pPacket->pData) _aligned_free(pPacket->pData);
-      delete pPacket;
+      if (pPacket->pData) g_demuxPacketPool.PutData(pPacket->pData);
+      g_demuxPacketPool.PutPacket(pPacket);
     }
     catch(...) {
       CLog::Log(LOGERROR, "%s - Exception thrown while freeing packet", __FUNCTION__);
@@ -52,7 +246,8 @@ void CDVDDemuxUtils::FreeDemuxPacket(DemuxPacket* pPacket)
 
 DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
 {
-  DemuxPacket* pPacket = new DemuxPacket;
+  bool hit;
+  DemuxPacket* pPacket = g_demuxPacketPool.GetPacket(hit);
   if (!pPacket) return NULL;
 
   try
@@ -70,12 +265,14 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
         * Note, if the first 23 bits of the additional bytes are not 0 then damaged
         * MPEG bitstreams could cause overread and segfault
         */
-      pPacket->pData =(BYTE*)_aligned_malloc(iDataSize + FF_INPUT_BUFFER_PADDING_SIZE, 16);
+      bool dataHit;
+      pPacket->pData = g_demuxPacketPool.GetData(iDataSize, dataHit);
       if (!pPacket->pData)
       {
         FreeDemuxPacket(pPacket);
         return NULL;
       }
+      hit = hit && dataHit;
 
       // reset the last 8 bytes to 0;
       memset(pPacket->pData + iDataSize, 0, FF_INPUT_BUFFER_PADDING_SIZE);
@@ -85,6 +282,8 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
     pPacket->dts       = DVD_NOPTS_VALUE;
     pPacket->pts       = DVD_NOPTS_VALUE;
     pPacket->iStreamId = -1;
+
+    g_demuxPacketPool.Count(hit);
   }
   catch(...)
   {
@@ -94,3 +293,13 @@ DemuxPacket* CDVDDemuxUtils::AllocateDemuxPacket(int iDataSize)
   }
   return pPacket;
 }
+
+void CDVDDemuxUtils::GetPoolStats(DemuxPacketPoolStats& stats)
+{
+  g_demuxPacketPool.GetStats(stats);
+}
+
+void CDVDDemuxUtils::ReleasePool()
+{
+  g_demuxPacketPool.Release();
+}
@@ -22,10 +22,25 @@
 
 #include "DVDDemuxPacket.h"
 
+#include <stdint.h>
+
+typedef struct DemuxPacketPoolStats
+{
+  long    allocs;  // packets allocated
+  long    hits;    // allocations served from the pool without touching the heap
+  int64_t inuse;   // payload bytes handed out and not yet freed
+  int64_t pooled;  // payload bytes kept for reuse
+  int64_t peak;    // highest inuse + pooled seen
+} DemuxPacketPoolStats;
+
 class CDVDDemuxUtils
 {
 public:
   static void FreeDemuxPacket(DemuxPacket* pPacket);
   static DemuxPacket* AllocateDemuxPacket(int iDataSize = 0);
+
+  /* packets and payloads are recycled through size classed free lists */
+  static void GetPoolStats(DemuxPacketPoolStats& stats);
+  static void ReleasePool();
 };
 
@@ -134,6 +134,14 @@ public:
   virtual int Read(BYTE* buf, int buf_size) = 0;
   virtual int64_t Seek(int64_t offset, int whence) = 0;
   virtual bool Pause(double dTime) = 0;
+
+  /*! \brief Read without copying from streams in memory
+   Points buf at up to buf_size bytes at the read position, they stay valid
+   until the next call on the stream. Consume moves the position past them.
+   \return the bytes available, 0 at the end of the stream, -1 if not supported
+   */
+  virtual int Peek(const BYTE** buf, int buf_size) { return -1; }
+  virtual void Consume(int size) {}
   virtual int64_t GetLength() = 0;
   virtual std::string& GetContent() { return m_content; };
   virtual std::string& GetFileName() { return m_strFileName; }
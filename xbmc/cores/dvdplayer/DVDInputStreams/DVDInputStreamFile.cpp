@@ -21,6 +21,7 @@
 #include "DVDInputStreamFile.h"
 #include "filesystem/File.h"
 #include "filesystem/IFile.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 
@@ -51,8 +52,12 @@ bool CDVDInputStreamFile::Open(const char* strFile, const std::string& content)
   if (!m_pFile)
     return false;
 
+  unsigned int flags = READ_TRUNCATED | READ_BITRATE | READ_CHUNKED;
+  if (g_advancedSettings.m_mmapLocalFiles)
+    flags |= READ_MMAP;
+
   // open file in binary mode
-  if (!m_pFile->Open(strFile, READ_TRUNCATED | READ_BITRATE | READ_CHUNKED))
+  if (!m_pFile->Open(strFile, flags))
   {
     delete m_pFile;
     m_pFile = NULL;
@@ -92,6 +97,22 @@ int CDVDInputStreamFile::Read(BYTE* buf, int buf_size)
   return (int)(ret & 0xFFFFFFFF);
 }
 
+int CDVDInputStreamFile::Peek(const BYTE** buf, int buf_size)
+{
+  if(!m_pFile) return -1;
+
+  int ret = m_pFile->Peek((const void**)buf, buf_size);
+  if( ret == 0 ) m_eof = true;
+
+  return ret;
+}
+
+void CDVDInputStreamFile::Consume(int size)
+{
+  if(m_pFile)
+    m_pFile->Consume(size);
+}
+
 int64_t CDVDInputStreamFile::Seek(int64_t offset, int whence)
 {
   if(!m_pFile) return -1;
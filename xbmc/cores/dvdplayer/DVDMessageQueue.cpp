@@ -27,9 +27,56 @@
 
 using namespace std;
 
-CDVDMessageQueue::CDVDMessageQueue(const string &owner) : m_hEvent(true)
+/* initial ring sizes, demux packets are put at priority 0 */
+#define MSGQ_SLOTS_DATA  256
+#define MSGQ_SLOTS_OTHER 16
+
+void CDVDMessageQueue::SPriorityQueue::Push(CDVDMsg* msg)
+{
+  if (count == slots.size())
+  {
+    // full, double the ring and unwrap it
+    vector<CDVDMsg*> grown(max<size_t>(slots.size() * 2, MSGQ_SLOTS_OTHER), (CDVDMsg*)NULL);
+    for (unsigned int i = 0; i < count; i++)
+      grown[i] = At(i);
+    slots.swap(grown);
+    head = 0;
+  }
+  slots[(head + count) % slots.size()] = msg;
+  count++;
+}
+
+CDVDMsg* CDVDMessageQueue::SPriorityQueue::Pop()
+{
+  CDVDMsg* msg = slots[head];
+  slots[head] = NULL;
+  head = (head + 1) % slots.size();
+  count--;
+  return msg;
+}
+
+void CDVDMessageQueue::SPriorityQueue::Remove(CDVDMsg::Message type)
+{
+  // compact the messages we keep towards the head, order is preserved
+  unsigned int kept = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    unsigned int slot = (head + i) % slots.size();
+    CDVDMsg*     msg  = slots[slot];
+    slots[slot] = NULL;
+
+    if (msg->IsType(type) || type == CDVDMsg::NONE)
+      msg->Release();
+    else
+      slots[(head + kept++) % slots.size()] = msg;
+  }
+  count = kept;
+}
+
+CDVDMessageQueue::CDVDMessageQueue(const string &owner)
 {
   m_owner = owner;
+  m_iWaiters      = 0;
   m_iDataSize     = 0;
   m_bAbortRequest = false;
   m_bInitialized  = false;
@@ -40,12 +87,18 @@ CDVDMessageQueue::CDVDMessageQueue(const string &owner) : m_hEvent(true)
   m_TimeFront     = DVD_NOPTS_VALUE;
   m_TimeSize      = 1.0 / 4.0; /* 4 seconds */
   m_iMaxDataSize  = 0;
+
+  m_queues.push_back(SPriorityQueue(0, MSGQ_SLOTS_DATA));
 }
 
 CDVDMessageQueue::~CDVDMessageQueue()
 {
   // remove all remaining messages
   Flush();
+
+  // and release whatever else is left, the rings don't own their messages
+  for(SQueues::iterator it = m_queues.begin(); it != m_queues.end(); it++)
+    it->Remove(CDVDMsg::NONE);
 }
 
 void CDVDMessageQueue::Init()
@@ -62,13 +115,8 @@ void CDVDMessageQueue::Flush(CDVDMsg::Message type)
 {
   CSingleLock lock(m_section);
 
-  for(SList::iterator it = m_list.begin(); it != m_list.end();)
-  {
-    if (it->message->IsType(type) ||  type == CDVDMsg::NONE)
-      it = m_list.erase(it);
-    else
-      it++;
-  }
+  for(SQueues::iterator it = m_queues.begin(); it != m_queues.end(); it++)
+    it->Remove(type);
 
   if (type == CDVDMsg::DEMUXER_PACKET ||  type == CDVDMsg::NONE)
   {
@@ -85,7 +133,7 @@ void CDVDMessageQueue::Abort()
 
   m_bAbortRequest = true;
 
-  m_hEvent.Set(); // inform waiter for abort action
+  m_condition.notifyAll(); // inform waiters for abort action
 }
 
 void CDVDMessageQueue::End()
@@ -99,6 +147,17 @@ void CDVDMessageQueue::End()
   m_bAbortRequest = false;
 }
 
+CDVDMessageQueue::SPriorityQueue& CDVDMessageQueue::GetQueue(int priority)
+{
+  SQueues::iterator it = m_queues.begin();
+  while(it != m_queues.end() && it->priority > priority)
+    it++;
+
+  if(it == m_queues.end() || it->priority != priority)
+    it = m_queues.insert(it, SPriorityQueue(priority, MSGQ_SLOTS_OTHER));
+
+  return *it;
+}
 
 MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
 {
@@ -116,14 +175,8 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     return MSGQ_INVALID_MSG;
   }
 
-  SList::iterator it = m_list.begin();
-  while(it != m_list.end())
-  {
-    if(priority <= it->priority)
-      break;
-    it++;
-  }
-  m_list.insert(it, DVDMessageListItem(pMsg, priority));
+  // the queue takes over the reference of the caller
+  GetQueue(priority).Push(pMsg);
 
   if (pMsg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
   {
@@ -140,9 +193,11 @@ MsgQueueReturnCode CDVDMessageQueue::Put(CDVDMsg* pMsg, int priority)
     }
   }
 
-  pMsg->Release();
-
-  m_hEvent.Set(); // inform waiter for new packet
+  // inform waiter for new packet, there normally is only the one
+  if (m_iWaiters == 1)
+    m_condition.notify();
+  else if (m_iWaiters > 1)
+    m_condition.notifyAll();
 
   return MSGQ_OK;
 }
@@ -161,7 +216,11 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     return MSGQ_NOT_INITIALIZED;
   }
 
-  if(m_list.empty() && m_bEmptied == false && priority == 0 && m_owner != "teletext")
+  SQueues::iterator it = m_queues.begin();
+  while(it != m_queues.end() && it->count == 0)
+    it++;
+
+  if(it == m_queues.end() && m_bEmptied == false && priority == 0 && m_owner != "teletext")
   {
 #if !defined(TARGET_RASPBERRY_PI)
     CLog::Log(LOGWARNING, "CDVDMessageQueue(%s)::Get - asked for new data packet, with nothing available", m_owner.c_str());
@@ -169,16 +228,22 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
     m_bEmptied = true;
   }
 
+  XbmcThreads::EndTime timeout(iTimeoutInMilliSeconds);
   while (!m_bAbortRequest)
   {
-    if(!m_list.empty() && m_list.back().priority >= priority && !m_bCaching)
+    // the highest priority message goes first, in the order they were put
+    it = m_queues.begin();
+    while(it != m_queues.end() && it->count == 0)
+      it++;
+
+    if(it != m_queues.end() && it->priority >= priority && !m_bCaching)
     {
-      DVDMessageListItem& item(m_list.back());
-      priority = item.priority;
+      CDVDMsg* msg = it->Pop();
+      priority = it->priority;
 
-      if (item.message->IsType(CDVDMsg::DEMUXER_PACKET) && item.priority == 0)
+      if (msg->IsType(CDVDMsg::DEMUXER_PACKET) && priority == 0)
       {
-        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)item.message)->GetPacket();
+        DemuxPacket* packet = ((CDVDMsgDemuxerPacket*)msg)->GetPacket();
         if(packet)
         {
           m_iDataSize -= packet->iSize;
@@ -192,28 +257,23 @@ MsgQueueReturnCode CDVDMessageQueue::Get(CDVDMsg** pMsg, unsigned int iTimeoutIn
           m_bEmptied = false;
       }
 
-      *pMsg = item.message->Acquire();
-      m_list.pop_back();
+      *pMsg = msg;
 
       ret = MSGQ_OK;
       break;
     }
-    else if (!iTimeoutInMilliSeconds)
+
+    unsigned int left = timeout.MillisLeft();
+    if (!left)
     {
       ret = MSGQ_TIMEOUT;
       break;
     }
-    else
-    {
-      m_hEvent.Reset();
-      lock.Leave();
-
-      // wait for a new message
-      if (!m_hEvent.WaitMSec(iTimeoutInMilliSeconds))
-        return MSGQ_TIMEOUT;
 
-      lock.Enter();
-    }
+    // wait for a new message
+    m_iWaiters++;
+    m_condition.wait(lock, left);
+    m_iWaiters--;
   }
 
   if (m_bAbortRequest) return MSGQ_ABORT;
@@ -230,10 +290,13 @@ unsigned CDVDMessageQueue::GetPacketCount(CDVDMsg::Message type)
     return 0;
 
   unsigned count = 0;
-  for(SList::iterator it = m_list.begin(); it != m_list.end();it++)
+  for(SQueues::iterator it = m_queues.begin(); it != m_queues.end(); it++)
   {
-    if(it->message->IsType(type))
-      count++;
+    for(unsigned int i = 0; i < it->count; i++)
+    {
+      if(it->At(i)->IsType(type))
+        count++;
+    }
   }
 
   return count;
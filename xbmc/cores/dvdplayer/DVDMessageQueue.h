@@ -23,50 +23,9 @@
 #include "DVDMessage.h"
 #include <string>
 #include <list>
+#include <vector>
 #include "threads/CriticalSection.h"
-#include "threads/Event.h"
-
-struct DVDMessageListItem
-{
-  DVDMessageListItem(CDVDMsg* msg, int prio)
-  {
-    message  = msg->Acquire();
-    priority = prio;
-  }
-  DVDMessageListItem()
-  {
-    message  = NULL;
-    priority = 0;
-  }
-  DVDMessageListItem(const DVDMessageListItem& item)
-  {
-    if(item.message)
-      message = item.message->Acquire();
-    else
-      message = NULL;
-    priority = item.priority;
-  }
- ~DVDMessageListItem()
-  {
-    if(message)
-      message->Release();
-  }
-
-  DVDMessageListItem& operator=(const DVDMessageListItem& item)
-  {
-    if(message)
-      message->Release();
-    if(item.message)
-      message = item.message->Acquire();
-    else
-      message = NULL;
-    priority = item.priority;
-    return *this;
-  }
-
-  CDVDMsg* message;
-  int      priority;
-};
+#include "threads/Condition.h"
 
 enum MsgQueueReturnCode
 {
@@ -124,8 +83,27 @@ public:
 
 private:
 
-  CEvent m_hEvent;
+  /* messages of one priority in arrival order, a ring over preallocated slots */
+  struct SPriorityQueue
+  {
+    SPriorityQueue(int prio, unsigned int size) : priority(prio), slots(size, (CDVDMsg*)NULL), head(0), count(0) {}
+
+    void     Push(CDVDMsg* msg);
+    CDVDMsg* Pop();
+    CDVDMsg* At(unsigned int index) const { return slots[(head + index) % slots.size()]; }
+    void     Remove(CDVDMsg::Message type);
+
+    int                   priority;
+    std::vector<CDVDMsg*> slots;
+    unsigned int          head;
+    unsigned int          count;
+  };
+
+  SPriorityQueue& GetQueue(int priority);
+
+  XbmcThreads::ConditionVariable m_condition;
   mutable CCriticalSection m_section;
+  int m_iWaiters; // threads blocked in Get
 
   bool m_bAbortRequest;
   bool m_bInitialized;
@@ -140,7 +118,7 @@ private:
   bool m_bEmptied;
   std::string m_owner;
 
-  typedef std::list<DVDMessageListItem> SList;
-  SList m_list;
+  typedef std::vector<SPriorityQueue> SQueues;
+  SQueues m_queues; // highest priority first
 };
 
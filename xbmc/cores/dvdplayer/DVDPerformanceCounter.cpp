@@ -20,6 +20,8 @@
 
 #include "DVDPerformanceCounter.h"
 #include "DVDMessageQueue.h"
+#include "DVDPictureQueue.h"
+#include "threads/Atomics.h"
 #include "utils/TimeUtils.h"
 
 #include "dvd_config.h"
@@ -66,6 +68,27 @@ HRESULT __stdcall DVDPerformanceCounterVideoQueue(PLARGE_INTEGER numerator, PLAR
   return S_OK;
 }
 
+HRESULT __stdcall DVDPerformanceCounterPictureQueue(PLARGE_INTEGER numerator, PLARGE_INTEGER demoninator)
+{
+  numerator->QuadPart = 0LL;
+  if (g_dvdPerformanceCounter.m_pPictureQueue)
+    numerator->QuadPart = g_dvdPerformanceCounter.m_pPictureQueue->GetFrames();
+  return S_OK;
+}
+
+#define DVD_DROP_COUNTER(name, reason) \
+HRESULT __stdcall DVDPerformanceCounter##name(PLARGE_INTEGER numerator, PLARGE_INTEGER demoninator) \
+{ \
+  numerator->QuadPart = g_dvdPerformanceCounter.GetVideoDrops(reason); \
+  return S_OK; \
+}
+
+DVD_DROP_COUNTER(VideoDropDecoder,  VIDEO_DROP_DECODER)
+DVD_DROP_COUNTER(VideoDropLate,     VIDEO_DROP_LATE)
+DVD_DROP_COUNTER(VideoDropSpeed,    VIDEO_DROP_SPEED)
+DVD_DROP_COUNTER(VideoDropRenderer, VIDEO_DROP_RENDERER)
+DVD_DROP_COUNTER(VideoDropFlush,    VIDEO_DROP_FLUSH)
+
 inline int64_t get_thread_cpu_usage(ProcessPerformance* p)
 {
   if (p->thread)
@@ -117,6 +140,8 @@ CDVDPerformanceCounter::CDVDPerformanceCounter()
 {
   m_pAudioQueue = NULL;
   m_pVideoQueue = NULL;
+  m_pPictureQueue = NULL;
+  memset((void*)m_videoDrops, 0, sizeof(m_videoDrops));
 
   memset(&m_videoDecodePerformance, 0, sizeof(m_videoDecodePerformance)); // video decoding
   memset(&m_audioDecodePerformance, 0, sizeof(m_audioDecodePerformance)); // audio decoding + output to audio device
@@ -141,6 +166,12 @@ bool CDVDPerformanceCounter::Initialize()
   DmRegisterPerformanceCounter("DVDVideoDecodePerformance",   DMCOUNT_SYNC, DVDPerformanceCounterVideoDecodePerformance);
   DmRegisterPerformanceCounter("DVDAudioDecodePerformance",   DMCOUNT_SYNC, DVDPerformanceCounterAudioDecodePerformance);
   DmRegisterPerformanceCounter("DVDMainPerformance",          DMCOUNT_SYNC, DVDPerformanceCounterMainPerformance);
+  DmRegisterPerformanceCounter("DVDVideoPictureQueue",        DMCOUNT_SYNC, DVDPerformanceCounterPictureQueue);
+  DmRegisterPerformanceCounter("DVDVideoDropDecoder",         DMCOUNT_SYNC, DVDPerformanceCounterVideoDropDecoder);
+  DmRegisterPerformanceCounter("DVDVideoDropLate",            DMCOUNT_SYNC, DVDPerformanceCounterVideoDropLate);
+  DmRegisterPerformanceCounter("DVDVideoDropSpeed",           DMCOUNT_SYNC, DVDPerformanceCounterVideoDropSpeed);
+  DmRegisterPerformanceCounter("DVDVideoDropRenderer",        DMCOUNT_SYNC, DVDPerformanceCounterVideoDropRenderer);
+  DmRegisterPerformanceCounter("DVDVideoDropFlush",           DMCOUNT_SYNC, DVDPerformanceCounterVideoDropFlush);
 
 #endif
 
@@ -152,3 +183,9 @@ void CDVDPerformanceCounter::DeInitialize()
 
 }
 
+void CDVDPerformanceCounter::AddVideoDrop(EVideoDropReason reason, long count)
+{
+  if (count > 0)
+    AtomicAdd(&m_videoDrops[reason], count);
+}
+
@@ -27,6 +27,17 @@
 #include "threads/SingleLock.h"
 
 class CDVDMessageQueue;
+class CDVDPictureQueue;
+
+enum EVideoDropReason
+{
+  VIDEO_DROP_DECODER = 0, // decoder was asked to skip a picture
+  VIDEO_DROP_LATE,        // output was too late for the clock
+  VIDEO_DROP_SPEED,       // skipped to keep up with ff/rw speed
+  VIDEO_DROP_RENDERER,    // no render buffer became free in time
+  VIDEO_DROP_FLUSH,       // decoded ahead but flushed before output
+  VIDEO_DROP_MAX
+};
 
 typedef struct stProcessPerformance
 {
@@ -50,6 +61,12 @@ public:
   void EnableVideoQueue(CDVDMessageQueue* pQueue)     { CSingleLock lock(m_critSection); m_pVideoQueue = pQueue;  }
   void DisableVideoQueue()                            { CSingleLock lock(m_critSection); m_pVideoQueue = NULL;  }
 
+  void EnablePictureQueue(CDVDPictureQueue* pQueue)   { CSingleLock lock(m_critSection); m_pPictureQueue = pQueue;  }
+  void DisablePictureQueue()                          { CSingleLock lock(m_critSection); m_pPictureQueue = NULL;  }
+
+  void AddVideoDrop(EVideoDropReason reason, long count = 1);
+  long GetVideoDrops(EVideoDropReason reason) const   { return m_videoDrops[reason]; }
+
   void EnableVideoDecodePerformance(CThread *thread)  { CSingleLock lock(m_critSection); m_videoDecodePerformance.thread = thread;  }
   void DisableVideoDecodePerformance()                { CSingleLock lock(m_critSection); m_videoDecodePerformance.thread = NULL;  }
 
@@ -61,6 +78,9 @@ public:
 
   CDVDMessageQueue*         m_pAudioQueue;
   CDVDMessageQueue*         m_pVideoQueue;
+  CDVDPictureQueue*         m_pPictureQueue;
+
+  volatile long             m_videoDrops[VIDEO_DROP_MAX];
 
   ProcessPerformance        m_videoDecodePerformance;
   ProcessPerformance        m_audioDecodePerformance;
@@ -0,0 +1,346 @@
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDPictureQueue.h"
+#include "threads/SingleLock.h"
+#include "utils/fastmemcpy.h"
+
+#include <algorithm>
+
+CDVDPictureQueue::CDVDPictureQueue()
+{
+  m_current   = NULL;
+  m_maxFrames = 0;
+  m_maxBytes  = 0;
+  m_bytes     = 0;
+  m_peak      = 0;
+  m_iShown    = 0;
+  m_bAbort    = false;
+  m_bPaused   = false;
+
+  m_result        = 0;
+  m_resultShown   = 0;
+  m_resultDropped = 0;
+}
+
+CDVDPictureQueue::~CDVDPictureQueue()
+{
+  End();
+}
+
+void CDVDPictureQueue::Init(unsigned int frames, unsigned int bytes)
+{
+  End();
+
+  CSingleLock lock(m_section);
+  m_maxFrames = frames;
+  m_maxBytes  = bytes;
+  m_peak      = 0;
+  m_bAbort    = false;
+  m_bPaused   = false;
+}
+
+void CDVDPictureQueue::End()
+{
+  CSingleLock lock(m_section);
+
+  Flush();
+  if (m_current)
+  {
+    Free(m_current);
+    m_current = NULL;
+  }
+
+  for (std::vector<SPicture*>::iterator it = m_free.begin(); it != m_free.end(); ++it)
+  {
+    delete[] (*it)->data;
+    delete *it;
+  }
+  m_free.clear();
+
+  m_bytes         = 0;
+  m_result        = 0;
+  m_resultShown   = 0;
+  m_resultDropped = 0;
+}
+
+bool CDVDPictureQueue::Supports(const DVDVideoPicture &picture) const
+{
+  return IsEnabled() && picture.format == RENDER_FMT_YUV420P;
+}
+
+CDVDPictureQueue::SPicture* CDVDPictureQueue::Allocate(unsigned int size)
+{
+  if (!size)
+  {
+    SPicture* pic = new SPicture;
+    pic->data = NULL;
+    pic->size = 0;
+    return pic;
+  }
+
+  // all pictures of a stream have the same size, anything else in the free list is stale
+  while (!m_free.empty())
+  {
+    SPicture* pic = m_free.back();
+    m_free.pop_back();
+    if (pic->size == size)
+      return pic;
+
+    delete[] pic->data;
+    delete pic;
+  }
+
+  SPicture* pic = new SPicture;
+  pic->data = size ? new BYTE[size] : NULL;
+  pic->size = size;
+  return pic;
+}
+
+void CDVDPictureQueue::Free(SPicture* pic)
+{
+  if (!pic->size)
+  {
+    delete pic;
+    return;
+  }
+
+  m_bytes -= pic->size;
+  m_free.push_back(pic);
+}
+
+bool CDVDPictureQueue::IsFull(unsigned int size) const
+{
+  // an empty queue always takes a picture, however big
+  if (m_queue.empty())
+    return false;
+
+  return m_queue.size() >= m_maxFrames
+      || m_bytes + size > m_maxBytes;
+}
+
+bool CDVDPictureQueue::Put(const DVDVideoPicture &picture, double pts, volatile bool &bStop)
+{
+  /* dropped pictures carry no data, only their timing is needed */
+  bool copy = !(picture.iFlags & DVP_FLAG_DROPPED) && picture.data[0];
+
+  unsigned int width  = picture.iWidth;
+  unsigned int height = picture.iHeight;
+  unsigned int size   = 0;
+  if (copy)
+    size = width * height + ((width + 1) >> 1) * ((height + 1) >> 1) * 2;
+
+  CSingleLock lock(m_section);
+
+  while (IsFull(size))
+  {
+    if (m_bAbort || bStop)
+      return false;
+    m_condition.wait(lock, 100);
+  }
+
+  if (m_bAbort)
+    return false;
+
+  SPicture* pic = Allocate(size);
+  pic->picture = picture;
+  pic->pts     = pts;
+
+  /* the decoder owns these, they are only valid until its next call */
+  pic->picture.qscale_table = NULL;
+  pic->picture.qscale_stride = 0;
+
+  if (copy)
+  {
+    /* copy the planes outside the lock, nobody else can see this picture yet */
+    m_bytes += size;
+    lock.Leave();
+
+    unsigned int w[3] = { width, (width + 1) >> 1, (width + 1) >> 1 };
+    unsigned int h[3] = { height, (height + 1) >> 1, (height + 1) >> 1 };
+
+    BYTE* d = pic->data;
+    for (int p = 0; p < 3; p++)
+    {
+      BYTE* s = picture.data[p];
+      pic->picture.data[p]      = d;
+      pic->picture.iLineSize[p] = w[p];
+
+      if ((unsigned int)picture.iLineSize[p] == w[p])
+        fast_memcpy(d, s, w[p] * h[p]);
+      else
+      {
+        for (unsigned int y = 0; y < h[p]; y++)
+          fast_memcpy(d + y * w[p], s + y * picture.iLineSize[p], w[p]);
+      }
+      d += w[p] * h[p];
+    }
+    pic->picture.data[3]      = NULL;
+    pic->picture.iLineSize[3] = 0;
+
+    lock.Enter();
+  }
+  else
+  {
+    for (int p = 0; p < 4; p++)
+    {
+      pic->picture.data[p]      = NULL;
+      pic->picture.iLineSize[p] = 0;
+    }
+  }
+
+  m_queue.push_back(pic);
+
+  unsigned int frames = m_queue.size() + (m_current ? 1 : 0);
+  if (frames > m_peak)
+    m_peak = frames;
+
+  m_condition.notifyAll();
+  return true;
+}
+
+bool CDVDPictureQueue::Get(DVDVideoPicture &picture, double &pts, unsigned int iTimeoutInMilliSeconds)
+{
+  CSingleLock lock(m_section);
+
+  XbmcThreads::EndTime timeout(iTimeoutInMilliSeconds);
+  while (m_queue.empty() || IsHolding() || m_current)
+  {
+    unsigned int left = timeout.MillisLeft();
+    if (m_bAbort || !left)
+      return false;
+    m_condition.wait(lock, left);
+  }
+
+  m_current = m_queue.front();
+  m_queue.pop_front();
+  m_iShown++;
+
+  picture = m_current->picture;
+  pts     = m_current->pts;
+  return true;
+}
+
+void CDVDPictureQueue::Release(int result, bool dropped)
+{
+  CSingleLock lock(m_section);
+  if (!m_current)
+    return;
+
+  /* pictures the player asked to drop are not counted, like in the video thread */
+  if (dropped)
+  {
+    if (!(m_current->picture.iFlags & DVP_FLAG_DROPPED))
+      m_resultDropped++;
+  }
+  else
+    m_resultShown++;
+
+  m_result |= result;
+
+  Free(m_current);
+  m_current = NULL;
+
+  m_condition.notifyAll();
+}
+
+int CDVDPictureQueue::TakeResult(unsigned int &shown, unsigned int &dropped)
+{
+  CSingleLock lock(m_section);
+
+  int result = m_result;
+  shown      = m_resultShown;
+  dropped    = m_resultDropped;
+
+  m_result        = 0;
+  m_resultShown   = 0;
+  m_resultDropped = 0;
+  return result;
+}
+
+unsigned int CDVDPictureQueue::Flush()
+{
+  CSingleLock lock(m_section);
+
+  unsigned int dropped = m_queue.size();
+  while (!m_queue.empty())
+  {
+    Free(m_queue.front());
+    m_queue.pop_front();
+  }
+  m_iShown = 0;
+
+  m_condition.notifyAll();
+  return dropped;
+}
+
+void CDVDPictureQueue::Abort()
+{
+  CSingleLock lock(m_section);
+  m_bAbort = true;
+  m_condition.notifyAll();
+}
+
+void CDVDPictureQueue::SetPaused(bool paused)
+{
+  CSingleLock lock(m_section);
+  m_bPaused = paused;
+  m_condition.notifyAll();
+}
+
+bool CDVDPictureQueue::WaitEmpty(volatile bool &bStop)
+{
+  CSingleLock lock(m_section);
+
+  while (!m_queue.empty() || m_current)
+  {
+    if (m_bAbort || bStop || (IsHolding() && !m_current))
+      return false;
+    m_condition.wait(lock, 100);
+  }
+  return true;
+}
+
+unsigned int CDVDPictureQueue::GetFrames() const
+{
+  CSingleLock lock(m_section);
+  return m_queue.size() + (m_current ? 1 : 0);
+}
+
+unsigned int CDVDPictureQueue::GetPeakFrames() const
+{
+  CSingleLock lock(m_section);
+  return m_peak;
+}
+
+unsigned int CDVDPictureQueue::GetBytes() const
+{
+  CSingleLock lock(m_section);
+  return m_bytes;
+}
+
+int CDVDPictureQueue::GetLevel() const
+{
+  CSingleLock lock(m_section);
+  if (!m_maxFrames)
+    return 0;
+  return std::min(100, (int)((m_queue.size() + (m_current ? 1 : 0)) * 100 / m_maxFrames));
+}
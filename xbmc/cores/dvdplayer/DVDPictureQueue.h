@@ -0,0 +1,109 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDCodecs/Video/DVDVideoCodec.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+
+#include <deque>
+#include <vector>
+
+/**
+ * Decoded pictures waiting for the renderer. The video thread copies the
+ * pictures it decodes in here, so it can run ahead of the renderer's own
+ * buffers through pictures that are slow to decode. The queue is bounded by
+ * a number of pictures and by the memory they use, only software YUV420P
+ * pictures can be queued, hardware surfaces are owned by their decoder.
+ */
+class CDVDPictureQueue
+{
+public:
+  CDVDPictureQueue();
+  ~CDVDPictureQueue();
+
+  /* set the limits and reset the queue, zero frames disables it */
+  void Init(unsigned int frames, unsigned int bytes);
+  void End();
+
+  bool IsEnabled() const { return m_maxFrames > 0; }
+  bool Supports(const DVDVideoPicture &picture) const;
+
+  /* copies the picture in, blocks while the queue is full. returns false when
+   * the queue was aborted, or bStop was set while it was full */
+  bool Put(const DVDVideoPicture &picture, double pts, volatile bool &bStop);
+
+  /* takes out the oldest picture, it stays valid until Release */
+  bool Get(DVDVideoPicture &picture, double &pts, unsigned int iTimeoutInMilliSeconds);
+  /* hands back the picture of Get with the result of its output */
+  void Release(int result, bool dropped);
+
+  /* collects the results of the pictures output since the last call */
+  int  TakeResult(unsigned int &shown, unsigned int &dropped);
+
+  /* drops the queued pictures, the one being output is kept. returns the
+   * number of pictures dropped */
+  unsigned int Flush();
+  void Abort();
+  /* while paused only the first picture after a flush is handed out */
+  void SetPaused(bool paused);
+  /* returns true once all pictures are output, false when they are held back */
+  bool WaitEmpty(volatile bool &bStop);
+
+  unsigned int GetFrames() const;
+  unsigned int GetMaxFrames() const { return m_maxFrames; }
+  unsigned int GetPeakFrames() const;
+  unsigned int GetBytes() const;
+  int          GetLevel() const;
+
+private:
+  struct SPicture
+  {
+    DVDVideoPicture picture;
+    double          pts;
+    BYTE*           data;
+    unsigned int    size;
+  };
+
+  SPicture* Allocate(unsigned int size);
+  void      Free(SPicture* pic);
+  bool      IsFull(unsigned int size) const;
+  bool      IsHolding() const { return m_bPaused && m_iShown > 0; }
+
+  mutable CCriticalSection       m_section;
+  XbmcThreads::ConditionVariable m_condition;
+
+  std::deque<SPicture*>  m_queue;
+  std::vector<SPicture*> m_free;    // buffers of the last picture size for reuse
+  SPicture*              m_current; // taken out by Get, not released yet
+
+  unsigned int m_maxFrames;
+  unsigned int m_maxBytes;
+  unsigned int m_bytes;
+  unsigned int m_peak;
+  unsigned int m_iShown;    // pictures handed out since the last flush
+  bool         m_bAbort;
+  bool         m_bPaused;
+
+  int          m_result;
+  unsigned int m_resultShown;
+  unsigned int m_resultDropped;
+};
@@ -1983,6 +1983,13 @@ void CDVDPlayer::OnExit()
 
     m_messenger.End();
 
+    // all packets are back, no need to keep them around until the next file
+    DemuxPacketPoolStats pool;
+    CDVDDemuxUtils::GetPoolStats(pool);
+    CLog::Log(LOGDEBUG, "CDVDPlayer::OnExit() packet pool, %ld of %ld allocations reused, peak %"PRId64" bytes"
+                      , pool.hits, pool.allocs, pool.peak);
+    CDVDDemuxUtils::ReleasePool();
+
   }
   catch (...)
   {
@@ -3714,6 +3721,15 @@ int CDVDPlayer::GetCacheLevel() const
   return (int)(m_State.cache_level * 100);
 }
 
+bool CDVDPlayer::GetCacheStatus(XFILE::SCacheStatus &status) const
+{
+  CSingleLock lock(m_StateSection);
+  if (!m_State.cache_file)
+    return false;
+  status = m_State.cache_status;
+  return true;
+}
+
 double CDVDPlayer::GetQueueTime()
 {
   int a = m_dvdPlayerAudio.GetLevel();
@@ -3881,9 +3897,14 @@ void CDVDPlayer::UpdatePlayState(double timeout)
     state.cache_bytes = status.forward;
     if(state.time_total)
       state.cache_bytes += m_pInputStream->GetLength() * GetQueueTime() / state.time_total;
+    state.cache_file   = true;
+    state.cache_status = status;
   }
   else
+  {
     state.cache_bytes = 0;
+    state.cache_file  = false;
+  }
 
   state.timestamp = CDVDClock::GetAbsoluteClock();
 
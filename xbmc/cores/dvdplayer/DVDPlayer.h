@@ -262,6 +262,7 @@ public:
 
   virtual bool IsCaching() const { return m_caching == CACHESTATE_FULL || m_caching == CACHESTATE_PVR; }
   virtual int GetCacheLevel() const ;
+  virtual bool GetCacheStatus(XFILE::SCacheStatus &status) const;
 
   virtual int OnDVDNavResult(void* pData, int iMessage);
 protected:
@@ -421,6 +422,8 @@ protected:
       cache_level   = 0.0;
       cache_delay   = 0.0;
       cache_offset  = 0.0;
+      cache_file    = false;
+      cache_status  = XFILE::SCacheStatus();
     }
 
     double timestamp;         // last time of update
@@ -446,6 +449,9 @@ protected:
     double  cache_level;   // current estimated required cache level
     double  cache_delay;   // time until cache is expected to reach estimated level
     double  cache_offset;  // percentage of file ahead of current position
+
+    bool                cache_file;   // is the input read through a file cache
+    XFILE::SCacheStatus cache_status; // last status of that cache
   } m_State;
   CCriticalSection m_StateSection;
 
@@ -125,6 +125,7 @@ CDVDPlayerVideo::CDVDPlayerVideo( CDVDClock* pClock
 : CThread("CDVDPlayerVideo")
 , m_messageQueue("video")
 , m_messageParent(parent)
+, m_outputThread(*this)
 {
   m_pClock = pClock;
   m_pOverlayContainer = pOverlayContainer;
@@ -167,13 +168,15 @@ CDVDPlayerVideo::CDVDPlayerVideo( CDVDClock* pClock
 CDVDPlayerVideo::~CDVDPlayerVideo()
 {
   StopThread();
+  ClearPackets();
   g_dvdPerformanceCounter.DisableVideoQueue();
   g_VideoReferenceClock.StopThread();
 }
 
 double CDVDPlayerVideo::GetOutputDelay()
 {
-    double time = m_messageQueue.GetPacketCount(CDVDMsg::DEMUXER_PACKET);
+    double time = m_messageQueue.GetPacketCount(CDVDMsg::DEMUXER_PACKET)
+                + m_pictureQueue.GetFrames();
     if( m_fFrameRate )
       time = (time * DVD_TIME_BASE) / m_fFrameRate;
     else
@@ -266,7 +269,11 @@ void CDVDPlayerVideo::OpenStream(CDVDStreamInfo &hint, CDVDVideoCodec* codec)
 void CDVDPlayerVideo::CloseStream(bool bWaitForBuffers)
 {
   // wait until buffers are empty
-  if (bWaitForBuffers && m_speed > 0) m_messageQueue.WaitUntilEmpty();
+  if (bWaitForBuffers && m_speed > 0)
+  {
+    m_messageQueue.WaitUntilEmpty();
+    m_pictureQueue.WaitEmpty(m_bStop);
+  }
 
   m_messageQueue.Abort();
 
@@ -306,6 +313,14 @@ void CDVDPlayerVideo::OnStartup()
   m_FlipTimeStamp = m_pClock->GetAbsoluteClock();
 
   g_dvdPerformanceCounter.EnableVideoDecodePerformance(this);
+
+  m_pictureQueue.Init(g_advancedSettings.m_videoDecodeAhead, g_advancedSettings.m_videoDecodeAheadMemory * 1024 * 1024);
+  m_pictureQueue.SetPaused(m_speed == DVD_PLAYSPEED_PAUSE);
+  if (m_pictureQueue.IsEnabled())
+  {
+    g_dvdPerformanceCounter.EnablePictureQueue(&m_pictureQueue);
+    m_outputThread.Create();
+  }
 }
 
 void CDVDPlayerVideo::Process()
@@ -324,6 +339,7 @@ void CDVDPlayerVideo::Process()
   double frametime = (double)DVD_TIME_BASE / m_fFrameRate;
 
   int iDropped = 0; //frames dropped in a row
+  unsigned int iDecoderFill = 0; //packets fed since the decoder was reset, up to its frame delay
   bool bRequestDrop = false;
 
   m_videoStats.Start();
@@ -363,7 +379,7 @@ void CDVDPlayerVideo::Process()
         //no need to output this as if it was interlaced
         picture.iFlags &= ~DVP_FLAG_INTERLACED;
         picture.iFlags |= DVP_FLAG_NOSKIP;
-        OutputPicture(&picture, pts);
+        OutputPictureDirect(&picture, pts);
         pts+= frametime;
       }
 
@@ -378,6 +394,7 @@ void CDVDPlayerVideo::Process()
 
         /* we may be very much off correct pts here, but next picture may be a still*/
         /* make sure it isn't dropped */
+        CSingleLock lock(m_outputSection);
         m_iNrOfPicturesNotToSkip = 5;
       }
       else
@@ -394,7 +411,10 @@ void CDVDPlayerVideo::Process()
       if(pMsgGeneralResync->m_timestamp != DVD_NOPTS_VALUE)
         pts = pMsgGeneralResync->m_timestamp;
 
-      double delay = m_FlipTimeStamp - m_pClock->GetAbsoluteClock();
+      double delay;
+      { CSingleLock lock(m_outputSection);
+        delay = m_FlipTimeStamp - m_pClock->GetAbsoluteClock();
+      }
       if( delay > frametime ) delay = frametime;
       else if( delay < 0 )    delay = 0;
 
@@ -431,19 +451,24 @@ void CDVDPlayerVideo::Process()
     }
     else if (pMsg->IsType(CDVDMsg::GENERAL_RESET))
     {
+      g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_FLUSH, m_pictureQueue.Flush());
       if(m_pVideoCodec)
         m_pVideoCodec->Reset();
       picture.iFlags &= ~DVP_FLAG_ALLOCATED;
-      m_packets.clear();
+      ClearPackets();
+      iDecoderFill = 0;
       m_started = false;
     }
     else if (pMsg->IsType(CDVDMsg::GENERAL_FLUSH)) // private message sent by (CDVDPlayerVideo::Flush())
     {
+      g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_FLUSH, m_pictureQueue.Flush());
       if(m_pVideoCodec)
         m_pVideoCodec->Reset();
       picture.iFlags &= ~DVP_FLAG_ALLOCATED;
-      m_packets.clear();
+      ClearPackets();
+      iDecoderFill = 0;
 
+      CSingleLock lock(m_outputSection);
       m_pullupCorrection.Flush();
       //we need to recalculate the framerate
       //TODO: this needs to be set on a streamchange instead
@@ -458,13 +483,16 @@ void CDVDPlayerVideo::Process()
       // so the first few pictures are not the correct ones to display in some cases
       // just display those together with the correct one.
       // (setting it to 2 will skip some menu stills, 5 is working ok for me).
+      CSingleLock lock(m_outputSection);
       m_iNrOfPicturesNotToSkip = 5;
     }
     else if (pMsg->IsType(CDVDMsg::PLAYER_SETSPEED))
     {
+      CSingleLock lock(m_outputSection);
       m_speed = static_cast<CDVDMsgInt*>(pMsg)->m_value;
       if(m_speed == DVD_PLAYSPEED_PAUSE)
         m_iNrOfPicturesNotToSkip = 0;
+      m_pictureQueue.SetPaused(m_speed == DVD_PLAYSPEED_PAUSE);
     }
     else if (pMsg->IsType(CDVDMsg::PLAYER_STARTED))
     {
@@ -474,6 +502,9 @@ void CDVDPlayerVideo::Process()
     else if (pMsg->IsType(CDVDMsg::GENERAL_STREAMCHANGE))
     {
       CDVDMsgVideoCodecChange* msg(static_cast<CDVDMsgVideoCodecChange*>(pMsg));
+      // let the pictures of the old stream go out first
+      m_pictureQueue.WaitEmpty(m_bStop);
+      CSingleLock lock(m_outputSection);
       OpenStream(msg->m_hints, msg->m_codec);
       msg->m_codec = NULL;
       picture.iFlags &= ~DVP_FLAG_ALLOCATED;
@@ -484,6 +515,7 @@ void CDVDPlayerVideo::Process()
       DemuxPacket* pPacket = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacket();
       bool bPacketDrop     = ((CDVDMsgDemuxerPacket*)pMsg)->GetPacketDrop();
 
+      CSingleLock stateLock(m_outputSection);
       if (m_stalled)
       {
         CLog::Log(LOGINFO, "CDVDPlayerVideo - Stillframe left, switching to normal playback");
@@ -510,6 +542,7 @@ void CDVDPlayerVideo::Process()
         m_iLateFrames     = 0;
       }
 #endif
+      stateLock.Leave();
 
       // if player want's us to drop this packet, do so nomatter what
       if(bPacketDrop)
@@ -548,22 +581,30 @@ void CDVDPlayerVideo::Process()
       // buffer packets so we can recover should decoder flush for some reason
       if(m_pVideoCodec->GetConvergeCount() > 0)
       {
-        m_packets.push_back(DVDMessageListItem(pMsg, 0));
+        m_packets.push_back(pMsg->Acquire());
         if(m_packets.size() > m_pVideoCodec->GetConvergeCount()
         || m_packets.size() * frametime > DVD_SEC_TO_TIME(10))
+        {
+          m_packets.front()->Release();
           m_packets.pop_front();
+        }
       }
 
       m_videoStats.AddSampleBytes(pPacket->iSize);
       // assume decoder dropped a picture if it didn't give us any
       // picture from a demux packet, this should be reasonable
       // for libavformat as a demuxer as it normally packetizes
-      // pictures when they come from demuxer
-      if(bRequestDrop && !bPacketDrop && (iDecoderState & VC_BUFFER) && !(iDecoderState & VC_PICTURE))
+      // pictures when they come from demuxer. frame threaded
+      // decoders don't return anything until their threads are busy
+      if(bRequestDrop && !bPacketDrop && (iDecoderState & VC_BUFFER) && !(iDecoderState & VC_PICTURE)
+      && iDecoderFill >= m_pVideoCodec->GetFrameDelay())
       {
         m_iDroppedFrames++;
         iDropped++;
+        g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_DECODER);
       }
+      if(iDecoderFill < m_pVideoCodec->GetFrameDelay())
+        iDecoderFill++;
 
       // loop while no error
       while (!m_bStop)
@@ -575,7 +616,8 @@ void CDVDPlayerVideo::Process()
           CLog::Log(LOGDEBUG, "CDVDPlayerVideo - video decoder was flushed");
           while(!m_packets.empty())
           {
-            CDVDMsgDemuxerPacket* msg = (CDVDMsgDemuxerPacket*)m_packets.front().message->Acquire();
+            // the queue takes over our reference
+            CDVDMsgDemuxerPacket* msg = (CDVDMsgDemuxerPacket*)m_packets.front();
             m_packets.pop_front();
 
             // all packets except the last one should be dropped
@@ -585,7 +627,7 @@ void CDVDPlayerVideo::Process()
           }
 
           m_pVideoCodec->Reset();
-          m_packets.clear();
+          iDecoderFill = 0;
           break;
         }
 
@@ -614,10 +656,12 @@ void CDVDPlayerVideo::Process()
             if(bPacketDrop)
               picture.iFlags |= DVP_FLAG_DROPPED;
 
-            if (m_iNrOfPicturesNotToSkip > 0)
-            {
-              picture.iFlags |= DVP_FLAG_NOSKIP;
-              m_iNrOfPicturesNotToSkip--;
+            { CSingleLock lock(m_outputSection);
+              if (m_iNrOfPicturesNotToSkip > 0)
+              {
+                picture.iFlags |= DVP_FLAG_NOSKIP;
+                m_iNrOfPicturesNotToSkip--;
+              }
             }
 
             // validate picture timing,
@@ -679,7 +723,11 @@ void CDVDPlayerVideo::Process()
               picture.iDuration *= picture.iRepeatPicture + 1;
 
 #if 1
-            int iResult = OutputPicture(&picture, pts);
+            int iResult;
+            if (m_pictureQueue.Supports(picture))
+              iResult = QueuePicture(&picture, pts, iDropped);
+            else
+              iResult = OutputPictureDirect(&picture, pts);
 #elif 0
             // testing NV12 rendering functions
             DVDVideoPicture* pTempNV12Picture = CDVDCodecUtils::ConvertToNV12Picture(&picture);
@@ -716,7 +764,9 @@ void CDVDPlayerVideo::Process()
               break;
             }
 
-            if( (iResult & EOS_DROPPED) && !bPacketDrop )
+            if( iResult & EOS_QUEUED )
+              ; // counted by QueuePicture once the output thread got to it
+            else if( (iResult & EOS_DROPPED) && !bPacketDrop )
             {
               m_iDroppedFrames++;
               iDropped++;
@@ -730,6 +780,7 @@ void CDVDPlayerVideo::Process()
           {
             CLog::Log(LOGWARNING, "Decoder Error getting videoPicture.");
             m_pVideoCodec->Reset();
+            iDecoderFill = 0;
           }
         }
 
@@ -764,8 +815,24 @@ void CDVDPlayerVideo::Process()
   m_pVideoCodec->ClearPicture(&picture);
 }
 
+void CDVDPlayerVideo::ClearPackets()
+{
+  while (!m_packets.empty())
+  {
+    m_packets.front()->Release();
+    m_packets.pop_front();
+  }
+}
+
 void CDVDPlayerVideo::OnExit()
 {
+  m_pictureQueue.Abort();
+  m_outputThread.StopThread();
+  g_dvdPerformanceCounter.DisablePictureQueue();
+  if (m_pictureQueue.IsEnabled())
+    CLog::Log(LOGDEBUG, "CDVDPlayerVideo - decoded ahead up to %u of %u pictures", m_pictureQueue.GetPeakFrames(), m_pictureQueue.GetMaxFrames());
+  m_pictureQueue.End();
+
   g_dvdPerformanceCounter.DisableVideoDecodePerformance();
 
   if (m_pOverlayCodecCC)
@@ -837,11 +904,15 @@ void CDVDPlayerVideo::SetSpeed(int speed)
   if(m_messageQueue.IsInited())
     m_messageQueue.Put( new CDVDMsgInt(CDVDMsg::PLAYER_SETSPEED, speed), 1 );
   else
+  {
+    CSingleLock lock(m_outputSection);
     m_speed = speed;
+  }
 }
 
 void CDVDPlayerVideo::StepFrame()
 {
+  CSingleLock lock(m_outputSection);
   m_iNrOfPicturesNotToSkip++;
 }
 
@@ -991,6 +1062,10 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   DVDVideoPicture picture(*src);
   DVDVideoPicture* pPicture = &picture;
 
+  /* the timing state is shared with the video thread, the lock is only let go
+   * while waiting on the renderer */
+  CSingleLock lock(m_outputSection);
+
 #ifdef HAS_VIDEO_PLAYBACK
   double config_framerate = m_bFpsInvalid ? 0.0 : m_fFrameRate;
   /* check so that our format or aspect has changed. if it has, reconfigure renderer */
@@ -1256,6 +1331,7 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
       if (m_iDroppedRequest > 5)
       {
         m_iDroppedRequest--; //decrease so we only drop half the frames
+        g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_LATE);
         return result | EOS_DROPPED;
       }
       m_iDroppedRequest++;
@@ -1270,7 +1346,10 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   {
     if( iClockSleep < -DVD_MSEC_TO_TIME(200)
     && !(pPicture->iFlags & DVP_FLAG_NOSKIP) )
+    {
+      g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_SPEED);
       return result | EOS_DROPPED;
+    }
   }
 
   if( (pPicture->iFlags & DVP_FLAG_DROPPED) )
@@ -1288,7 +1367,10 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
     m_droptime += iFrameDuration;
 #ifndef PROFILE
     if( next < current && !(pPicture->iFlags & DVP_FLAG_NOSKIP) )
+    {
+      g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_SPEED);
       return result | EOS_DROPPED;
+    }
 #endif
 
     while(!m_bStop && m_dropbase < m_droptime)             m_dropbase += frametime;
@@ -1315,6 +1397,7 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   ProcessOverlays(pPicture, pts);
   AutoCrop(pPicture);
 
+  CSingleExit exit(m_outputSection);
   int index = g_renderManager.AddVideoPicture(*pPicture);
 
   // video device might not be done yet
@@ -1326,7 +1409,10 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
   }
 
   if (index < 0)
+  {
+    g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_RENDERER);
     return EOS_DROPPED;
+  }
 
   g_renderManager.FlipPage(CThread::m_bStop, (iCurrentClock + iSleepTime) / DVD_TIME_BASE, -1, mDisplayField);
 
@@ -1337,6 +1423,63 @@ int CDVDPlayerVideo::OutputPicture(const DVDVideoPicture* src, double pts)
 #endif
 }
 
+int CDVDPlayerVideo::OutputPictureDirect(const DVDVideoPicture* src, double pts)
+{
+  /* pictures that can't be queued have to wait for the ones that are. the
+   * pictures held back while paused are older than this one and would only
+   * be shown after it, so they are dropped instead */
+  if (!m_pictureQueue.WaitEmpty(m_bStop))
+  {
+    if (m_bStop)
+      return EOS_ABORT;
+    g_dvdPerformanceCounter.AddVideoDrop(VIDEO_DROP_FLUSH, m_pictureQueue.Flush());
+    if (!m_pictureQueue.WaitEmpty(m_bStop))
+      return EOS_ABORT;
+  }
+
+  /* the output thread is idle now, so OutputPicture only runs here */
+  return OutputPicture(src, pts);
+}
+
+int CDVDPlayerVideo::QueuePicture(const DVDVideoPicture* src, double pts, int& iDropped)
+{
+  if (!m_pictureQueue.Put(*src, pts, m_bStop))
+    return EOS_ABORT;
+
+  /* the output thread runs behind, pick up what happened to the earlier pictures */
+  unsigned int shown, dropped;
+  int result = m_pictureQueue.TakeResult(shown, dropped);
+
+  m_iDroppedFrames += dropped;
+  if (dropped)
+    iDropped += dropped;
+  else if (shown)
+    iDropped = 0;
+
+  return EOS_QUEUED | (result & (EOS_ABORT | EOS_VERYLATE));
+}
+
+CDVDPlayerVideoOutput::CDVDPlayerVideoOutput(CDVDPlayerVideo& video)
+: CThread("CDVDPlayerVideoOutput")
+, m_video(video)
+{
+}
+
+void CDVDPlayerVideoOutput::Process()
+{
+  DVDVideoPicture picture;
+  double pts;
+
+  while (!m_bStop)
+  {
+    if (!m_video.m_pictureQueue.Get(picture, pts, 100))
+      continue;
+
+    int result = m_video.OutputPicture(&picture, pts);
+    m_video.m_pictureQueue.Release(result, (result & EOS_DROPPED) != 0);
+  }
+}
+
 void CDVDPlayerVideo::AutoCrop(DVDVideoPicture *pPicture)
 {
   if ((pPicture->format == RENDER_FMT_YUV420P) ||
@@ -1521,7 +1664,10 @@ std::string CDVDPlayerVideo::GetPlayerInfo()
   s << ", dc:"   << m_codecname;
   s << ", Mb/s:" << fixed << setprecision(2) << (double)GetVideoBitrate() / (1024.0*1024.0);
   s << ", drop:" << m_iDroppedFrames;
+  if (m_pictureQueue.IsEnabled())
+    s << ", ahead:" << m_pictureQueue.GetFrames() << "/" << m_pictureQueue.GetMaxFrames();
 
+  CSingleLock lock(m_outputSection);
   int pc = m_pullupCorrection.GetPatternLength();
   if (pc > 0)
     s << ", pc:" << pc;
@@ -22,6 +22,7 @@
 
 #include "threads/Thread.h"
 #include "DVDMessageQueue.h"
+#include "DVDPictureQueue.h"
 #include "DVDDemuxers/DVDDemuxUtils.h"
 #include "DVDCodecs/Video/DVDVideoCodec.h"
 #include "DVDClock.h"
@@ -37,6 +38,20 @@ class CDVDOverlayCodecCC;
 
 #define VIDEO_PICTURE_QUEUE_SIZE 1
 
+class CDVDPlayerVideo;
+
+/* presents the pictures the video thread has decoded ahead */
+class CDVDPlayerVideoOutput : public CThread
+{
+public:
+  CDVDPlayerVideoOutput(CDVDPlayerVideo& video);
+
+protected:
+  virtual void Process();
+
+  CDVDPlayerVideo& m_video;
+};
+
 class CDVDPlayerVideo : public CThread
 {
 public:
@@ -54,7 +69,7 @@ public:
 
   // waits until all available data has been rendered
   // just waiting for packetqueue should be enough for video
-  void WaitForBuffers()                             { m_messageQueue.WaitUntilEmpty(); }
+  void WaitForBuffers()                             { m_messageQueue.WaitUntilEmpty(); m_pictureQueue.WaitEmpty(m_bStop); }
   bool AcceptsData() const                          { return !m_messageQueue.IsFull(); }
   bool HasData() const                              { return m_messageQueue.GetDataSize() > 0; }
   int  GetLevel();
@@ -110,12 +125,17 @@ protected:
 #define EOS_ABORT 1
 #define EOS_DROPPED 2
 #define EOS_VERYLATE 4
+#define EOS_QUEUED 8 // went to the decode ahead queue, drops are counted when it is output
+
+  friend class CDVDPlayerVideoOutput;
 
   void AutoCrop(DVDVideoPicture* pPicture);
   void AutoCrop(DVDVideoPicture *pPicture, RECT &crop);
   CRect m_crop;
 
   int OutputPicture(const DVDVideoPicture* src, double pts);
+  int OutputPictureDirect(const DVDVideoPicture* src, double pts);
+  int QueuePicture(const DVDVideoPicture* src, double pts, int& iDropped);
 #ifdef HAS_VIDEO_PLAYBACK
   void ProcessOverlays(DVDVideoPicture* pSource, double pts);
 #endif
@@ -124,6 +144,10 @@ protected:
   CDVDMessageQueue m_messageQueue;
   CDVDMessageQueue& m_messageParent;
 
+  CDVDPictureQueue      m_pictureQueue;  // decoded pictures waiting for the renderer
+  CDVDPlayerVideoOutput m_outputThread;
+  CCriticalSection      m_outputSection; // guards the timing state OutputPicture shares with the video thread
+
   double m_iCurrentPts; // last pts displayed
   double m_iVideoDelay;
   double m_iSubtitleDelay;
@@ -194,6 +218,8 @@ protected:
 
   CPullupCorrection m_pullupCorrection;
 
-  std::list<DVDMessageListItem> m_packets;
+  // the last packets given to the decoder, each holding a reference
+  std::list<CDVDMsg*> m_packets;
+  void ClearPackets();
 };
 
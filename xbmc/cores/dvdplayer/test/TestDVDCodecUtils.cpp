@@ -0,0 +1,310 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDCodecs/DVDCodecUtils.h"
+#include "cores/VideoRenderers/RenderFormats.h"
+#include "utils/CPUInfo.h"
+#include "utils/Stopwatch.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/* odd sized so every kernel has to run its tail code */
+#define TEST_WIDTH  1027
+#define TEST_HEIGHT 37
+/* offsets to check the kernels handle unaligned rows */
+#define TEST_OFFSETS 4
+
+static const struct
+{
+  const char   *name;
+  unsigned int  feature;
+  bool          uswc;
+} simdTiers[] =
+{
+  { "SSE2"  , CPU_FEATURE_SSE2, false },
+  { "SSE4.1", CPU_FEATURE_SSE4, true  },
+  { "NEON"  , CPU_FEATURE_NEON, false }
+};
+
+static void FillRandom(std::vector<uint8_t> &buffer)
+{
+  for (size_t i = 0; i < buffer.size(); ++i)
+    buffer[i] = rand() & 0xff;
+}
+
+/* a YUV420P picture with padded strides, like the decoders hand out */
+class TestPicture
+{
+public:
+  TestPicture(int width, int height)
+  {
+    memset(&picture, 0, sizeof(picture));
+    picture.iWidth  = width;
+    picture.iHeight = height;
+    picture.format  = RENDER_FMT_YUV420P;
+
+    int stride[3] = { width + 32, width / 2 + 16, width / 2 + 16 };
+    int lines[3]  = { height, height / 2, height / 2 };
+    for (int p = 0; p < 3; p++)
+    {
+      planes[p].resize(stride[p] * lines[p]);
+      FillRandom(planes[p]);
+      picture.data[p]      = &planes[p][0];
+      picture.iLineSize[p] = stride[p];
+    }
+  }
+
+  DVDVideoPicture      picture;
+  std::vector<uint8_t> planes[3];
+};
+
+TEST(TestDVDCodecUtils, CopyPlane)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+  const int          stride      = TEST_WIDTH + TEST_OFFSETS + 16;
+
+  std::vector<uint8_t> in(stride * TEST_HEIGHT + TEST_OFFSETS), ref(stride * TEST_HEIGHT), out(ref.size());
+  FillRandom(in);
+
+  DVDCopyPlaneFn generic = CDVDCodecUtils::GetCopyPlane(0);
+  for (size_t t = 0; t < XBMC_ARRAY_SIZE(simdTiers); ++t)
+  {
+    if (!(cpuFeatures & simdTiers[t].feature))
+      continue;
+
+    DVDCopyPlaneFn simd = CDVDCodecUtils::GetCopyPlane(simdTiers[t].feature, simdTiers[t].uswc);
+    for (int offset = 0; offset < TEST_OFFSETS; ++offset)
+    {
+      /* a packed plane is copied as one row, the padded one row by row */
+      for (int padded = 0; padded < 2; ++padded)
+      {
+        int width = padded ? TEST_WIDTH : stride;
+        memset(&ref[0], 0, ref.size());
+        memset(&out[0], 0, out.size());
+        generic(&ref[0], stride, &in[offset], stride, width, TEST_HEIGHT);
+        simd   (&out[0], stride, &in[offset], stride, width, TEST_HEIGHT);
+        EXPECT_EQ(0, memcmp(&ref[0], &out[0], ref.size()))
+          << simdTiers[t].name << " offset " << offset << " padded " << padded;
+      }
+    }
+  }
+}
+
+TEST(TestDVDCodecUtils, Interleave)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+  const int          width       = TEST_WIDTH / 2;
+  const int          stride      = width + TEST_OFFSETS + 16;
+
+  std::vector<uint8_t> u(stride * TEST_HEIGHT), v(stride * TEST_HEIGHT);
+  std::vector<uint8_t> ref(stride * 2 * TEST_HEIGHT), out(ref.size());
+  FillRandom(u);
+  FillRandom(v);
+
+  DVDInterleaveFn generic = CDVDCodecUtils::GetInterleave(0);
+  for (size_t t = 0; t < XBMC_ARRAY_SIZE(simdTiers); ++t)
+  {
+    if (!(cpuFeatures & simdTiers[t].feature))
+      continue;
+
+    DVDInterleaveFn simd = CDVDCodecUtils::GetInterleave(simdTiers[t].feature);
+    for (int offset = 0; offset < TEST_OFFSETS; ++offset)
+    {
+      memset(&ref[0], 0, ref.size());
+      memset(&out[0], 0, out.size());
+      generic(&ref[offset], stride * 2, &u[offset], stride, &v[0], stride, width, TEST_HEIGHT);
+      simd   (&out[offset], stride * 2, &u[offset], stride, &v[0], stride, width, TEST_HEIGHT);
+      EXPECT_EQ(0, memcmp(&ref[0], &out[0], ref.size()))
+        << simdTiers[t].name << " offset " << offset;
+    }
+  }
+}
+
+TEST(TestDVDCodecUtils, Pack)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+  TestPicture        src(TEST_WIDTH - 1, TEST_HEIGHT + 1);
+  const DVDVideoPicture &pic = src.picture;
+  const int          stride      = pic.iWidth * 2 + 16;
+
+  std::vector<uint8_t> ref(stride * pic.iHeight), out(ref.size());
+
+  DVDPackFn generic = CDVDCodecUtils::GetPack(0);
+  for (size_t t = 0; t < XBMC_ARRAY_SIZE(simdTiers); ++t)
+  {
+    if (!(cpuFeatures & simdTiers[t].feature))
+      continue;
+
+    DVDPackFn simd = CDVDCodecUtils::GetPack(simdTiers[t].feature);
+    for (int uyvy = 0; uyvy < 2; ++uyvy)
+    {
+      memset(&ref[0], 0, ref.size());
+      memset(&out[0], 0, out.size());
+      generic(&ref[0], stride, pic.data[0], pic.iLineSize[0], pic.data[1], pic.iLineSize[1],
+              pic.data[2], pic.iLineSize[2], pic.iWidth, pic.iHeight, uyvy != 0);
+      simd   (&out[0], stride, pic.data[0], pic.iLineSize[0], pic.data[1], pic.iLineSize[1],
+              pic.data[2], pic.iLineSize[2], pic.iWidth, pic.iHeight, uyvy != 0);
+      EXPECT_EQ(0, memcmp(&ref[0], &out[0], ref.size()))
+        << simdTiers[t].name << " uyvy " << uyvy;
+    }
+  }
+}
+
+/* 4K pictures are split in stripes, they have to come out like a single pass */
+TEST(TestDVDCodecUtils, StripedConversions)
+{
+  TestPicture src(3840, 2160);
+  const DVDVideoPicture &pic = src.picture;
+  const int w = pic.iWidth;
+  const int h = pic.iHeight;
+
+  DVDVideoPicture* copy = CDVDCodecUtils::AllocatePicture(w, h);
+  ASSERT_TRUE(copy != NULL);
+  EXPECT_TRUE(CDVDCodecUtils::CopyPicture(copy, &src.picture));
+  for (int p = 0; p < 3; p++)
+  {
+    int pw = p ? w / 2 : w;
+    int ph = p ? h / 2 : h;
+    for (int y = 0; y < ph; y++)
+      ASSERT_EQ(0, memcmp(copy->data[p] + y * copy->iLineSize[p], pic.data[p] + y * pic.iLineSize[p], pw))
+        << "plane " << p << " row " << y;
+  }
+  CDVDCodecUtils::FreePicture(copy);
+
+  DVDVideoPicture* nv12 = CDVDCodecUtils::ConvertToNV12Picture(&src.picture);
+  ASSERT_TRUE(nv12 != NULL);
+  std::vector<uint8_t> uv(w * h / 2);
+  CDVDCodecUtils::GetInterleave(0)(&uv[0], w, pic.data[1], pic.iLineSize[1], pic.data[2], pic.iLineSize[2], w / 2, h / 2);
+  for (int y = 0; y < h; y++)
+    ASSERT_EQ(0, memcmp(nv12->data[0] + y * nv12->iLineSize[0], pic.data[0] + y * pic.iLineSize[0], w)) << "row " << y;
+  EXPECT_EQ(0, memcmp(nv12->data[1], &uv[0], uv.size()));
+  CDVDCodecUtils::FreePicture(nv12);
+
+  for (int uyvy = 0; uyvy < 2; ++uyvy)
+  {
+    ERenderFormat format = uyvy ? RENDER_FMT_UYVY422 : RENDER_FMT_YUYV422;
+    DVDVideoPicture* packed = CDVDCodecUtils::ConvertToYUV422PackedPicture(&src.picture, format);
+    ASSERT_TRUE(packed != NULL);
+    EXPECT_EQ(format, packed->format);
+
+    std::vector<uint8_t> ref(w * 2 * h);
+    CDVDCodecUtils::GetPack(0)(&ref[0], w * 2, pic.data[0], pic.iLineSize[0], pic.data[1], pic.iLineSize[1],
+                               pic.data[2], pic.iLineSize[2], w, h, uyvy != 0);
+    EXPECT_EQ(0, memcmp(packed->data[0], &ref[0], ref.size())) << "uyvy " << uyvy;
+    CDVDCodecUtils::FreePicture(packed);
+  }
+}
+
+static void PrintRate(const char *name, size_t bytes, int iterations, float elapsed)
+{
+  std::cout << " " << name << "="
+            << testing::PrintToString(XBMC_MILLIONS_PER_SECOND(bytes * iterations, elapsed));
+}
+
+TEST(TestDVDCodecUtils, Throughput)
+{
+  const unsigned int cpuFeatures = g_cpuInfo.GetCPUFeatures();
+  const int          iterations  = 20;
+  const struct { const char *name; int width; int height; } sizes[] =
+  {
+    { "1080p", 1920, 1080 },
+    { "4K"   , 3840, 2160 }
+  };
+
+  for (size_t s = 0; s < XBMC_ARRAY_SIZE(sizes); ++s)
+  {
+    TestPicture src(sizes[s].width, sizes[s].height);
+    const DVDVideoPicture &pic = src.picture;
+    const int    w     = pic.iWidth;
+    const int    h     = pic.iHeight;
+    const size_t bytes = w * h * 3 / 2;
+
+    std::vector<uint8_t> out(w * h * 2);
+    DVDVideoPicture dst = pic;
+    dst.data[0] = &out[0];
+    dst.data[1] = dst.data[0] + w * h;
+    dst.data[2] = dst.data[1] + w * h / 4;
+    dst.iLineSize[0] = w;
+    dst.iLineSize[1] = w / 2;
+    dst.iLineSize[2] = w / 2;
+
+    /* the single threaded kernels, generic and the best the cpu has */
+    const unsigned int tiers[] = { 0, cpuFeatures };
+    const char        *names[] = { "C", "SIMD" };
+    CStopWatch watch;
+
+    std::cout << sizes[s].name << " MB/s\n  copy:";
+    for (int t = 0; t < 2; ++t)
+    {
+      DVDCopyPlaneFn fn = CDVDCodecUtils::GetCopyPlane(tiers[t]);
+      watch.StartZero();
+      for (int i = 0; i < iterations; ++i)
+      {
+        fn(dst.data[0], dst.iLineSize[0], pic.data[0], pic.iLineSize[0], w, h);
+        fn(dst.data[1], dst.iLineSize[1], pic.data[1], pic.iLineSize[1], w / 2, h / 2);
+        fn(dst.data[2], dst.iLineSize[2], pic.data[2], pic.iLineSize[2], w / 2, h / 2);
+      }
+      PrintRate(names[t], bytes, iterations, watch.GetElapsedSeconds());
+    }
+    watch.StartZero();
+    for (int i = 0; i < iterations; ++i)
+      CDVDCodecUtils::CopyPicture(&dst, &src.picture);
+    PrintRate("CopyPicture", bytes, iterations, watch.GetElapsedSeconds());
+
+    std::cout << "\n  nv12:";
+    for (int t = 0; t < 2; ++t)
+    {
+      DVDCopyPlaneFn  copy       = CDVDCodecUtils::GetCopyPlane(tiers[t]);
+      DVDInterleaveFn interleave = CDVDCodecUtils::GetInterleave(tiers[t]);
+      watch.StartZero();
+      for (int i = 0; i < iterations; ++i)
+      {
+        copy(&out[0], w, pic.data[0], pic.iLineSize[0], w, h);
+        interleave(&out[w * h], w, pic.data[1], pic.iLineSize[1], pic.data[2], pic.iLineSize[2], w / 2, h / 2);
+      }
+      PrintRate(names[t], bytes, iterations, watch.GetElapsedSeconds());
+    }
+    watch.StartZero();
+    for (int i = 0; i < iterations; ++i)
+      CDVDCodecUtils::FreePicture(CDVDCodecUtils::ConvertToNV12Picture(&src.picture));
+    PrintRate("ConvertToNV12Picture", bytes, iterations, watch.GetElapsedSeconds());
+
+    std::cout << "\n  yuy2:";
+    for (int t = 0; t < 2; ++t)
+    {
+      DVDPackFn pack = CDVDCodecUtils::GetPack(tiers[t]);
+      watch.StartZero();
+      for (int i = 0; i < iterations; ++i)
+        pack(&out[0], w * 2, pic.data[0], pic.iLineSize[0], pic.data[1], pic.iLineSize[1],
+             pic.data[2], pic.iLineSize[2], w, h, false);
+      PrintRate(names[t], bytes, iterations, watch.GetElapsedSeconds());
+    }
+    watch.StartZero();
+    for (int i = 0; i < iterations; ++i)
+      CDVDCodecUtils::FreePicture(CDVDCodecUtils::ConvertToYUV422PackedPicture(&src.picture, RENDER_FMT_YUYV422));
+    PrintRate("ConvertToYUV422PackedPicture", bytes, iterations, watch.GetElapsedSeconds());
+    std::cout << "\n";
+  }
+}
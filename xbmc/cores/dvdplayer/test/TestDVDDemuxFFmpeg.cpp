@@ -0,0 +1,90 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDDemuxers/DVDDemux.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDFactoryDemuxer.h"
+#include "cores/dvdplayer/DVDInputStreams/DVDInputStream.h"
+#include "cores/dvdplayer/DVDInputStreams/DVDFactoryInputStream.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/Stopwatch.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+/* demuxes the whole file, returns the number of packets or -1 if it can't be opened */
+static int Demux(const CStdString &path, bool mmap, uint64_t &bytes, float &elapsed)
+{
+  bool mmapLocalFiles = g_advancedSettings.m_mmapLocalFiles;
+  g_advancedSettings.m_mmapLocalFiles = mmap;
+
+  CStopWatch watch;
+  watch.StartZero();
+
+  std::auto_ptr<CDVDInputStream> input(CDVDFactoryInputStream::CreateInputStream(NULL, path, ""));
+  bool opened = input.get() && input->Open(path, "");
+  g_advancedSettings.m_mmapLocalFiles = mmapLocalFiles;
+  if (!opened)
+    return -1;
+
+  std::auto_ptr<CDVDDemux> demux(CDVDFactoryDemuxer::CreateDemuxer(input.get()));
+  if (!demux.get())
+    return -1;
+
+  int packets = 0;
+  DemuxPacket *pPacket;
+  while ((pPacket = demux->Read()))
+  {
+    packets++;
+    CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+  }
+
+  elapsed = watch.GetElapsedSeconds();
+  bytes   = input->GetLength();
+  return packets;
+}
+
+/* Demux only benchmark of local files read with reads and through a memory
+ * mapping, the files are given to the test suite with --add-demux-file.
+ * Every file is demuxed once before to have it in the page cache, so both
+ * modes measure the copies and calls rather than the disk.
+ */
+TEST(TestDVDDemuxFFmpeg, DemuxBenchmark)
+{
+  std::vector<CStdString> files = CXBMCTestUtils::Instance().getDemuxFiles();
+  for (std::vector<CStdString>::iterator it = files.begin(); it != files.end(); ++it)
+  {
+    uint64_t bytes;
+    float    elapsed;
+    std::cout << "Demuxing: " << *it << "\n";
+    int expected = Demux(*it, false, bytes, elapsed);
+    ASSERT_GT(expected, 0);
+
+    for (int mmap = 0; mmap <= 1; mmap++)
+    {
+      int packets = Demux(*it, mmap != 0, bytes, elapsed);
+      EXPECT_EQ(expected, packets);
+      std::cout << "  " << (mmap ? "mmap" : "read") << ": " << packets << " packets in "
+                << elapsed << "s, " << (elapsed > 0.0f ? bytes / elapsed / (1024 * 1024) : 0.0f) << " MB/s\n";
+    }
+  }
+}
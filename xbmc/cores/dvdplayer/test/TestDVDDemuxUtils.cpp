@@ -0,0 +1,163 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDClock.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "DllAvCodec.h"
+#include "utils/Stopwatch.h"
+#include "threads/test/TestHelpers.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+TEST(TestDVDDemuxUtils, Defaults)
+{
+  DemuxPacket *pkt = CDVDDemuxUtils::AllocateDemuxPacket(1000);
+  ASSERT_TRUE(pkt != NULL);
+  ASSERT_TRUE(pkt->pData != NULL);
+  EXPECT_EQ(0, (int)((uintptr_t)pkt->pData & 15));
+  EXPECT_EQ(-1, pkt->iStreamId);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pkt->pts);
+  EXPECT_EQ(DVD_NOPTS_VALUE, pkt->dts);
+
+  /* dirty the whole buffer, the padding has to be cleared again on reuse */
+  memset(pkt->pData, 0xff, 1024);
+  pkt->iStreamId = 5;
+  CDVDDemuxUtils::FreeDemuxPacket(pkt);
+
+  pkt = CDVDDemuxUtils::AllocateDemuxPacket(1000);
+  ASSERT_TRUE(pkt != NULL);
+  EXPECT_EQ(-1, pkt->iStreamId);
+  for (int i = 1000; i < 1000 + FF_INPUT_BUFFER_PADDING_SIZE; ++i)
+    EXPECT_EQ(0, pkt->pData[i]);
+  CDVDDemuxUtils::FreeDemuxPacket(pkt);
+
+  pkt = CDVDDemuxUtils::AllocateDemuxPacket(0);
+  ASSERT_TRUE(pkt != NULL);
+  EXPECT_TRUE(pkt->pData == NULL);
+  CDVDDemuxUtils::FreeDemuxPacket(pkt);
+}
+
+TEST(TestDVDDemuxUtils, Reuse)
+{
+  CDVDDemuxUtils::ReleasePool();
+
+  DemuxPacketPoolStats before, after;
+  CDVDDemuxUtils::GetPoolStats(before);
+
+  /* same size class, the second round must not touch the heap */
+  for (int round = 0; round < 2; ++round)
+  {
+    DemuxPacket *pkts[8];
+    for (int i = 0; i < 8; ++i)
+      pkts[i] = CDVDDemuxUtils::AllocateDemuxPacket(3000 + i * 100);
+    for (int i = 0; i < 8; ++i)
+      CDVDDemuxUtils::FreeDemuxPacket(pkts[i]);
+  }
+
+  CDVDDemuxUtils::GetPoolStats(after);
+  EXPECT_EQ(16, after.allocs - before.allocs);
+  EXPECT_EQ(8, after.hits - before.hits);
+  EXPECT_EQ(before.inuse, after.inuse);
+  EXPECT_EQ(8 * 4096, after.pooled);
+  EXPECT_GE(after.peak, 8 * 4096);
+
+  CDVDDemuxUtils::ReleasePool();
+  CDVDDemuxUtils::GetPoolStats(after);
+  EXPECT_EQ(0, after.pooled);
+}
+
+TEST(TestDVDDemuxUtils, Oversized)
+{
+  CDVDDemuxUtils::ReleasePool();
+
+  /* too big for any size class, goes straight back to the heap */
+  DemuxPacket *pkt = CDVDDemuxUtils::AllocateDemuxPacket(4 * 1024 * 1024);
+  ASSERT_TRUE(pkt != NULL);
+  pkt->pData[4 * 1024 * 1024 - 1] = 1;
+  CDVDDemuxUtils::FreeDemuxPacket(pkt);
+
+  DemuxPacketPoolStats stats;
+  CDVDDemuxUtils::GetPoolStats(stats);
+  EXPECT_EQ(0, stats.pooled);
+}
+
+class PacketWorker : public IRunnable
+{
+public:
+  unsigned int count;
+  unsigned int errors;
+
+  PacketWorker(unsigned int c) : count(c), errors(0) {}
+
+  /* keeps a window of packets of mixed sizes alive, like the player queues */
+  void Run()
+  {
+    DemuxPacket *held[32];
+    memset(held, 0, sizeof(held));
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      unsigned int slot = i % 32;
+      if (held[slot])
+      {
+        if (held[slot]->iStreamId != (int)slot || held[slot]->pData[0] != (BYTE)slot)
+          ++errors;
+        CDVDDemuxUtils::FreeDemuxPacket(held[slot]);
+      }
+
+      int size = (i & 1) ? 200 + (i % 7) * 100 : 20000 + (i % 13) * 5000;
+      held[slot] = CDVDDemuxUtils::AllocateDemuxPacket(size);
+      held[slot]->iStreamId = slot;
+      held[slot]->pData[0]  = slot;
+    }
+
+    for (unsigned int slot = 0; slot < 32; ++slot)
+      CDVDDemuxUtils::FreeDemuxPacket(held[slot]);
+  }
+};
+
+TEST(TestDVDDemuxUtils, Threads)
+{
+  const unsigned int count = 200000;
+  PacketWorker w1(count), w2(count), w3(count), w4(count);
+
+  DemuxPacketPoolStats before, after;
+  CDVDDemuxUtils::GetPoolStats(before);
+
+  CStopWatch watch;
+  watch.StartZero();
+  {
+    thread t1(w1), t2(w2), t3(w3), t4(w4);
+    t1.join(); t2.join(); t3.join(); t4.join();
+  }
+  float elapsed = watch.GetElapsedSeconds();
+
+  CDVDDemuxUtils::GetPoolStats(after);
+  long allocs = after.allocs - before.allocs;
+  long hits   = after.hits   - before.hits;
+  std::cout << allocs << " packets in " << elapsed << "s on 4 threads, "
+            << (hits * 100.0 / allocs) << "% reused, peak "
+            << after.peak << " bytes\n";
+
+  EXPECT_EQ(0U, w1.errors + w2.errors + w3.errors + w4.errors);
+  EXPECT_EQ(4 * (long)count, allocs);
+  EXPECT_EQ(before.inuse, after.inuse);
+}
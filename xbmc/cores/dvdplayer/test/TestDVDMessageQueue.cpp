@@ -0,0 +1,239 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "cores/dvdplayer/DVDClock.h"
+#include "cores/dvdplayer/DVDMessage.h"
+#include "cores/dvdplayer/DVDMessageQueue.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "utils/TimeUtils.h"
+#include "threads/test/TestHelpers.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <vector>
+
+static CDVDMsgDemuxerPacket* NewPacket(int size, double pts)
+{
+  DemuxPacket *pkt = CDVDDemuxUtils::AllocateDemuxPacket(size);
+  pkt->iSize = size;
+  pkt->pts   = pts;
+  return new CDVDMsgDemuxerPacket(pkt);
+}
+
+static CDVDMsg::Message GetType(CDVDMessageQueue &queue, int &priority)
+{
+  CDVDMsg *msg = NULL;
+  if (queue.Get(&msg, 0, priority) != MSGQ_OK)
+    return CDVDMsg::NONE;
+  CDVDMsg::Message type = msg->GetMessageType();
+  msg->Release();
+  return type;
+}
+
+TEST(TestDVDMessageQueue, Priority)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC));
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF), 10);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_FLUSH), 1);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESET), 10);
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_DELAY));
+
+  /* highest priority first, in the order they were put within one priority */
+  int priority = 0;
+  EXPECT_EQ(CDVDMsg::GENERAL_EOF, GetType(queue, priority));
+  EXPECT_EQ(10, priority);
+  priority = 0;
+  EXPECT_EQ(CDVDMsg::GENERAL_RESET, GetType(queue, priority));
+  priority = 0;
+  EXPECT_EQ(CDVDMsg::GENERAL_FLUSH, GetType(queue, priority));
+  EXPECT_EQ(1, priority);
+
+  /* nothing left above the requested priority */
+  CDVDMsg *msg = NULL;
+  priority = 1;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 10, priority));
+  EXPECT_TRUE(msg == NULL);
+
+  priority = 0;
+  EXPECT_EQ(CDVDMsg::GENERAL_RESYNC, GetType(queue, priority));
+  priority = 0;
+  EXPECT_EQ(CDVDMsg::GENERAL_DELAY, GetType(queue, priority));
+  priority = 0;
+  EXPECT_EQ(MSGQ_TIMEOUT, queue.Get(&msg, 0, priority));
+
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, Flush)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  /* enough to wrap and grow the rings */
+  for (int i = 0; i < 600; i++)
+  {
+    queue.Put(NewPacket(100, i * DVD_TIME_BASE));
+    if (i % 3 == 0)
+      queue.Put(new CDVDMsg(CDVDMsg::GENERAL_SYNCHRONIZE));
+    if (i % 50 == 0)
+      queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), 1);
+  }
+
+  EXPECT_EQ(600 * 100, queue.GetDataSize());
+  EXPECT_EQ(600U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(200U, queue.GetPacketCount(CDVDMsg::GENERAL_SYNCHRONIZE));
+  EXPECT_EQ(12U,  queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  queue.Flush(CDVDMsg::DEMUXER_PACKET);
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U,   queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(200U, queue.GetPacketCount(CDVDMsg::GENERAL_SYNCHRONIZE));
+
+  int priority = 0;
+  for (int i = 0; i < 12; i++)
+  {
+    priority = 0;
+    EXPECT_EQ(CDVDMsg::GENERAL_RESYNC, GetType(queue, priority));
+  }
+  for (int i = 0; i < 200; i++)
+  {
+    priority = 0;
+    EXPECT_EQ(CDVDMsg::GENERAL_SYNCHRONIZE, GetType(queue, priority));
+  }
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::NONE));
+
+  queue.End();
+}
+
+TEST(TestDVDMessageQueue, End)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  queue.Put(NewPacket(100, 0));
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), 1);
+  queue.Put(NewPacket(100, DVD_TIME_BASE));
+
+  /* only the demux packets are dropped, other messages stay queued */
+  queue.End();
+  queue.Init();
+  EXPECT_EQ(0, queue.GetDataSize());
+  EXPECT_EQ(0U, queue.GetPacketCount(CDVDMsg::DEMUXER_PACKET));
+  EXPECT_EQ(1U, queue.GetPacketCount(CDVDMsg::GENERAL_RESYNC));
+
+  int priority = 0;
+  EXPECT_EQ(CDVDMsg::GENERAL_RESYNC, GetType(queue, priority));
+
+  /* the destructor releases what's left */
+  queue.Put(new CDVDMsg(CDVDMsg::GENERAL_EOF));
+}
+
+TEST(TestDVDMessageQueue, Abort)
+{
+  CDVDMessageQueue queue("test");
+  queue.Init();
+  queue.Abort();
+
+  CDVDMsg *msg = NULL;
+  EXPECT_EQ(MSGQ_ABORT, queue.Get(&msg, 1000));
+  queue.End();
+}
+
+class QueueProducer : public IRunnable
+{
+public:
+  CDVDMessageQueue &queue;
+  unsigned int      count;
+
+  QueueProducer(CDVDMessageQueue &q, unsigned int c) : queue(q), count(c) {}
+
+  /* demux packets carrying their put time, with the odd control message in between */
+  void Run()
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      CDVDMsgDemuxerPacket *msg = NewPacket(64, i);
+      msg->GetPacket()->dts = (double)CurrentHostCounter();
+      queue.Put(msg);
+      if (i % 100 == 0)
+        queue.Put(new CDVDMsg(CDVDMsg::GENERAL_RESYNC), 1);
+      if (i % 16 == 0)
+        SleepMillis(0);
+    }
+  }
+};
+
+/* One producer and one consumer, like the demuxer and a decoder thread.
+ * Reports the throughput and the put to get latency.
+ */
+TEST(TestDVDMessageQueue, Stress)
+{
+  const unsigned int count = 200000;
+  CDVDMessageQueue queue("test");
+  queue.Init();
+
+  std::vector<double> latency;
+  latency.reserve(count);
+
+  QueueProducer producer(queue, count);
+  double next     = 0.0;
+  int    controls = 0;
+
+  int64_t freq  = CurrentHostFrequency();
+  int64_t start = CurrentHostCounter();
+  {
+    thread t(producer);
+    while (latency.size() < count)
+    {
+      CDVDMsg *msg = NULL;
+      int priority = 0;
+      ASSERT_EQ(MSGQ_OK, queue.Get(&msg, 1000, priority));
+      if (msg->IsType(CDVDMsg::DEMUXER_PACKET))
+      {
+        DemuxPacket *pkt = ((CDVDMsgDemuxerPacket*)msg)->GetPacket();
+        latency.push_back((CurrentHostCounter() - (int64_t)pkt->dts) * 1000000.0 / freq);
+        EXPECT_EQ(next, pkt->pts);
+        next = pkt->pts + 1.0;
+      }
+      else
+      {
+        EXPECT_EQ(1, priority);
+        controls++;
+      }
+      msg->Release();
+    }
+    t.join();
+  }
+  double elapsed = (CurrentHostCounter() - start) / (double)freq;
+
+  std::sort(latency.begin(), latency.end());
+  std::cout << (count + controls) / elapsed << " messages/s, latency us p50 "
+            << latency[count / 2] << " p99 " << latency[count * 99 / 100]
+            << " max " << latency.back() << "\n";
+
+  EXPECT_EQ((int)(count + 99) / 100, controls);
+  EXPECT_EQ(0, queue.GetDataSize());
+  queue.End();
+}
@@ -0,0 +1,169 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "cores/dvdplayer/DVDPictureQueue.h"
+#include "cores/VideoRenderers/RenderFormats.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+/* a YUV420P picture with padded strides, like the decoders hand out */
+class TestPicture
+{
+public:
+  TestPicture(unsigned int width, unsigned int height)
+  {
+    memset(&picture, 0, sizeof(picture));
+    picture.iWidth  = width;
+    picture.iHeight = height;
+    picture.format  = RENDER_FMT_YUV420P;
+
+    unsigned int stride[3] = { width + 32, (width + 1) / 2 + 16, (width + 1) / 2 + 16 };
+    unsigned int lines[3]  = { height, (height + 1) / 2, (height + 1) / 2 };
+    for (int p = 0; p < 3; p++)
+    {
+      planes[p] = new BYTE[stride[p] * lines[p]];
+      for (unsigned int i = 0; i < stride[p] * lines[p]; i++)
+        planes[p][i] = (BYTE)(i * (p + 1));
+      picture.data[p]      = planes[p];
+      picture.iLineSize[p] = stride[p];
+    }
+  }
+
+  ~TestPicture()
+  {
+    for (int p = 0; p < 3; p++)
+      delete[] planes[p];
+  }
+
+  bool Matches(const DVDVideoPicture &copy) const
+  {
+    unsigned int w[3] = { picture.iWidth,  (picture.iWidth  + 1) / 2, (picture.iWidth  + 1) / 2 };
+    unsigned int h[3] = { picture.iHeight, (picture.iHeight + 1) / 2, (picture.iHeight + 1) / 2 };
+    for (int p = 0; p < 3; p++)
+    {
+      for (unsigned int y = 0; y < h[p]; y++)
+      {
+        if (memcmp(copy.data[p] + y * copy.iLineSize[p], planes[p] + y * picture.iLineSize[p], w[p]))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  DVDVideoPicture picture;
+  BYTE*           planes[3];
+};
+
+TEST(TestDVDPictureQueue, Copy)
+{
+  CDVDPictureQueue queue;
+  queue.Init(4, 16 * 1024 * 1024);
+  EXPECT_TRUE(queue.IsEnabled());
+
+  volatile bool stop = false;
+  TestPicture   src(321, 241);
+  ASSERT_TRUE(queue.Put(src.picture, 1.0, stop));
+
+  /* the queue has its own copy, the decoder may reuse its buffers */
+  TestPicture     other(321, 241);
+  DVDVideoPicture picture;
+  double          pts;
+  ASSERT_TRUE(queue.Get(picture, pts, 0));
+  EXPECT_EQ(1.0, pts);
+  EXPECT_TRUE(picture.data[0] != src.picture.data[0]);
+  EXPECT_TRUE(src.Matches(picture));
+  queue.Release(0, false);
+
+  unsigned int shown, dropped;
+  queue.TakeResult(shown, dropped);
+  EXPECT_EQ(1U, shown);
+  EXPECT_EQ(0U, dropped);
+  EXPECT_EQ(0U, queue.GetFrames());
+}
+
+TEST(TestDVDPictureQueue, Limits)
+{
+  CDVDPictureQueue queue;
+  TestPicture      src(320, 240);
+  unsigned int     size = 320 * 240 * 3 / 2;
+  volatile bool    stop = true; /* don't block once full */
+
+  queue.Init(3, 100 * size);
+  EXPECT_TRUE(queue.Put(src.picture, 1.0, stop));
+  EXPECT_TRUE(queue.Put(src.picture, 2.0, stop));
+  EXPECT_TRUE(queue.Put(src.picture, 3.0, stop));
+  EXPECT_FALSE(queue.Put(src.picture, 4.0, stop));
+  EXPECT_EQ(3U, queue.GetFrames());
+  EXPECT_EQ(100, queue.GetLevel());
+
+  /* the memory bound applies first, but one picture always fits */
+  queue.Init(8, size + size / 2);
+  EXPECT_TRUE(queue.Put(src.picture, 1.0, stop));
+  EXPECT_FALSE(queue.Put(src.picture, 2.0, stop));
+  EXPECT_EQ(size, queue.GetBytes());
+
+  queue.Init(0, 0);
+  EXPECT_FALSE(queue.IsEnabled());
+  EXPECT_FALSE(queue.Supports(src.picture));
+}
+
+TEST(TestDVDPictureQueue, FlushAndPause)
+{
+  CDVDPictureQueue queue;
+  queue.Init(8, 16 * 1024 * 1024);
+
+  volatile bool stop = false;
+  TestPicture   src(64, 64);
+  for (int i = 0; i < 4; i++)
+    ASSERT_TRUE(queue.Put(src.picture, i, stop));
+
+  /* the picture being output survives a flush */
+  DVDVideoPicture picture;
+  double          pts;
+  ASSERT_TRUE(queue.Get(picture, pts, 0));
+  EXPECT_EQ(3U, queue.Flush());
+  EXPECT_EQ(1U, queue.GetFrames());
+  EXPECT_TRUE(src.Matches(picture));
+  queue.Release(0, true);
+
+  /* paused, only the first picture after the flush goes out */
+  queue.SetPaused(true);
+  ASSERT_TRUE(queue.Put(src.picture, 10.0, stop));
+  ASSERT_TRUE(queue.Put(src.picture, 11.0, stop));
+  ASSERT_TRUE(queue.Get(picture, pts, 0));
+  EXPECT_EQ(10.0, pts);
+  queue.Release(0, false);
+  EXPECT_FALSE(queue.Get(picture, pts, 10));
+  EXPECT_FALSE(queue.WaitEmpty(stop));
+
+  queue.SetPaused(false);
+  ASSERT_TRUE(queue.Get(picture, pts, 0));
+  EXPECT_EQ(11.0, pts);
+  queue.Release(0, false);
+  EXPECT_TRUE(queue.WaitEmpty(stop));
+
+  unsigned int shown, dropped;
+  queue.TakeResult(shown, dropped);
+  EXPECT_EQ(2U, shown);
+  EXPECT_EQ(1U, dropped);
+}
@@ -0,0 +1,206 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/dvdplayer/DVDClock.h"
+#include "cores/dvdplayer/DVDStreamInfo.h"
+#include "cores/dvdplayer/DVDCodecs/DVDCodecs.h"
+#include "cores/dvdplayer/DVDCodecs/Video/DVDVideoCodecFFmpeg.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemux.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/dvdplayer/DVDDemuxers/DVDFactoryDemuxer.h"
+#include "cores/dvdplayer/DVDInputStreams/DVDInputStream.h"
+#include "cores/dvdplayer/DVDInputStreams/DVDFactoryInputStream.h"
+#include "utils/CPUInfo.h"
+#include "utils/Stopwatch.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+/* video packets read from each file, the same ones are decoded in every run */
+#define BENCH_PACKETS 500
+
+typedef std::vector<DemuxPacket*> PacketList;
+
+static CDVDCodecOptions ThreadOptions(const char *type, int threads)
+{
+  CStdString count;
+  count.Format("%d", threads);
+
+  CDVDCodecOptions options;
+  options.m_keys.push_back(CDVDCodecOption("threads", count));
+  options.m_keys.push_back(CDVDCodecOption("thread_type", type));
+  return options;
+}
+
+static bool ReadPackets(const CStdString &path, CDVDStreamInfo &hint, PacketList &packets)
+{
+  std::auto_ptr<CDVDInputStream> input(CDVDFactoryInputStream::CreateInputStream(NULL, path, ""));
+  if (!input.get() || !input->Open(path, ""))
+    return false;
+
+  std::auto_ptr<CDVDDemux> demux(CDVDFactoryDemuxer::CreateDemuxer(input.get()));
+  if (!demux.get())
+    return false;
+
+  int stream = -1;
+  for (int i = 0; i < demux->GetNrOfStreams(); i++)
+  {
+    CDemuxStream *pStream = demux->GetStream(i);
+    if (pStream && pStream->type == STREAM_VIDEO && stream < 0)
+      stream = i;
+    else if (pStream)
+      pStream->SetDiscard(AVDISCARD_ALL);
+  }
+  if (stream < 0)
+    return false;
+
+  hint.Assign(*demux->GetStream(stream), true);
+
+  DemuxPacket *pPacket;
+  while (packets.size() < BENCH_PACKETS && (pPacket = demux->Read()))
+  {
+    if (pPacket->iStreamId == stream)
+      packets.push_back(pPacket);
+    else
+      CDVDDemuxUtils::FreeDemuxPacket(pPacket);
+  }
+  return !packets.empty();
+}
+
+static void FreePackets(PacketList &packets)
+{
+  for (PacketList::iterator it = packets.begin(); it != packets.end(); ++it)
+    CDVDDemuxUtils::FreeDemuxPacket(*it);
+  packets.clear();
+}
+
+static bool GetPicture(CDVDVideoCodec &codec, unsigned int &pictures, double &lastDts)
+{
+  DVDVideoPicture picture;
+  memset(&picture, 0, sizeof(picture));
+  if (!codec.GetPicture(&picture))
+    return false;
+
+  /* the dts has to follow the picture through the decoder delay */
+  if (picture.dts != DVD_NOPTS_VALUE)
+  {
+    if (lastDts != DVD_NOPTS_VALUE && picture.dts < lastDts)
+      return false;
+    lastDts = picture.dts;
+  }
+
+  pictures++;
+  return true;
+}
+
+/* decode all packets without rendering anything, returns the pictures per second */
+static double Decode(CDVDStreamInfo &hint, const PacketList &packets, const char *type, int threads)
+{
+  CDVDCodecOptions     options = ThreadOptions(type, threads);
+  CDVDVideoCodecFFmpeg codec;
+  if (!codec.Open(hint, options))
+    return 0.0;
+
+  unsigned int pictures = 0;
+  double       lastDts  = DVD_NOPTS_VALUE;
+  CStopWatch   watch;
+  watch.StartZero();
+
+  for (PacketList::const_iterator it = packets.begin(); it != packets.end(); ++it)
+  {
+    int state = codec.Decode((*it)->pData, (*it)->iSize, (*it)->dts, (*it)->pts);
+    while (state & VC_PICTURE)
+    {
+      EXPECT_TRUE(GetPicture(codec, pictures, lastDts));
+      if (state & VC_BUFFER)
+        break;
+      state = codec.Decode(NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+    }
+    if (state & VC_ERROR)
+      break;
+  }
+
+  /* drain what the threads and reordering still hold */
+  for (unsigned int i = 0; i <= codec.GetFrameDelay() + 16; i++)
+  {
+    if (!(codec.Decode(NULL, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE) & VC_PICTURE))
+      break;
+    EXPECT_TRUE(GetPicture(codec, pictures, lastDts));
+  }
+
+  float elapsed = watch.GetElapsedSeconds();
+  codec.Dispose();
+
+  std::cout << "  " << type << " threads " << threads << ": " << pictures << " pictures in "
+            << elapsed << "s, " << (elapsed > 0.0f ? pictures / elapsed : 0.0f) << " fps\n";
+  return elapsed > 0.0f ? pictures / elapsed : 0.0;
+}
+
+TEST(TestDVDVideoCodecFFmpeg, FrameDelay)
+{
+  CDVDStreamInfo hint;
+  hint.codec    = CODEC_ID_H264;
+  hint.width    = 1920;
+  hint.height   = 1080;
+  hint.software = true;
+
+  CDVDVideoCodecFFmpeg slice;
+  CDVDCodecOptions     sliceOptions = ThreadOptions("slice", 4);
+  ASSERT_TRUE(slice.Open(hint, sliceOptions));
+  EXPECT_EQ(0U, slice.GetFrameDelay());
+  slice.Dispose();
+
+  /* frame threads hold back one picture per extra thread, unless ffmpeg was built without threads */
+  CDVDVideoCodecFFmpeg frame;
+  CDVDCodecOptions     frameOptions = ThreadOptions("frame", 4);
+  ASSERT_TRUE(frame.Open(hint, frameOptions));
+  EXPECT_TRUE(frame.GetFrameDelay() == 0 || frame.GetFrameDelay() == 3);
+  frame.Dispose();
+}
+
+/* Decode only benchmark, the files are given to the test suite with
+ * --add-videodecode-file. Every file is decoded with slice and frame
+ * threading at 1, 2, 4 ... threads up to the number of cpus.
+ */
+TEST(TestDVDVideoCodecFFmpeg, DecodeBenchmark)
+{
+  std::vector<CStdString> files = CXBMCTestUtils::Instance().getVideoDecodeFiles();
+  for (std::vector<CStdString>::iterator it = files.begin(); it != files.end(); ++it)
+  {
+    CDVDStreamInfo hint;
+    PacketList     packets;
+    std::cout << "Decoding: " << *it << "\n";
+    ASSERT_TRUE(ReadPackets(*it, hint, packets));
+
+    /* software only, there is nothing to render hardware surfaces to */
+    hint.software = true;
+
+    int cpus = g_cpuInfo.getCPUCount();
+    for (int threads = 1; threads <= cpus; threads = threads < cpus && threads * 2 > cpus ? cpus : threads * 2)
+    {
+      EXPECT_GT(Decode(hint, packets, "slice", threads), 0.0);
+      EXPECT_GT(Decode(hint, packets, "frame", threads), 0.0);
+    }
+
+    FreePackets(packets);
+  }
+}
@@ -302,6 +302,12 @@ bool CDatabase::CommitInsertQueries()
   return bReturn;
 }
 
+Statement *CDatabase::GetStatement(const std::string &strQuery)
+{
+  if (NULL == m_pDB.get()) return NULL;
+  return m_pDB->getStatement(strQuery);
+}
+
 bool CDatabase::Open()
 {
   DatabaseSettings db_fallback;
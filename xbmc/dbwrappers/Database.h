@@ -25,6 +25,7 @@
 namespace dbiplus {
   class Database;
   class Dataset;
+  class Statement;
 }
 
 #include <memory>
@@ -134,6 +135,16 @@ public:
    */
   bool CommitInsertQueries();
 
+  /*!
+   * @brief Get the compiled statement of a query that takes its values from '?' placeholders.
+   * @remarks The statement is compiled once and cached with the connection, so repeated queries
+   * skip parsing and planning. Bind the values, then step() through the rows. Call reset() when
+   * not stepping to the last row, so the statement doesn't hold locks.
+   * @param strQuery The query to compile.
+   * @return The statement, owned by the connection. NULL if the database isn't open.
+   */
+  dbiplus::Statement *GetStatement(const std::string &strQuery);
+
   virtual bool GetFilter(const CDbUrl &dbUrl, Filter &filter) { return true; }
   virtual bool BuildSQL(const CStdString &strBaseDir, const CStdString &strQuery, Filter &filter, CStdString &strSQL, CDbUrl &dbUrl);
 
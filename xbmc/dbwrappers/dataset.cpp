@@ -52,6 +52,9 @@ Database::Database() {
 
 Database::~Database() {
   disconnect();		// Disconnect if connected to database
+  for (StatementMap::iterator i = statements.begin(); i != statements.end(); ++i)
+    delete i->second;
+  statements.clear();
 }
 
 int Database::connectFull(const char *newHost, const char *newPort, const char *newDb, const char *newLogin, const char *newPasswd) {
@@ -75,6 +78,69 @@ string Database::prepare(const char *format, ...)
   return result;
 }
 
+Statement *Database::getStatement(const string &sql)
+{
+  StatementMap::iterator i = statements.find(sql);
+  if (i != statements.end())
+    return i->second;
+
+  Statement *stmt = CreateStatement(sql);
+  if (stmt == NULL)
+    throw DbErrors("Statements are not supported by this database");
+  statements.insert(make_pair(sql, stmt));
+  return stmt;
+}
+
+void Database::resetStatements()
+{
+  for (StatementMap::iterator i = statements.begin(); i != statements.end(); ++i)
+    i->second->reset();
+}
+
+void Database::finalizeStatements()
+{
+  for (StatementMap::iterator i = statements.begin(); i != statements.end(); ++i)
+    i->second->finalize();
+}
+
+//************* Statement implementation ***************
+
+Statement::Statement(Database *newDb, const string &newSql) {
+  db = newDb;
+  sql = newSql;
+  running = false;
+}
+
+void Statement::bind(int index, const field_value &value) {
+  if (index < 1)
+    throw DbErrors("Parameter index not found: %d", index);
+  if (running)
+    reset();
+  if (params.size() < (unsigned int)index)
+    params.resize(index);
+  params[index - 1] = value;
+}
+
+void Statement::bind_null(int index) {
+  field_value value;
+  value.set_isNull();
+  bind(index, value);
+}
+
+int Statement::exec() {
+  reset();
+  while (step());
+  return DB_COMMAND_OK;
+}
+
+const field_value Statement::get_field_value(int index) {
+  if (!running)
+    throw DbErrors("Statement is not running");
+  if (index < 0 || index >= field_count())
+    throw DbErrors("Field index not found: %d", index);
+  return row[index];
+}
+
 //************* Dataset implementation ***************
 
 Dataset::Dataset() {
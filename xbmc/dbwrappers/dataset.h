@@ -42,6 +42,7 @@
 
 namespace dbiplus {
 class Dataset;		// forward declaration of class Dataset
+class Statement;	// forward declaration of class Statement
 
 
 #define S_NO_CONNECTION "No active connection";
@@ -67,11 +68,14 @@ class Dataset;		// forward declaration of class Dataset
 ******************************************************************/
 class Database  {
 protected:
+  typedef std::map<std::string, Statement*> StatementMap;
+
   bool active;
   std::string error, // Error description
     host, port, db, login, passwd, //Login info
     sequence_table, //Sequence table for nextid
     default_charset; //Default character set
+  StatementMap statements; // compiled statements keyed by their sql
 
 public:
 /* constructor */
@@ -79,6 +83,8 @@ public:
 /* destructor */
   virtual ~Database();
   virtual Dataset *CreateDataset() const = 0;
+/* creates a statement for the backend, NULL when it can't compile statements */
+  virtual Statement *CreateStatement(const std::string &sql) { return NULL; }
 /* sets a new host name */
   virtual void setHostName(const char *newHost) { host = newHost; }
 /* gets a host name */
@@ -153,6 +159,81 @@ public:
 
   virtual bool in_transaction() {return false;};
 
+/* methods for compiled statements */
+
+  /*! \brief Get the statement compiled from a query with '?' placeholders.
+   The statement is created on first use and kept until the database is destroyed,
+   so the backend only has to parse and plan the query once.
+   \param sql - the query, values are bound to its '?' placeholders.
+   \return the statement, owned by the database.
+   */
+  Statement *getStatement(const std::string &sql);
+
+  /*! \brief Stop all statements that are stepping through their rows.
+   */
+  void resetStatements();
+
+  /*! \brief Release the compiled statements, they are compiled again on their next use.
+   Backends call this before the connection is closed.
+   */
+  void finalizeStatements();
+
+};
+
+
+
+
+/******************* Class Statement definition *******************
+
+  a query compiled once and executed with the values bound
+  to its '?' placeholders
+
+******************************************************************/
+class Statement  {
+protected:
+  Database *db;		// the connection the statement is compiled on
+  std::string sql;
+  sql_record params;	// bound values, params[0] goes to the first '?'
+  sql_record row;	// values of the current row
+  bool running;		// executed and stepping through the rows
+
+public:
+/* constructor */
+  Statement(Database *newDb, const std::string &newSql);
+/* destructor */
+  virtual ~Statement() {}
+
+/* retrieves the query string */
+  const char *getSql() const { return sql.c_str(); }
+
+/* bind a value to the '?' placeholder No index (starting with 1),
+   a statement that is running is reset first */
+  void bind(int index, const field_value &value);
+  void bind(int index, const std::string &value) { bind(index, field_value(value.c_str())); }
+  void bind(int index, const char *value) { bind(index, field_value(value)); }
+/* bind NULL to the '?' placeholder No index (starting with 1) */
+  void bind_null(int index);
+
+/* executes the statement on the first call and goes to the next row of the
+   results on every call. Returns false when there are no more rows, the
+   statement is reset then */
+  virtual bool step() = 0;
+/* stops stepping through the rows, the bound values are kept */
+  virtual void reset() = 0;
+/* releases the compiled statement, it's compiled again on next use */
+  virtual void finalize() = 0;
+/* executes the statement without returning rows */
+  virtual int exec();
+
+/* last inserted id */
+  virtual int64_t lastinsertid() = 0;
+
+/* Number of fields in the current row */
+  int field_count() { return row.size(); }
+/* Getting value of field for current row */
+  const field_value get_field_value(int index);
+/* Alias to get_field_value */
+  const field_value fv(int index) { return get_field_value(index); }
 };
 
 
@@ -65,6 +65,10 @@ Dataset* MysqlDatabase::CreateDataset() const {
    return new MysqlDataset((MysqlDatabase*)this);
 }
 
+Statement* MysqlDatabase::CreateStatement(const string &sql) {
+   return new MysqlStatement(this, sql);
+}
+
 int MysqlDatabase::status(void) {
   if (active == false) return DB_CONNECTION_NONE;
   return DB_CONNECTION_OK;
@@ -183,6 +187,9 @@ int MysqlDatabase::connect(bool create_new) {
 }
 
 void MysqlDatabase::disconnect(void) {
+  // prepared statements belong to the connection
+  finalizeStatements();
+
   if (conn != NULL)
   {
     mysql_close(conn);
@@ -1597,6 +1604,265 @@ void MysqlDataset::interrupt() {
   // Impossible
 }
 
+
+//************* MysqlStatement implementation ***************
+
+MysqlStatement::MysqlStatement(MysqlDatabase *newDb, const string &newSql):Statement(newDb, newSql) {
+  stmt = NULL;
+  meta = NULL;
+}
+
+MysqlStatement::~MysqlStatement() {
+  finalize();
+}
+
+MYSQL* MysqlStatement::handle() {
+  if (db != NULL && db->isActive())
+    return static_cast<MysqlDatabase*>(db)->getHandle();
+  return NULL;
+}
+
+int MysqlStatement::compile() {
+  stmt = mysql_stmt_init(handle());
+  if (stmt == NULL)
+    return mysql_errno(handle());
+
+  if (mysql_stmt_prepare(stmt, sql.c_str(), sql.size()) != MYSQL_OK)
+  {
+    int err = mysql_stmt_errno(stmt);
+    finalize();
+    return err;
+  }
+  meta = mysql_stmt_result_metadata(stmt);
+  return MYSQL_OK;
+}
+
+int MysqlStatement::bind_params() {
+  const unsigned int count = mysql_stmt_param_count(stmt);
+  param_binds.assign(count, MYSQL_BIND());
+  param_strings.resize(count);
+  param_ints.resize(count);
+  param_doubles.resize(count);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    MYSQL_BIND &b = param_binds[i];
+    memset(&b, 0, sizeof(b));
+    if (i >= params.size() || params[i].get_isNull())
+    {
+      b.buffer_type = MYSQL_TYPE_NULL;
+      continue;
+    }
+    const field_value &v = params[i];
+    switch (v.get_fType())
+    {
+    case ft_String:
+      param_strings[i] = v.get_asString();
+      b.buffer_type = MYSQL_TYPE_STRING;
+      b.buffer = (void *)param_strings[i].c_str();
+      b.buffer_length = param_strings[i].size();
+      break;
+    case ft_Float:
+    case ft_Double:
+      param_doubles[i] = v.get_asDouble();
+      b.buffer_type = MYSQL_TYPE_DOUBLE;
+      b.buffer = &param_doubles[i];
+      break;
+    default:
+      param_ints[i] = v.get_asInt64();
+      b.buffer_type = MYSQL_TYPE_LONGLONG;
+      b.buffer = &param_ints[i];
+      break;
+    }
+  }
+  if (count > 0 && mysql_stmt_bind_param(stmt, &param_binds[0]) != MYSQL_OK)
+    return mysql_stmt_errno(stmt);
+  return MYSQL_OK;
+}
+
+void MysqlStatement::bind_results() {
+  const unsigned int numColumns = mysql_num_fields(meta);
+  result_binds.assign(numColumns, MYSQL_BIND());
+  result_buffers.resize(numColumns);
+  result_lengths.assign(numColumns, 0);
+  result_nulls.assign(numColumns, 0);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    // every column is fetched as text like MysqlDataset::query() does, larger
+    // values are fetched again once their length is known
+    if (result_buffers[i].size() < 256)
+      result_buffers[i].resize(256);
+    MYSQL_BIND &b = result_binds[i];
+    memset(&b, 0, sizeof(b));
+    b.buffer_type = MYSQL_TYPE_STRING;
+    b.buffer = &result_buffers[i][0];
+    b.buffer_length = result_buffers[i].size();
+    b.length = &result_lengths[i];
+    b.is_null = &result_nulls[i];
+  }
+  if (numColumns > 0 && mysql_stmt_bind_result(stmt, &result_binds[0]) != MYSQL_OK)
+  {
+    db->setErr(mysql_stmt_errno(stmt), sql.c_str());
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+void MysqlStatement::execute() {
+  int attempts = 5;
+  int err;
+
+  // try to reconnect if server is gone, this finalizes the statement
+  while (true)
+  {
+    err = MYSQL_OK;
+    if (stmt == NULL)
+      err = compile();
+    if (err == MYSQL_OK)
+      err = bind_params();
+    if (err == MYSQL_OK && mysql_stmt_execute(stmt) != MYSQL_OK)
+      err = mysql_stmt_errno(stmt);
+    if (err == MYSQL_OK)
+      break;
+
+    if ((err != CR_SERVER_GONE_ERROR && err != CR_SERVER_LOST) || attempts-- <= 0)
+    {
+      db->setErr(err, sql.c_str());
+      throw DbErrors(db->getErrorMsg());
+    }
+    CLog::Log(LOGINFO,"MYSQL server has gone. Will try %d more attempt(s) to reconnect.", attempts);
+    db->connect(true);
+    if (!handle())
+      throw DbErrors("No Database Connection");
+  }
+
+  if (meta != NULL)
+  {
+    bind_results();
+    // buffer the rows on the client, so other queries can run while stepping
+    if (mysql_stmt_store_result(stmt) != MYSQL_OK)
+    {
+      db->setErr(mysql_stmt_errno(stmt), sql.c_str());
+      throw DbErrors(db->getErrorMsg());
+    }
+  }
+}
+
+void MysqlStatement::fill_row() {
+  const unsigned int numColumns = result_binds.size();
+  MYSQL_FIELD *fields = mysql_fetch_fields(meta);
+  bool rebind = false;
+  row.clear();
+  row.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    field_value &v = row[i];
+    if (result_nulls[i])
+    {
+      v.set_asString("");
+      v.set_isNull();
+      continue;
+    }
+
+    // truncated, grow the buffer and fetch the whole value
+    if (result_lengths[i] > result_buffers[i].size())
+    {
+      result_buffers[i].resize(result_lengths[i]);
+      result_binds[i].buffer = &result_buffers[i][0];
+      result_binds[i].buffer_length = result_buffers[i].size();
+      if (mysql_stmt_fetch_column(stmt, &result_binds[i], i, 0) != MYSQL_OK)
+      {
+        db->setErr(mysql_stmt_errno(stmt), sql.c_str());
+        throw DbErrors(db->getErrorMsg());
+      }
+      rebind = true;
+    }
+
+    const string value(&result_buffers[i][0], result_lengths[i]);
+    switch (fields[i].type)
+    {
+      case MYSQL_TYPE_LONGLONG:
+      case MYSQL_TYPE_DECIMAL:
+      case MYSQL_TYPE_NEWDECIMAL:
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONG:
+        v.set_asInt(atoi(value.c_str()));
+        break;
+      case MYSQL_TYPE_FLOAT:
+      case MYSQL_TYPE_DOUBLE:
+        v.set_asDouble(atof(value.c_str()));
+        break;
+      default:
+        v.set_asString(value);
+        break;
+    }
+  }
+
+  // later rows are fetched into the grown buffers
+  if (rebind && mysql_stmt_bind_result(stmt, &result_binds[0]) != MYSQL_OK)
+  {
+    db->setErr(mysql_stmt_errno(stmt), sql.c_str());
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+bool MysqlStatement::step() {
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  if (!running)
+  {
+    execute();
+    running = true;
+  }
+
+  if (meta == NULL)
+  {
+    reset();
+    return false;
+  }
+
+  int rc = mysql_stmt_fetch(stmt);
+  if (rc == MYSQL_OK || rc == MYSQL_DATA_TRUNCATED)
+  {
+    fill_row();
+    return true;
+  }
+
+  int err = mysql_stmt_errno(stmt);
+  reset();
+  if (rc == MYSQL_NO_DATA)
+    return false;
+
+  db->setErr(err, sql.c_str());
+  throw DbErrors(db->getErrorMsg());
+}
+
+void MysqlStatement::reset() {
+  if (stmt != NULL && running)
+  {
+    mysql_stmt_free_result(stmt);
+    mysql_stmt_reset(stmt);
+  }
+  running = false;
+  row.clear();
+}
+
+void MysqlStatement::finalize() {
+  if (meta != NULL)
+    mysql_free_result(meta);
+  if (stmt != NULL)
+    mysql_stmt_close(stmt);
+  meta = NULL;
+  stmt = NULL;
+  running = false;
+  row.clear();
+}
+
+int64_t MysqlStatement::lastinsertid() {
+  if (stmt == NULL) throw DbErrors("No Database Connection");
+  return mysql_stmt_insert_id(stmt);
+}
+
 }//namespace
 #endif //HAS_MYSQL
 
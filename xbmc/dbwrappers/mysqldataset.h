@@ -22,6 +22,7 @@
 #define _MYSQLDATASET_H
 
 #include <stdio.h>
+#include <vector>
 #include "dataset.h"
 #include "mysql/mysql.h"
 
@@ -46,6 +47,7 @@ public:
   ~MysqlDatabase();
 
   Dataset *CreateDataset() const;
+  Statement *CreateStatement(const std::string &sql);
 
 /* func. returns connection handle with MySQL-server */
   MYSQL *getHandle() {  return conn; }
@@ -171,5 +173,53 @@ or insert() operations default = false) */
 
   virtual bool dropIndex(const char *table, const char *index);
 };
+
+
+
+/***************** Class MysqlStatement definition ******************
+
+       class 'MysqlStatement' is a prepared statement on the MySQL-server
+
+******************************************************************/
+
+class MysqlStatement : public Statement {
+protected:
+  MYSQL_STMT *stmt;
+  MYSQL_RES *meta;	// result columns, NULL when the statement returns no rows
+  MYSQL* handle();
+
+/* bound parameters, the values have to live until the statement is executed */
+  std::vector<MYSQL_BIND> param_binds;
+  std::vector<std::string> param_strings;
+  std::vector<long long> param_ints;
+  std::vector<double> param_doubles;
+
+/* buffers the columns of the current row are fetched into */
+  std::vector<MYSQL_BIND> result_binds;
+  std::vector< std::vector<char> > result_buffers;
+  std::vector<unsigned long> result_lengths;
+  std::vector<my_bool> result_nulls;
+
+/* compiles the query on the server, returns the mysql error code */
+  int compile();
+  int bind_params();
+  void bind_results();
+/* executes the query, reconnecting when the server has gone */
+  void execute();
+/* Filling the current row from the fetched buffers */
+  void fill_row();
+
+public:
+/* constructor */
+  MysqlStatement(MysqlDatabase *newDb, const std::string &newSql);
+/* destructor */
+  ~MysqlStatement();
+
+  virtual bool step();
+  virtual void reset();
+  virtual void finalize();
+/* last inserted id */
+  virtual int64_t lastinsertid();
+};
 } //namespace
 #endif
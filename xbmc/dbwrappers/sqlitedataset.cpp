@@ -110,6 +110,10 @@ Dataset* SqliteDatabase::CreateDataset() const {
 	return new SqliteDataset((SqliteDatabase*)this); 
 }
 
+Statement* SqliteDatabase::CreateStatement(const string &sql) {
+  return new SqliteStatement(this, sql);
+}
+
 void SqliteDatabase::setHostName(const char *newHost) {
   host = newHost;
 
@@ -260,6 +264,8 @@ bool SqliteDatabase::exists(void)
 
 void SqliteDatabase::disconnect(void) {
   if (active == false) return;
+  // the connection can't be closed while statements are compiled on it
+  finalizeStatements();
   sqlite3_close(conn);
   active = false;
 }
@@ -360,6 +366,7 @@ void SqliteDatabase::start_transaction() {
 
 void SqliteDatabase::commit_transaction() {
   if (active) {
+    resetStatements();
     sqlite3_exec(conn,"commit",NULL,NULL,NULL);
     _in_transaction = false;
   }
@@ -367,6 +374,7 @@ void SqliteDatabase::commit_transaction() {
 
 void SqliteDatabase::rollback_transaction() {
   if (active) {
+    resetStatements();
     sqlite3_exec(conn,"rollback",NULL,NULL,NULL);
     _in_transaction = false;
   }  
@@ -777,4 +785,148 @@ long SqliteDataset::nextid(const char *seq_name) {
 void SqliteDataset::interrupt() {
   sqlite3_interrupt(handle());
 }
+
+
+//************* SqliteStatement implementation ***************
+
+SqliteStatement::SqliteStatement(SqliteDatabase *newDb, const string &newSql):Statement(newDb, newSql) {
+  stmt = NULL;
+}
+
+SqliteStatement::~SqliteStatement() {
+  finalize();
+}
+
+sqlite3* SqliteStatement::handle() {
+  if (db != NULL && db->isActive())
+    return static_cast<SqliteDatabase*>(db)->getHandle();
+  return NULL;
+}
+
+void SqliteStatement::compile() {
+  #if defined(TARGET_DARWIN)
+  if (db->setErr(sqlite3_prepare(handle(),sql.c_str(),-1,&stmt, NULL),sql.c_str()) != SQLITE_OK)
+  #else
+  if (db->setErr(sqlite3_prepare_v2(handle(),sql.c_str(),-1,&stmt, NULL),sql.c_str()) != SQLITE_OK)
+  #endif
+  {
+    stmt = NULL;
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+void SqliteStatement::bind_params() {
+  int rc = SQLITE_OK;
+  for (unsigned int i = 0; i < params.size() && rc == SQLITE_OK; i++)
+  {
+    const field_value &v = params[i];
+    if (v.get_isNull())
+    {
+      rc = sqlite3_bind_null(stmt, i + 1);
+      continue;
+    }
+    switch (v.get_fType())
+    {
+    case ft_String:
+      rc = sqlite3_bind_text(stmt, i + 1, v.get_asString().c_str(), -1, SQLITE_TRANSIENT);
+      break;
+    case ft_Float:
+    case ft_Double:
+      rc = sqlite3_bind_double(stmt, i + 1, v.get_asDouble());
+      break;
+    default:
+      rc = sqlite3_bind_int64(stmt, i + 1, v.get_asInt64());
+      break;
+    }
+  }
+  if (db->setErr(rc, sql.c_str()) != SQLITE_OK)
+    throw DbErrors(db->getErrorMsg());
+}
+
+void SqliteStatement::fill_row() {
+  const unsigned int numColumns = sqlite3_column_count(stmt);
+  row.clear();
+  row.resize(numColumns);
+  for (unsigned int i = 0; i < numColumns; i++)
+  {
+    field_value &v = row[i];
+    switch (sqlite3_column_type(stmt, i))
+    {
+    case SQLITE_INTEGER:
+      v.set_asInt64(sqlite3_column_int64(stmt, i));
+      break;
+    case SQLITE_FLOAT:
+      v.set_asDouble(sqlite3_column_double(stmt, i));
+      break;
+    case SQLITE_TEXT:
+    case SQLITE_BLOB:
+      v.set_asString((const char *)sqlite3_column_text(stmt, i));
+      break;
+    case SQLITE_NULL:
+    default:
+      v.set_asString("");
+      v.set_isNull();
+      break;
+    }
+  }
+}
+
+bool SqliteStatement::step() {
+  if (!handle()) throw DbErrors("No Database Connection");
+
+  // a statement compiled with the legacy interface fails once the schema
+  // changed, it has to be compiled again then
+  for (int attempt = 0; ; attempt++)
+  {
+    if (!running)
+    {
+      if (stmt == NULL)
+        compile();
+      bind_params();
+      running = true;
+    }
+
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW)
+    {
+      fill_row();
+      return true;
+    }
+
+    running = false;
+    int err = sqlite3_reset(stmt);
+    if (rc == SQLITE_DONE)
+    {
+      row.clear();
+      return false;
+    }
+    if (err == SQLITE_SCHEMA && attempt == 0)
+    {
+      finalize();
+      continue;
+    }
+    db->setErr(err != SQLITE_OK ? err : rc, sql.c_str());
+    throw DbErrors(db->getErrorMsg());
+  }
+}
+
+void SqliteStatement::reset() {
+  if (stmt != NULL && running)
+    sqlite3_reset(stmt);
+  running = false;
+  row.clear();
+}
+
+void SqliteStatement::finalize() {
+  if (stmt != NULL)
+    sqlite3_finalize(stmt);
+  stmt = NULL;
+  running = false;
+  row.clear();
+}
+
+int64_t SqliteStatement::lastinsertid() {
+  if (!handle()) throw DbErrors("No Database Connection");
+  return sqlite3_last_insert_rowid(handle());
+}
 }//namespace
@@ -53,6 +53,7 @@ public:
   ~SqliteDatabase();
 
   Dataset *CreateDataset() const; 
+  Statement *CreateStatement(const std::string &sql);
 
 /* func. returns connection handle with SQLite-server */
   sqlite3 *getHandle() {  return conn; }
@@ -171,5 +172,37 @@ or insert() operations default = false) */
 
   virtual bool dropIndex(const char *table, const char *index);
 };
+
+
+
+/***************** Class SqliteStatement definition *****************
+
+       class 'SqliteStatement' is a query compiled by SQLite
+
+******************************************************************/
+
+class SqliteStatement : public Statement {
+protected:
+  sqlite3_stmt *stmt;
+  sqlite3* handle();
+
+/* compiles the query and binds the parameters to it */
+  void compile();
+  void bind_params();
+/* Filling the current row from the stepped statement */
+  void fill_row();
+
+public:
+/* constructor */
+  SqliteStatement(SqliteDatabase *newDb, const std::string &newSql);
+/* destructor */
+  ~SqliteStatement();
+
+  virtual bool step();
+  virtual void reset();
+  virtual void finalize();
+/* last inserted id */
+  virtual int64_t lastinsertid();
+};
 } //namespace
 #endif
@@ -0,0 +1,371 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/sqlitedataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "threads/SystemClock.h"
+#include "utils/StdString.h"
+
+#include <iostream>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+using namespace dbiplus;
+
+class TestDatabase : public testing::Test
+{
+protected:
+  TestDatabase()
+  {
+    m_db.setHostName(CSpecialProtocol::TranslatePath("special://temp/").c_str());
+    m_db.setDatabase("TestDatabase");
+    XFILE::CFile::Delete(Path());
+  }
+
+  ~TestDatabase()
+  {
+    m_db.disconnect();
+    XFILE::CFile::Delete(Path());
+  }
+
+  CStdString Path()
+  {
+    return CStdString(m_db.getHostName()) + m_db.getDatabase();
+  }
+
+  void CreateLibrary()
+  {
+    std::auto_ptr<Dataset> ds(m_db.CreateDataset());
+    ds->exec("CREATE TABLE path (idPath integer primary key, strPath text)");
+    ds->exec("CREATE UNIQUE INDEX ix_path ON path ( strPath )");
+    ds->exec("CREATE TABLE files (idFile integer primary key, idPath integer, strFileName text)");
+    ds->exec("CREATE UNIQUE INDEX ix_files ON files ( idPath, strFileName )");
+    ds->exec("CREATE TABLE genre (idGenre integer primary key, strGenre text)");
+    ds->exec("CREATE TABLE actors (idActor integer primary key, strActor text)");
+    ds->exec("CREATE TABLE genrelinkmovie (idGenre integer, idMovie integer)");
+    ds->exec("CREATE UNIQUE INDEX ix_genrelinkmovie ON genrelinkmovie ( idGenre, idMovie )");
+    ds->exec("CREATE TABLE actorlinkmovie (idActor integer, idMovie integer, strRole text, iOrder integer)");
+    ds->exec("CREATE UNIQUE INDEX ix_actorlinkmovie ON actorlinkmovie ( idActor, idMovie )");
+  }
+
+  int Count(const char *table)
+  {
+    std::auto_ptr<Dataset> ds(m_db.CreateDataset());
+    ds->query(m_db.prepare("select count(*) from %s", table).c_str());
+    return ds->fv(0).get_asInt();
+  }
+
+  SqliteDatabase m_db;
+};
+
+TEST_F(TestDatabase, Statement)
+{
+  ASSERT_EQ(DB_CONNECTION_OK, m_db.connect(true));
+  CreateLibrary();
+
+  Statement *insert = m_db.getStatement("insert into path (idPath, strPath) values (NULL, ?)");
+  EXPECT_EQ(insert, m_db.getStatement("insert into path (idPath, strPath) values (NULL, ?)"));
+
+  insert->bind(1, "/movies/");
+  EXPECT_EQ(DB_COMMAND_OK, insert->exec());
+  EXPECT_EQ(1, insert->lastinsertid());
+  insert->bind(1, "/it's quoted/");
+  insert->exec();
+  EXPECT_EQ(2, insert->lastinsertid());
+
+  Statement *select = m_db.getStatement("select idPath, strPath from path where strPath=?");
+  select->bind(1, "/it's quoted/");
+  ASSERT_TRUE(select->step());
+  EXPECT_EQ(2, select->field_count());
+  EXPECT_EQ(2, select->fv(0).get_asInt());
+  EXPECT_EQ("/it's quoted/", select->fv(1).get_asString());
+  EXPECT_FALSE(select->step());
+
+  // binding resets a statement that is stepping through its rows
+  select->bind(1, "/movies/");
+  ASSERT_TRUE(select->step());
+  EXPECT_EQ(1, select->fv(0).get_asInt());
+  select->bind(1, "/missing/");
+  EXPECT_FALSE(select->step());
+
+  Statement *files = m_db.getStatement("insert into files (idFile, idPath, strFileName) values (NULL, ?, ?)");
+  files->bind(1, 1);
+  files->bind_null(2);
+  files->exec();
+  Statement *file = m_db.getStatement("select strFileName from files where idPath=?");
+  file->bind(1, 1);
+  ASSERT_TRUE(file->step());
+  EXPECT_TRUE(file->fv(0).get_isNull());
+  file->reset();
+
+  // statements are compiled again on the new connection
+  ASSERT_EQ(DB_CONNECTION_OK, m_db.connect(false));
+  select->bind(1, "/movies/");
+  ASSERT_TRUE(select->step());
+  EXPECT_EQ(1, select->fv(0).get_asInt());
+  select->reset();
+
+  EXPECT_THROW(m_db.getStatement("select * from nosuchtable")->step(), DbErrors);
+}
+
+/* adds a synthetic library the way the video scanner does, returns the number of statements */
+class CTestScan
+{
+public:
+  CTestScan(SqliteDatabase &db) : m_db(db), m_statements(0) {}
+  virtual ~CTestScan() {}
+
+  int Scan(int movies)
+  {
+    m_db.start_transaction();
+    for (int i = 0; i < movies; i++)
+    {
+      CStdString path, file;
+      path.Format("/library/movies %d/", i / 20);
+      file.Format("Movie's title %d (%d).mkv", i, 1950 + i % 60);
+      int idFile = AddFile(AddPath(path), file);
+      for (int j = 0; j < 3; j++)
+      {
+        CStdString genre;
+        genre.Format("Genre %d", (i + j * 7) % 20);
+        AddGenreLink(AddGenre(genre), idFile);
+      }
+      for (int j = 0; j < 5; j++)
+      {
+        CStdString actor;
+        actor.Format("Actor %d", (i * 13 + j) % 400);
+        AddActorLink(AddActor(actor), idFile, "Role", j);
+      }
+    }
+    m_db.commit_transaction();
+    return m_statements;
+  }
+
+protected:
+  virtual int AddPath(const CStdString &path) = 0;
+  virtual int AddFile(int idPath, const CStdString &file) = 0;
+  virtual int AddGenre(const CStdString &genre) = 0;
+  virtual int AddActor(const CStdString &actor) = 0;
+  virtual void AddGenreLink(int idGenre, int idMovie) = 0;
+  virtual void AddActorLink(int idActor, int idMovie, const CStdString &role, int order) = 0;
+
+  SqliteDatabase &m_db;
+  int m_statements;
+};
+
+/* formats every query, like CVideoDatabase did */
+class CTestScanFormatted : public CTestScan
+{
+public:
+  CTestScanFormatted(SqliteDatabase &db) : CTestScan(db), m_ds(db.CreateDataset()) {}
+
+protected:
+  int Lookup(const std::string &select, const std::string &insert)
+  {
+    m_statements++;
+    m_ds->query(select.c_str());
+    if (m_ds->num_rows() > 0)
+    {
+      int id = m_ds->fv(0).get_asInt();
+      m_ds->close();
+      return id;
+    }
+    m_ds->close();
+    m_statements++;
+    m_ds->exec(insert);
+    return (int)m_ds->lastinsertid();
+  }
+
+  void Link(const std::string &select, const std::string &insert)
+  {
+    m_statements++;
+    m_ds->query(select.c_str());
+    if (m_ds->num_rows() == 0)
+    {
+      m_statements++;
+      m_ds->exec(insert);
+    }
+    m_ds->close();
+  }
+
+  virtual int AddPath(const CStdString &path)
+  {
+    return Lookup(m_db.prepare("select idPath from path where strPath='%s'", path.c_str()),
+                  m_db.prepare("insert into path (idPath, strPath) values (NULL,'%s')", path.c_str()));
+  }
+  virtual int AddFile(int idPath, const CStdString &file)
+  {
+    return Lookup(m_db.prepare("select idFile from files where strFileName='%s' and idPath=%i", file.c_str(), idPath),
+                  m_db.prepare("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, file.c_str()));
+  }
+  virtual int AddGenre(const CStdString &genre)
+  {
+    return Lookup(m_db.prepare("select idGenre from genre where strGenre like '%s'", genre.c_str()),
+                  m_db.prepare("insert into genre (idGenre, strGenre) values(NULL, '%s')", genre.c_str()));
+  }
+  virtual int AddActor(const CStdString &actor)
+  {
+    return Lookup(m_db.prepare("select idActor from actors where strActor like '%s'", actor.c_str()),
+                  m_db.prepare("insert into actors (idActor, strActor) values(NULL, '%s')", actor.c_str()));
+  }
+  virtual void AddGenreLink(int idGenre, int idMovie)
+  {
+    Link(m_db.prepare("select * from genrelinkmovie where idGenre=%i and idMovie=%i", idGenre, idMovie),
+         m_db.prepare("insert into genrelinkmovie (idGenre,idMovie) values(%i,%i)", idGenre, idMovie));
+  }
+  virtual void AddActorLink(int idActor, int idMovie, const CStdString &role, int order)
+  {
+    Link(m_db.prepare("select * from actorlinkmovie where idActor=%i and idMovie=%i", idActor, idMovie),
+         m_db.prepare("insert into actorlinkmovie (idActor, idMovie, strRole, iOrder) values(%i,%i,'%s',%i)", idActor, idMovie, role.c_str(), order));
+  }
+
+  std::auto_ptr<Dataset> m_ds;
+};
+
+/* binds the values to cached statements */
+class CTestScanCompiled : public CTestScan
+{
+public:
+  CTestScanCompiled(SqliteDatabase &db) : CTestScan(db) {}
+
+protected:
+  int Lookup(const char *select, const char *insert, const sql_record &values)
+  {
+    m_statements++;
+    Statement *stmt = m_db.getStatement(select);
+    for (unsigned int i = 0; i < values.size(); i++)
+      stmt->bind(i + 1, values[i]);
+    if (stmt->step())
+    {
+      int id = stmt->fv(0).get_asInt();
+      stmt->reset();
+      return id;
+    }
+    m_statements++;
+    stmt = m_db.getStatement(insert);
+    for (unsigned int i = 0; i < values.size(); i++)
+      stmt->bind(i + 1, values[i]);
+    stmt->exec();
+    return (int)stmt->lastinsertid();
+  }
+
+  virtual int AddPath(const CStdString &path)
+  {
+    return Lookup("select idPath from path where strPath=?",
+                  "insert into path (idPath, strPath) values (NULL, ?)", sql_record(1, path.c_str()));
+  }
+  virtual int AddFile(int idPath, const CStdString &file)
+  {
+    sql_record values;
+    values.push_back(file.c_str());
+    values.push_back(idPath);
+    return Lookup("select idFile from files where strFileName=? and idPath=?",
+                  "insert into files (idFile, strFileName, idPath) values(NULL, ?, ?)", values);
+  }
+  virtual int AddGenre(const CStdString &genre)
+  {
+    return Lookup("select idGenre from genre where strGenre like ?",
+                  "insert into genre (idGenre, strGenre) values(NULL, ?)", sql_record(1, genre.c_str()));
+  }
+  virtual int AddActor(const CStdString &actor)
+  {
+    return Lookup("select idActor from actors where strActor like ?",
+                  "insert into actors (idActor, strActor) values(NULL, ?)", sql_record(1, actor.c_str()));
+  }
+  virtual void AddGenreLink(int idGenre, int idMovie)
+  {
+    m_statements++;
+    Statement *stmt = m_db.getStatement("select * from genrelinkmovie where idGenre=? and idMovie=?");
+    stmt->bind(1, idGenre);
+    stmt->bind(2, idMovie);
+    if (!stmt->step())
+    {
+      m_statements++;
+      stmt = m_db.getStatement("insert into genrelinkmovie (idGenre,idMovie) values(?,?)");
+      stmt->bind(1, idGenre);
+      stmt->bind(2, idMovie);
+      stmt->exec();
+    }
+    else
+      stmt->reset();
+  }
+  virtual void AddActorLink(int idActor, int idMovie, const CStdString &role, int order)
+  {
+    m_statements++;
+    Statement *stmt = m_db.getStatement("select * from actorlinkmovie where idActor=? and idMovie=?");
+    stmt->bind(1, idActor);
+    stmt->bind(2, idMovie);
+    if (!stmt->step())
+    {
+      m_statements++;
+      stmt = m_db.getStatement("insert into actorlinkmovie (idActor, idMovie, strRole, iOrder) values(?,?,?,?)");
+      stmt->bind(1, idActor);
+      stmt->bind(2, idMovie);
+      stmt->bind(3, role);
+      stmt->bind(4, order);
+      stmt->exec();
+    }
+    else
+      stmt->reset();
+  }
+};
+
+TEST_F(TestDatabase, ScanBenchmark)
+{
+  const int movies = 1000;
+  const char *tables[] = { "path", "files", "genre", "actors", "genrelinkmovie", "actorlinkmovie" };
+  const int numTables = sizeof(tables) / sizeof(tables[0]);
+  int counts[numTables];
+  unsigned int elapsed[2];
+  int statements[2];
+
+  for (int i = 0; i < 2; i++)
+  {
+    XFILE::CFile::Delete(Path());
+    ASSERT_EQ(DB_CONNECTION_OK, m_db.connect(true));
+    CreateLibrary();
+
+    std::auto_ptr<CTestScan> scan;
+    if (i == 0)
+      scan.reset(new CTestScanFormatted(m_db));
+    else
+      scan.reset(new CTestScanCompiled(m_db));
+
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    statements[i] = scan->Scan(movies);
+    elapsed[i] = std::max(XbmcThreads::SystemClockMillis() - start, 1U);
+    std::cout << (i == 0 ? "formatted" : "compiled") << ": " << statements[i] << " statements in "
+              << elapsed[i] << " ms, " << (int64_t)statements[i] * 1000 / elapsed[i] << " statements/s" << std::endl;
+
+    // both scans have to add the same library
+    for (int j = 0; j < numTables; j++)
+    {
+      if (i == 0)
+        counts[j] = Count(tables[j]);
+      else
+        EXPECT_EQ(counts[j], Count(tables[j])) << tables[j];
+    }
+    m_db.disconnect();
+  }
+  EXPECT_EQ(movies, counts[1]);
+  EXPECT_EQ(statements[0], statements[1]);
+}
@@ -0,0 +1,550 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "BlockCache.h"
+#include "Directory.h"
+#include "File.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/md5.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace XFILE;
+
+#define BLOCK_CACHE_MAGIC   0x49434258 // "XBCI"
+#define BLOCK_CACHE_VERSION 1
+#define BLOCK_CACHE_HEADER  32
+
+struct SBlockCacheHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t blockSize;
+  uint32_t slots;
+  uint32_t reserved[4];
+};
+
+bool CBlockCache::SKey::operator<(const SKey& key) const
+{
+  return memcmp(digest, key.digest, sizeof(digest)) < 0;
+}
+
+bool CBlockCache::SKey::operator==(const SKey& key) const
+{
+  return memcmp(digest, key.digest, sizeof(digest)) == 0;
+}
+
+CBlockCache::CBlockCache()
+{
+  m_maxBytes = 0;
+  m_data     = NULL;
+  m_index    = NULL;
+  m_stamp    = 0;
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CBlockCache::~CBlockCache()
+{
+  Close();
+}
+
+CBlockCache::SKey CBlockCache::GetKey(const CStdString& url, int64_t size, int64_t mtime)
+{
+  CStdString id;
+  id.Format("%s|%"PRId64"|%"PRId64, url.c_str(), size, mtime);
+
+  SKey key;
+  XBMC::XBMC_MD5 md5;
+  md5.append(id);
+  md5.getDigest(key.digest);
+  return key;
+}
+
+bool CBlockCache::IsOpen() const
+{
+  CSingleLock lock(m_section);
+  return m_data != NULL;
+}
+
+bool CBlockCache::Open(const CStdString& path, uint64_t maxBytes)
+{
+  CSingleLock lock(m_section);
+
+  if (m_data && m_path == path && m_maxBytes == maxBytes)
+    return true;
+
+  Close();
+
+  unsigned int slots = (unsigned int)(maxBytes / BLOCK_SIZE);
+  if (slots < 4)
+  {
+    CLog::Log(LOGERROR, "CBlockCache::Open - cache size of %"PRIu64" bytes is too small", maxBytes);
+    return false;
+  }
+
+  if (!CDirectory::Exists(path) && !CDirectory::Create(path))
+  {
+    CLog::Log(LOGERROR, "CBlockCache::Open - unable to create %s", path.c_str());
+    return false;
+  }
+
+  m_path     = path;
+  m_maxBytes = maxBytes;
+  m_data     = new CFile();
+  m_index    = new CFile();
+  m_slots.resize(slots);
+
+  if (!Load() && !Reset())
+  {
+    CLog::Log(LOGERROR, "CBlockCache::Open - unable to open the cache in %s", path.c_str());
+    Close();
+    return false;
+  }
+
+  CLog::Log(LOGDEBUG, "CBlockCache::Open - %u of %u blocks cached in %s", (unsigned int)m_lookup.size(), slots, path.c_str());
+  return true;
+}
+
+void CBlockCache::Close()
+{
+  CSingleLock lock(m_section);
+
+  if (m_index && m_data)
+    Flush();
+
+  delete m_data;
+  delete m_index;
+  m_data  = NULL;
+  m_index = NULL;
+
+  m_slots.clear();
+  m_lookup.clear();
+  m_lru.clear();
+  m_lruPos.clear();
+  m_free.clear();
+  m_dirty.clear();
+  m_stamp = 0;
+}
+
+bool CBlockCache::Load()
+{
+  CStdString indexPath = URIUtils::AddFileToFolder(m_path, "index.dat");
+  CStdString dataPath  = URIUtils::AddFileToFolder(m_path, "blocks.dat");
+  if (!CFile::Exists(indexPath) || !CFile::Exists(dataPath))
+    return false;
+
+  if (!m_index->OpenForWrite(indexPath, false) || !m_data->OpenForWrite(dataPath, false))
+    return false;
+
+  /* a cache of another size or version is started over */
+  SBlockCacheHeader header;
+  if (m_index->Read(&header, sizeof(header)) != sizeof(header)
+  ||  header.magic     != BLOCK_CACHE_MAGIC
+  ||  header.version   != BLOCK_CACHE_VERSION
+  ||  header.blockSize != BLOCK_SIZE
+  ||  header.slots     != m_slots.size())
+  {
+    CLog::Log(LOGDEBUG, "CBlockCache::Load - index in %s doesn't match, starting over", m_path.c_str());
+    m_index->Close();
+    m_data->Close();
+    return false;
+  }
+
+  /* records past the end of the index, or torn by a crash, are free slots */
+  unsigned int size = m_slots.size() * sizeof(SRecord);
+  memset(&m_slots[0], 0, size);
+  m_index->Seek(BLOCK_CACHE_HEADER, SEEK_SET);
+  m_index->Read(&m_slots[0], size);
+
+  std::vector<std::pair<uint64_t, unsigned int> > used;
+  for (unsigned int slot = 0; slot < m_slots.size(); slot++)
+  {
+    SRecord& record = m_slots[slot];
+    if (!record.used || record.crc != RecordCrc(record) || record.size > BLOCK_SIZE)
+    {
+      memset(&record, 0, sizeof(record));
+      continue;
+    }
+
+    BlockId id(record.key, record.block);
+    if (m_lookup.find(id) != m_lookup.end())
+    {
+      memset(&record, 0, sizeof(record));
+      continue;
+    }
+
+    m_lookup[id] = slot;
+    used.push_back(std::make_pair(record.stamp, slot));
+    m_stamp = std::max(m_stamp, record.stamp);
+  }
+
+  m_lruPos.resize(m_slots.size(), m_lru.end());
+  std::sort(used.begin(), used.end());
+  for (std::vector<std::pair<uint64_t, unsigned int> >::iterator it = used.begin(); it != used.end(); ++it)
+  {
+    m_lru.push_front(it->second);
+    m_lruPos[it->second] = m_lru.begin();
+  }
+
+  for (unsigned int slot = m_slots.size(); slot > 0; slot--)
+  {
+    if (!m_slots[slot - 1].used)
+      m_free.push_back(slot - 1);
+  }
+  return true;
+}
+
+bool CBlockCache::Reset()
+{
+  CStdString indexPath = URIUtils::AddFileToFolder(m_path, "index.dat");
+  CStdString dataPath  = URIUtils::AddFileToFolder(m_path, "blocks.dat");
+  if (!m_index->OpenForWrite(indexPath, true) || !m_data->OpenForWrite(dataPath, true))
+    return false;
+
+  SBlockCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = BLOCK_CACHE_MAGIC;
+  header.version   = BLOCK_CACHE_VERSION;
+  header.blockSize = BLOCK_SIZE;
+  header.slots     = m_slots.size();
+  if (m_index->Write(&header, sizeof(header)) != sizeof(header))
+    return false;
+
+  memset(&m_slots[0], 0, m_slots.size() * sizeof(SRecord));
+  m_lookup.clear();
+  m_lru.clear();
+  m_lruPos.assign(m_slots.size(), m_lru.end());
+  m_free.clear();
+  for (unsigned int slot = m_slots.size(); slot > 0; slot--)
+    m_free.push_back(slot - 1);
+  m_dirty.clear();
+  m_stamp = 0;
+  return true;
+}
+
+uint32_t CBlockCache::RecordCrc(const SRecord& record)
+{
+  Crc32 crc;
+  crc.Compute((const char*)&record, offsetof(SRecord, crc));
+  return crc;
+}
+
+bool CBlockCache::WriteRecord(unsigned int slot)
+{
+  SRecord& record = m_slots[slot];
+  record.crc = RecordCrc(record);
+
+  int64_t offset = BLOCK_CACHE_HEADER + (int64_t)slot * sizeof(SRecord);
+  return m_index->Seek(offset, SEEK_SET) == offset
+      && m_index->Write(&record, sizeof(record)) == sizeof(record);
+}
+
+void CBlockCache::Touch(unsigned int slot)
+{
+  m_slots[slot].stamp = ++m_stamp;
+  m_lru.splice(m_lru.begin(), m_lru, m_lruPos[slot]);
+  m_dirty.insert(slot);
+}
+
+void CBlockCache::Drop(unsigned int slot)
+{
+  SRecord& record = m_slots[slot];
+  m_lookup.erase(BlockId(record.key, record.block));
+  m_lru.erase(m_lruPos[slot]);
+  m_lruPos[slot] = m_lru.end();
+  m_dirty.erase(slot);
+
+  memset(&record, 0, sizeof(record));
+  m_free.push_back(slot);
+}
+
+bool CBlockCache::Contains(const SKey& key, int64_t block) const
+{
+  CSingleLock lock(m_section);
+  return m_lookup.find(BlockId(key, block)) != m_lookup.end();
+}
+
+int CBlockCache::Read(const SKey& key, int64_t block, char* buffer)
+{
+  CSingleLock lock(m_section);
+  if (!m_data)
+    return -1;
+
+  std::map<BlockId, unsigned int>::iterator it = m_lookup.find(BlockId(key, block));
+  if (it == m_lookup.end())
+  {
+    m_stats.misses++;
+    return -1;
+  }
+
+  unsigned int slot   = it->second;
+  SRecord&     record = m_slots[slot];
+  int64_t      offset = (int64_t)slot * BLOCK_SIZE;
+
+  Crc32 crc;
+  if (m_data->Seek(offset, SEEK_SET) == offset
+  &&  m_data->Read(buffer, record.size) == record.size)
+    crc.Compute(buffer, record.size);
+
+  /* the block didn't make it to disk before the index did */
+  if ((uint32_t)crc != record.dataCrc)
+  {
+    CLog::Log(LOGWARNING, "CBlockCache::Read - block %"PRId64" in slot %u is damaged, dropping it", block, slot);
+    Drop(slot);
+    WriteRecord(slot);
+    m_stats.misses++;
+    return -1;
+  }
+
+  Touch(slot);
+  m_stats.hits++;
+  m_stats.bytesSaved += record.size;
+  return record.size;
+}
+
+bool CBlockCache::Write(const SKey& key, int64_t block, const char* buffer, unsigned int size)
+{
+  CSingleLock lock(m_section);
+  if (!m_data || size > BLOCK_SIZE)
+    return false;
+
+  BlockId id(key, block);
+  std::map<BlockId, unsigned int>::iterator it = m_lookup.find(id);
+  if (it != m_lookup.end())
+  {
+    Touch(it->second);
+    return true;
+  }
+
+  if (m_free.empty())
+  {
+    Drop(m_lru.back());
+    m_stats.evictions++;
+  }
+
+  unsigned int slot = m_free.back();
+  m_free.pop_back();
+
+  /* the data goes first, a record pointing at a half written block fails
+   * its data checksum when it is read */
+  int64_t offset = (int64_t)slot * BLOCK_SIZE;
+  if (m_data->Seek(offset, SEEK_SET) != offset
+  ||  m_data->Write(buffer, size) != (int)size)
+  {
+    CLog::Log(LOGERROR, "CBlockCache::Write - unable to write block %"PRId64" to slot %u", block, slot);
+    m_free.push_back(slot);
+    return false;
+  }
+
+  Crc32 crc;
+  crc.Compute(buffer, size);
+
+  SRecord& record = m_slots[slot];
+  memset(&record, 0, sizeof(record));
+  record.key     = key;
+  record.block   = block;
+  record.size    = size;
+  record.dataCrc = crc;
+  record.used    = 1;
+
+  m_lookup[id] = slot;
+  m_lru.push_front(slot);
+  m_lruPos[slot] = m_lru.begin();
+  record.stamp = ++m_stamp;
+
+  m_dirty.erase(slot);
+  if (!WriteRecord(slot))
+  {
+    Drop(slot);
+    return false;
+  }
+
+  m_stats.bytesStored += size;
+  return true;
+}
+
+void CBlockCache::Flush()
+{
+  CSingleLock lock(m_section);
+  if (!m_index)
+    return;
+
+  for (std::set<unsigned int>::iterator it = m_dirty.begin(); it != m_dirty.end(); ++it)
+    WriteRecord(*it);
+  m_dirty.clear();
+  m_index->Flush();
+  m_data->Flush();
+}
+
+void CBlockCache::GetStats(SBlockCacheStats& stats) const
+{
+  CSingleLock lock(m_section);
+  stats          = m_stats;
+  stats.blocks   = m_lookup.size();
+  stats.capacity = m_slots.size();
+}
+
+void CBlockCache::ResetStats()
+{
+  CSingleLock lock(m_section);
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CBlockCacheReader::CBlockCacheReader(CBlockCache& cache) : m_cache(cache)
+{
+  memset(&m_key, 0, sizeof(m_key));
+  m_source         = NULL;
+  m_caching        = false;
+  m_length         = 0;
+  m_position       = 0;
+  m_sourcePosition = 0;
+  m_buffer         = NULL;
+  m_block          = -1;
+  m_fill           = 0;
+  m_complete       = false;
+}
+
+CBlockCacheReader::~CBlockCacheReader()
+{
+  Close();
+}
+
+void CBlockCacheReader::Open(IFile* source, const CBlockCache::SKey* key, int64_t length)
+{
+  Close();
+
+  m_source  = source;
+  m_caching = key && length > 0 && m_cache.IsOpen();
+  if (m_caching)
+  {
+    m_key            = *key;
+    m_length         = length;
+    m_sourcePosition = source->GetPosition();
+    m_buffer         = new char[CBlockCache::BLOCK_SIZE];
+  }
+}
+
+void CBlockCacheReader::Close()
+{
+  if (m_caching)
+    m_cache.Flush();
+
+  delete[] m_buffer;
+  m_buffer         = NULL;
+  m_source         = NULL;
+  m_caching        = false;
+  m_position       = 0;
+  m_sourcePosition = 0;
+  m_block          = -1;
+  m_fill           = 0;
+  m_complete       = false;
+}
+
+int64_t CBlockCacheReader::BlockLength(int64_t block) const
+{
+  return std::min((int64_t)CBlockCache::BLOCK_SIZE, m_length - block * CBlockCache::BLOCK_SIZE);
+}
+
+int64_t CBlockCacheReader::Seek(int64_t position)
+{
+  if (!m_caching)
+    return m_source->Seek(position, SEEK_SET);
+
+  if (position < 0 || position > m_length)
+    return -1;
+
+  /* move the source along unless the data is cached, so a failing seek
+   * shows up here and not on the next read */
+  int64_t block = position / CBlockCache::BLOCK_SIZE;
+  if (block != m_block && position < m_length && !m_cache.Contains(m_key, block))
+  {
+    int64_t start = block * CBlockCache::BLOCK_SIZE;
+    if (m_sourcePosition != start)
+    {
+      if (m_source->Seek(start, SEEK_SET) != start)
+        return -1;
+      m_sourcePosition = start;
+    }
+  }
+
+  m_position = position;
+  return position;
+}
+
+int CBlockCacheReader::Read(char* buffer, unsigned int size)
+{
+  if (!m_caching)
+    return (int)m_source->Read(buffer, size);
+
+  if (m_position >= m_length)
+    return 0;
+
+  int64_t      block  = m_position / CBlockCache::BLOCK_SIZE;
+  unsigned int offset = (unsigned int)(m_position % CBlockCache::BLOCK_SIZE);
+  unsigned int length = (unsigned int)BlockLength(block);
+
+  if (block != m_block)
+  {
+    m_block    = block;
+    m_fill     = 0;
+    m_complete = false;
+
+    int cached = m_cache.Read(m_key, block, m_buffer);
+    if (cached == (int)length)
+    {
+      m_fill     = length;
+      m_complete = true;
+    }
+  }
+
+  /* fill the block from its start, so it can be stored once it is complete */
+  while (!m_complete && m_fill <= offset)
+  {
+    int64_t start = block * CBlockCache::BLOCK_SIZE + m_fill;
+    if (m_sourcePosition != start)
+    {
+      if (m_source->Seek(start, SEEK_SET) != start)
+        return -1;
+      m_sourcePosition = start;
+    }
+
+    unsigned int want = std::min(length - m_fill, std::max(size, offset + 1 - m_fill));
+    int read = (int)m_source->Read(m_buffer + m_fill, want);
+    if (read <= 0)
+      return read;
+
+    m_fill           += read;
+    m_sourcePosition += read;
+    if (m_fill == length)
+    {
+      m_complete = true;
+      m_cache.Write(m_key, block, m_buffer, length);
+    }
+  }
+
+  unsigned int count = std::min(size, m_fill - offset);
+  memcpy(buffer, m_buffer + offset, count);
+  m_position += count;
+  return count;
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "IFile.h"
+#include "threads/CriticalSection.h"
+#include "utils/StdString.h"
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace XFILE
+{
+  class CFile;
+
+  struct SBlockCacheStats
+  {
+    uint64_t     hits;        // blocks read from the cache
+    uint64_t     misses;      // blocks that had to come from the source
+    uint64_t     bytesSaved;  // bytes read from the cache instead of the source
+    uint64_t     bytesStored;
+    uint64_t     evictions;
+    unsigned int blocks;      // blocks in the cache
+    unsigned int capacity;    // blocks the cache can hold
+
+    double HitRate() const { return hits + misses ? (double)hits / (hits + misses) : 0.0; }
+  };
+
+  /**
+   * A size bounded cache of file blocks on disk that outlives the files it
+   * caches, so opening a network file again doesn't fetch it again. Blocks
+   * are keyed by a digest of the url, size and modification time of their
+   * file, a changed file gets a new key and its old blocks age out. The
+   * least recently used block is evicted when the cache is full.
+   *
+   * The blocks live in fixed slots of one data file, the index holds a
+   * record per slot with a checksum of itself and of its data. Records and
+   * blocks that fail their checksum after a crash are dropped when they are
+   * loaded or read, so the cache never returns data it didn't store.
+   */
+  class CBlockCache
+  {
+  public:
+    enum { BLOCK_SIZE = 256 * 1024 };
+
+    struct SKey
+    {
+      unsigned char digest[16];
+      bool operator<(const SKey& key) const;
+      bool operator==(const SKey& key) const;
+    };
+
+    CBlockCache();
+    ~CBlockCache();
+
+    /* opens the cache in the given folder, creating or resetting it as needed.
+     * opening it again with the same arguments is a no-op */
+    bool Open(const CStdString& path, uint64_t maxBytes);
+    void Close();
+    bool IsOpen() const;
+
+    static SKey GetKey(const CStdString& url, int64_t size, int64_t mtime);
+
+    /* reads a block into buffer (BLOCK_SIZE bytes), returns its size or -1 if it isn't cached */
+    int  Read(const SKey& key, int64_t block, char* buffer);
+    bool Write(const SKey& key, int64_t block, const char* buffer, unsigned int size);
+    bool Contains(const SKey& key, int64_t block) const;
+
+    /* stores the use order of blocks read since the last call */
+    void Flush();
+
+    void GetStats(SBlockCacheStats& stats) const;
+    void ResetStats();
+
+  private:
+    struct SRecord
+    {
+      SKey     key;
+      int64_t  block;
+      uint32_t size;
+      uint32_t dataCrc;
+      uint64_t stamp;
+      uint32_t used;
+      uint32_t crc;
+    };
+
+    typedef std::pair<SKey, int64_t> BlockId;
+
+    bool Load();
+    bool Reset();
+    void Touch(unsigned int slot);
+    void Drop(unsigned int slot);
+    bool WriteRecord(unsigned int slot);
+
+    static uint32_t RecordCrc(const SRecord& record);
+
+    mutable CCriticalSection m_section;
+
+    CStdString   m_path;
+    uint64_t     m_maxBytes;
+    CFile*       m_data;
+    CFile*       m_index;
+
+    std::vector<SRecord>                          m_slots;
+    std::map<BlockId, unsigned int>               m_lookup;
+    std::list<unsigned int>                       m_lru;    // most recently used first
+    std::vector<std::list<unsigned int>::iterator> m_lruPos;
+    std::vector<unsigned int>                     m_free;
+    std::set<unsigned int>                        m_dirty;  // records with a newer stamp than on disk
+    uint64_t                                      m_stamp;
+
+    SBlockCacheStats m_stats;
+  };
+
+  /**
+   * Reads a source file through a CBlockCache. Blocks that are cached are
+   * read from disk, the others are read from the source a chunk at a time
+   * and stored once complete. Without a key all calls go to the source.
+   */
+  class CBlockCacheReader
+  {
+  public:
+    CBlockCacheReader(CBlockCache& cache);
+    ~CBlockCacheReader();
+
+    void    Open(IFile* source, const CBlockCache::SKey* key, int64_t length);
+    void    Close();
+    bool    IsCaching() const { return m_caching; }
+
+    int     Read(char* buffer, unsigned int size);
+    int64_t Seek(int64_t position);
+
+  private:
+    int64_t BlockLength(int64_t block) const;
+
+    CBlockCache&      m_cache;
+    CBlockCache::SKey m_key;
+    IFile*            m_source;
+    bool              m_caching;
+    int64_t           m_length;
+    int64_t           m_position;
+    int64_t           m_sourcePosition;
+    char*             m_buffer;
+    int64_t           m_block;    // block held in m_buffer
+    unsigned int      m_fill;     // bytes of it in m_buffer
+    bool              m_complete;
+  };
+}
+
+extern XFILE::CBlockCache g_blockCache;
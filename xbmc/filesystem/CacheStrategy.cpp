@@ -57,6 +57,10 @@ void CCacheStrategy::ClearEndOfInput()
   m_bEndOfInput = false;
 }
 
+void CCacheStrategy::SetReadAhead(size_t bytes)
+{
+}
+
 CSimpleFileCache::CSimpleFileCache()
   : m_hCacheFileRead(NULL)
   , m_hCacheFileWrite(NULL)
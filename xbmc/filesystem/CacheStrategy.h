@@ -57,6 +57,10 @@ public:
   virtual bool IsEndOfInput();
   virtual void ClearEndOfInput();
 
+  /* hint of how many bytes the reader wants cached forward, caches with a
+   * fixed size can give the rest to data already read. 0 clears the hint */
+  virtual void SetReadAhead(size_t bytes);
+
   CEvent m_space;
 protected:
   bool  m_bEndOfInput;
@@ -35,6 +35,7 @@ CCircularCache::CCircularCache(size_t front, size_t back)
  , m_buf(NULL)
  , m_size(front + back)
  , m_size_back(back)
+ , m_size_back_default(back)
 #ifdef _WIN32
  , m_handle(INVALID_HANDLE_VALUE)
 #endif
@@ -219,3 +220,22 @@ void CCircularCache::Reset(int64_t pos)
   m_cur = pos;
 }
 
+/**
+ * Moves the split between front and back buffer. What the
+ * front buffer doesn't need for the read ahead is kept as
+ * back buffer, so seeks backwards can be served from memory.
+ * At least 1/16 of the buffer stays back buffer, and at most
+ * half of it, so a short read ahead still leaves room to fill.
+ */
+void CCircularCache::SetReadAhead(size_t bytes)
+{
+  CSingleLock lock(m_sync);
+  if(bytes == 0)
+  {
+    m_size_back = m_size_back_default;
+    return;
+  }
+
+  size_t back = bytes < m_size ? m_size - bytes : 0;
+  m_size_back = std::max(m_size / 16, std::min(m_size / 2, back));
+}
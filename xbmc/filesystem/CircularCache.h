@@ -42,6 +42,7 @@ public:
 
     virtual int64_t Seek(int64_t pos) ;
     virtual void Reset(int64_t pos) ;
+    virtual void SetReadAhead(size_t bytes) ;
 
 protected:
     uint64_t          m_beg;       /**< index in file (not buffer) of beginning of valid data */
@@ -50,6 +51,7 @@ protected:
     uint8_t          *m_buf;       /**< buffer holding data */
     size_t            m_size;      /**< size of data buffer used (m_buf) */
     size_t            m_size_back; /**< guaranteed size of back buffer (actual size can be smaller, or larger if front buffer doesn't need it) */
+    size_t            m_size_back_default; /**< back buffer size when no read ahead is set */
     CCriticalSection  m_sync;
     CEvent            m_written;
 #ifdef _WIN32
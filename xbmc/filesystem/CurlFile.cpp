@@ -50,6 +50,8 @@ using namespace XCURL;
 #define XMIN(a,b) ((a)<(b)?(a):(b))
 #define FITS_INT(a) (((a) <= INT_MAX) && ((a) >= INT_MIN))
 
+#define RANGE_SEGMENT_SIZE (1024 * 1024)
+
 #define dllselect select
 
 // curl calls this routine to debug
@@ -297,6 +299,252 @@ void CCurlFile::CReadState::Disconnect()
 }
 
 
+CCurlFile::CRangeState::CRangeState(CCurlFile& file, unsigned int connections, unsigned int segmentSize)
+  : m_file(file)
+{
+  m_filePos     = 0;
+  m_fileSize    = 0;
+  m_failed      = false;
+  m_segmentSize = segmentSize;
+  m_nextStart   = 0;
+
+  CURL url(m_file.m_url);
+  for (unsigned int i = 0; i < connections; i++)
+  {
+    SSegment segment;
+    segment.state = new CReadState();
+    segment.start = segment.end = segment.fetched = 0;
+    segment.retries = 0;
+    segment.checked = false;
+
+    g_curlInterface.easy_aquire(url.GetProtocol(), url.GetHostName(), &segment.state->m_easyHandle, &segment.state->m_multiHandle);
+    m_file.SetCommonOptions(segment.state);
+    /* share the header list of the main connection, rebuilding it would free it under that one */
+    if (m_file.m_curlHeaderList)
+      g_curlInterface.easy_setopt(segment.state->m_easyHandle, CURLOPT_HTTPHEADER, m_file.m_curlHeaderList);
+
+    // a segment always fits its buffer, as long as the server sticks to the range
+    segment.state->m_bufferSize = segmentSize;
+    segment.state->m_buffer.Create(segmentSize);
+    m_segments.push_back(segment);
+  }
+}
+
+CCurlFile::CRangeState::~CRangeState()
+{
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+    delete it->state;
+}
+
+void CCurlFile::CRangeState::Stop(SSegment& segment)
+{
+  CReadState* state = segment.state;
+  if (state->m_stillRunning)
+    g_curlInterface.multi_remove_handle(state->m_multiHandle, state->m_easyHandle);
+
+  state->m_stillRunning = 0;
+  state->m_buffer.Clear();
+  free(state->m_overflowBuffer);
+  state->m_overflowBuffer = NULL;
+  state->m_overflowSize = 0;
+}
+
+void CCurlFile::CRangeState::Connect(SSegment& segment, int64_t start, int64_t end)
+{
+  CReadState* state = segment.state;
+  if (state->m_stillRunning)
+    g_curlInterface.multi_remove_handle(state->m_multiHandle, state->m_easyHandle);
+
+  CStdString range;
+  range.Format("%"PRId64"-%"PRId64, start, end - 1);
+  g_curlInterface.easy_setopt(state->m_easyHandle, CURLOPT_RANGE, range.c_str());
+  g_curlInterface.multi_add_handle(state->m_multiHandle, state->m_easyHandle);
+
+  state->m_stillRunning = 1;
+  state->m_headerdone = false;
+}
+
+void CCurlFile::CRangeState::Start(int64_t pos)
+{
+  m_filePos   = pos;
+  m_nextStart = pos;
+
+  /* the first segment runs to the next segment boundary, the others are whole */
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+  {
+    Stop(*it);
+    it->start   = m_nextStart;
+    it->end     = std::min((m_nextStart / m_segmentSize + 1) * m_segmentSize, m_fileSize);
+    it->fetched = 0;
+    it->retries = 0;
+    it->checked = false;
+    if (it->start < it->end)
+      Connect(*it, it->start, it->end);
+    else
+      it->start = it->end = m_fileSize;
+    m_nextStart = it->end;
+  }
+}
+
+bool CCurlFile::CRangeState::Seek(int64_t pos)
+{
+  if (m_failed)
+    return false;
+
+  if (pos == m_filePos)
+    return true;
+
+  /* skip ahead in what the first segment has buffered already */
+  SSegment& front = m_segments.front();
+  CReadState* state = front.state;
+  if (pos > m_filePos && pos < front.end && FITS_INT(pos - m_filePos) && state->m_buffer.SkipBytes((int)(pos - m_filePos)))
+  {
+    m_filePos = pos;
+    return true;
+  }
+
+  Start(pos);
+  return true;
+}
+
+/* runs the transfers of all segments once, then waits for any of them */
+bool CCurlFile::CRangeState::Perform()
+{
+  fd_set fdread;
+  fd_set fdwrite;
+  fd_set fdexcep;
+  int    maxfd   = -1;
+  long   timeout = 200;
+
+  FD_ZERO(&fdread);
+  FD_ZERO(&fdwrite);
+  FD_ZERO(&fdexcep);
+
+  for (std::deque<SSegment>::iterator it = m_segments.begin(); it != m_segments.end(); ++it)
+  {
+    CReadState* state = it->state;
+    if (!state->m_stillRunning)
+      continue;
+
+    if (m_file.m_state->m_cancelled)
+      return false;
+
+    unsigned int before = state->m_buffer.getMaxReadSize() + state->m_overflowSize;
+    CURLMcode result = g_curlInterface.multi_perform(state->m_multiHandle, &state->m_stillRunning);
+    if (result != CURLM_OK && result != CURLM_CALL_MULTI_PERFORM)
+    {
+      CLog::Log(LOGERROR, "%s - curl multi perform failed with code %d", __FUNCTION__, result);
+      m_failed = true;
+      return false;
+    }
+    it->fetched += state->m_buffer.getMaxReadSize() + state->m_overflowSize - before;
+
+    /* a server that ignores the range sends the whole file, give up on those */
+    if (!it->checked && (it->fetched || !state->m_stillRunning))
+    {
+      long response = 0;
+      g_curlInterface.easy_getinfo(state->m_easyHandle, CURLINFO_RESPONSE_CODE, &response);
+      if (response != 206)
+      {
+        CLog::Log(LOGDEBUG, "%s - range request answered with %ld, stopping range requests", __FUNCTION__, response);
+        m_failed = true;
+        return false;
+      }
+      it->checked = true;
+    }
+
+    if (!state->m_stillRunning)
+    {
+      CURLcode code = CURLE_OK;
+      int      msgs;
+      CURLMsg* msg;
+      while ((msg = g_curlInterface.multi_info_read(state->m_multiHandle, &msgs)))
+      {
+        if (msg->msg == CURLMSG_DONE)
+          code = msg->data.result;
+      }
+      g_curlInterface.multi_remove_handle(state->m_multiHandle, state->m_easyHandle);
+
+      if (code == CURLE_OK && it->start + it->fetched == it->end)
+        continue;
+
+      /* pick up where the transfer broke off */
+      if (++it->retries > g_advancedSettings.m_curlretries || it->start + it->fetched > it->end)
+      {
+        CLog::Log(LOGWARNING, "%s - range %"PRId64"-%"PRId64" failed with code %d", __FUNCTION__, it->start, it->end, code);
+        m_failed = true;
+        return false;
+      }
+      CLog::Log(LOGDEBUG, "%s - range %"PRId64"-%"PRId64" reconnecting, (re)try %i", __FUNCTION__, it->start, it->end, it->retries);
+      Connect(*it, it->start + it->fetched, it->end);
+      continue;
+    }
+
+    int fd = -1;
+    g_curlInterface.multi_fdset(state->m_multiHandle, &fdread, &fdwrite, &fdexcep, &fd);
+    maxfd = std::max(maxfd, fd);
+
+    long wait = -1;
+    if (CURLM_OK == g_curlInterface.multi_timeout(state->m_multiHandle, &wait) && wait >= 0)
+      timeout = std::min(timeout, wait);
+  }
+
+  struct timeval t = { timeout / 1000, (timeout % 1000) * 1000 };
+  if (SOCKET_ERROR == dllselect(maxfd + 1, &fdread, &fdwrite, &fdexcep, &t))
+  {
+    CLog::Log(LOGERROR, "%s - curl failed with socket error", __FUNCTION__);
+    m_failed = true;
+    return false;
+  }
+  return true;
+}
+
+unsigned int CCurlFile::CRangeState::Read(void* lpBuf, int64_t uiBufSize)
+{
+  if (m_failed || m_filePos >= m_fileSize)
+    return 0;
+
+  SSegment&   front = m_segments.front();
+  CReadState* state = front.state;
+  while (!state->m_buffer.getMaxReadSize())
+  {
+    if (!state->m_stillRunning && front.start + front.fetched == front.end)
+    {
+      CLog::Log(LOGERROR, "%s - segment ended at %"PRId64" before position %"PRId64, __FUNCTION__, front.end, m_filePos);
+      m_failed = true;
+      return 0;
+    }
+    if (!Perform())
+      return 0;
+  }
+
+  unsigned int want = (unsigned int)XMIN(state->m_buffer.getMaxReadSize(), uiBufSize);
+  if (!state->m_buffer.ReadData((char *)lpBuf, want))
+    return 0;
+  m_filePos += want;
+
+  /* done with this segment, have it fetch the next free one */
+  if (m_filePos == front.end)
+  {
+    SSegment segment = front;
+    m_segments.pop_front();
+
+    Stop(segment);
+    segment.start   = m_nextStart;
+    segment.end     = std::min(m_nextStart + m_segmentSize, m_fileSize);
+    segment.fetched = 0;
+    segment.retries = 0;
+    segment.checked = false;
+    if (segment.start < segment.end)
+      Connect(segment, segment.start, segment.end);
+    else
+      segment.start = segment.end = m_fileSize;
+    m_nextStart = segment.end;
+    m_segments.push_back(segment);
+  }
+  return want;
+}
+
 CCurlFile::~CCurlFile()
 {
   if (m_opened)
@@ -326,6 +574,7 @@ CCurlFile::CCurlFile()
   m_password = "";
   m_httpauth = "";
   m_state = new CReadState();
+  m_range = NULL;
   m_skipshout = false;
 }
 
@@ -337,6 +586,8 @@ void CCurlFile::SetBufferSize(unsigned int size)
 
 void CCurlFile::Close()
 {
+  delete m_range;
+  m_range = NULL;
   m_state->Disconnect();
 
   m_url.Empty();
@@ -420,8 +671,8 @@ void CCurlFile::SetCommonOptions(CReadState* state)
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYPEER, 0);
   g_curlInterface.easy_setopt(h, CURLOPT_SSL_VERIFYHOST, 0);
 
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_URL, m_url.c_str());
-  g_curlInterface.easy_setopt(m_state->m_easyHandle, CURLOPT_TRANSFERTEXT, FALSE);
+  g_curlInterface.easy_setopt(h, CURLOPT_URL, m_url.c_str());
+  g_curlInterface.easy_setopt(h, CURLOPT_TRANSFERTEXT, FALSE);
 
   // setup POST data if it exists
   if (!m_postdata.IsEmpty())
@@ -891,9 +1142,69 @@ bool CCurlFile::Open(const CURL& url)
   if (CURLE_OK == g_curlInterface.easy_getinfo(m_state->m_easyHandle, CURLINFO_EFFECTIVE_URL,&efurl) && efurl)
     m_url = efurl;
 
+  if (m_seekable && g_advancedSettings.m_curlconnections > 1
+  &&  m_state->m_fileSize >= 4 * RANGE_SEGMENT_SIZE
+  &&  m_contentencoding.IsEmpty() && m_postdata.IsEmpty()
+  &&  m_state->m_httpheader.GetValue("Accept-Ranges").Equals("bytes")
+  &&  (url2.GetProtocol().Equals("http") || url2.GetProtocol().Equals("https")))
+    StartRanges();
+
   return true;
 }
 
+bool CCurlFile::StartRanges()
+{
+  CLog::Log(LOGDEBUG, "CCurlFile::StartRanges - reading %s over %d connections", m_url.c_str(), g_advancedSettings.m_curlconnections);
+
+  m_range = new CRangeState(*this, g_advancedSettings.m_curlconnections, RANGE_SEGMENT_SIZE);
+  m_range->m_fileSize = m_state->m_fileSize;
+  m_range->Start(m_state->m_filePos);
+
+  /* the initial connection is picked up again if the ranges fail */
+  int64_t size = m_state->m_fileSize;
+  m_state->Disconnect();
+  m_state->m_fileSize = size;
+  return true;
+}
+
+/* continue on the single connection at the position the ranges got to */
+void CCurlFile::StopRanges()
+{
+  m_state->m_filePos  = m_range->m_filePos;
+  m_state->m_fileSize = m_range->m_fileSize;
+  delete m_range;
+  m_range = NULL;
+}
+
+unsigned int CCurlFile::Read(void* lpBuf, int64_t uiBufSize)
+{
+  if (m_range)
+  {
+    unsigned int read = m_range->Read(lpBuf, uiBufSize);
+    if (read || !m_range->m_failed)
+      return read;
+
+    CLog::Log(LOGWARNING, "CCurlFile::Read - range requests failed at %"PRId64", falling back to a single connection", m_range->m_filePos);
+    StopRanges();
+    long response = m_state->Connect(m_bufferSize);
+    if (response < 0 || response >= 400)
+      return 0;
+  }
+  return m_state->Read(lpBuf, uiBufSize);
+}
+
+bool CCurlFile::ReadString(char *szLine, int iLineLength)
+{
+  if (m_range)
+  {
+    StopRanges();
+    long response = m_state->Connect(m_bufferSize);
+    if (response < 0 || response >= 400)
+      return false;
+  }
+  return m_state->ReadString(szLine, iLineLength);
+}
+
 bool CCurlFile::CReadState::ReadString(char *szLine, int iLineLength)
 {
   unsigned int want = (unsigned int)iLineLength;
@@ -965,7 +1276,7 @@ bool CCurlFile::Exists(const CURL& url)
 
 int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  int64_t nextPos = m_state->m_filePos;
+  int64_t nextPos = GetPosition();
   switch(iWhence)
   {
     case SEEK_SET:
@@ -987,6 +1298,13 @@ int64_t CCurlFile::Seek(int64_t iFilePosition, int iWhence)
   // We can't seek beyond EOF
   if (m_state->m_fileSize && nextPos > m_state->m_fileSize) return -1;
 
+  if (m_range)
+  {
+    if (m_range->Seek(nextPos))
+      return nextPos;
+    StopRanges();
+  }
+
   if(m_state->Seek(nextPos))
     return nextPos;
 
@@ -1042,6 +1360,7 @@ int64_t CCurlFile::GetLength()
 int64_t CCurlFile::GetPosition()
 {
   if (!m_opened) return 0;
+  if (m_range) return m_range->m_filePos;
   return m_state->m_filePos;
 }
 
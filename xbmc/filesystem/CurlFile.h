@@ -21,6 +21,7 @@
 
 #include "IFile.h"
 #include "utils/RingBuffer.h"
+#include <deque>
 #include <map>
 #include "utils/HttpHeader.h"
 
@@ -47,8 +48,8 @@ namespace XFILE
       virtual int64_t  GetLength();
       virtual int  Stat(const CURL& url, struct __stat64* buffer);
       virtual void Close();
-      virtual bool ReadString(char *szLine, int iLineLength)     { return m_state->ReadString(szLine, iLineLength); }
-      virtual unsigned int Read(void* lpBuf, int64_t uiBufSize)  { return m_state->Read(lpBuf, uiBufSize); }
+      virtual bool ReadString(char *szLine, int iLineLength);
+      virtual unsigned int Read(void* lpBuf, int64_t uiBufSize);
       virtual CStdString GetMimeType()                           { return m_state->m_httpheader.GetMimeType(); }
       virtual int IoControl(EIoControl request, void* param);
 
@@ -118,15 +119,57 @@ namespace XFILE
           void         Disconnect();
       };
 
+      /* reads ahead with byte range requests on several connections at once,
+       * each fetching one segment of the file. segments are handed out in
+       * order and move on to the next free segment once read. */
+      class CRangeState
+      {
+      public:
+          CRangeState(CCurlFile& file, unsigned int connections, unsigned int segmentSize);
+          ~CRangeState();
+
+          int64_t         m_filePos;
+          int64_t         m_fileSize;
+          bool            m_failed;           // the server didn't honour the ranges
+
+          void         Start(int64_t pos);
+          bool         Seek(int64_t pos);
+          unsigned int Read(void* lpBuf, int64_t uiBufSize);
+
+      private:
+          struct SSegment
+          {
+            CReadState* state;
+            int64_t     start;
+            int64_t     end;
+            int64_t     fetched;              // bytes received from start on
+            int         retries;
+            bool        checked;              // response code was verified
+          };
+
+          void         Connect(SSegment& segment, int64_t start, int64_t end);
+          void         Stop(SSegment& segment);
+          bool         Perform();
+
+          CCurlFile&           m_file;
+          std::deque<SSegment> m_segments;    // in file order, the first holds m_filePos
+          unsigned int         m_segmentSize;
+          int64_t              m_nextStart;   // where the next free segment starts
+      };
+      friend class CRangeState;
+
     protected:
       void ParseAndCorrectUrl(CURL &url);
       void SetCommonOptions(CReadState* state);
       void SetRequestHeaders(CReadState* state);
       void SetCorrectHeaders(CReadState* state);
       bool Service(const CStdString& strURL, const CStdString& strPostData, CStdString& strHTML);
+      bool StartRanges();
+      void StopRanges();
 
     private:
       CReadState*     m_state;
+      CRangeState*    m_range;            // set while reads are spread over several connections
       unsigned int    m_bufferSize;
 
       CStdString      m_url;
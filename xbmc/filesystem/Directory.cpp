@@ -39,6 +39,9 @@ using namespace XFILE;
 
 #define TIME_TO_BUSY_DIALOG 500
 
+static CCriticalSection g_statCountersSection;
+static CDirectory::SStatCounters g_statCounters = {};
+
 class CGetDirectory
 {
 private:
@@ -269,6 +272,66 @@ bool CDirectory::Exists(const CStdString& strPath)
   return false;
 }
 
+void CDirectory::StatFiles(const CStdString& strPath, const std::vector<CStdString>& files, std::vector<SFileStat>& results)
+{
+  results.assign(files.size(), SFileStat());
+  if (files.empty())
+    return;
+
+  unsigned int roundtrips = 0;
+  bool cached = false, listed = false;
+  try
+  {
+    if (g_directoryCache.StatFiles(strPath, files, results))
+      cached = true;
+    else
+    {
+      CStdString realPath = URIUtils::SubstitutePath(strPath);
+      auto_ptr<IDirectory> pDirectory(CDirectoryFactory::Create(realPath));
+      if (pDirectory.get())
+      {
+        CFileItemList items;
+        pDirectory->SetFlags(DIR_FLAG_NO_FILE_DIRS);
+        listed = pDirectory->StatFiles(realPath, files, results, items);
+        if (listed)
+        {
+          items.SetPath(strPath);
+          g_directoryCache.SetDirectory(strPath, items, pDirectory->GetCacheType(strPath));
+          roundtrips = 1;
+        }
+        else
+          roundtrips = files.size();
+      }
+    }
+  }
+  XBMCCOMMONS_HANDLE_UNCHECKED
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - Unhandled exception", __FUNCTION__);
+  }
+
+  CSingleLock lock(g_statCountersSection);
+  g_statCounters.batches++;
+  g_statCounters.files += files.size();
+  g_statCounters.roundtrips += roundtrips;
+  if (cached)
+    g_statCounters.cached++;
+  if (listed)
+    g_statCounters.listings++;
+}
+
+CDirectory::SStatCounters CDirectory::GetStatCounters()
+{
+  CSingleLock lock(g_statCountersSection);
+  return g_statCounters;
+}
+
+void CDirectory::ResetStatCounters()
+{
+  CSingleLock lock(g_statCountersSection);
+  memset(&g_statCounters, 0, sizeof(g_statCounters));
+}
+
 bool CDirectory::Remove(const CStdString& strPath)
 {
   try
@@ -58,6 +58,28 @@ public:
   static bool Exists(const CStdString& strPath);
   static bool Remove(const CStdString& strPath);
 
+  /*! \brief Check for existence of, and stat, a number of files in one directory
+   Answers from the directory cache when \e strPath is cached. Otherwise the filesystem may
+   list the directory once instead of checking each file, the listing is then cached so
+   CFile::Exists() on the same files, or other files in \e strPath, doesn't go to the filesystem.
+   \param strPath Directory holding the files
+   \param files   Full paths of the files, all directly inside \e strPath
+   \param results Retrieves one result per file, in the same order
+   \sa IDirectory::StatFiles */
+  static void StatFiles(const CStdString& strPath, const std::vector<CStdString>& files, std::vector<SFileStat>& results);
+
+  /*! \brief Counters of StatFiles, to see how many round trips batching saves */
+  struct SStatCounters
+  {
+    unsigned int batches;    ///< calls to StatFiles
+    unsigned int files;      ///< files checked
+    unsigned int cached;     ///< batches answered from the directory cache
+    unsigned int listings;   ///< batches answered from one listing of the directory
+    unsigned int roundtrips; ///< requests made to filesystems, saved are files - roundtrips
+  };
+  static SStatCounters GetStatCounters();
+  static void ResetStatCounters();
+
   /*! \brief Filter files that act like directories from the list, replacing them with their directory counterparts
    \param items The item list to filter
    \param mask  The mask to apply when filtering files */
@@ -19,41 +19,32 @@
  */
 
 #include "DirectoryCache.h"
+#include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "FileItem.h"
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
-#include "climits"
+
+#include <algorithm>
+#include <string.h>
 
 using namespace std;
 using namespace XFILE;
 
 CDirectoryCache::CDir::CDir(DIR_CACHE_TYPE cacheType)
+  : m_Items(new CFileItemList)
 {
   m_cacheType = cacheType;
-  m_lastAccess = 0;
-  m_Items = new CFileItemList;
+  m_bytes = 0;
+  m_expires.SetInfinite();
   m_Items->SetFastLookup(true);
 }
 
-CDirectoryCache::CDir::~CDir()
-{
-  delete m_Items;
-}
-
-void CDirectoryCache::CDir::SetLastAccess(unsigned int &accessCounter)
-{
-  m_lastAccess = accessCounter++;
-}
-
 CDirectoryCache::CDirectoryCache(void)
 {
-  m_accessCounter = 0;
-#ifdef _DEBUG
-  m_cacheHits = 0;
-  m_cacheMisses = 0;
-#endif
+  m_bytes = 0;
+  ResetStats();
 }
 
 CDirectoryCache::~CDirectoryCache(void)
@@ -62,27 +53,24 @@ CDirectoryCache::~CDirectoryCache(void)
 
 bool CDirectoryCache::GetDirectory(const CStdString& strPath, CFileItemList &items, bool retrieveAll)
 {
-  CSingleLock lock (m_cs);
+  boost::shared_ptr<CFileItemList> cached;
+  {
+    CSingleLock lock (m_cs);
 
-  CStdString storedPath = URIUtils::SubstitutePath(strPath);
-  URIUtils::RemoveSlashAtEnd(storedPath);
+    CStdString storedPath = URIUtils::SubstitutePath(strPath);
+    URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ciCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
-  {
-    CDir* dir = i->second;
-    if (dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
-       (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll))
-    {
-      items.Copy(*dir->m_Items);
-      dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-      m_cacheHits+=items.Size();
-#endif
-      return true;
-    }
+    CDir* dir = Find(storedPath);
+    if (!dir || !(dir->m_cacheType == XFILE::DIR_CACHE_ALWAYS ||
+                 (dir->m_cacheType == XFILE::DIR_CACHE_ONCE && retrieveAll)))
+      return false;
+    cached = dir->m_Items;
   }
-  return false;
+
+  // callers alter the items they get, so they get a copy. the cached listing
+  // isn't changed once stored, so it's copied without holding up the cache
+  items.Copy(*cached);
+  return true;
 }
 
 void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemList &items, DIR_CACHE_TYPE cacheType)
@@ -101,19 +89,29 @@ void CDirectoryCache::SetDirectory(const CStdString& strPath, const CFileItemLis
   // IDEALLY, any further processing on the item would actually create a new item
   // instead of altering it, but we can't really enforce that in an easy way, so
   // this is the best solution for now.
-  CSingleLock lock (m_cs);
+  CDir* dir = new CDir(cacheType);
+  dir->m_Items->Copy(items);
+  dir->m_bytes = EstimateSize(*dir->m_Items);
 
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  ClearDirectory(storedPath);
+  unsigned int ttl = GetTTL(storedPath);
+  if (ttl)
+    dir->m_expires.Set(ttl);
 
-  CheckIfFull();
+  CSingleLock lock (m_cs);
 
-  CDir* dir = new CDir(cacheType);
-  dir->m_Items->Copy(items);
-  dir->SetLastAccess(m_accessCounter);
-  m_cache.insert(pair<CStdString, CDir*>(storedPath, dir));
+  iCache i = m_cache.find(storedPath);
+  if (i != m_cache.end())
+    Delete(i);
+
+  CheckIfFull(dir->m_bytes);
+
+  i = m_cache.insert(make_pair(storedPath, dir)).first;
+  if (cacheType != DIR_CACHE_ALWAYS)
+    dir->m_lru = m_lru.insert(m_lru.begin(), i);
+  m_bytes += dir->m_bytes;
 }
 
 void CDirectoryCache::ClearFile(const CStdString& strFile)
@@ -125,32 +123,33 @@ void CDirectoryCache::ClearFile(const CStdString& strFile)
 
 void CDirectoryCache::ClearDirectory(const CStdString& strPath)
 {
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.find(storedPath);
-  if (i != m_cache.end())
+  {
+    CSingleLock lock (m_cs);
+    iCache i = m_cache.find(storedPath);
+    if (i == m_cache.end())
+      return;
     Delete(i);
+  }
+  NotifyInvalidated(storedPath);
 }
 
 void CDirectoryCache::ClearSubPaths(const CStdString& strPath)
 {
-  CSingleLock lock (m_cs);
-
   CStdString storedPath = URIUtils::SubstitutePath(strPath);
   URIUtils::RemoveSlashAtEnd(storedPath);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end())
   {
-    CStdString path = i->first;
-    if (strncmp(path.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
+    CSingleLock lock (m_cs);
+
+    // the sub paths sort right after the path itself
+    iCache i = m_cache.lower_bound(storedPath);
+    while (i != m_cache.end() && strncmp(i->first.c_str(), storedPath.c_str(), storedPath.GetLength()) == 0)
       Delete(i++);
-    else
-      i++;
   }
+  NotifyInvalidated(storedPath);
 }
 
 void CDirectoryCache::AddFile(const CStdString& strFile)
@@ -161,13 +160,23 @@ void CDirectoryCache::AddFile(const CStdString& strFile)
   URIUtils::GetDirectory(strFile, strPath);
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  CDir* dir = Find(strPath);
+  if (dir)
   {
-    CDir *dir = i->second;
+    // a lookup may be copying the listing, add to a new one sharing the items
+    if (!dir->m_Items.unique())
+    {
+      boost::shared_ptr<CFileItemList> items(new CFileItemList);
+      items->SetFastLookup(true);
+      items->Assign(*dir->m_Items);
+      dir->m_Items = items;
+    }
     CFileItemPtr item(new CFileItem(strFile, false));
     dir->m_Items->Add(item);
-    dir->SetLastAccess(m_accessCounter);
+
+    unsigned int bytes = EstimateSize(*dir->m_Items);
+    m_bytes = m_bytes - dir->m_bytes + bytes;
+    dir->m_bytes = bytes;
   }
 }
 
@@ -180,31 +189,72 @@ bool CDirectoryCache::FileExists(const CStdString& strFile, bool& bInCache)
   URIUtils::GetDirectory(strFile, strPath);
   URIUtils::RemoveSlashAtEnd(strPath);
 
-  ciCache i = m_cache.find(strPath);
-  if (i != m_cache.end())
+  CDir* dir = Find(strPath);
+  if (dir)
   {
     bInCache = true;
-    CDir *dir = i->second;
-    dir->SetLastAccess(m_accessCounter);
-#ifdef _DEBUG
-    m_cacheHits++;
-#endif
     return dir->m_Items->Contains(strFile);
   }
-#ifdef _DEBUG
-  m_cacheMisses++;
-#endif
   return false;
 }
 
+bool CDirectoryCache::StatFiles(const CStdString& strPath, const vector<CStdString>& files, vector<SFileStat>& results)
+{
+  CSingleLock lock (m_cs);
+
+  CStdString storedPath = URIUtils::SubstitutePath(strPath);
+  URIUtils::RemoveSlashAtEnd(storedPath);
+
+  CDir* dir = Find(storedPath);
+  if (!dir)
+    return false;
+
+  results.assign(files.size(), SFileStat());
+  for (unsigned int j = 0; j < files.size(); j++)
+  {
+    CFileItemPtr item = dir->m_Items->Get(files[j]);
+    if (item)
+    {
+      results[j].exists = true;
+      IDirectory::StatFromItem(*item, results[j].stat);
+    }
+  }
+  return true;
+}
+
 void CDirectoryCache::Clear()
 {
   // this routine clears everything
-  CSingleLock lock (m_cs);
+  {
+    CSingleLock lock (m_cs);
 
-  iCache i = m_cache.begin();
-  while (i != m_cache.end() )
-    Delete(i++);
+    iCache i = m_cache.begin();
+    while (i != m_cache.end() )
+      Delete(i++);
+  }
+  NotifyInvalidated("");
+}
+
+void CDirectoryCache::RegisterCallback(IDirectoryCacheCallback* callback)
+{
+  CSingleLock lock(m_callbackSection);
+  if (find(m_callbacks.begin(), m_callbacks.end(), callback) == m_callbacks.end())
+    m_callbacks.push_back(callback);
+}
+
+void CDirectoryCache::UnregisterCallback(IDirectoryCacheCallback* callback)
+{
+  CSingleLock lock(m_callbackSection);
+  vector<IDirectoryCacheCallback*>::iterator it = find(m_callbacks.begin(), m_callbacks.end(), callback);
+  if (it != m_callbacks.end())
+    m_callbacks.erase(it);
+}
+
+void CDirectoryCache::NotifyInvalidated(const CStdString& strPath)
+{
+  CSingleLock lock(m_callbackSection);
+  for (vector<IDirectoryCacheCallback*>::iterator it = m_callbacks.begin(); it != m_callbacks.end(); ++it)
+    (*it)->OnDirectoryInvalidated(strPath);
 }
 
 void CDirectoryCache::InitCache(set<CStdString>& dirs)
@@ -221,6 +271,8 @@ void CDirectoryCache::InitCache(set<CStdString>& dirs)
 
 void CDirectoryCache::ClearCache(set<CStdString>& dirs)
 {
+  CSingleLock lock (m_cs);
+
   iCache i = m_cache.begin();
   while (i != m_cache.end())
   {
@@ -231,51 +283,109 @@ void CDirectoryCache::ClearCache(set<CStdString>& dirs)
   }
 }
 
-void CDirectoryCache::CheckIfFull()
+void CDirectoryCache::CheckIfFull(uint64_t bytesNeeded)
 {
-  CSingleLock lock (m_cs);
-  static const unsigned int max_cached_dirs = 10;
+  uint64_t maxBytes = g_advancedSettings.m_dirCacheSize;
 
-  // find the last accessed folder, and remove if the number of cached folders is too many
-  iCache lastAccessed = m_cache.end();
-  unsigned int numCached = 0;
-  for (iCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // evict the least recently used folders until the new one fits, folders
+  // that are always cached aren't in the lru list and are never evicted
+  while (!m_lru.empty() && m_bytes + bytesNeeded > maxBytes)
   {
-    // ensure dirs that are always cached aren't cleared
-    if (i->second->m_cacheType != DIR_CACHE_ALWAYS)
-    {
-      if (lastAccessed == m_cache.end() || i->second->GetLastAccess() < lastAccessed->second->GetLastAccess())
-        lastAccessed = i;
-      numCached++;
-    }
+    Delete(m_lru.back());
+    m_stats.evictions++;
+  }
+}
+
+CDirectoryCache::CDir* CDirectoryCache::Find(const CStdString& storedPath)
+{
+  iCache i = m_cache.find(storedPath);
+  if (i == m_cache.end())
+  {
+    m_stats.misses++;
+    return NULL;
+  }
+
+  CDir* dir = i->second;
+  if (dir->m_expires.IsTimePast())
+  {
+    Delete(i);
+    m_stats.expirations++;
+    m_stats.misses++;
+    return NULL;
   }
-  if (lastAccessed != m_cache.end() && numCached >= max_cached_dirs)
-    Delete(lastAccessed);
+
+  if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+    m_lru.splice(m_lru.begin(), m_lru, dir->m_lru);
+  m_stats.hits++;
+  return dir;
 }
 
 void CDirectoryCache::Delete(iCache it)
 {
   CDir* dir = it->second;
+  if (dir->m_cacheType != DIR_CACHE_ALWAYS)
+    m_lru.erase(dir->m_lru);
+  m_bytes -= dir->m_bytes;
   delete dir;
   m_cache.erase(it);
 }
 
-#ifdef _DEBUG
-void CDirectoryCache::PrintStats() const
+unsigned int CDirectoryCache::EstimateSize(const CFileItemList& items)
 {
-  CSingleLock lock (m_cs);
-  CLog::Log(LOGDEBUG, "%s - total of %u cache hits, and %u cache misses", __FUNCTION__, m_cacheHits, m_cacheMisses);
-  // run through and find the oldest and the number of items cached
-  unsigned int oldest = UINT_MAX;
-  unsigned int numItems = 0;
-  unsigned int numDirs = 0;
-  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+  // the items, their path and label, and the fast lookup entry that holds
+  // the path again. tags and properties are left out, most listings don't
+  // have them yet
+  static const unsigned int node = 4 * sizeof(void*);
+  unsigned int bytes = sizeof(CFileItemList);
+  for (int i = 0; i < items.Size(); i++)
   {
-    CDir *dir = i->second;
-    oldest = min(oldest, dir->GetLastAccess());
-    numItems += dir->m_Items->Size();
-    numDirs++;
+    const CFileItemPtr item = items[i];
+    bytes += sizeof(CFileItem) + sizeof(CFileItemPtr) + node + sizeof(CStdString);
+    bytes += 2 * item->GetPath().size() + item->GetLabel().size();
   }
-  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total.  Oldest is %u, current is %u", __FUNCTION__, numDirs, numItems, oldest, m_accessCounter);
+  return bytes;
+}
+
+unsigned int CDirectoryCache::GetTTL(const CStdString& storedPath)
+{
+  const map<CStdString, unsigned int>& ttls = g_advancedSettings.m_dirCacheTTL;
+  if (ttls.empty())
+    return 0;
+
+  int pos = storedPath.Find("://");
+  CStdString protocol = pos > 0 ? storedPath.Left(pos) : "file";
+  protocol.ToLower();
+
+  map<CStdString, unsigned int>::const_iterator it = ttls.find(protocol);
+  if (it == ttls.end())
+    return 0;
+  return it->second * 1000;
+}
+
+void CDirectoryCache::GetStats(SDirectoryCacheStats& stats) const
+{
+  CSingleLock lock (m_cs);
+  stats = m_stats;
+  stats.dirs = m_cache.size();
+  stats.items = 0;
+  for (ciCache i = m_cache.begin(); i != m_cache.end(); i++)
+    stats.items += i->second->m_Items->Size();
+  stats.bytes = m_bytes;
+  stats.maxBytes = g_advancedSettings.m_dirCacheSize;
+}
+
+void CDirectoryCache::ResetStats()
+{
+  CSingleLock lock (m_cs);
+  memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void CDirectoryCache::PrintStats() const
+{
+  SDirectoryCacheStats stats;
+  GetStats(stats);
+  CLog::Log(LOGDEBUG, "%s - total of %"PRIu64" cache hits, and %"PRIu64" cache misses (%.1f%%)", __FUNCTION__,
+            stats.hits, stats.misses, stats.HitRate() * 100.0);
+  CLog::Log(LOGDEBUG, "%s - %u folders cached, with %u items total, using %"PRIu64"/%"PRIu64" KB. %"PRIu64" evicted, %"PRIu64" expired", __FUNCTION__,
+            stats.dirs, stats.items, stats.bytes / 1024, stats.maxBytes / 1024, stats.evictions, stats.expirations);
 }
-#endif
@@ -22,29 +22,72 @@
 #include "IDirectory.h"
 #include "Directory.h"
 #include "threads/CriticalSection.h"
+#include "threads/SystemClock.h"
 
+#include <boost/shared_ptr.hpp>
+#include <list>
 #include <map>
 #include <set>
+#include <vector>
 
 class CFileItem;
 
 namespace XFILE
 {
+  struct SDirectoryCacheStats
+  {
+    uint64_t     hits;        // lookups answered from the cache
+    uint64_t     misses;
+    uint64_t     evictions;   // listings dropped to stay within the memory limit
+    uint64_t     expirations; // listings dropped once their protocol's ttl ran out
+    unsigned int dirs;        // listings in the cache
+    unsigned int items;
+    uint64_t     bytes;       // approximate memory used by the listings
+    uint64_t     maxBytes;
+
+    double HitRate() const { return hits + misses ? (double)hits / (hits + misses) : 0.0; }
+  };
+
+  /* gets told when cached listings are invalidated because the folders they
+   * list changed, evictions and expirations aren't reported */
+  class IDirectoryCacheCallback
+  {
+  public:
+    virtual ~IDirectoryCacheCallback() {}
+    /* strPath is the folder, the parent of all invalidated folders for
+     * ClearSubPaths, or empty when the whole cache was cleared */
+    virtual void OnDirectoryInvalidated(const CStdString& strPath) = 0;
+  };
+
+  /**
+   * Caches folder listings, bounded by the approximate memory they use. When
+   * it's full the least recently used listing is evicted, listings that are
+   * always cached are only dropped when they are invalidated. Listings of
+   * protocols with a ttl in advancedsettings expire after it.
+   *
+   * A cached listing is never changed after it is stored, lookups take a
+   * reference to it and copy it outside the lock, so concurrent lookups of
+   * big folders don't serialize on each other. AddFile replaces a listing
+   * that is being copied rather than adding to it.
+   */
   class CDirectoryCache
   {
+    class CDir;
+    typedef std::map<CStdString, CDir*> CacheMap;
+    typedef CacheMap::iterator iCache;
+    typedef CacheMap::const_iterator ciCache;
+    typedef std::list<iCache> LruList;
+
     class CDir
     {
     public:
       CDir(DIR_CACHE_TYPE cacheType);
-      virtual ~CDir();
 
-      void SetLastAccess(unsigned int &accessCounter);
-      unsigned int GetLastAccess() const { return m_lastAccess; };
-
-      CFileItemList* m_Items;
+      boost::shared_ptr<CFileItemList> m_Items;
       DIR_CACHE_TYPE m_cacheType;
-    private:
-      unsigned int m_lastAccess;
+      unsigned int m_bytes;
+      XbmcThreads::EndTime m_expires;
+      LruList::iterator m_lru; // unused for listings that are always cached
     };
   public:
     CDirectoryCache(void);
@@ -57,27 +100,39 @@ namespace XFILE
     void Clear();
     void AddFile(const CStdString& strFile);
     bool FileExists(const CStdString& strPath, bool& bInCache);
-#ifdef _DEBUG
+    bool StatFiles(const CStdString& strPath, const std::vector<CStdString>& files, std::vector<SFileStat>& results);
+
+    void RegisterCallback(IDirectoryCacheCallback* callback);
+    void UnregisterCallback(IDirectoryCacheCallback* callback);
+
+    void GetStats(SDirectoryCacheStats& stats) const;
+    void ResetStats();
     void PrintStats() const;
-#endif
+
+    /* approximate memory used by a listing in the cache */
+    static unsigned int EstimateSize(const CFileItemList& items);
   protected:
     void InitCache(std::set<CStdString>& dirs);
     void ClearCache(std::set<CStdString>& dirs);
-    void CheckIfFull();
+    void CheckIfFull(uint64_t bytesNeeded);
 
-    std::map<CStdString, CDir*> m_cache;
-    typedef std::map<CStdString, CDir*>::iterator iCache;
-    typedef std::map<CStdString, CDir*>::const_iterator ciCache;
+    /* returns the listing of a folder and marks it as used, or NULL if it
+     * isn't cached or expired */
+    CDir* Find(const CStdString& storedPath);
     void Delete(iCache i);
+    void NotifyInvalidated(const CStdString& strPath);
+
+    static unsigned int GetTTL(const CStdString& storedPath);
 
-    CCriticalSection m_cs;
+    CacheMap m_cache;
+    LruList  m_lru; // most recently used first
 
-    unsigned int m_accessCounter;
+    mutable CCriticalSection m_cs;
+    CCriticalSection m_callbackSection;
+    std::vector<IDirectoryCacheCallback*> m_callbacks;
 
-#ifdef _DEBUG
-    unsigned int m_cacheHits;
-    unsigned int m_cacheMisses;
-#endif
+    uint64_t m_bytes;
+    SDirectoryCacheStats m_stats;
   };
 }
 extern XFILE::CDirectoryCache g_directoryCache;
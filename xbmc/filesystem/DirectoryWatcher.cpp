@@ -0,0 +1,244 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "DirectoryWatcher.h"
+#include "SpecialProtocol.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/URIUtils.h"
+
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+
+// network filesystems, inotify doesn't see the changes other machines make on them
+static const unsigned int network_fs_types[] = {
+  0x6969,     // NFS
+  0x517B,     // SMB
+  0xFF534D42, // CIFS
+  0xFE534D42, // SMB2
+  0x01021997, // 9P
+  0x73757245, // CODA
+  0x5346414F, // AFS
+  0x00C36400, // CEPH
+  0x65735546  // FUSE (sshfs, ...)
+};
+#endif
+
+using namespace std;
+using namespace XFILE;
+
+CDirectoryWatcher::CDirectoryWatcher()
+{
+  m_fd = -1;
+}
+
+CDirectoryWatcher::~CDirectoryWatcher()
+{
+#ifdef HAVE_INOTIFY
+  if (m_fd >= 0)
+    close(m_fd); // drops the watches along with it
+#endif
+}
+
+bool CDirectoryWatcher::IsSupported(const CStdString &path)
+{
+#ifdef HAVE_INOTIFY
+  if (URIUtils::IsInArchive(path) || URIUtils::IsStack(path))
+    return false;
+  CStdString local(CSpecialProtocol::TranslatePath(path));
+  CURL url(local);
+  if (!url.GetProtocol().IsEmpty())
+    return false;
+
+  struct statfs fs;
+  if (statfs(local.c_str(), &fs) != 0)
+    return false;
+  for (unsigned int i = 0; i < sizeof(network_fs_types) / sizeof(network_fs_types[0]); i++)
+  {
+    if ((unsigned int)fs.f_type == network_fs_types[i])
+      return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool CDirectoryWatcher::Watch(const CStdString &path)
+{
+#ifdef HAVE_INOTIFY
+  if (!IsSupported(path))
+    return false;
+
+  CStdString folder(path);
+  URIUtils::AddSlashAtEnd(folder);
+
+  CSingleLock lock(m_section);
+  ReadEvents();
+  m_changes.erase(folder);
+  if (m_paths.find(folder) != m_paths.end())
+    return true;
+
+  if (m_fd < 0)
+  {
+    m_fd = inotify_init();
+    if (m_fd < 0)
+    {
+      CLog::Log(LOGERROR, "%s - unable to initialize inotify (%d)", __FUNCTION__, errno);
+      return false;
+    }
+    int opts = fcntl(m_fd, F_GETFL);
+    if (opts == -1 || fcntl(m_fd, F_SETFL, opts | O_NONBLOCK) == -1)
+    {
+      close(m_fd);
+      m_fd = -1;
+      return false;
+    }
+  }
+
+  int wd = inotify_add_watch(m_fd, CSpecialProtocol::TranslatePath(folder).c_str(), WATCH_MASK | IN_ONLYDIR);
+  if (wd < 0)
+  {
+    if (errno == ENOSPC)
+      CLog::Log(LOGDEBUG, "%s - watch limit reached, not watching %s", __FUNCTION__, folder.c_str());
+    return false;
+  }
+
+  // the same folder under another name shares the watch, keep the newest name
+  map<int, CStdString>::iterator it = m_watches.find(wd);
+  if (it != m_watches.end())
+    m_paths.erase(it->second);
+  m_watches[wd] = folder;
+  m_paths[folder] = wd;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void CDirectoryWatcher::Unwatch(const CStdString &path)
+{
+  CStdString folder(path);
+  URIUtils::AddSlashAtEnd(folder);
+
+  CSingleLock lock(m_section);
+  map<CStdString, int>::iterator it = m_paths.find(folder);
+  if (it == m_paths.end())
+    return;
+#ifdef HAVE_INOTIFY
+  inotify_rm_watch(m_fd, it->second);
+#endif
+  m_watches.erase(it->second);
+  m_paths.erase(it);
+  m_changes.erase(folder);
+}
+
+void CDirectoryWatcher::UnwatchAll()
+{
+  CSingleLock lock(m_section);
+#ifdef HAVE_INOTIFY
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+  m_fd = -1;
+  m_watches.clear();
+  m_paths.clear();
+  m_changes.clear();
+}
+
+bool CDirectoryWatcher::IsWatched(const CStdString &path)
+{
+  CStdString folder(path);
+  URIUtils::AddSlashAtEnd(folder);
+
+  CSingleLock lock(m_section);
+  ReadEvents();
+  return m_paths.find(folder) != m_paths.end();
+}
+
+bool CDirectoryWatcher::HasChanged(const CStdString &path)
+{
+  CStdString folder(path);
+  URIUtils::AddSlashAtEnd(folder);
+
+  CSingleLock lock(m_section);
+  ReadEvents();
+  return m_changes.find(folder) != m_changes.end();
+}
+
+void CDirectoryWatcher::GetChanges(set<CStdString> &changes)
+{
+  CSingleLock lock(m_section);
+  ReadEvents();
+  changes.clear();
+  changes.swap(m_changes);
+}
+
+void CDirectoryWatcher::ReadEvents()
+{
+#ifdef HAVE_INOTIFY
+  if (m_fd < 0)
+    return;
+
+  char buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+  while (true)
+  {
+    int length = read(m_fd, buffer, sizeof(buffer));
+    if (length <= 0)
+      break; // EAGAIN, nothing (more) queued
+
+    for (int i = 0; i + (int)sizeof(struct inotify_event) <= length;)
+    {
+      struct inotify_event *event = (struct inotify_event *)(buffer + i);
+      i += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW)
+      { // events were dropped, anything could have changed
+        CLog::Log(LOGDEBUG, "%s - event queue overflowed, assuming %u folders changed", __FUNCTION__, (unsigned int)m_paths.size());
+        for (map<CStdString, int>::const_iterator it = m_paths.begin(); it != m_paths.end(); ++it)
+          m_changes.insert(it->first);
+        continue;
+      }
+
+      map<int, CStdString>::iterator it = m_watches.find(event->wd);
+      if (it == m_watches.end())
+        continue;
+      m_changes.insert(it->second);
+
+      if (event->mask & (IN_IGNORED | IN_MOVE_SELF))
+      { // the folder is gone (or elsewhere), the watch goes with it
+        if (!(event->mask & IN_IGNORED))
+          inotify_rm_watch(m_fd, event->wd);
+        m_paths.erase(it->second);
+        m_watches.erase(it);
+      }
+    }
+  }
+#endif
+}
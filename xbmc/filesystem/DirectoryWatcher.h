@@ -0,0 +1,79 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "utils/StdString.h"
+
+#include <map>
+#include <set>
+
+namespace XFILE
+{
+  /**
+   * Keeps track of which local folders changed since they were last looked at,
+   * using inotify where it's available. Watches aren't recursive, every folder
+   * of interest is watched on its own.
+   *
+   * There is no thread behind it, the events queue up in the kernel and are
+   * picked up whenever the watcher is asked about a folder. When the queue
+   * overflows every watched folder is reported as changed.
+   *
+   * Folders that can't be watched (remote ones, or once the watch limit is
+   * reached) are never reported as watched, callers have to fall back on
+   * something else for those.
+   */
+  class CDirectoryWatcher
+  {
+  public:
+    CDirectoryWatcher();
+    ~CDirectoryWatcher();
+
+    /* true if changes of the folder can be watched at all, which excludes
+     * network mounts as other machines change them behind inotify's back */
+    static bool IsSupported(const CStdString &path);
+
+    /* starts watching a folder if it isn't watched yet and forgets about the
+     * changes seen so far, call it before the folder is listed. Returns false
+     * if the folder can't be watched */
+    bool Watch(const CStdString &path);
+    void Unwatch(const CStdString &path);
+    void UnwatchAll();
+
+    bool IsWatched(const CStdString &path);
+
+    /* true if the folder, or the list of files in it, changed since Watch was
+     * last called for it. Only meaningful for watched folders */
+    bool HasChanged(const CStdString &path);
+
+    /* moves the changed folders into changes, which are then no longer
+     * reported as changed */
+    void GetChanges(std::set<CStdString> &changes);
+
+  private:
+    void ReadEvents();
+
+    CCriticalSection m_section;
+    int m_fd;
+    std::map<int, CStdString> m_watches; // watch descriptor -> folder
+    std::map<CStdString, int> m_paths;
+    std::set<CStdString> m_changes;
+  };
+}
@@ -25,6 +25,8 @@
 #include "DirectoryCache.h"
 #include "Directory.h"
 #include "FileCache.h"
+#include "FileCopy.h"
+#include "settings/AdvancedSettings.h"
 #include "utils/log.h"
 #include "utils/URIUtils.h"
 #include "utils/BitstreamStats.h"
@@ -65,20 +67,9 @@ CFile::~CFile()
 
 //*********************************************************************************************
 
-class CAutoBuffer
-{
-  char* p;
-public:
-  explicit CAutoBuffer(size_t s) { p = (char*)malloc(s); }
-  ~CAutoBuffer() { free(p); }
-  char* get() { return p; }
-};
-
 // This *looks* like a copy function, therefor the name "Cache" is misleading
 bool CFile::Cache(const CStdString& strFileName, const CStdString& strDest, XFILE::IFileCallback* pCallback, void* pContext)
 {
-  CFile file;
-
   if (strFileName.empty() || strDest.empty())
     return false;
 
@@ -86,127 +77,16 @@ bool CFile::Cache(const CStdString& strFileName, const CStdString& strDest, XFIL
   CURL url(strFileName);
   if (URIUtils::IsInZIP(strFileName) || URIUtils::IsInAPK(strFileName))
     url.SetOptions("?cache=no");
-  if (file.Open(url.Get(), READ_TRUNCATED))
-  {
-
-    CFile newFile;
-    if (URIUtils::IsHD(strDest)) // create possible missing dirs
-    {
-      vector<CStdString> tokens;
-      CStdString strDirectory;
-      URIUtils::GetDirectory(strDest,strDirectory);
-      URIUtils::RemoveSlashAtEnd(strDirectory);  // for the test below
-      if (!(strDirectory.size() == 2 && strDirectory[1] == ':'))
-      {
-        CURL url(strDirectory);
-        CStdString pathsep;
-#ifndef _LINUX
-        pathsep = "\\";
-#else
-        pathsep = "/";
-#endif
-        CUtil::Tokenize(url.GetFileName(),tokens,pathsep.c_str());
-        CStdString strCurrPath;
-        // Handle special
-        if (!url.GetProtocol().IsEmpty()) {
-          pathsep = "/";
-          strCurrPath += url.GetProtocol() + "://";
-        } // If the directory has a / at the beginning, don't forget it
-        else if (strDirectory[0] == pathsep[0])
-          strCurrPath += pathsep;
-        for (vector<CStdString>::iterator iter=tokens.begin();iter!=tokens.end();++iter)
-        {
-          strCurrPath += *iter+pathsep;
-          CDirectory::Create(strCurrPath);
-        }
-      }
-    }
-    if (CFile::Exists(strDest))
-      CFile::Delete(strDest);
-    if (!newFile.OpenForWrite(strDest, true))  // overwrite always
-    {
-      file.Close();
-      return false;
-    }
-
-    // 128k is optimal for xbox
-    int iBufferSize = 128 * 1024;
-
-    CAutoBuffer buffer(iBufferSize);
-    int iRead, iWrite;
-
-    UINT64 llFileSize = file.GetLength();
-    UINT64 llPos = 0;
-
-    CStopWatch timer;
-    timer.StartZero();
-    float start = 0.0f;
-    while (true)
-    {
-      g_application.ResetScreenSaver();
-
-      iRead = file.Read(buffer.get(), iBufferSize);
-      if (iRead == 0) break;
-      else if (iRead < 0)
-      {
-        CLog::Log(LOGERROR, "%s - Failed read from file %s", __FUNCTION__, strFileName.c_str());
-        llFileSize = (uint64_t)-1;
-        break;
-      }
-
-      /* write data and make sure we managed to write it all */
-      iWrite = 0;
-      while(iWrite < iRead)
-      {
-        int iWrite2 = newFile.Write(buffer.get()+iWrite, iRead-iWrite);
-        if(iWrite2 <=0)
-          break;
-        iWrite+=iWrite2;
-      }
-
-      if (iWrite != iRead)
-      {
-        CLog::Log(LOGERROR, "%s - Failed write to file %s", __FUNCTION__, strDest.c_str());
-        llFileSize = (uint64_t)-1;
-        break;
-      }
-
-      llPos += iRead;
-
-      // calculate the current and average speeds
-      float end = timer.GetElapsedSeconds();
-
-      if (pCallback && end - start > 0.5 && end)
-      {
-        start = end;
-
-        float averageSpeed = llPos / end;
-        int ipercent = 0;
-        if(llFileSize)
-          ipercent = 100 * llPos / llFileSize;
-
-        if(!pCallback->OnFileCallback(pContext, ipercent, averageSpeed))
-        {
-          CLog::Log(LOGERROR, "%s - User aborted copy", __FUNCTION__);
-          llFileSize = (uint64_t)-1;
-          break;
-        }
-      }
-    }
-
-    /* close both files */
-    newFile.Close();
-    file.Close();
 
-    /* verify that we managed to completed the file */
-    if (llFileSize && llPos != llFileSize)
-    {
-      CFile::Delete(strDest);
-      return false;
-    }
-    return true;
-  }
-  return false;
+  CFileCopy copy(url.Get(), strDest);
+  copy.SetCallback(pCallback, pContext);
+  // sources that seek cheaply are read in several ranges at once
+  if (url.GetProtocol() == "http" || url.GetProtocol() == "https" || url.GetProtocol() == "nfs")
+    copy.SetReaders(g_advancedSettings.m_fileCopyReaders);
+  copy.SetVerify(g_advancedSettings.m_fileCopyVerify);
+  // local copies go through a partial file that is renamed once it's done
+  copy.SetResume(g_advancedSettings.m_fileCopyResume && URIUtils::IsHD(strDest));
+  return copy.Copy();
 }
 
 //*********************************************************************************************
@@ -286,6 +166,9 @@ bool CFile::Open(const CStdString& strFileName, unsigned int flags)
       return false;
     }
 
+    if ((m_flags & READ_MMAP) && m_pFile->IoControl(IOCTRL_MMAP, NULL) == 0)
+      CLog::Log(LOGDEBUG, "%s - mapped %s into memory", __FUNCTION__, strFileName.c_str());
+
     if (m_pFile->GetChunkSize() && !(m_flags & READ_CHUNKED))
     {
       m_pBuffer = new CFileStreamBuffer(0);
@@ -518,6 +401,8 @@ void CFile::Close()
 {
   try
   {
+    if (m_pFile)
+      m_pFile->WaitAsync();
     SAFE_DELETE(m_pBuffer);
     SAFE_DELETE(m_pFile);
   }
@@ -607,6 +492,49 @@ int64_t CFile::GetLength()
   return 0;
 }
 
+//*********************************************************************************************
+int CFile::Peek(const void** lpBuf, unsigned int uiBufSize)
+{
+  // data of the stream buffer can't be peeked
+  if (!m_pFile || m_pBuffer)
+    return -1;
+
+  return m_pFile->Peek(lpBuf, uiBufSize);
+}
+
+void CFile::Consume(unsigned int uiSize)
+{
+  if (!m_pFile || m_pBuffer)
+    return;
+
+  m_pFile->Consume(uiSize);
+  if (m_bitStreamStats && uiSize > 0)
+    m_bitStreamStats->AddSampleBytes(uiSize);
+}
+
+//*********************************************************************************************
+bool CFile::ReadAsync(CFileReadRequest* request)
+{
+  try
+  {
+    if (m_pFile)
+      return m_pFile->ReadAsync(request);
+    return false;
+  }
+  XBMCCOMMONS_HANDLE_UNCHECKED
+  catch(...)
+  {
+    CLog::Log(LOGERROR, "%s - Unhandled exception", __FUNCTION__);
+  }
+  return false;
+}
+
+void CFile::WaitAsync()
+{
+  if (m_pFile)
+    m_pFile->WaitAsync();
+}
+
 //*********************************************************************************************
 int64_t CFile::GetPosition() const
 {
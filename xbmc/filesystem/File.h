@@ -41,11 +41,18 @@ namespace XFILE
 {
 
 class IFile;
+class CFileReadRequest;
 
 class IFileCallback
 {
 public:
   virtual bool OnFileCallback(void* pContext, int ipercent, float avgSpeed) = 0;
+  /* the progress of a copy with the seconds it needs to finish, -1 when that
+   * isn't known. callbacks that don't show it get OnFileCallback */
+  virtual bool OnFileProgress(void* pContext, int ipercent, float avgSpeed, int secondsLeft)
+  {
+    return OnFileCallback(pContext, ipercent, avgSpeed);
+  }
   virtual ~IFileCallback() {};
 };
 
@@ -64,6 +71,9 @@ public:
 /* calcuate bitrate for file while reading */
 #define READ_BITRATE   0x10
 
+/* map local files into memory, so they can be read with Peek and Consume */
+#define READ_MMAP      0x20
+
 class CFileStreamBuffer;
 
 class CFile
@@ -85,6 +95,14 @@ public:
   void Close();
   int GetChunkSize();
 
+  /* reads without copying from files opened with READ_MMAP, see IFile::Peek */
+  int  Peek(const void** lpBuf, unsigned int uiBufSize);
+  void Consume(unsigned int uiSize);
+
+  /* queues a read at an offset that completes on another thread, see IFile::ReadAsync */
+  bool ReadAsync(CFileReadRequest* request);
+  void WaitAsync();
+
   // will return a size, that is aligned to chunk size
   // but always greater or equal to the file's chunk size
   static int GetChunkSize(int chunk, int minimum)
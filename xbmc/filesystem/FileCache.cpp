@@ -29,12 +29,16 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
 #include "settings/AdvancedSettings.h"
 
+#include <climits>
+
 using namespace AUTOPTR;
 using namespace XFILE;
 
 #define READ_CACHE_CHUNK_SIZE (64*1024)
+#define READ_CACHE_CHUNK_MAX   (1024*1024)
 
 class CWriteRate
 {
@@ -77,8 +81,64 @@ private:
   unsigned m_pause;
 };
 
+CReadAhead::CReadAhead(unsigned chunk, unsigned seconds)
+{
+  m_base    = chunk;
+  m_max     = std::max(chunk, READ_CACHE_CHUNK_MAX / chunk * chunk);
+  m_seconds = seconds;
+  Reset();
+}
+
+void CReadAhead::Reset()
+{
+  m_chunk = m_base;
+  m_ahead = false;
+  m_fill.Start();
+}
+
+void CReadAhead::Resume()
+{
+  m_fill.Start();
+}
+
+void CReadAhead::AddFill(unsigned bytes)
+{
+  m_fill.AddSampleBytes(bytes);
+
+  // read about a tenth of a second of what the source delivers at once
+  unsigned rate = GetFillRate();
+  if (rate)
+    m_chunk = std::max(m_base, std::min(m_max, rate / 10 / m_base * m_base));
+}
+
+uint64_t CReadAhead::GetTarget(unsigned consume) const
+{
+  if (!m_seconds || !consume)
+    return 0;
+
+  uint64_t target = (uint64_t)consume * m_seconds;
+
+  // a source that is barely faster than the reader needs more margin for its dips
+  unsigned fill = GetFillRate();
+  if (fill && fill < 2 * consume)
+    target *= 2;
+
+  return std::max(target, (uint64_t)4 * m_max);
+}
+
+bool CReadAhead::IsAhead(int64_t forward, unsigned consume)
+{
+  uint64_t target = GetTarget(consume);
+  if (!target || forward < 0)
+    m_ahead = false;
+  else if ((uint64_t)forward >= target)
+    m_ahead = true;
+  else if ((uint64_t)forward < target / 2)
+    m_ahead = false;
+  return m_ahead;
+}
 
-CFileCache::CFileCache() : CThread("CFileCache")
+CFileCache::CFileCache() : CThread("CFileCache"), m_reader(g_blockCache)
 {
    m_bDeleteCache = true;
    m_nSeekResult = 0;
@@ -91,10 +151,12 @@ CFileCache::CFileCache() : CThread("CFileCache")
      m_pCache = new CCircularCache(g_advancedSettings.m_cacheMemBufferSize
                                  , std::max<unsigned int>( g_advancedSettings.m_cacheMemBufferSize / 4, 1024 * 1024));
    m_seekPossible = 0;
+   m_readRate = 0;
+   m_readAhead = 0;
    m_cacheFull = false;
 }
 
-CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("CFileCache")
+CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("CFileCache"), m_reader(g_blockCache)
 {
   m_pCache = pCache;
   m_bDeleteCache = bDeleteCache;
@@ -103,6 +165,8 @@ CFileCache::CFileCache(CCacheStrategy *pCache, bool bDeleteCache) : CThread("CFi
   m_writePos = 0;
   m_nSeekResult = 0;
   m_chunkSize = 0;
+  m_readRate = 0;
+  m_readAhead = 0;
 }
 
 CFileCache::~CFileCache()
@@ -167,10 +231,30 @@ bool CFileCache::Open(const CURL& url)
   m_seekPossible = m_source.IoControl(IOCTRL_SEEK_POSSIBLE, NULL);
   m_chunkSize = CFile::GetChunkSize(m_source.GetChunkSize(), READ_CACHE_CHUNK_SIZE);
 
+  // keep what is read from remote files on disk, for the next time they are opened
+  int64_t length = m_source.GetLength();
+  bool    persist = g_advancedSettings.m_cacheDiskSize > 0 && length > 0
+                 && !URIUtils::IsHD(m_sourcePath) && !URIUtils::IsLiveTV(m_sourcePath)
+                 && g_blockCache.Open(URIUtils::AddFileToFolder(g_advancedSettings.m_cachePath, "blockcache"),
+                                      (uint64_t)g_advancedSettings.m_cacheDiskSize * 1024 * 1024);
+  if (persist)
+  {
+    struct __stat64 st;
+    int64_t mtime = m_source.Stat(&st) == 0 ? st.st_mtime : 0;
+    CBlockCache::SKey key = CBlockCache::GetKey(m_sourcePath, length, mtime);
+    m_reader.Open(m_source.GetImplemenation(), &key, length);
+  }
+  else
+    m_reader.Open(m_source.GetImplemenation(), NULL, length);
+
   m_readPos = 0;
   m_writePos = 0;
   m_writeRate = 1024 * 1024;
   m_writeRateActual = 0;
+  m_readStats = BitstreamStats();
+  m_readStats.Start();
+  m_readRate = 0;
+  m_readAhead = 0;
   m_cacheFull = false;
   m_seekEvent.Reset();
   m_seekEnded.Reset();
@@ -188,8 +272,10 @@ void CFileCache::Process()
     return;
   }
 
+  CReadAhead readahead(m_chunkSize, g_advancedSettings.m_cacheReadAhead);
+
   // create our read buffer
-  auto_aptr<char> buffer(new char[m_chunkSize]);
+  auto_aptr<char> buffer(new char[readahead.GetMaxChunkSize()]);
   if (buffer.get() == NULL)
   {
     CLog::Log(LOGERROR, "%s - failed to allocate read buffer", __FUNCTION__);
@@ -206,7 +292,7 @@ void CFileCache::Process()
     {
       m_seekEvent.Reset();
       CLog::Log(LOGDEBUG,"%s, request seek on source to %"PRId64, __FUNCTION__, m_seekPos);
-      m_nSeekResult = m_source.Seek(m_seekPos, SEEK_SET);
+      m_nSeekResult = m_reader.Seek(m_seekPos);
       if (m_nSeekResult != m_seekPos)
       {
         CLog::Log(LOGERROR,"%s, error %d seeking. seek returned %"PRId64, __FUNCTION__, (int)GetLastError(), m_nSeekResult);
@@ -217,6 +303,7 @@ void CFileCache::Process()
         m_pCache->Reset(m_seekPos);
         average.Reset(m_seekPos);
         limiter.Reset(m_seekPos);
+        readahead.Reset();
         m_writePos = m_seekPos;
         m_readPos = m_seekPos;
         m_cacheFull = false;
@@ -243,7 +330,31 @@ void CFileCache::Process()
       }
     }
 
-    int iRead = m_source.Read(buffer.get(), m_chunkSize);
+    // give what the read ahead doesn't need to the back buffer
+    unsigned readRate = GetReadRate();
+    uint64_t target = readahead.GetTarget(readRate);
+    if (target != m_readAhead)
+    {
+      m_pCache->SetReadAhead((size_t)std::min(target, (uint64_t)INT_MAX));
+      CSingleLock lock(m_rateSync);
+      m_readAhead = target;
+    }
+
+    // back off while well ahead of the reader
+    if (readahead.IsAhead(m_writePos - m_readPos, readRate))
+    {
+      average.Pause();
+      bool seek = m_seekEvent.WaitMSec(100);
+      average.Resume();
+      readahead.Resume();
+      if (seek)
+        m_seekEvent.Set();
+      continue;
+    }
+
+    int iRead = m_reader.Read(buffer.get(), readahead.GetChunkSize());
+    if (iRead > 0)
+      readahead.AddFill(iRead);
     if (iRead == 0)
     {
       CLog::Log(LOGINFO, "CFileCache::Process - Hit eof.");
@@ -341,6 +452,9 @@ retry:
   if (iRc > 0)
   {
     m_readPos += iRc;
+    m_readStats.AddSampleBytes((unsigned)iRc);
+    CSingleLock rateLock(m_rateSync);
+    m_readRate = (unsigned)(m_readStats.GetBitrate() / 8);
     return (int)iRc;
   }
 
@@ -431,6 +545,14 @@ void CFileCache::Close()
   if (m_pCache)
     m_pCache->Close();
 
+  if (m_reader.IsCaching())
+  {
+    SBlockCacheStats stats;
+    g_blockCache.GetStats(stats);
+    CLog::Log(LOGDEBUG, "CFileCache::Close - block cache hit rate %.1f%%, %"PRIu64" bytes saved, %u of %u blocks used",
+              stats.HitRate() * 100.0, stats.bytesSaved, stats.blocks, stats.capacity);
+  }
+  m_reader.Close();
   m_source.Close();
 }
 
@@ -460,6 +582,12 @@ CStdString CFileCache::GetContent()
   return m_source.GetImplemenation()->GetContent();
 }
 
+unsigned CFileCache::GetReadRate()
+{
+  CSingleLock lock(m_rateSync);
+  return m_readRate;
+}
+
 int CFileCache::IoControl(EIoControl request, void* param)
 {
   if (request == IOCTRL_CACHE_STATUS)
@@ -469,6 +597,9 @@ int CFileCache::IoControl(EIoControl request, void* param)
     status->maxrate = m_writeRate;
     status->currate = m_writeRateActual;
     status->full    = m_cacheFull;
+    CSingleLock lock(m_rateSync);
+    status->consumerate = m_readRate;
+    status->readahead   = m_readAhead;
     return 0;
   }
 
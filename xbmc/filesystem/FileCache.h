@@ -20,14 +20,48 @@
  */
 
 #include "IFile.h"
+#include "BlockCache.h"
 #include "CacheStrategy.h"
 #include "threads/CriticalSection.h"
 #include "File.h"
 #include "threads/Thread.h"
+#include "utils/BitstreamStats.h"
 
 namespace XFILE
 {
 
+  /* sizes the reads from the source after the rate it delivers at, and how
+   * far ahead of the reader to cache after the rate the reader consumes at */
+  class CReadAhead
+  {
+  public:
+    CReadAhead(unsigned chunk, unsigned seconds);
+
+    void Reset();
+    /* call after waiting, so the wait doesn't count against the source */
+    void Resume();
+    void AddFill(unsigned bytes);
+
+    unsigned GetFillRate() const { return (unsigned)(m_fill.GetBitrate() / 8); }
+    unsigned GetChunkSize() const { return m_chunk; }
+    unsigned GetMaxChunkSize() const { return m_max; }
+
+    /* bytes to keep cached forward, 0 when there is no limit */
+    uint64_t GetTarget(unsigned consume) const;
+
+    /* true while well ahead of the reader. reading stops at the target, and
+     * resumes once half of it is used, so the source sees few large bursts */
+    bool IsAhead(int64_t forward, unsigned consume);
+
+  private:
+    BitstreamStats m_fill;
+    unsigned       m_base;
+    unsigned       m_max;
+    unsigned       m_chunk;
+    unsigned       m_seconds;
+    bool           m_ahead;
+  };
+
   class CFileCache : public IFile, public CThread
   {
   public:
@@ -61,10 +95,13 @@ namespace XFILE
     virtual CStdString GetContent();
 
   private:
+    unsigned GetReadRate();
+
     CCacheStrategy *m_pCache;
     bool      m_bDeleteCache;
     int        m_seekPossible;
     CFile      m_source;
+    CBlockCacheReader m_reader; // reads m_source through the disk block cache
     CStdString    m_sourcePath;
     CEvent      m_seekEvent;
     CEvent      m_seekEnded;
@@ -75,8 +112,12 @@ namespace XFILE
     unsigned     m_chunkSize;
     unsigned     m_writeRate;
     unsigned     m_writeRateActual;
+    BitstreamStats m_readStats;  // what the reader takes out of the cache
+    unsigned     m_readRate;   // written by the reader, guarded by m_rateSync
+    uint64_t     m_readAhead;  // written by the cache thread, guarded by m_rateSync
     bool         m_cacheFull;
     CCriticalSection m_sync;
+    CCriticalSection m_rateSync; // m_sync is held while the reader waits on the cache thread
   };
 
 }
@@ -0,0 +1,488 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileCopy.h"
+#include "File.h"
+#include "Directory.h"
+#include "Application.h"
+#include "URL.h"
+#include "Util.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/Crc32.h"
+#include "utils/log.h"
+#include "utils/Stopwatch.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace XFILE;
+using namespace std;
+
+// the reads and writes are done in blocks of this, each reader has two
+#define COPY_BLOCK_SIZE (512 * 1024)
+// how much of the end of a partial copy has to match the source to resume it
+#define RESUME_CHECK_SIZE (64 * 1024)
+
+class CFileCopy::CReader : public IRunnable
+{
+public:
+  CReader(CFileCopy* copy, CFile* file)
+    : m_copy(copy), m_file(file), m_thread(this, "FileCopyReader")
+  {
+    m_thread.Create();
+  }
+
+  ~CReader()
+  {
+    m_thread.StopThread(true);
+  }
+
+  virtual void Run()
+  {
+    m_copy->ReadBlocks(m_file);
+  }
+
+private:
+  CFileCopy* m_copy;
+  CFile*     m_file;
+  CThread    m_thread;
+};
+
+static unsigned int ReadFully(CFile& file, void* buffer, unsigned int size)
+{
+  unsigned int total = 0;
+  while (total < size)
+  {
+    unsigned int read = file.Read((uint8_t*)buffer + total, size - total);
+    if (read == 0)
+      break;
+    total += read;
+  }
+  return total;
+}
+
+CFileCopy::CFileCopy(const CStdString& strSource, const CStdString& strDest)
+  : m_strSource(strSource), m_strDest(strDest)
+{
+  m_callback = NULL;
+  m_context = NULL;
+  m_readers = 1;
+  m_blockSize = COPY_BLOCK_SIZE;
+  m_bVerify = false;
+  m_bResume = false;
+  m_nextRead = 0;
+  m_nextWrite = 0;
+  m_bEnd = false;
+  m_bAbort = false;
+  m_length = 0;
+  m_start = 0;
+  m_copied = 0;
+  m_crc = 0;
+  m_lastProgress = 0.0f;
+  m_bUserAbort = false;
+}
+
+CFileCopy::~CFileCopy()
+{
+}
+
+void CFileCopy::SetCallback(IFileCallback* callback, void* context)
+{
+  m_callback = callback;
+  m_context = context;
+}
+
+CStdString CFileCopy::GetPartialPath(const CStdString& strDest)
+{
+  return strDest + ".part";
+}
+
+bool CFileCopy::Copy()
+{
+  if (m_strSource.empty() || m_strDest.empty())
+    return false;
+
+  // several readers each read their own ranges, the cache would only be in the way
+  unsigned int flags = READ_TRUNCATED;
+  if (m_readers > 1)
+    flags |= READ_NO_CACHE;
+
+  CFile source;
+  if (!source.Open(m_strSource, flags))
+    return false;
+  m_length = std::max<int64_t>(source.GetLength(), 0);
+
+  CStdString strPath = m_bResume ? GetPartialPath(m_strDest) : m_strDest;
+  m_start = 0;
+  if (m_bResume && m_length > 0)
+    m_start = GetResumePosition(source, strPath);
+
+  CFile dest;
+  if (!OpenDest(dest, strPath))
+    return false;
+
+  if (source.GetPosition() != m_start && source.Seek(m_start, SEEK_SET) != m_start)
+  {
+    // sources that don't seek back are opened again
+    source.Close();
+    if (m_start > 0 || !source.Open(m_strSource, flags))
+    {
+      dest.Close();
+      CFile::Delete(strPath);
+      return false;
+    }
+  }
+
+  vector<CFile*> files;
+  files.push_back(&source);
+  while (files.size() < m_readers && m_length - m_start > (int64_t)m_blockSize * (int64_t)files.size())
+  {
+    CFile* file = new CFile();
+    if (!file->Open(m_strSource, flags))
+    {
+      delete file;
+      break;
+    }
+    files.push_back(file);
+  }
+
+  m_blocks.resize(2 * files.size());
+  for (vector<SBlock>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+  {
+    it->data = new uint8_t[m_blockSize];
+    it->size = 0;
+    it->filled = false;
+    it->error = false;
+  }
+  m_nextRead = 0;
+  m_nextWrite = 0;
+  m_bEnd = false;
+  m_bAbort = false;
+  m_bUserAbort = false;
+
+  vector<CReader*> readers;
+  for (vector<CFile*>::iterator it = files.begin(); it != files.end(); ++it)
+    readers.push_back(new CReader(this, *it));
+
+  bool result = WriteBlocks(dest);
+
+  {
+    CSingleLock lock(m_section);
+    m_bAbort = true;
+    m_condition.notifyAll();
+  }
+  for (vector<CReader*>::iterator it = readers.begin(); it != readers.end(); ++it)
+    delete *it;
+  for (vector<CFile*>::iterator it = files.begin() + 1; it != files.end(); ++it)
+    delete *it;
+  for (vector<SBlock>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+    delete[] it->data;
+  m_blocks.clear();
+
+  /* close both files */
+  dest.Close();
+  source.Close();
+
+  bool keep = m_bResume && !m_bUserAbort && m_start + m_copied > 0;
+  if (result && m_bVerify)
+    result = keep = Verify(strPath);
+
+  if (result && strPath != m_strDest)
+  {
+    if (CFile::Exists(m_strDest))
+      CFile::Delete(m_strDest);
+    result = CFile::Rename(strPath, m_strDest);
+    if (!result)
+      CLog::Log(LOGERROR, "%s - Failed to rename %s to %s", __FUNCTION__, strPath.c_str(), m_strDest.c_str());
+  }
+
+  if (!result)
+  {
+    if (keep)
+      CLog::Log(LOGINFO, "%s - Keeping %"PRId64" bytes of %s to resume the copy", __FUNCTION__, m_start + m_copied, strPath.c_str());
+    else
+      CFile::Delete(strPath);
+  }
+  return result;
+}
+
+int64_t CFileCopy::GetResumePosition(CFile& source, const CStdString& strPath)
+{
+  struct __stat64 buffer;
+  if (CFile::Stat(strPath, &buffer) != 0 || buffer.st_size <= 0 || buffer.st_size > m_length)
+    return 0;
+  int64_t size = buffer.st_size;
+
+  // the end of what was copied has to match, else it's a copy of another file
+  unsigned int check = (unsigned int)std::min<int64_t>(size, RESUME_CHECK_SIZE);
+  vector<uint8_t> copied(check), original(check);
+  CFile partial;
+  if (!partial.Open(strPath, READ_NO_CACHE) ||
+      partial.Seek(size - check, SEEK_SET) != size - check ||
+      ReadFully(partial, &copied[0], check) != check)
+    return 0;
+  if (source.Seek(size - check, SEEK_SET) != size - check ||
+      ReadFully(source, &original[0], check) != check ||
+      memcmp(&copied[0], &original[0], check) != 0)
+  {
+    CLog::Log(LOGINFO, "%s - %s doesn't match %s, copying it again", __FUNCTION__, strPath.c_str(), m_strSource.c_str());
+    return 0;
+  }
+
+  CLog::Log(LOGINFO, "%s - Resuming the copy of %s at %"PRId64" of %"PRId64" bytes", __FUNCTION__, m_strSource.c_str(), size, m_length);
+  return size;
+}
+
+bool CFileCopy::OpenDest(CFile& dest, const CStdString& strPath)
+{
+  if (m_start > 0)
+  {
+    if (dest.OpenForWrite(strPath, false) && dest.Seek(m_start, SEEK_SET) == m_start)
+      return true;
+    dest.Close();
+    m_start = 0;
+  }
+
+  if (URIUtils::IsHD(strPath)) // create possible missing dirs
+  {
+    vector<CStdString> tokens;
+    CStdString strDirectory;
+    URIUtils::GetDirectory(strPath,strDirectory);
+    URIUtils::RemoveSlashAtEnd(strDirectory);  // for the test below
+    if (!(strDirectory.size() == 2 && strDirectory[1] == ':'))
+    {
+      CURL url(strDirectory);
+      CStdString pathsep;
+#ifndef _LINUX
+      pathsep = "\\";
+#else
+      pathsep = "/";
+#endif
+      CUtil::Tokenize(url.GetFileName(),tokens,pathsep.c_str());
+      CStdString strCurrPath;
+      // Handle special
+      if (!url.GetProtocol().IsEmpty()) {
+        pathsep = "/";
+        strCurrPath += url.GetProtocol() + "://";
+      } // If the directory has a / at the beginning, don't forget it
+      else if (strDirectory[0] == pathsep[0])
+        strCurrPath += pathsep;
+      for (vector<CStdString>::iterator iter=tokens.begin();iter!=tokens.end();++iter)
+      {
+        strCurrPath += *iter+pathsep;
+        CDirectory::Create(strCurrPath);
+      }
+    }
+  }
+  if (CFile::Exists(strPath))
+    CFile::Delete(strPath);
+  return dest.OpenForWrite(strPath, true);  // overwrite always
+}
+
+void CFileCopy::ReadBlocks(CFile* file)
+{
+  int64_t position = file->GetPosition();
+  while (true)
+  {
+    int64_t index;
+    {
+      CSingleLock lock(m_section);
+      // the ring holds the blocks between the writer and the readers
+      while (!m_bAbort && !m_bEnd && m_nextRead >= m_nextWrite + (int64_t)m_blocks.size())
+        m_condition.wait(lock);
+      if (m_bAbort || m_bEnd)
+        return;
+      if (m_length > 0 && m_start + m_nextRead * m_blockSize >= m_length)
+        return;
+      index = m_nextRead++;
+    }
+
+    SBlock& block = m_blocks[index % m_blocks.size()];
+    int64_t offset = m_start + index * m_blockSize;
+    unsigned int size = m_blockSize;
+    if (m_length > 0)
+      size = (unsigned int)std::min<int64_t>(size, m_length - offset);
+
+    bool error = false;
+    unsigned int total = 0;
+    if (position != offset)
+    {
+      position = file->Seek(offset, SEEK_SET);
+      error = position != offset;
+    }
+    while (!error && !m_bAbort && total < size)
+    {
+      unsigned int read = file->Read(block.data + total, size - total);
+      if (read == 0)
+        break;
+      total    += read;
+      position += read;
+    }
+
+    CSingleLock lock(m_section);
+    block.size   = total;
+    block.error  = error;
+    block.filled = true;
+    // nothing past a short block is needed, it's the end of the source
+    if (error || total < size || size < m_blockSize)
+      m_bEnd = true;
+    m_condition.notifyAll();
+  }
+}
+
+bool CFileCopy::WriteBlocks(CFile& dest)
+{
+  m_copied = 0;
+  m_lastProgress = 0.0f;
+  if (m_length > 0 && m_start >= m_length)
+    return true;
+
+  Crc32 crc;
+  crc.Reset();
+  CStopWatch timer;
+  timer.StartZero();
+
+  bool result = false;
+  while (true)
+  {
+    g_application.ResetScreenSaver();
+
+    SBlock* block;
+    {
+      CSingleLock lock(m_section);
+      block = &m_blocks[m_nextWrite % m_blocks.size()];
+      while (!block->filled)
+      {
+        // keep the progress going while the source is slow
+        if (m_condition.wait(lock, 500) || block->filled)
+          continue;
+        lock.Leave();
+        bool proceed = Progress(timer.GetElapsedSeconds());
+        lock.Enter();
+        if (!proceed)
+          break;
+      }
+      if (!block->filled || m_bUserAbort)
+        break;
+    }
+
+    if (block->error)
+    {
+      CLog::Log(LOGERROR, "%s - Failed read from file %s", __FUNCTION__, m_strSource.c_str());
+      break;
+    }
+
+    /* write data and make sure we managed to write it all */
+    unsigned int written = 0;
+    while (written < block->size)
+    {
+      int write = dest.Write(block->data + written, block->size - written);
+      if (write <= 0)
+        break;
+      written += write;
+    }
+    if (written != block->size)
+    {
+      CLog::Log(LOGERROR, "%s - Failed write to file %s", __FUNCTION__, m_strDest.c_str());
+      break;
+    }
+
+    if (m_bVerify)
+      crc.Compute((const char*)block->data, block->size);
+    m_copied += block->size;
+
+    bool last = block->size < m_blockSize || (m_length > 0 && m_start + m_copied >= m_length);
+    {
+      CSingleLock lock(m_section);
+      block->filled = false;
+      m_nextWrite++;
+      m_condition.notifyAll();
+    }
+
+    if (last)
+    {
+      /* verify that we managed to completed the file */
+      result = m_length == 0 || m_start + m_copied == m_length;
+      break;
+    }
+    if (!Progress(timer.GetElapsedSeconds()))
+      break;
+  }
+
+  m_crc = crc;
+  return result;
+}
+
+bool CFileCopy::Progress(float elapsed)
+{
+  if (!m_callback || elapsed - m_lastProgress <= 0.5f)
+    return true;
+  m_lastProgress = elapsed;
+
+  // calculate the average speed and the time left at it
+  float averageSpeed = m_copied / elapsed;
+  int ipercent = 0;
+  int secondsLeft = -1;
+  if (m_length > 0)
+  {
+    ipercent = (int)(100 * (m_start + m_copied) / m_length);
+    if (averageSpeed > 0.0f)
+      secondsLeft = (int)((m_length - m_start - m_copied) / averageSpeed);
+  }
+
+  if (!m_callback->OnFileProgress(m_context, ipercent, averageSpeed, secondsLeft))
+  {
+    CLog::Log(LOGERROR, "%s - User aborted copy", __FUNCTION__);
+    m_bUserAbort = true;
+    return false;
+  }
+  return true;
+}
+
+bool CFileCopy::Verify(const CStdString& strPath)
+{
+  CFile file;
+  if (!file.Open(strPath, READ_NO_CACHE) || file.Seek(m_start, SEEK_SET) != m_start)
+  {
+    CLog::Log(LOGERROR, "%s - Failed to open %s to verify it", __FUNCTION__, strPath.c_str());
+    return false;
+  }
+
+  Crc32 crc;
+  crc.Reset();
+  vector<char> buffer(m_blockSize);
+  int64_t total = 0;
+  unsigned int read;
+  while ((read = file.Read(&buffer[0], buffer.size())) > 0)
+  {
+    crc.Compute(&buffer[0], read);
+    total += read;
+  }
+
+  if (total != m_copied || (uint32_t)crc != m_crc)
+  {
+    CLog::Log(LOGERROR, "%s - Copy of %s doesn't match, %"PRId64" bytes crc %08x, wrote %"PRId64" bytes crc %08x",
+              __FUNCTION__, m_strSource.c_str(), total, (uint32_t)crc, m_copied, m_crc);
+    return false;
+  }
+  return true;
+}
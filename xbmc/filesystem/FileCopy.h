@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "utils/StdString.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace XFILE
+{
+  class CFile;
+  class IFileCallback;
+
+  /**
+   * Copies a file with its reads and writes overlapped. Reader threads fill a
+   * ring of blocks while the writer empties it in file order. Sources that
+   * seek cheaply can be read in ranges by several readers at once.
+   *
+   * With resume set the copy goes to the partial path first and is renamed
+   * when it is complete. A copy that fails leaves the partial file behind and
+   * the next copy to the same place carries on from its end.
+   */
+  class CFileCopy
+  {
+  public:
+    CFileCopy(const CStdString& strSource, const CStdString& strDest);
+    ~CFileCopy();
+
+    void SetCallback(IFileCallback* callback, void* context);
+    /* readers past the first read the source through files of their own */
+    void SetReaders(unsigned int readers) { m_readers = readers; }
+    /* reads the copy back and compares its crc with what was written */
+    void SetVerify(bool verify)           { m_bVerify = verify; }
+    void SetResume(bool resume)           { m_bResume = resume; }
+    void SetBlockSize(unsigned int size)  { m_blockSize = size; }
+
+    bool Copy();
+
+    /* bytes written, a resumed copy doesn't count what it resumed from */
+    int64_t  GetBytesCopied() const { return m_copied; }
+    int64_t  GetResumedFrom() const { return m_start; }
+    uint32_t GetCRC() const         { return m_crc; }
+
+    static CStdString GetPartialPath(const CStdString& strDest);
+
+  private:
+    class CReader;
+    friend class CReader;
+
+    struct SBlock
+    {
+      uint8_t*     data;
+      unsigned int size;
+      bool         filled;
+      bool         error;
+    };
+
+    bool    OpenDest(CFile& dest, const CStdString& strPath);
+    int64_t GetResumePosition(CFile& source, const CStdString& strPath);
+    bool    Verify(const CStdString& strPath);
+    void    ReadBlocks(CFile* file);
+    bool    WriteBlocks(CFile& dest);
+    bool    Progress(float elapsed);
+
+    CStdString     m_strSource;
+    CStdString     m_strDest;
+    IFileCallback* m_callback;
+    void*          m_context;
+    unsigned int   m_readers;
+    unsigned int   m_blockSize;
+    bool           m_bVerify;
+    bool           m_bResume;
+
+    CCriticalSection               m_section;
+    XbmcThreads::ConditionVariable m_condition;
+    std::vector<SBlock> m_blocks;
+    int64_t  m_nextRead;  // block the next reader takes
+    int64_t  m_nextWrite; // block the writer waits for
+    bool     m_bEnd;      // a reader hit the end of the source
+    bool     m_bAbort;
+
+    int64_t  m_length;    // of the source, 0 when it isn't known
+    int64_t  m_start;     // where the copy started, past the resumed part
+    int64_t  m_copied;
+    uint32_t m_crc;
+    float    m_lastProgress;
+    bool     m_bUserAbort;
+  };
+}
@@ -0,0 +1,273 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileReadRequest.h"
+#include "IFile.h"
+#include "threads/SingleLock.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace XFILE;
+
+namespace
+{
+  class CFileReadJob : public CJob
+  {
+  public:
+    CFileReadJob(IFile* file, CFileReadRequest* request)
+      : m_file(file), m_request(request)
+    {
+    }
+
+    virtual const char* GetType() const { return "fileread"; }
+
+    // the job queue finds its jobs with this. a request that is queued again
+    // right after it completed is a new read, even while the job queue still
+    // holds the job of the last one
+    virtual bool operator==(const CJob* job) const
+    {
+      return job == this;
+    }
+
+    virtual bool DoWork()
+    {
+      int result = m_file->ReadAt(m_request->GetBuffer(), m_request->GetSize(), m_request->GetOffset());
+      m_request->Complete(result);
+      return result >= 0;
+    }
+
+  private:
+    IFile*            m_file;
+    CFileReadRequest* m_request;
+  };
+}
+
+CFileReadRequest::CFileReadRequest()
+  : m_done(true, true)
+{
+  Set(NULL, 0, 0);
+}
+
+CFileReadRequest::CFileReadRequest(void* buffer, unsigned int size, int64_t offset, IFileReadCallback* callback)
+  : m_done(true, true)
+{
+  Set(buffer, size, offset, callback);
+}
+
+void CFileReadRequest::Set(void* buffer, unsigned int size, int64_t offset, IFileReadCallback* callback)
+{
+  m_buffer   = buffer;
+  m_size     = size;
+  m_offset   = offset;
+  m_callback = callback;
+  m_result   = -1;
+}
+
+bool CFileReadRequest::IsComplete()
+{
+  return m_done.WaitMSec(0);
+}
+
+bool CFileReadRequest::Wait(unsigned int milliSeconds)
+{
+  return m_done.WaitMSec(milliSeconds);
+}
+
+void CFileReadRequest::Wait()
+{
+  m_done.Wait();
+}
+
+void CFileReadRequest::Queued()
+{
+  m_result = -1;
+  m_done.Reset();
+}
+
+void CFileReadRequest::Complete(int result)
+{
+  m_result = result;
+  if (m_callback)
+    m_callback->OnReadComplete(this);
+  // the request may be gone once it's set
+  m_done.Set();
+}
+
+CFileReadQueue::CFileReadQueue(IFile* file, unsigned int readsAtOnce)
+  : CJobQueue(false, readsAtOnce, CJob::PRIORITY_NORMAL),
+    m_file(file), m_pending(0), m_idle(true, true)
+{
+}
+
+CFileReadQueue::~CFileReadQueue()
+{
+  WaitIdle();
+}
+
+void CFileReadQueue::Add(CFileReadRequest* request)
+{
+  {
+    CSingleLock lock(m_pendingSection);
+    if (m_pending++ == 0)
+      m_idle.Reset();
+  }
+  request->Queued();
+  AddJob(new CFileReadJob(m_file, request));
+}
+
+void CFileReadQueue::WaitIdle()
+{
+  while (true)
+  {
+    // the last job leaves the section after it set the event, take it so
+    // the queue isn't destroyed under it
+    CSingleLock lock(m_pendingSection);
+    if (m_pending == 0)
+      return;
+    lock.Leave();
+    m_idle.Wait();
+  }
+}
+
+unsigned int CFileReadQueue::GetPending()
+{
+  CSingleLock lock(m_pendingSection);
+  return m_pending;
+}
+
+void CFileReadQueue::OnJobComplete(unsigned int jobID, bool success, CJob* job)
+{
+  CJobQueue::OnJobComplete(jobID, success, job);
+
+  CSingleLock lock(m_pendingSection);
+  if (--m_pending == 0)
+    m_idle.Set();
+}
+
+CFileReadPipeline::CFileReadPipeline(IFile* file, unsigned int depth, unsigned int chunkSize)
+  : m_file(file), m_queue(file, std::max(depth, 1U)),
+    m_depth(std::max(depth, 1U)), m_chunkSize(chunkSize),
+    m_position(0), m_next(0), m_length(0), m_eof(false)
+{
+}
+
+CFileReadPipeline::~CFileReadPipeline()
+{
+  Reset();
+  for (std::vector<SChunk*>::iterator it = m_free.begin(); it != m_free.end(); ++it)
+  {
+    delete[] (*it)->buffer;
+    delete *it;
+  }
+}
+
+void CFileReadPipeline::Reset()
+{
+  m_queue.WaitIdle();
+  while (!m_chunks.empty())
+  {
+    m_free.push_back(m_chunks.front());
+    m_chunks.pop_front();
+  }
+  m_next = m_position;
+}
+
+void CFileReadPipeline::Fill()
+{
+  while (m_chunks.size() < m_depth && !m_eof && (m_length <= 0 || m_next < m_length))
+  {
+    SChunk* chunk;
+    if (m_free.empty())
+    {
+      chunk = new SChunk;
+      chunk->buffer = new uint8_t[m_chunkSize];
+    }
+    else
+    {
+      chunk = m_free.back();
+      m_free.pop_back();
+    }
+
+    unsigned int size = m_chunkSize;
+    if (m_length > 0 && m_next + size > m_length)
+      size = (unsigned int)(m_length - m_next);
+
+    chunk->consumed = 0;
+    chunk->request.Set(chunk->buffer, size, m_next);
+    m_queue.Add(&chunk->request);
+    m_chunks.push_back(chunk);
+    m_next += size;
+  }
+}
+
+int CFileReadPipeline::Read(void* lpBuf, unsigned int uiBufSize, int64_t position)
+{
+  if (position != m_position)
+  {
+    Reset();
+    m_position = m_next = position;
+    m_eof = false;
+  }
+  if (m_chunks.empty())
+    m_length = m_file->GetLength();
+
+  unsigned int total = 0;
+  while (total < uiBufSize)
+  {
+    Fill();
+    if (m_chunks.empty())
+      break;
+
+    // hand out what is there rather than wait on the link
+    SChunk* chunk = m_chunks.front();
+    if (total > 0 && !chunk->request.IsComplete())
+      break;
+    chunk->request.Wait();
+
+    int result = chunk->request.GetResult();
+    if (result < 0)
+    {
+      // the next read starts over from here
+      Reset();
+      return total > 0 ? (int)total : -1;
+    }
+
+    unsigned int size = std::min(uiBufSize - total, (unsigned int)result - chunk->consumed);
+    memcpy((uint8_t*)lpBuf + total, chunk->buffer + chunk->consumed, size);
+    chunk->consumed += size;
+    total           += size;
+    m_position      += size;
+
+    if (chunk->consumed == (unsigned int)result)
+    {
+      m_chunks.pop_front();
+      m_free.push_back(chunk);
+      // a short read is the end of the file, or the chunks after it are off
+      if ((unsigned int)result < chunk->request.GetSize())
+      {
+        Reset();
+        if (result == 0)
+          m_eof = true;
+      }
+    }
+  }
+  return (int)total;
+}
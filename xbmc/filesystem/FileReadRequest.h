@@ -0,0 +1,149 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "utils/JobManager.h"
+
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+namespace XFILE
+{
+  class IFile;
+  class CFileReadRequest;
+
+  class IFileReadCallback
+  {
+  public:
+    virtual ~IFileReadCallback() {}
+    /* called on the thread that did the read, before the request is marked complete */
+    virtual void OnReadComplete(CFileReadRequest* request) = 0;
+  };
+
+  /**
+   * A read at an offset of a file, queued with IFile::ReadAsync. The request
+   * and its buffer must stay valid until it is complete, which the callback
+   * and Wait tell. A complete request can be set up and queued again.
+   */
+  class CFileReadRequest
+  {
+  public:
+    CFileReadRequest();
+    CFileReadRequest(void* buffer, unsigned int size, int64_t offset, IFileReadCallback* callback = NULL);
+
+    void Set(void* buffer, unsigned int size, int64_t offset, IFileReadCallback* callback = NULL);
+
+    void*        GetBuffer() const { return m_buffer; }
+    unsigned int GetSize() const   { return m_size; }
+    int64_t      GetOffset() const { return m_offset; }
+    /* bytes read, 0 at the end of the file, -1 on errors */
+    int          GetResult() const { return m_result; }
+
+    bool IsComplete();
+    /* waits for the request to complete, returns false on timeout */
+    bool Wait(unsigned int milliSeconds);
+    void Wait();
+
+    /* called by the file when it takes the request and when it's done with it */
+    void Queued();
+    void Complete(int result);
+
+  private:
+    void*              m_buffer;
+    unsigned int       m_size;
+    int64_t            m_offset;
+    int                m_result;
+    IFileReadCallback* m_callback;
+    CEvent             m_done;
+  };
+
+  /**
+   * Runs the async reads of a file on the job manager through its ReadAt.
+   * Files that read at an offset without moving their position run several
+   * reads at once, others one after the other.
+   */
+  class CFileReadQueue : public CJobQueue
+  {
+  public:
+    CFileReadQueue(IFile* file, unsigned int readsAtOnce);
+    virtual ~CFileReadQueue();
+
+    void Add(CFileReadRequest* request);
+    /* waits for all added requests to complete */
+    void WaitIdle();
+    unsigned int GetPending();
+
+    virtual void OnJobComplete(unsigned int jobID, bool success, CJob* job);
+
+  private:
+    IFile*           m_file;
+    CCriticalSection m_pendingSection;
+    unsigned int     m_pending;
+    CEvent           m_idle;
+  };
+
+  /**
+   * Reads a file ahead in chunks with several reads outstanding, so files
+   * that wait a round trip for every read keep the link busy while the caller
+   * works through the data it got. The file must implement ReadAt, it's read
+   * from as many threads as there are reads outstanding.
+   */
+  class CFileReadPipeline
+  {
+  public:
+    CFileReadPipeline(IFile* file, unsigned int depth, unsigned int chunkSize);
+    ~CFileReadPipeline();
+
+    /* reads from position on, the pipeline restarts when the position isn't
+     * where the last read ended. returns the bytes read, 0 at the end of the
+     * file and -1 on errors */
+    int Read(void* lpBuf, unsigned int uiBufSize, int64_t position);
+    /* waits for the outstanding reads and drops what was read ahead */
+    void Reset();
+
+    unsigned int GetDepth() const     { return m_depth; }
+    unsigned int GetChunkSize() const { return m_chunkSize; }
+
+  private:
+    struct SChunk
+    {
+      CFileReadRequest request;
+      uint8_t*         buffer;
+      unsigned int     consumed;
+    };
+
+    void Fill();
+
+    IFile*              m_file;
+    CFileReadQueue      m_queue;
+    unsigned int        m_depth;
+    unsigned int        m_chunkSize;
+    std::deque<SChunk*> m_chunks; // outstanding or unconsumed, in file order
+    std::vector<SChunk*> m_free;
+    int64_t             m_position; // where the data of the first chunk is consumed to
+    int64_t             m_next;     // offset of the next chunk to read
+    int64_t             m_length;
+    bool                m_eof;
+  };
+}
@@ -20,6 +20,7 @@
 
 #include "system.h"
 #include "HDFile.h"
+#include "FileReadRequest.h"
 #include "Util.h"
 #include "URL.h"
 #include "utils/AliasShortcutUtils.h"
@@ -30,16 +31,40 @@
 #include <sys/stat.h>
 #ifdef _LINUX
 #include <sys/ioctl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(TARGET_LINUX) && !defined(TARGET_ANDROID)
+#define HAS_POSIX_AIO
+#include <aio.h>
+#endif
 #else
 #include <io.h>
 #include "utils/CharsetConverter.h"
 #include "utils/URIUtils.h"
 #endif
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 
 
 using namespace XFILE;
 
+#ifdef _LINUX
+// the part of a mapped file that is mapped at once, so big files fit 32bit
+// address spaces, and how far ahead of the position the kernel reads
+#define MMAP_WINDOW    (64 * 1024 * 1024)
+#define MMAP_READAHEAD (4 * 1024 * 1024)
+
+struct CHDFile::SAioRead
+{
+#ifdef HAS_POSIX_AIO
+  struct aiocb      cb;
+#endif
+  CFileReadRequest* request;
+  CHDFile*          file;
+};
+#endif
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -47,6 +72,15 @@ using namespace XFILE;
 //*********************************************************************************************
 CHDFile::CHDFile()
     : m_hFile(INVALID_HANDLE_VALUE)
+#ifdef _LINUX
+    , m_bMapped(false)
+    , m_map(NULL)
+    , m_mapOffset(0)
+    , m_mapSize(0)
+    , m_mapAdvised(0)
+    , m_aioPending(0)
+    , m_aioIdle(true, true)
+#endif
 {}
 
 //*********************************************************************************************
@@ -100,6 +134,10 @@ bool CHDFile::Open(const CURL& url)
 
   m_i64FilePos = 0;
   m_i64FileLen = 0;
+#ifdef _LINUX
+  Unmap();
+  m_bMapped = false;
+#endif
 
   return true;
 }
@@ -203,6 +241,23 @@ bool CHDFile::OpenForWrite(const CURL& url, bool bOverWrite)
 unsigned int CHDFile::Read(void *lpBuf, int64_t uiBufSize)
 {
   if (!m_hFile.isValid()) return 0;
+#ifdef _LINUX
+  if (m_bMapped)
+  {
+    unsigned int total = 0;
+    while (total < uiBufSize)
+    {
+      const void* data;
+      int available = Peek(&data, (unsigned int)std::min<int64_t>(uiBufSize - total, INT_MAX));
+      if (available <= 0)
+        break;
+      memcpy((char*)lpBuf + total, data, available);
+      Consume(available);
+      total += available;
+    }
+    return total;
+  }
+#endif
   DWORD nBytesRead;
   if ( ReadFile((HANDLE)m_hFile, lpBuf, (DWORD)uiBufSize, &nBytesRead, NULL) )
   {
@@ -228,12 +283,216 @@ int CHDFile::Write(const void *lpBuf, int64_t uiBufSize)
 //*********************************************************************************************
 void CHDFile::Close()
 {
+  WaitAsync();
+#ifdef _LINUX
+  Unmap();
+  m_bMapped = false;
+#endif
   m_hFile.reset();
 }
 
+#ifdef _LINUX
+//*********************************************************************************************
+bool CHDFile::MapWindow(int64_t iPosition)
+{
+  if (m_map && iPosition >= m_mapOffset && iPosition < m_mapOffset + (int64_t)m_mapSize)
+    return true;
+
+  Unmap();
+  int64_t length = GetLength();
+  if (iPosition >= length)
+    return true; // nothing to map at the end of the file
+
+  static const int64_t page = sysconf(_SC_PAGESIZE);
+  int64_t offset = iPosition - iPosition % page;
+  size_t  size   = (size_t)std::min<int64_t>(MMAP_WINDOW, length - offset);
+  void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, (*m_hFile).fd, (off_t)offset);
+  if (map == MAP_FAILED)
+  {
+    CLog::Log(LOGERROR, "%s - mmap of %"PRIuS" bytes at %"PRId64" failed (%d)", __FUNCTION__, size, offset, errno);
+    return false;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  m_map        = (uint8_t*)map;
+  m_mapOffset  = offset;
+  m_mapSize    = size;
+  m_mapAdvised = offset;
+  return true;
+}
+
+//*********************************************************************************************
+void CHDFile::Unmap()
+{
+  if (m_map)
+    munmap(m_map, m_mapSize);
+  m_map = NULL;
+  m_mapOffset = 0;
+  m_mapSize = 0;
+}
+
+//*********************************************************************************************
+void CHDFile::ReadAhead()
+{
+  // ask for the next part once the position is half way through the last
+  int64_t end = std::min<int64_t>(m_i64FilePos + MMAP_READAHEAD, m_mapOffset + m_mapSize);
+  if (m_i64FilePos + MMAP_READAHEAD / 2 < m_mapAdvised || end <= m_mapAdvised)
+    return;
+
+  static const int64_t page = sysconf(_SC_PAGESIZE);
+  int64_t start = std::max(m_mapAdvised, m_i64FilePos);
+  start -= (start - m_mapOffset) % page;
+  madvise(m_map + (start - m_mapOffset), (size_t)(end - start), MADV_WILLNEED);
+  m_mapAdvised = end;
+}
+
+//*********************************************************************************************
+int CHDFile::Peek(const void** lpBuf, unsigned int uiBufSize)
+{
+  if (!m_bMapped || !MapWindow(m_i64FilePos))
+    return -1;
+  if (!m_map)
+    return 0;
+
+  ReadAhead();
+  size_t offset = (size_t)(m_i64FilePos - m_mapOffset);
+  *lpBuf = m_map + offset;
+  return (int)std::min<size_t>(uiBufSize, m_mapSize - offset);
+}
+
+//*********************************************************************************************
+void CHDFile::Consume(unsigned int uiSize)
+{
+  if (m_bMapped)
+    m_i64FilePos += uiSize;
+}
+
+//*********************************************************************************************
+int CHDFile::ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset)
+{
+  if (!m_hFile.isValid()) return -1;
+
+  unsigned int total = 0;
+  while (total < uiBufSize)
+  {
+    ssize_t read = pread((*m_hFile).fd, (char*)lpBuf + total, uiBufSize - total, (off_t)(iOffset + total));
+    if (read < 0 && errno == EINTR)
+      continue;
+    if (read < 0)
+      return -1;
+    if (read == 0)
+      break;
+    total += read;
+  }
+  return (int)total;
+}
+
+//*********************************************************************************************
+bool CHDFile::ReadAsync(CFileReadRequest* request)
+{
+  if (!m_hFile.isValid()) return false;
+
+#ifdef HAS_POSIX_AIO
+  // let the kernel read, it completes on a thread of the aio implementation
+  SAioRead* aio = new SAioRead;
+  memset(&aio->cb, 0, sizeof(aio->cb));
+  aio->cb.aio_fildes = (*m_hFile).fd;
+  aio->cb.aio_buf    = request->GetBuffer();
+  aio->cb.aio_nbytes = request->GetSize();
+  aio->cb.aio_offset = (off_t)request->GetOffset();
+  aio->cb.aio_sigevent.sigev_notify = SIGEV_THREAD;
+  aio->cb.aio_sigevent.sigev_notify_function = OnAioComplete;
+  aio->cb.aio_sigevent.sigev_value.sival_ptr = aio;
+  aio->request = request;
+  aio->file    = this;
+
+  {
+    CSingleLock lock(m_aioSection);
+    if (m_aioPending++ == 0)
+      m_aioIdle.Reset();
+  }
+  request->Queued();
+  if (aio_read(&aio->cb) == 0)
+    return true;
+
+  CLog::Log(LOGDEBUG, "%s - aio_read failed (%d), using positioned reads", __FUNCTION__, errno);
+  delete aio;
+  CSingleLock lock(m_aioSection);
+  if (--m_aioPending == 0)
+    m_aioIdle.Set();
+  lock.Leave();
+#endif
+
+  // reads at an offset on the job manager
+  return IFile::ReadAsync(request);
+}
+
+//*********************************************************************************************
+void CHDFile::OnAioComplete(union sigval value)
+{
+  SAioRead* aio = (SAioRead*)value.sival_ptr;
+  CHDFile* file = aio->file;
+
+  int result = -1;
+#ifdef HAS_POSIX_AIO
+  if (aio_error(&aio->cb) == 0)
+    result = (int)aio_return(&aio->cb);
+  else
+    aio_return(&aio->cb);
+#endif
+  aio->request->Complete(result);
+  delete aio;
+
+  CSingleLock lock(file->m_aioSection);
+  if (--file->m_aioPending == 0)
+    file->m_aioIdle.Set();
+}
+
+//*********************************************************************************************
+void CHDFile::WaitAsync()
+{
+  while (true)
+  {
+    CSingleLock lock(m_aioSection);
+    if (m_aioPending == 0)
+      break;
+    lock.Leave();
+    m_aioIdle.Wait();
+  }
+  IFile::WaitAsync();
+}
+#endif
+
 //*********************************************************************************************
 int64_t CHDFile::Seek(int64_t iFilePosition, int iWhence)
 {
+#ifdef _LINUX
+  if (m_bMapped)
+  {
+    // the handle isn't read from, only the position moves
+    int64_t position;
+    switch (iWhence)
+    {
+    case SEEK_SET:
+      position = iFilePosition;
+      break;
+    case SEEK_CUR:
+      position = m_i64FilePos + iFilePosition;
+      break;
+    case SEEK_END:
+      m_i64FileLen = 0;
+      position = GetLength() + iFilePosition;
+      break;
+    default:
+      return -1;
+    }
+    if (position < 0)
+      return -1;
+    m_i64FilePos = position;
+    return m_i64FilePos;
+  }
+#endif
+
   LARGE_INTEGER lPos, lNewPos;
   lPos.QuadPart = iFilePosition;
   int bSuccess;
@@ -326,6 +585,14 @@ int CHDFile::IoControl(EIoControl request, void* param)
     SNativeIoControl* s = (SNativeIoControl*)param;
     return ioctl((*m_hFile).fd, s->request, s->param);
   }
+  if(request == IOCTRL_MMAP && m_hFile.isValid())
+  {
+    m_bMapped = true;
+    if (MapWindow(m_i64FilePos))
+      return 0;
+    m_bMapped = false;
+    return -1;
+  }
 #endif
   return -1;
 }
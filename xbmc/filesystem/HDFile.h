@@ -30,7 +30,12 @@
 #endif // _MSC_VER > 1000
 
 #include "IFile.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include "utils/AutoPtrHandle.h"
+#ifdef _LINUX
+#include <signal.h>
+#endif
 
 namespace XFILE
 {
@@ -59,11 +64,40 @@ public:
   virtual bool SetHidden(const CURL& url, bool hidden);
 
   virtual int IoControl(EIoControl request, void* param);
+
+#ifdef _LINUX
+  virtual int  Peek(const void** lpBuf, unsigned int uiBufSize);
+  virtual void Consume(unsigned int uiSize);
+
+  virtual bool ReadAsync(CFileReadRequest* request);
+  virtual void WaitAsync();
+  virtual int  ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset);
+  virtual bool CanReadAt() { return true; }
+#endif
 protected:
   CStdString GetLocal(const CURL &url); /* crate a properly format path from an url */
   AUTOPTR::CAutoPtrHandle m_hFile;
   int64_t m_i64FilePos;
   int64_t m_i64FileLen;
+
+#ifdef _LINUX
+  bool MapWindow(int64_t iPosition);
+  void Unmap();
+  void ReadAhead();
+
+  bool     m_bMapped;    // reads go through a window of the file mapped into memory
+  uint8_t* m_map;        // the window, NULL at the end of the file
+  int64_t  m_mapOffset;
+  size_t   m_mapSize;
+  int64_t  m_mapAdvised; // the kernel was asked to read ahead up to here
+
+  struct SAioRead;
+  static void OnAioComplete(union sigval value);
+
+  CCriticalSection m_aioSection;
+  unsigned int     m_aioPending; // kernel reads that haven't completed
+  CEvent           m_aioIdle;
+#endif
 };
 
 }
@@ -20,6 +20,8 @@
 
 
 #include "IDirectory.h"
+#include "File.h"
+#include "FileItem.h"
 #include "Util.h"
 #include "dialogs/GUIDialogOK.h"
 #include "guilib/GUIKeyboardFactory.h"
@@ -107,6 +109,59 @@ void IDirectory::SetFlags(int flags)
   m_flags = flags;
 }
 
+bool IDirectory::StatFiles(const CStdString& strPath, const std::vector<CStdString>& files,
+                           std::vector<SFileStat>& results, CFileItemList& items)
+{
+  results.assign(files.size(), SFileStat());
+  for (unsigned int i = 0; i < files.size(); i++)
+  {
+    // not every filesystem can stat, all of them can tell whether a file exists
+    if (CFile::Stat(files[i], &results[i].stat) == 0)
+      results[i].exists = true;
+    else
+      results[i].exists = CFile::Exists(files[i], false);
+  }
+  return false;
+}
+
+bool IDirectory::StatFromListing(const CStdString& strPath, const std::vector<CStdString>& files,
+                                 std::vector<SFileStat>& results, CFileItemList& items)
+{
+  items.Clear();
+  items.SetPath(strPath);
+  if (!GetDirectory(strPath, items))
+  {
+    items.Clear();
+    return IDirectory::StatFiles(strPath, files, results, items);
+  }
+
+  items.SetFastLookup(true);
+  results.assign(files.size(), SFileStat());
+  for (unsigned int i = 0; i < files.size(); i++)
+  {
+    CFileItemPtr item = items.Get(files[i]);
+    if (item)
+    {
+      results[i].exists = true;
+      StatFromItem(*item, results[i].stat);
+    }
+  }
+  return true;
+}
+
+void IDirectory::StatFromItem(const CFileItem& item, struct __stat64& buffer)
+{
+  memset(&buffer, 0, sizeof(buffer));
+  buffer.st_size = item.m_dwSize;
+  buffer.st_mode = item.m_bIsFolder ? _S_IFDIR : _S_IFREG;
+  if (item.m_dateTime.IsValid())
+  {
+    time_t time;
+    item.m_dateTime.GetAsTime(time);
+    buffer.st_mtime = buffer.st_ctime = buffer.st_atime = time;
+  }
+}
+
 bool IDirectory::ProcessRequirements()
 {
   CStdString type = m_requirements["type"].asString();
@@ -22,6 +22,15 @@
 #include "utils/StdString.h"
 #include "utils/Variant.h"
 
+#ifdef _LINUX
+#include "PlatformDefs.h" // for __stat64
+#endif
+
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+class CFileItem;
 class CFileItemList;
 
 namespace XFILE
@@ -47,6 +56,17 @@ namespace XFILE
     DIR_FLAG_READ_CACHE    = (2 << 4), ///< Force reading from the directory cache (if available)
     DIR_FLAG_BYPASS_CACHE  = (2 << 5)  ///< Completely bypass the directory cache (no reading, no writing)
   };
+
+  /*! \brief Result for one file of a batched stat, see IDirectory::StatFiles */
+  struct SFileStat
+  {
+    SFileStat() : exists(false)
+    {
+      memset(&stat, 0, sizeof(stat));
+    }
+    bool exists;
+    struct __stat64 stat;
+  };
 /*!
  \ingroup filesystem
  \brief Interface to the directory on a file system.
@@ -114,6 +134,21 @@ public:
   */
   virtual DIR_CACHE_TYPE GetCacheType(const CStdString& strPath) const { return DIR_CACHE_ONCE; };
 
+  /*!
+  \brief Check for existence of, and stat, a number of files in one directory
+  The default implementation checks the files one by one. Filesystems where every
+  check is a round trip to a server should answer from one listing of the directory
+  instead, using StatFromListing.
+  \param strPath Directory holding the files.
+  \param files Full paths of the files, all directly inside \e strPath.
+  \param results Retrieves one result per file, in the same order.
+  \param items Retrieves the listing of \e strPath, if the results came from one.
+  \return Returns \e true, if the results came from a listing of \e strPath.
+  \sa CDirectory::StatFiles
+  */
+  virtual bool StatFiles(const CStdString& strPath, const std::vector<CStdString>& files,
+                         std::vector<SFileStat>& results, CFileItemList& items);
+
   void SetMask(const CStdString& strMask);
   void SetFlags(int flags);
 
@@ -126,7 +161,17 @@ public:
    */
   bool ProcessRequirements();
 
+  /*! \brief Fill a stat buffer from an item of a directory listing */
+  static void StatFromItem(const CFileItem& item, struct __stat64& buffer);
+
 protected:
+  /*! \brief Implementation of StatFiles for filesystems that list a directory in one round trip.
+   Falls back to checking the files one by one if the directory can't be listed.
+   \sa StatFiles
+   */
+  bool StatFromListing(const CStdString& strPath, const std::vector<CStdString>& files,
+                       std::vector<SFileStat>& results, CFileItemList& items);
+
   /*! \brief Prompt the user for some keyboard input
    Call this method from the GetDirectory method to retrieve additional input from the user.
    If this function returns false then no input has been received, and the GetDirectory call
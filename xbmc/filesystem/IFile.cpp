@@ -19,6 +19,7 @@
 */
 
 #include "IFile.h"
+#include "FileReadRequest.h"
 #include "URL.h"
 #include <cstring>
 #include <errno.h>
@@ -31,10 +32,12 @@ using namespace XFILE;
 
 IFile::IFile()
 {
+  m_readQueue = NULL;
 }
 
 IFile::~IFile()
 {
+  delete m_readQueue;
 }
 
 int IFile::Stat(struct __stat64* buffer)
@@ -90,6 +93,37 @@ bool IFile::ReadString(char *szLine, int iLineLength)
   return true;
 }
 
+bool IFile::ReadAsync(CFileReadRequest* request)
+{
+  if (!m_readQueue)
+    m_readQueue = new CFileReadQueue(this, CanReadAt() ? 4 : 1);
+  m_readQueue->Add(request);
+  return true;
+}
+
+void IFile::WaitAsync()
+{
+  if (m_readQueue)
+    m_readQueue->WaitIdle();
+}
+
+int IFile::ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset)
+{
+  if (Seek(iOffset, SEEK_SET) != iOffset)
+    return -1;
+
+  // read the full size unless the file ends, like a positioned read would
+  unsigned int total = 0;
+  while (total < uiBufSize)
+  {
+    unsigned int read = Read((char*)lpBuf + total, uiBufSize - total);
+    if (read == 0)
+      break;
+    total += read;
+  }
+  return (int)total;
+}
+
 CRedirectException::CRedirectException() : 
   m_pNewFileImp(NULL), m_pNewUrl(NULL)
 {
@@ -44,6 +44,9 @@ class CURL;
 namespace XFILE
 {
 
+class CFileReadRequest;
+class CFileReadQueue;
+
 class IFile
 {
 public:
@@ -81,7 +84,33 @@ public:
 
   virtual int IoControl(EIoControl request, void* param) { return -1; }
 
+  /* For files mapped into memory with IOCTRL_MMAP. Points lpBuf at up to  *
+   * uiBufSize bytes at the position without copying them, they are valid *
+   * until the next call on the file. Consume moves the position past the  *
+   * bytes used. Returns the bytes available, 0 at the end of the file or  *
+   * -1 if the file isn't mapped.                                          */
+  virtual int  Peek(const void** lpBuf, unsigned int uiBufSize) { return -1; }
+  virtual void Consume(unsigned int uiSize) { }
+
   virtual CStdString GetContent()                            { return "application/octet-stream"; }
+
+  /* Queues a read of the request's size at its offset, it completes on     *
+   * another thread. Several requests can be outstanding, the file must     *
+   * not be closed before WaitAsync returned. Files that can read at an     *
+   * offset without moving their position read the requests at once, the   *
+   * others read them one after the other with Seek and Read, their         *
+   * position is undefined after that and their blocking calls must not be *
+   * used while requests are outstanding.                                   */
+  virtual bool ReadAsync(CFileReadRequest* request);
+  virtual void WaitAsync();
+
+  /* Reads at an offset for the async reads, returns -1 on errors. Files   *
+   * that implement it with a positioned read return true from CanReadAt.  */
+  virtual int  ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset);
+  virtual bool CanReadAt() { return false; }
+
+protected:
+  CFileReadQueue* m_readQueue;
 };
 
 class CRedirectException
@@ -35,6 +35,8 @@ struct SCacheStatus
   unsigned maxrate;  /**< maximum number of bytes per second cache is allowed to fill */
   unsigned currate;  /**< average read rate from source file since last position change */
   bool     full;     /**< is the cache full */
+  unsigned consumerate; /**< average rate data is read out of the cache, over the last seconds */
+  uint64_t readahead;   /**< number of bytes the cache aims to keep forward of current position, 0 if not limited */
 };
 
 typedef enum {
@@ -43,6 +45,7 @@ typedef enum {
   IOCTRL_CACHE_STATUS  = 3, /**< SCacheStatus structure */
   IOCTRL_CACHE_SETRATE = 4, /**< unsigned int with speed limit for caching in bytes per second */
   IOCTRL_SET_CACHE    = 8, /** <CFileCache */
+  IOCTRL_MMAP          = 9, /**< map the file into memory for Peek and Consume, returns 0 if it is mapped */
 } EIoControl;
 
 }
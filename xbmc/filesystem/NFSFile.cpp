@@ -603,6 +603,24 @@ unsigned int CNFSFile::Read(void *lpBuf, int64_t uiBufSize)
   return (unsigned int)numberOfBytesRead;
 }
 
+int CNFSFile::ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset)
+{
+  int numberOfBytesRead = 0;
+  CSingleLock lock(gNfsConnection);
+
+  if (m_pFileHandle == NULL || m_pNfsContext == NULL ) return -1;
+
+  numberOfBytesRead = gNfsConnection.GetImpl()->nfs_pread(m_pNfsContext, m_pFileHandle, iOffset, uiBufSize, (char *)lpBuf);
+
+  lock.Leave();//no need to keep the connection lock after that
+
+  gNfsConnection.resetKeepAlive(m_pFileHandle);//triggers keep alive timer reset for this filehandle
+
+  if (numberOfBytesRead < 0)
+    CLog::Log(LOGERROR, "%s - Error( %d, %s )", __FUNCTION__, numberOfBytesRead, gNfsConnection.GetImpl()->nfs_get_error(m_pNfsContext));
+  return numberOfBytesRead;
+}
+
 int64_t CNFSFile::Seek(int64_t iFilePosition, int iWhence)
 {
   int ret = 0;
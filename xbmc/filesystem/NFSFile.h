@@ -143,6 +143,10 @@ namespace XFILE
     virtual bool OpenForWrite(const CURL& url, bool bOverWrite = false);
     virtual bool Delete(const CURL& url);
     virtual bool Rename(const CURL& url, const CURL& urlnew);    
+
+    //reads at an offset with nfs_pread, the async reads don't touch the file position
+    virtual int  ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset);
+    virtual bool CanReadAt() { return true; }
   protected:
     CURL m_url;
     bool IsValidFile(const CStdString& strFileName);
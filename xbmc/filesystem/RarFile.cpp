@@ -127,6 +127,7 @@ CRarFile::CRarFile()
   m_szStartOfBuffer = NULL;
   m_iDataInBuffer = 0;
   m_bUseFile = false;
+  m_bUseStored = false;
   m_bOpen = false;
   m_bSeekable = true;
 }
@@ -142,6 +143,8 @@ CRarFile::~CRarFile()
     m_File.Close();
     g_RarManager.ClearCachedFile(m_strRarPath,m_strPathInRar);
   }
+  else if (m_bUseStored)
+    m_stored.Close();
   else
   {
     CleanUp();
@@ -170,6 +173,16 @@ bool CRarFile::Open(const CURL& url)
   {
     if (items[i]->m_idepth == 0x30) // stored
     {
+      // read straight from the volumes when we understand them, saves
+      // running the data through the extractor and makes seeking cheap
+      if (m_stored.Open(m_strRarPath,m_strPathInRar))
+      {
+        m_iFileSize = m_stored.GetLength();
+        m_bUseStored = true;
+        m_bOpen = true;
+        return true;
+      }
+
       if (!OpenInArchive())
         return false;
 
@@ -277,6 +290,9 @@ unsigned int CRarFile::Read(void *lpBuf, int64_t uiBufSize)
   if (m_bUseFile)
     return m_File.Read(lpBuf,uiBufSize);
 
+  if (m_bUseStored)
+    return m_stored.Read(lpBuf,uiBufSize);
+
   if (m_iFilePosition >= GetLength()) // we are done
     return 0;
 
@@ -373,6 +389,12 @@ void CRarFile::Close()
     g_RarManager.ClearCachedFile(m_strRarPath,m_strPathInRar);
     m_bOpen = false;
   }
+  else if (m_bUseStored)
+  {
+    m_stored.Close();
+    m_bUseStored = false;
+    m_bOpen = false;
+  }
   else
   {
     CleanUp();
@@ -398,6 +420,9 @@ int64_t CRarFile::Seek(int64_t iFilePosition, int iWhence)
   if (m_bUseFile)
     return m_File.Seek(iFilePosition,iWhence);
 
+  if (m_bUseStored)
+    return m_stored.Seek(iFilePosition,iWhence);
+
   if( !m_pExtract->GetDataIO().hBufferEmpty->WaitMSec(SEEKTIMOUT) )
   {
     CLog::Log(LOGERROR, "%s - Timeout waiting for buffer to empty", __FUNCTION__);
@@ -523,6 +548,9 @@ int64_t CRarFile::GetPosition()
   if (m_bUseFile)
     return m_File.GetPosition();
 
+  if (m_bUseStored)
+    return m_stored.GetPosition();
+
   return m_iFilePosition;
 }
 
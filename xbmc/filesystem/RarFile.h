@@ -26,6 +26,7 @@
 
 #include "File.h"
 #include "IFile.h"
+#include "RarStoredStream.h"
 #include "threads/Thread.h"
 #include "threads/Event.h"
 
@@ -95,9 +96,11 @@ namespace XFILE
     int64_t m_iFileSize;
     // rar stuff
     bool m_bUseFile;
+    bool m_bUseStored;
     bool m_bOpen;
     bool m_bSeekable;
     CFile m_File; // for packed source
+    CRarStoredStream m_stored; // for stored source, read from the volumes
 #ifdef HAS_FILESYSTEM_RAR
     Archive* m_pArc;
     CommandData* m_pCmd;
@@ -0,0 +1,350 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "RarStoredStream.h"
+#include "utils/CharsetConverter.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <ctype.h>
+
+using namespace XFILE;
+
+#define RAR_MARK_SIZE   7
+#define RAR_BLOCK_SIZE  7   // crc, type, flags and size common to all blocks
+#define RAR_FILE_SIZE   32  // fixed part of a file block, up to the name
+
+#define RAR_MAIN_HEAD   0x73
+#define RAR_FILE_HEAD   0x74
+#define RAR_NEWSUB_HEAD 0x7a
+#define RAR_END_HEAD    0x7b
+
+#define MHD_NEWNUMBERING 0x0010
+#define MHD_PASSWORD     0x0080
+
+#define LHD_SPLIT_BEFORE 0x0001
+#define LHD_SPLIT_AFTER  0x0002
+#define LHD_PASSWORD     0x0004
+#define LHD_LARGE        0x0100
+#define LHD_DIRECTORY    0x00e0
+#define LONG_BLOCK       0x8000
+
+#define RAR_METHOD_STORE 0x30
+
+static const unsigned char s_mark[RAR_MARK_SIZE] = { 0x52, 0x61, 0x72, 0x21, 0x1a, 0x07, 0x00 };
+
+static inline unsigned int Get16(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t Get32(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+CRarStoredStream::CRarStoredStream()
+{
+  m_iSegment = -1;
+  m_bSeek = false;
+  m_iPosition = 0;
+  m_iLength = 0;
+  m_iUnpackedSize = 0;
+}
+
+CRarStoredStream::~CRarStoredStream()
+{
+  Close();
+}
+
+bool CRarStoredStream::Open(const CStdString& strRarPath, const CStdString& strPathInRar)
+{
+  Close();
+
+  CStdString strVolume = strRarPath;
+  bool bNewNumbering = false;
+  bool bMore = true;
+  while (bMore)
+  {
+    if (!IndexVolume(strVolume, strPathInRar, bNewNumbering, bMore))
+    {
+      Close();
+      return false;
+    }
+    strVolume = GetNextVolume(strVolume, bNewNumbering);
+  }
+
+  if (m_iLength != m_iUnpackedSize)
+  {
+    CLog::Log(LOGDEBUG, "CRarStoredStream::Open - %s has %"PRId64" bytes in %u volumes, expected %"PRId64,
+              strPathInRar.c_str(), m_iLength, (unsigned int)m_segments.size(), m_iUnpackedSize);
+    Close();
+    return false;
+  }
+
+  CLog::Log(LOGDEBUG, "CRarStoredStream::Open - streaming %s from %u volumes", strPathInRar.c_str(), (unsigned int)m_segments.size());
+  return true;
+}
+
+void CRarStoredStream::Close()
+{
+  m_file.Close();
+  m_segments.clear();
+  m_iSegment = -1;
+  m_bSeek = false;
+  m_iPosition = 0;
+  m_iLength = 0;
+  m_iUnpackedSize = 0;
+}
+
+bool CRarStoredStream::IndexVolume(const CStdString& strVolume, const CStdString& strPathInRar,
+                                   bool& bNewNumbering, bool& bMore)
+{
+  CFile file;
+  if (!file.Open(strVolume))
+  {
+    CLog::Log(LOGERROR, "CRarStoredStream::IndexVolume - unable to open volume %s", strVolume.c_str());
+    return false;
+  }
+
+  unsigned char mark[RAR_MARK_SIZE];
+  if (file.Read(mark, RAR_MARK_SIZE) != RAR_MARK_SIZE || memcmp(mark, s_mark, RAR_MARK_SIZE) != 0)
+    return false; // sfx, rar5 or not an archive at all
+
+  int64_t iBlock = RAR_MARK_SIZE;
+  int64_t iVolumeSize = file.GetLength();
+  while (iBlock + RAR_BLOCK_SIZE <= iVolumeSize)
+  {
+    unsigned char header[RAR_FILE_SIZE + 8 + 1024];
+    if (file.Seek(iBlock, SEEK_SET) != iBlock || file.Read(header, RAR_BLOCK_SIZE) != RAR_BLOCK_SIZE)
+      return false;
+
+    unsigned int iType = header[2];
+    unsigned int iFlags = Get16(header + 3);
+    unsigned int iHeadSize = Get16(header + 5);
+    if (iHeadSize < RAR_BLOCK_SIZE)
+      return false;
+
+    int64_t iAddSize = 0;
+    if (iType == RAR_MAIN_HEAD)
+    {
+      if (iFlags & MHD_PASSWORD)
+        return false;
+      bNewNumbering = (iFlags & MHD_NEWNUMBERING) != 0;
+    }
+    else if (iType == RAR_FILE_HEAD || iType == RAR_NEWSUB_HEAD)
+    {
+      unsigned int iRead = std::min<unsigned int>(iHeadSize, sizeof(header));
+      if (iRead < RAR_FILE_SIZE || file.Read(header + RAR_BLOCK_SIZE, iRead - RAR_BLOCK_SIZE) != iRead - RAR_BLOCK_SIZE)
+        return false;
+
+      iAddSize = Get32(header + 7);
+      int64_t iUnpackedSize = Get32(header + 11);
+      unsigned int iMethod = header[25];
+      unsigned int iNameSize = Get16(header + 26);
+      unsigned int iName = RAR_FILE_SIZE;
+      if (iFlags & LHD_LARGE)
+      {
+        if (iRead < RAR_FILE_SIZE + 8)
+          return false;
+        iAddSize |= (int64_t)Get32(header + 32) << 32;
+        iUnpackedSize |= (int64_t)Get32(header + 36) << 32;
+        iName += 8;
+      }
+
+      if (iType == RAR_FILE_HEAD && (iFlags & LHD_DIRECTORY) != LHD_DIRECTORY && iName + iNameSize <= iRead)
+      {
+        // unicode names have the oem name first, terminated by a zero
+        CStdString strName((const char*)header + iName, strnlen((const char*)header + iName, iNameSize));
+        bool bAscii = true;
+        for (unsigned int i = 0; i < strName.size() && bAscii; i++)
+          bAscii = (unsigned char)strName[i] < 0x80;
+        if (!bAscii)
+        {
+          CStdString strUtf8;
+          g_charsetConverter.unknownToUTF8(strName, strUtf8);
+          strName = strUtf8;
+        }
+        strName.Replace('\\', '/');
+
+        if (strName == strPathInRar)
+        {
+          if (iMethod != RAR_METHOD_STORE || (iFlags & LHD_PASSWORD))
+            return false;
+          // the first piece has to be in the volume we started at
+          if (m_segments.empty() == ((iFlags & LHD_SPLIT_BEFORE) != 0))
+            return false;
+
+          SSegment segment;
+          segment.volume = strVolume;
+          segment.offset = iBlock + iHeadSize;
+          segment.start = m_iLength;
+          segment.size = iAddSize;
+          if (segment.offset + segment.size > iVolumeSize)
+            return false; // truncated volume
+          m_segments.push_back(segment);
+          m_iLength += segment.size;
+          m_iUnpackedSize = iUnpackedSize;
+          bMore = (iFlags & LHD_SPLIT_AFTER) != 0;
+          return true;
+        }
+      }
+    }
+    else if (iType == RAR_END_HEAD)
+      break;
+    else if (iFlags & LONG_BLOCK)
+    {
+      if (file.Read(header + RAR_BLOCK_SIZE, 4) != 4)
+        return false;
+      iAddSize = Get32(header + RAR_BLOCK_SIZE);
+    }
+
+    iBlock += iHeadSize + iAddSize;
+  }
+
+  return false;
+}
+
+CStdString CRarStoredStream::GetNextVolume(const CStdString& strVolume, bool bNewNumbering)
+{
+  CStdString strNext = strVolume;
+  int iExt = strNext.ReverseFind('.');
+  if (iExt < 0)
+    return strNext;
+
+  if (bNewNumbering)
+  {
+    // increment the number in front of the extension, name.part01.rar
+    int i = iExt - 1;
+    for (; i >= 0 && strNext[i] >= '0' && strNext[i] <= '9'; i--)
+    {
+      if (strNext[i] != '9')
+      {
+        strNext.SetAt(i, strNext[i] + 1);
+        return strNext;
+      }
+      strNext.SetAt(i, '0');
+    }
+    strNext.Insert(i + 1, '1');
+    return strNext;
+  }
+
+  // name.rar, name.r00 ... name.r99, name.s00 ...
+  if (strNext.size() - iExt != 4 || !isdigit(strNext[iExt + 2]) || !isdigit(strNext[iExt + 3]))
+    return strNext.Left(iExt + 2) + "00";
+
+  if (strNext[iExt + 3] != '9')
+    strNext.SetAt(iExt + 3, strNext[iExt + 3] + 1);
+  else if (strNext[iExt + 2] != '9')
+  {
+    strNext.SetAt(iExt + 2, strNext[iExt + 2] + 1);
+    strNext.SetAt(iExt + 3, '0');
+  }
+  else
+  {
+    strNext.SetAt(iExt + 1, strNext[iExt + 1] + 1);
+    strNext.SetAt(iExt + 2, '0');
+    strNext.SetAt(iExt + 3, '0');
+  }
+  return strNext;
+}
+
+bool CRarStoredStream::OpenSegment(unsigned int iSegment)
+{
+  if ((int)iSegment != m_iSegment)
+  {
+    m_file.Close();
+    m_iSegment = -1;
+    if (!m_file.Open(m_segments[iSegment].volume))
+    {
+      CLog::Log(LOGERROR, "CRarStoredStream::OpenSegment - unable to open volume %s", m_segments[iSegment].volume.c_str());
+      return false;
+    }
+    m_iSegment = iSegment;
+    m_bSeek = true;
+  }
+
+  if (m_bSeek)
+  {
+    const SSegment& segment = m_segments[iSegment];
+    int64_t iOffset = segment.offset + m_iPosition - segment.start;
+    if (m_file.Seek(iOffset, SEEK_SET) != iOffset)
+      return false;
+    m_bSeek = false;
+  }
+  return true;
+}
+
+unsigned int CRarStoredStream::Read(void* lpBuf, int64_t uiBufSize)
+{
+  unsigned char* pBuf = (unsigned char*)lpBuf;
+  unsigned int iRead = 0;
+  while (uiBufSize > 0 && m_iPosition < m_iLength)
+  {
+    // segments are in file order, usually we stay in the current one
+    unsigned int iSegment = m_iSegment < 0 ? 0 : m_iSegment;
+    while (iSegment > 0 && m_iPosition < m_segments[iSegment].start)
+      iSegment--;
+    while (m_iPosition >= m_segments[iSegment].start + m_segments[iSegment].size)
+      iSegment++;
+
+    if (!OpenSegment(iSegment))
+      break;
+
+    const SSegment& segment = m_segments[iSegment];
+    int64_t iToRead = std::min(uiBufSize, segment.start + segment.size - m_iPosition);
+    unsigned int iResult = m_file.Read(pBuf, iToRead);
+    if (iResult == 0)
+      break;
+
+    pBuf += iResult;
+    iRead += iResult;
+    uiBufSize -= iResult;
+    m_iPosition += iResult;
+  }
+  return iRead;
+}
+
+int64_t CRarStoredStream::Seek(int64_t iFilePosition, int iWhence)
+{
+  switch (iWhence)
+  {
+  case SEEK_SET:
+    break;
+  case SEEK_CUR:
+    iFilePosition += m_iPosition;
+    break;
+  case SEEK_END:
+    iFilePosition += m_iLength;
+    break;
+  default:
+    return -1;
+  }
+
+  if (iFilePosition < 0 || iFilePosition > m_iLength)
+    return -1;
+
+  if (iFilePosition != m_iPosition)
+  {
+    m_iPosition = iFilePosition;
+    m_bSeek = true;
+  }
+  return m_iPosition;
+}
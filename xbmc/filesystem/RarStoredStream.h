@@ -0,0 +1,84 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "File.h"
+#include "utils/StdString.h"
+
+#include <vector>
+
+namespace XFILE
+{
+  /**
+   * Reads a file stored (method 0x30, no compression) in a RAR archive straight
+   * from the volumes it is split over. The block headers of each volume are
+   * walked once on open to find the pieces of the file, after that reads and
+   * seeks map onto the volumes without going through UnrarXLib, so nothing is
+   * extracted and seeking costs no more than in a plain file.
+   * Only RAR 1.5 - 4.x archives are understood, with unencrypted headers and
+   * data; Open fails for anything else so the caller can fall back to
+   * extracting.
+   */
+  class CRarStoredStream
+  {
+  public:
+    CRarStoredStream();
+    ~CRarStoredStream();
+
+    bool Open(const CStdString& strRarPath, const CStdString& strPathInRar);
+    void Close();
+
+    unsigned int Read(void* lpBuf, int64_t uiBufSize);
+    int64_t Seek(int64_t iFilePosition, int iWhence = SEEK_SET);
+    int64_t GetPosition() const { return m_iPosition; }
+    int64_t GetLength() const { return m_iLength; }
+
+    /* number of volumes the file is split over */
+    unsigned int GetVolumeCount() const { return m_segments.size(); }
+
+    /* name of the volume following strVolume, either name.partN.rar or the
+     * older name.rar, name.r00, name.r01, ... */
+    static CStdString GetNextVolume(const CStdString& strVolume, bool bNewNumbering);
+
+  private:
+    struct SSegment
+    {
+      CStdString volume;
+      int64_t offset; // start of the data in the volume
+      int64_t start;  // position in the file of the first byte
+      int64_t size;
+    };
+
+    /* finds the piece of strPathInRar in a volume, bMore is set when it
+     * continues in the next volume */
+    bool IndexVolume(const CStdString& strVolume, const CStdString& strPathInRar,
+                     bool& bNewNumbering, bool& bMore);
+    bool OpenSegment(unsigned int iSegment);
+
+    std::vector<SSegment> m_segments;
+    CFile m_file;
+    int m_iSegment;    // segment m_file is open on, -1 for none
+    bool m_bSeek;      // m_file has to be positioned before reading
+    int64_t m_iPosition;
+    int64_t m_iLength;
+    int64_t m_iUnpackedSize;
+  };
+}
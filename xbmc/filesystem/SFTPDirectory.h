@@ -35,6 +35,9 @@ namespace XFILE
     CSFTPDirectory(void);
     virtual ~CSFTPDirectory(void);
     virtual bool GetDirectory(const CStdString& strPath, CFileItemList &items);
+    virtual bool StatFiles(const CStdString& strPath, const std::vector<CStdString>& files,
+                           std::vector<SFileStat>& results, CFileItemList &items)
+    { return StatFromListing(strPath, files, results, items); }
   };
 }
 #endif
@@ -32,6 +32,9 @@ public:
   virtual ~CSMBDirectory(void);
   virtual bool GetDirectory(const CStdString& strPath, CFileItemList &items);
   virtual DIR_CACHE_TYPE GetCacheType(const CStdString &strPath) const { return DIR_CACHE_ONCE; };
+  virtual bool StatFiles(const CStdString& strPath, const std::vector<CStdString>& files,
+                         std::vector<SFileStat>& results, CFileItemList &items)
+  { return StatFromListing(strPath, files, results, items); }
   virtual bool Create(const char* strPath);
   virtual bool Exists(const char* strPath);
   virtual bool Remove(const char* strPath);
@@ -26,6 +26,7 @@
 #include "SmbFile.h"
 #include "PasswordManager.h"
 #include "SMBDirectory.h"
+#include "FileReadRequest.h"
 #include "Util.h"
 #include <libsmbclient.h>
 #include "settings/AdvancedSettings.h"
@@ -35,8 +36,19 @@
 #include "utils/TimeUtils.h"
 #include "commons/Exception.h"
 
+#include <algorithm>
+
 using namespace XFILE;
 
+/* work around stupid bug in samba */
+/* some samba servers has a bug in it where the */
+/* 17th bit will be ignored in a request of data */
+/* this can lead to a very small return of data */
+/* also worse, a request of exactly 64k will return */
+/* as if eof, client has a workaround for windows */
+/* thou it seems other servers are affected too */
+#define SMB_READ_MAX (64*1024-2)
+
 void xb_smbc_log(const char* msg)
 {
   CLog::Log(LOGINFO, "%s%s", "smb: ", msg);
@@ -87,6 +99,21 @@ void CSMB::Deinit()
     }
     m_context = NULL;
   }
+
+  for (std::vector<CSMBContext*>::iterator it = m_contexts.begin(); it != m_contexts.end(); ++it)
+  {
+    try
+    {
+      smbc_free_context((*it)->m_context, 1);
+    }
+    XBMCCOMMONS_HANDLE_UNCHECKED
+    catch(...)
+    {
+      CLog::Log(LOGERROR,"exception on CSMB::Deinit. errno: %d", errno);
+    }
+    delete *it;
+  }
+  m_contexts.clear();
 }
 
 void CSMB::Init()
@@ -153,29 +180,8 @@ void CSMB::Init()
 #endif
 
     // setup our context
-    m_context = smbc_new_context();
-#ifdef DEPRECATED_SMBC_INTERFACE
-    smbc_setDebug(m_context, g_advancedSettings.m_logLevel == LOG_LEVEL_DEBUG_SAMBA ? 10 : 0);
-    smbc_setFunctionAuthData(m_context, xb_smbc_auth);
-    orig_cache = smbc_getFunctionGetCachedServer(m_context);
-    smbc_setFunctionGetCachedServer(m_context, xb_smbc_cache);
-    smbc_setOptionOneSharePerServer(m_context, false);
-    smbc_setOptionBrowseMaxLmbCount(m_context, 0);
-    smbc_setTimeout(m_context, g_advancedSettings.m_sambaclienttimeout * 1000);
-    smbc_setUser(m_context, strdup("guest"));
-#else
-    m_context->debug = g_advancedSettings.m_logLevel == LOG_LEVEL_DEBUG_SAMBA ? 10 : 0;
-    m_context->callbacks.auth_fn = xb_smbc_auth;
-    orig_cache = m_context->callbacks.get_cached_srv_fn;
-    m_context->callbacks.get_cached_srv_fn = xb_smbc_cache;
-    m_context->options.one_share_per_server = false;
-    m_context->options.browse_max_lmb_count = 0;
-    m_context->timeout = g_advancedSettings.m_sambaclienttimeout * 1000;
-    m_context->user = strdup("guest");
-#endif
-
-    // initialize samba and do some hacking into the settings
-    if (smbc_init_context(m_context))
+    m_context = CreateContext();
+    if (m_context)
     {
       /* setup old interface to use this context */
       smbc_set_context(m_context);
@@ -196,17 +202,144 @@ void CSMB::Init()
         lp_do_parameter( -1, "dos charset", "CP850");
 #endif
     }
-    else
-    {
-      smbc_free_context(m_context, 1);
-      m_context = NULL;
-    }
   }
 #ifdef TARGET_POSIX
   m_IdleTimeout = 180;
 #endif
 }
 
+SMBCCTX* CSMB::CreateContext()
+{
+  SMBCCTX* context = smbc_new_context();
+#ifdef DEPRECATED_SMBC_INTERFACE
+  smbc_setDebug(context, g_advancedSettings.m_logLevel == LOG_LEVEL_DEBUG_SAMBA ? 10 : 0);
+  smbc_setFunctionAuthData(context, xb_smbc_auth);
+  orig_cache = smbc_getFunctionGetCachedServer(context);
+  smbc_setFunctionGetCachedServer(context, xb_smbc_cache);
+  smbc_setOptionOneSharePerServer(context, false);
+  smbc_setOptionBrowseMaxLmbCount(context, 0);
+  smbc_setTimeout(context, g_advancedSettings.m_sambaclienttimeout * 1000);
+  smbc_setUser(context, strdup("guest"));
+#else
+  context->debug = g_advancedSettings.m_logLevel == LOG_LEVEL_DEBUG_SAMBA ? 10 : 0;
+  context->callbacks.auth_fn = xb_smbc_auth;
+  orig_cache = context->callbacks.get_cached_srv_fn;
+  context->callbacks.get_cached_srv_fn = xb_smbc_cache;
+  context->options.one_share_per_server = false;
+  context->options.browse_max_lmb_count = 0;
+  context->timeout = g_advancedSettings.m_sambaclienttimeout * 1000;
+  context->user = strdup("guest");
+#endif
+
+  // initialize samba and do some hacking into the settings
+  if (!smbc_init_context(context))
+  {
+    smbc_free_context(context, 1);
+    return NULL;
+  }
+  return context;
+}
+
+CSMBContext* CSMB::AcquireContext(const std::vector<CSMBContext*>& exclude)
+{
+  Init();
+  CSingleLock lock(*this);
+  CSMBContext* context = NULL;
+  for (std::vector<CSMBContext*>::iterator it = m_contexts.begin(); it != m_contexts.end(); ++it)
+  {
+    if (find(exclude.begin(), exclude.end(), *it) != exclude.end())
+      continue;
+    if (!context || (*it)->m_users < context->m_users)
+      context = *it;
+  }
+
+  if ((!context || context->m_users > 0) && m_contexts.size() < (size_t)g_advancedSettings.m_sambacontexts)
+  {
+    SMBCCTX* smbContext = CreateContext();
+    if (smbContext)
+    {
+      context = new CSMBContext(smbContext);
+      m_contexts.push_back(context);
+    }
+  }
+
+  if (context)
+    context->m_users++;
+  return context;
+}
+
+void CSMB::ReleaseContext(CSMBContext* context)
+{
+  CSingleLock lock(*this);
+  context->m_users--;
+}
+
+SMBCFILE* CSMBContext::Open(const CStdString& strPath)
+{
+#ifdef DEPRECATED_SMBC_INTERFACE
+  return smbc_getFunctionOpen(m_context)(m_context, strPath.c_str(), O_RDONLY, 0);
+#else
+  return m_context->open(m_context, strPath.c_str(), O_RDONLY, 0);
+#endif
+}
+
+void CSMBContext::Close(SMBCFILE* file)
+{
+#ifdef DEPRECATED_SMBC_INTERFACE
+  smbc_getFunctionClose(m_context)(m_context, file);
+#else
+  m_context->close_fn(m_context, file);
+#endif
+}
+
+int CSMBContext::Read(SMBCFILE* file, void* lpBuf, unsigned int uiBufSize)
+{
+#ifdef DEPRECATED_SMBC_INTERFACE
+  return (int)smbc_getFunctionRead(m_context)(m_context, file, lpBuf, uiBufSize);
+#else
+  return (int)m_context->read(m_context, file, lpBuf, uiBufSize);
+#endif
+}
+
+int64_t CSMBContext::Seek(SMBCFILE* file, int64_t iFilePosition)
+{
+#ifdef DEPRECATED_SMBC_INTERFACE
+  return smbc_getFunctionLseek(m_context)(m_context, file, iFilePosition, SEEK_SET);
+#else
+  return m_context->lseek(m_context, file, iFilePosition, SEEK_SET);
+#endif
+}
+
+int CSMBContext::Stat(SMBCFILE* file, struct __stat64* buffer)
+{
+#ifdef TARGET_WINDOWS
+  struct __stat64 tmpBuffer = {0};
+#else
+  struct stat tmpBuffer = {0};
+#endif
+
+#ifdef DEPRECATED_SMBC_INTERFACE
+  int iResult = smbc_getFunctionFstat(m_context)(m_context, file, &tmpBuffer);
+#else
+  int iResult = m_context->fstat(m_context, file, &tmpBuffer);
+#endif
+
+  memset(buffer, 0, sizeof(struct __stat64));
+  buffer->st_dev = tmpBuffer.st_dev;
+  buffer->st_ino = tmpBuffer.st_ino;
+  buffer->st_mode = tmpBuffer.st_mode;
+  buffer->st_nlink = tmpBuffer.st_nlink;
+  buffer->st_uid = tmpBuffer.st_uid;
+  buffer->st_gid = tmpBuffer.st_gid;
+  buffer->st_rdev = tmpBuffer.st_rdev;
+  buffer->st_size = tmpBuffer.st_size;
+  buffer->st_atime = tmpBuffer.st_atime;
+  buffer->st_mtime = tmpBuffer.st_mtime;
+  buffer->st_ctime = tmpBuffer.st_ctime;
+
+  return iResult;
+}
+
 void CSMB::Purge()
 {
 #ifdef TARGET_WINDOWS
@@ -350,6 +483,10 @@ CSmbFile::CSmbFile()
 {
   smb.Init();
   m_fd = -1;
+  m_pipeline = NULL;
+  m_bPipelineTried = false;
+  m_position = 0;
+  m_lastRead = -1;
 #ifdef TARGET_POSIX
   smb.AddActiveConnection();
 #endif
@@ -365,6 +502,7 @@ CSmbFile::~CSmbFile()
 
 int64_t CSmbFile::GetPosition()
 {
+  if (!m_handles.empty()) return m_position;
   if (m_fd == -1) return 0;
   smb.Init();
   CSingleLock lock(smb);
@@ -376,7 +514,7 @@ int64_t CSmbFile::GetPosition()
 
 int64_t CSmbFile::GetLength()
 {
-  if (m_fd == -1) return 0;
+  if (m_fd == -1 && m_handles.empty()) return 0;
   return m_fileSize;
 }
 
@@ -397,11 +535,27 @@ bool CSmbFile::Open(const CURL& url)
   // when opening smb://server xbms will try to find folder.jpg in all shares
   // listed, which will create lot's of open sessions.
 
+  // with more than one context, files opened for reading go through contexts
+  // of their own, so they don't wait on the reads of other files. that needs a
+  // libsmbclient that is thread safe across contexts, older ones share global
+  // state and need every call serialized on the global context
+  bool opened;
   CStdString strFileName;
-  m_fd = OpenFile(url, strFileName);
+  if (g_advancedSettings.m_sambacontexts > 1)
+  {
+    m_strPath = GetAuthenticatedPath(url);
+    strFileName = m_strPath;
+    opened = OpenHandles(1);
+    CLog::Log(LOGDEBUG,"CSmbFile::Open - opened %s, %s",url.GetFileName().c_str(), opened ? "ok" : "failed");
+  }
+  else
+  {
+    m_fd = OpenFile(url, strFileName);
+    opened = m_fd != -1;
+    CLog::Log(LOGDEBUG,"CSmbFile::Open - opened %s, fd=%d",url.GetFileName().c_str(), m_fd);
+  }
 
-  CLog::Log(LOGDEBUG,"CSmbFile::Open - opened %s, fd=%d",url.GetFileName().c_str(), m_fd);
-  if (m_fd == -1)
+  if (!opened)
   {
     // write error to logfile
 #ifdef TARGET_WINDOWS
@@ -413,29 +567,145 @@ bool CSmbFile::Open(const CURL& url)
     return false;
   }
 
-  CSingleLock lock(smb);
+  if (m_handles.empty())
+  {
+    CSingleLock lock(smb);
 #ifdef TARGET_WINDOWS
-  struct __stat64 tmpBuffer = {0};
+    struct __stat64 tmpBuffer = {0};
 #else
-  struct stat tmpBuffer;
+    struct stat tmpBuffer;
 #endif
-  if (smbc_stat(strFileName, &tmpBuffer) < 0)
+    if (smbc_stat(strFileName, &tmpBuffer) < 0)
+    {
+      smbc_close(m_fd);
+      m_fd = -1;
+      return false;
+    }
+
+    m_fileSize = tmpBuffer.st_size;
+
+    int64_t ret = smbc_lseek(m_fd, 0, SEEK_SET);
+    if ( ret < 0 )
+    {
+      smbc_close(m_fd);
+      m_fd = -1;
+      return false;
+    }
+    // We've successfully opened the file!
+    return true;
+  }
+
+  struct __stat64 tmpBuffer;
+  if (Stat(&tmpBuffer) < 0)
   {
-    smbc_close(m_fd);
-    m_fd = -1;
+    CloseHandles();
     return false;
   }
 
   m_fileSize = tmpBuffer.st_size;
+  m_position = 0;
+  m_lastRead = -1;
+  m_bPipelineTried = false;
+
+  // We've successfully opened the file!
+  return true;
+}
+
+bool CSmbFile::OpenHandles(unsigned int count)
+{
+  std::vector<CSMBContext*> contexts;
+  for (std::vector<SHandle*>::iterator it = m_handles.begin(); it != m_handles.end(); ++it)
+    contexts.push_back((*it)->context);
 
-  int64_t ret = smbc_lseek(m_fd, 0, SEEK_SET);
-  if ( ret < 0 )
+  while (m_handles.size() < count)
   {
-    smbc_close(m_fd);
-    m_fd = -1;
-    return false;
+    CSMBContext* context = smb.AcquireContext(contexts);
+    if (!context)
+      break;
+
+    SMBCFILE* file;
+    {
+      CSingleLock lock(*context);
+      file = context->Open(m_strPath);
+    }
+    if (!file)
+    {
+      smb.ReleaseContext(context);
+      break;
+    }
+
+    SHandle* handle = new SHandle;
+    handle->context = context;
+    handle->file    = file;
+    handle->busy    = false;
+    CSingleLock lock(m_handleSection);
+    m_handles.push_back(handle);
+    contexts.push_back(context);
   }
-  // We've successfully opened the file!
+  return m_handles.size() >= count;
+}
+
+void CSmbFile::CloseHandles()
+{
+  delete m_pipeline;
+  m_pipeline = NULL;
+  WaitAsync();
+
+  CSingleLock lock(m_handleSection);
+  for (std::vector<SHandle*>::iterator it = m_handles.begin(); it != m_handles.end(); ++it)
+  {
+    {
+      CSingleLock contextLock(*(*it)->context);
+      (*it)->context->Close((*it)->file);
+    }
+    smb.ReleaseContext((*it)->context);
+    delete *it;
+  }
+  m_handles.clear();
+}
+
+CSmbFile::SHandle* CSmbFile::GetHandle()
+{
+  CSingleLock lock(m_handleSection);
+  while (true)
+  {
+    for (std::vector<SHandle*>::iterator it = m_handles.begin(); it != m_handles.end(); ++it)
+    {
+      if (!(*it)->busy)
+      {
+        (*it)->busy = true;
+        return *it;
+      }
+    }
+    m_handleFree.wait(lock);
+  }
+}
+
+void CSmbFile::ReleaseHandle(SHandle* handle)
+{
+  CSingleLock lock(m_handleSection);
+  handle->busy = false;
+  m_handleFree.notifyAll();
+}
+
+bool CSmbFile::OpenPipeline()
+{
+  if (m_pipeline)
+    return true;
+  if (m_bPipelineTried)
+    return false;
+  m_bPipelineTried = true;
+
+  // one handle per read outstanding, the reads are spread over the contexts
+  unsigned int depth = (unsigned int)g_advancedSettings.m_sambareaddepth;
+  if (depth <= 1)
+    return false;
+  OpenHandles(depth);
+  if (m_handles.size() <= 1)
+    return false;
+
+  CLog::Log(LOGDEBUG, "CSmbFile::OpenPipeline - %"PRIuS" reads outstanding for %s", m_handles.size(), m_url.GetFileName().c_str());
+  m_pipeline = new CFileReadPipeline(this, m_handles.size(), SMB_READ_MAX);
   return true;
 }
 
@@ -508,6 +778,18 @@ bool CSmbFile::Exists(const CURL& url)
 
 int CSmbFile::Stat(struct __stat64* buffer)
 {
+  if (!m_handles.empty())
+  {
+    SHandle* handle = GetHandle();
+    int iResult;
+    {
+      CSingleLock lock(*handle->context);
+      iResult = handle->context->Stat(handle->file, buffer);
+    }
+    ReleaseHandle(handle);
+    return iResult;
+  }
+
   if (m_fd == -1)
     return -1;
 
@@ -586,20 +868,37 @@ int CSmbFile::Truncate(int64_t size)
 
 unsigned int CSmbFile::Read(void *lpBuf, int64_t uiBufSize)
 {
+  if (!m_handles.empty())
+  {
+#ifdef TARGET_POSIX
+    smb.SetActivityTime();
+#endif
+    unsigned int size = (unsigned int)std::min<int64_t>(uiBufSize, INT_MAX);
+    int bytesRead;
+    // a read that continues the last one is streamed with reads outstanding
+    if (m_position == m_lastRead && OpenPipeline())
+      bytesRead = m_pipeline->Read(lpBuf, size, m_position);
+    else
+    {
+      if (m_pipeline)
+        m_pipeline->Reset();
+      bytesRead = ReadAt(lpBuf, std::min(size, (unsigned int)SMB_READ_MAX), m_position);
+    }
+    if (bytesRead <= 0)
+      return 0;
+
+    m_position += bytesRead;
+    m_lastRead = m_position;
+    return (unsigned int)bytesRead;
+  }
+
   if (m_fd == -1) return 0;
   CSingleLock lock(smb); // Init not called since it has to be "inited" by now
 #ifdef TARGET_POSIX
   smb.SetActivityTime();
 #endif
-  /* work around stupid bug in samba */
-  /* some samba servers has a bug in it where the */
-  /* 17th bit will be ignored in a request of data */
-  /* this can lead to a very small return of data */
-  /* also worse, a request of exactly 64k will return */
-  /* as if eof, client has a workaround for windows */
-  /* thou it seems other servers are affected too */
-  if( uiBufSize >= 64*1024-2 )
-    uiBufSize = 64*1024-2;
+  if( uiBufSize >= SMB_READ_MAX )
+    uiBufSize = SMB_READ_MAX;
 
   int bytesRead = smbc_read(m_fd, lpBuf, (int)uiBufSize);
 
@@ -622,8 +921,74 @@ unsigned int CSmbFile::Read(void *lpBuf, int64_t uiBufSize)
   return (unsigned int)bytesRead;
 }
 
+int CSmbFile::ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset)
+{
+  if (m_handles.empty())
+    return IFile::ReadAt(lpBuf, uiBufSize, iOffset);
+
+  SHandle* handle = GetHandle();
+  unsigned int total = 0;
+  int bytesRead = 0;
+  {
+    CSingleLock lock(*handle->context);
+    if (handle->context->Seek(handle->file, iOffset) != iOffset)
+      bytesRead = -1;
+
+    while (bytesRead >= 0 && total < uiBufSize)
+    {
+      unsigned int size = std::min(uiBufSize - total, (unsigned int)SMB_READ_MAX);
+      bytesRead = handle->context->Read(handle->file, (char*)lpBuf + total, size);
+      if ( bytesRead < 0 && errno == EINVAL )
+      {
+        CLog::Log(LOGERROR, "%s - Error( %d, %d, %s ) - Retrying", __FUNCTION__, bytesRead, errno, strerror(errno));
+        bytesRead = handle->context->Read(handle->file, (char*)lpBuf + total, size);
+      }
+      if (bytesRead <= 0)
+        break;
+      total += bytesRead;
+    }
+  }
+  ReleaseHandle(handle);
+
+  if (bytesRead < 0)
+  {
+#ifdef TARGET_WINDOWS
+    CLog::Log(LOGERROR, "%s - Error( %s )", __FUNCTION__, get_friendly_nt_error_msg(smb.ConvertUnixToNT(errno)));
+#else
+    CLog::Log(LOGERROR, "%s - Error( %d, %d, %s )", __FUNCTION__, bytesRead, errno, strerror(errno));
+#endif
+    if (total == 0)
+      return -1;
+  }
+  return (int)total;
+}
+
 int64_t CSmbFile::Seek(int64_t iFilePosition, int iWhence)
 {
+  if (!m_handles.empty())
+  {
+    // the handles are positioned for each read
+    int64_t position;
+    switch (iWhence)
+    {
+    case SEEK_SET:
+      position = iFilePosition;
+      break;
+    case SEEK_CUR:
+      position = m_position + iFilePosition;
+      break;
+    case SEEK_END:
+      position = m_fileSize + iFilePosition;
+      break;
+    default:
+      return -1;
+    }
+    if (position < 0)
+      return -1;
+    m_position = position;
+    return m_position;
+  }
+
   if (m_fd == -1) return -1;
 
   CSingleLock lock(smb); // Init not called since it has to be "inited" by now
@@ -647,6 +1012,12 @@ int64_t CSmbFile::Seek(int64_t iFilePosition, int iWhence)
 
 void CSmbFile::Close()
 {
+  if (!m_handles.empty())
+  {
+    CLog::Log(LOGDEBUG,"CSmbFile::Close closing %s", m_url.GetFileName().c_str());
+    CloseHandles();
+  }
+
   if (m_fd != -1)
   {
     CLog::Log(LOGDEBUG,"CSmbFile::Close closing fd %d", m_fd);
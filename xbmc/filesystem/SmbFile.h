@@ -40,6 +40,9 @@
 #include "IFile.h"
 #include "URL.h"
 #include "threads/CriticalSection.h"
+#include "threads/Condition.h"
+
+#include <vector>
 
 #define NT_STATUS_CONNECTION_REFUSED long(0xC0000000 | 0x0236)
 #define NT_STATUS_INVALID_HANDLE long(0xC0000000 | 0x0008)
@@ -51,6 +54,29 @@
 
 struct _SMBCCTX;
 typedef _SMBCCTX SMBCCTX;
+struct _SMBCFILE;
+typedef _SMBCFILE SMBCFILE;
+
+/**
+ * A samba context files are read through. Every context has a connection of
+ * its own, the lock is held for each call so reads through different contexts
+ * don't wait on each other. Only used with <samba><contexts> above 1, which
+ * needs a libsmbclient that is thread safe across contexts.
+ */
+class CSMBContext : public CCriticalSection
+{
+public:
+  CSMBContext(SMBCCTX* context) : m_context(context), m_users(0) {}
+
+  SMBCFILE* Open(const CStdString& strPath);
+  void      Close(SMBCFILE* file);
+  int       Read(SMBCFILE* file, void* lpBuf, unsigned int uiBufSize);
+  int64_t   Seek(SMBCFILE* file, int64_t iFilePosition);
+  int       Stat(SMBCFILE* file, struct __stat64* buffer);
+
+  SMBCCTX*     m_context;
+  unsigned int m_users;
+};
 
 class CSMB : public CCriticalSection
 {
@@ -71,8 +97,16 @@ public:
   CStdString URLEncode(const CURL &url);
 
   DWORD ConvertUnixToNT(int error);
+
+  /* leases the least used context that isn't in exclude, more are set up
+   * while they are all in use, up to <samba><contexts> */
+  CSMBContext* AcquireContext(const std::vector<CSMBContext*>& exclude);
+  void ReleaseContext(CSMBContext* context);
 private:
+  SMBCCTX* CreateContext();
+
   SMBCCTX *m_context;
+  std::vector<CSMBContext*> m_contexts;
   CStdString m_strLastHost;
   CStdString m_strLastShare;
 #ifdef _LINUX
@@ -85,6 +119,8 @@ extern CSMB smb;
 
 namespace XFILE
 {
+class CFileReadPipeline;
+
 class CSmbFile : public IFile
 {
 public:
@@ -108,12 +144,39 @@ public:
   virtual bool Rename(const CURL& url, const CURL& urlnew);
   virtual int  GetChunkSize() {return 1;}
 
+  virtual int  ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset);
+  virtual bool CanReadAt() { return !m_handles.empty(); }
+
 protected:
+  /* the file opened on a context, files opened for reading have one of
+   * these per read outstanding */
+  struct SHandle
+  {
+    CSMBContext* context;
+    SMBCFILE*    file;
+    bool         busy;
+  };
+
+  bool     OpenHandles(unsigned int count);
+  void     CloseHandles();
+  SHandle* GetHandle();
+  void     ReleaseHandle(SHandle* handle);
+  bool     OpenPipeline();
+
   CURL m_url;
   bool IsValidFile(const CStdString& strFileName);
   CStdString GetAuthenticatedPath(const CURL &url);
   int64_t m_fileSize;
   int m_fd;
+
+  CStdString                     m_strPath;
+  std::vector<SHandle*>          m_handles;
+  CCriticalSection               m_handleSection;
+  XbmcThreads::ConditionVariable m_handleFree;
+  CFileReadPipeline*             m_pipeline;
+  bool                           m_bPipelineTried;
+  int64_t                        m_position;
+  int64_t                        m_lastRead;   // where the last read ended
 };
 }
 
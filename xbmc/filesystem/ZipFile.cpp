@@ -20,11 +20,14 @@
 
 #include "ZipFile.h"
 #include "URL.h"
-#include "utils/URIUtils.h"
 
+#include <algorithm>
 #include <sys/stat.h>
 
-#define ZIP_CACHE_LIMIT 4*1024*1024
+// minimum distance in uncompressed data between two inflate checkpoints
+#define ZIP_CHECKPOINT_SPAN 1024*1024
+// checkpoints kept per entry (32k of window each), larger entries get a wider span
+#define ZIP_CHECKPOINT_MAX  128
 
 using namespace XFILE;
 using namespace std;
@@ -34,8 +37,9 @@ CZipFile::CZipFile()
   m_szStringBuffer = NULL;
   m_szStartOfStringBuffer = NULL;
   m_iDataInStringBuffer = 0;
-  m_bCached = false;
   m_iRead = -1;
+  m_iWindowPos = 0;
+  m_iWindowSize = 0;
 }
 
 CZipFile::~CZipFile()
@@ -46,7 +50,6 @@ CZipFile::~CZipFile()
 
 bool CZipFile::Open(const CURL&url)
 {
-  CStdString strOpts = url.GetOptions();
   CURL url2(url);
   url2.SetOptions("");
   CStdString strPath = url2.Get();
@@ -65,18 +68,6 @@ bool CZipFile::Open(const CURL&url)
     return false;
   }
 
-  if (mZipItem.method != 0 && mZipItem.usize > ZIP_CACHE_LIMIT && strOpts != "?cache=no")
-  {
-    if (!CFile::Exists("special://temp/" + URIUtils::GetFileName(strPath)))
-    {
-      url2.SetOptions("?cache=no");
-      if (!CFile::Cache(url2.Get(), "special://temp/" + URIUtils::GetFileName(strPath)))
-        return false;
-    }
-    m_bCached = true;
-    return mFile.Open("special://temp/" + URIUtils::GetFileName(strPath));
-  }
-
   if (!mFile.Open(url.GetHostName())) // this is the zip-file, always open binary
   {
     CLog::Log(LOGERROR,"FileZip: unable to open zip file %s!",url.GetHostName().c_str());
@@ -92,7 +83,9 @@ bool CZipFile::InitDecompress()
   m_iFilePos = 0;
   m_iZipFilePos = 0;
   m_iAvailBuffer = 0;
-  m_bFlush = false;
+  m_iWindowPos = 0;
+  m_iWindowSize = 0;
+  ClearCheckpoints();
   m_ZStream.zalloc = Z_NULL;
   m_ZStream.zfree = Z_NULL;
   m_ZStream.opaque = Z_NULL;
@@ -118,16 +111,11 @@ int64_t CZipFile::GetLength()
 
 int64_t CZipFile::GetPosition()
 {
-  if (m_bCached)
-    return mFile.GetPosition();
-
   return m_iFilePos;
 }
 
 int64_t CZipFile::Seek(int64_t iFilePosition, int iWhence)
 {
-  if (m_bCached)
-    return mFile.Seek(iFilePosition,iWhence);
   if (mZipItem.method == 0) // this is easy
   {
     int64_t iResult;
@@ -164,73 +152,48 @@ int64_t CZipFile::Seek(int64_t iFilePosition, int iWhence)
 
     }
   }
-  // here goes the stupid part..
   if (mZipItem.method == 8)
   {
-    char temp[131072];
     switch (iWhence)
     {
     case SEEK_SET:
-      if (iFilePosition == m_iFilePos)
-        return m_iFilePos; // mp3reader does this lots-of-times
-      if (iFilePosition > mZipItem.usize || iFilePosition < 0)
-        return -1;
-      // read until position in 128k blocks.. only way to do it due to format.
-      // can't start in the middle of data since then we'd have no clue where
-      // we are in uncompressed data..
-      if (iFilePosition < m_iFilePos)
-      {
-        m_iFilePos = 0;
-        m_iZipFilePos = 0;
-        inflateEnd(&m_ZStream);
-        inflateInit2(&m_ZStream,-MAX_WBITS); // simply restart zlib
-        mFile.Seek(mZipItem.offset,SEEK_SET);
-        m_ZStream.next_in = (Bytef*)m_szBuffer;
-        m_ZStream.avail_in = 0;
-        m_ZStream.total_out = 0;
-        while (m_iFilePos < iFilePosition)
-        {
-          unsigned int iToRead = (iFilePosition-m_iFilePos)>131072?131072:(int)(iFilePosition-m_iFilePos);
-          if (Read(temp,iToRead) != iToRead)
-            return -1;
-        }
-        return m_iFilePos;
-      }
-      else // seek forward
-        return Seek(iFilePosition-m_iFilePos,SEEK_CUR);
       break;
-
     case SEEK_CUR:
-      if (iFilePosition < 0)
-        return Seek(m_iFilePos+iFilePosition,SEEK_SET); // can't rewind stream
-      // read until requested position, drop data
-      if (m_iFilePos+iFilePosition > mZipItem.usize)
-        return -1;
       iFilePosition += m_iFilePos;
-      while (m_iFilePos < iFilePosition)
-      {
-        unsigned int iToRead = (iFilePosition-m_iFilePos)>131072?131072:(int)(iFilePosition-m_iFilePos);
-        if (Read(temp,iToRead) != iToRead)
-          return -1;
-      }
-      return m_iFilePos;
       break;
-
     case SEEK_END:
-      // now this is a nasty bastard, possibly takes lotsoftime
-      // uncompress, minding m_ZStream.total_out
-
-      while( (int)m_ZStream.total_out < mZipItem.usize+iFilePosition)
-      {
-        unsigned int iToRead = (mZipItem.usize+iFilePosition-m_ZStream.total_out > 131072)?131072:(int)(mZipItem.usize+iFilePosition-m_ZStream.total_out);
-        if (Read(temp,iToRead) != iToRead)
-          return -1;
-      }
-      return m_iFilePos;
+      iFilePosition += mZipItem.usize;
       break;
     default:
       return -1;
     }
+
+    if (iFilePosition > mZipItem.usize || iFilePosition < 0)
+      return -1;
+    if (iFilePosition == m_iFilePos)
+      return m_iFilePos; // mp3reader does this lots-of-times
+
+    // can't start in the middle of a deflate block, so restart at the closest
+    // checkpoint before the position when seeking back, or when it lets us
+    // skip data going forward, and inflate the rest in 128k blocks.
+    const SCheckpoint* checkpoint = FindCheckpoint(iFilePosition);
+    if (iFilePosition < m_iFilePos || (checkpoint && checkpoint->out > m_iFilePos))
+    {
+      if (!RestoreCheckpoint(checkpoint))
+      {
+        CLog::Log(LOGERROR,"FileZip: unable to restart inflate at %"PRId64, checkpoint ? checkpoint->out : 0);
+        return -1;
+      }
+    }
+
+    char temp[131072];
+    while (m_iFilePos < iFilePosition)
+    {
+      unsigned int iToRead = (iFilePosition-m_iFilePos)>131072?131072:(int)(iFilePosition-m_iFilePos);
+      if (Read(temp,iToRead) != iToRead)
+        return -1;
+    }
+    return m_iFilePos;
   }
   return -1;
 }
@@ -277,9 +240,6 @@ int CZipFile::Stat(const CURL& url, struct __stat64* buffer)
 
 unsigned int CZipFile::Read(void* lpBuf, int64_t uiBufSize)
 {
-  if (m_bCached)
-    return mFile.Read(lpBuf,uiBufSize);
-
   // flush what might be left in the string buffer
   if (m_iDataInStringBuffer > 0)
   {
@@ -292,40 +252,30 @@ unsigned int CZipFile::Read(void* lpBuf, int64_t uiBufSize)
   {
     uLong iDecompressed = 0;
     uLong prevOut = m_ZStream.total_out;
-    while (((int)iDecompressed < uiBufSize) && ((m_iZipFilePos < mZipItem.csize) || (m_bFlush)))
+    while ((int64_t)iDecompressed < uiBufSize)
     {
+      if (!m_ZStream.avail_in)
+        FillBuffer(); // at eof zlib may still have output pending
+
       m_ZStream.next_out = (Bytef*)(lpBuf)+iDecompressed;
       m_ZStream.avail_out = static_cast<uInt>(uiBufSize-iDecompressed);
-      if (m_bFlush) // need to flush buffer !
-      {
-        int iMessage = inflate(&m_ZStream,Z_SYNC_FLUSH);
-        m_bFlush = ((iMessage == Z_OK) && (m_ZStream.avail_out == 0))?true:false;
-        if (!m_ZStream.avail_out) // flush filled buffer, get out of here
-        {
-          iDecompressed = m_ZStream.total_out-prevOut;
-          break;
-        }
-      }
 
-      if (!m_ZStream.avail_in)
-      {
-        if (!FillBuffer()) // eof!
-        {
-          iDecompressed = m_ZStream.total_out-prevOut;
-          break;
-        }
-      }
+      // Z_BLOCK returns at the end of each deflate block, where we can checkpoint
+      int iMessage = inflate(&m_ZStream,Z_BLOCK);
+      uLong iOut = m_ZStream.total_out-prevOut-iDecompressed;
+      UpdateWindow((unsigned char*)lpBuf+iDecompressed, iOut);
+      iDecompressed += iOut;
 
-      int iMessage = inflate(&m_ZStream,Z_SYNC_FLUSH);
+      if (iMessage == Z_STREAM_END || iMessage == Z_BUF_ERROR) // done, or eof
+        break;
       if (iMessage < 0)
       {
         Close();
         return 0; // READ ERROR
       }
 
-      m_bFlush = ((iMessage == Z_OK) && (m_ZStream.avail_out == 0))?true:false; // more info in input buffer
-
-      iDecompressed = m_ZStream.total_out-prevOut;
+      if ((m_ZStream.data_type & 128) && !(m_ZStream.data_type & 64))
+        AddCheckpoint(m_iFilePos+iDecompressed);
     }
     m_iFilePos += iDecompressed;
     return static_cast<unsigned int>(iDecompressed);
@@ -349,10 +299,11 @@ unsigned int CZipFile::Read(void* lpBuf, int64_t uiBufSize)
 
 void CZipFile::Close()
 {
-  if (mZipItem.method == 8 && !m_bCached && m_iRead != -1)
+  if (mZipItem.method == 8 && m_iRead != -1)
     inflateEnd(&m_ZStream);
 
   mFile.Close();
+  ClearCheckpoints();
 }
 /* CHANGED: JM - moved to CFile
 bool CZipFile::ReadString(char* szLine, int iLineLength)
@@ -442,18 +393,97 @@ bool CZipFile::FillBuffer()
   return true;
 }
 
-void CZipFile::DestroyBuffer(void* lpBuffer, int iBufSize)
+void CZipFile::UpdateWindow(const unsigned char* data, unsigned int size)
+{
+  if (size >= sizeof(m_window))
+  {
+    memcpy(m_window, data+size-sizeof(m_window), sizeof(m_window));
+    m_iWindowPos = 0;
+    m_iWindowSize = sizeof(m_window);
+    return;
+  }
+
+  unsigned int iFirst = std::min<unsigned int>(size, sizeof(m_window)-m_iWindowPos);
+  memcpy(m_window+m_iWindowPos, data, iFirst);
+  memcpy(m_window, data+iFirst, size-iFirst);
+  m_iWindowPos = (m_iWindowPos+size) % sizeof(m_window);
+  m_iWindowSize = std::min<unsigned int>(m_iWindowSize+size, sizeof(m_window));
+}
+
+void CZipFile::AddCheckpoint(int64_t iFilePosition)
 {
-  if (!m_bFlush)
+  // positions before the last checkpoint were indexed on an earlier pass
+  int64_t iLast = m_checkpoints.empty() ? 0 : m_checkpoints.back()->out;
+  int64_t iSpan = std::max<int64_t>(ZIP_CHECKPOINT_SPAN, (int64_t)mZipItem.usize / ZIP_CHECKPOINT_MAX);
+  if (iFilePosition-iLast < iSpan || m_checkpoints.size() >= ZIP_CHECKPOINT_MAX)
     return;
-  int iMessage = Z_OK;
-  while ((iMessage == Z_OK) && (m_ZStream.avail_out == 0))
+
+  SCheckpoint* checkpoint = new SCheckpoint;
+  checkpoint->out = iFilePosition;
+  checkpoint->in = m_iZipFilePos-m_ZStream.avail_in;
+  checkpoint->bits = m_ZStream.data_type & 7;
+  checkpoint->window = m_iWindowSize;
+
+  // unroll the window, oldest data first
+  unsigned int iStart = (m_iWindowPos+sizeof(m_window)-m_iWindowSize) % sizeof(m_window);
+  unsigned int iFirst = std::min<unsigned int>(m_iWindowSize, sizeof(m_window)-iStart);
+  memcpy(checkpoint->data, m_window+iStart, iFirst);
+  memcpy(checkpoint->data+iFirst, m_window, m_iWindowSize-iFirst);
+
+  m_checkpoints.push_back(checkpoint);
+}
+
+const CZipFile::SCheckpoint* CZipFile::FindCheckpoint(int64_t iFilePosition) const
+{
+  const SCheckpoint* checkpoint = NULL;
+  for (vector<SCheckpoint*>::const_iterator it = m_checkpoints.begin(); it != m_checkpoints.end() && (*it)->out <= iFilePosition; ++it)
+    checkpoint = *it;
+  return checkpoint;
+}
+
+bool CZipFile::RestoreCheckpoint(const SCheckpoint* checkpoint)
+{
+  inflateEnd(&m_ZStream);
+  if (inflateInit2(&m_ZStream,-MAX_WBITS) != Z_OK)
+  {
+    m_iRead = -1;
+    return false;
+  }
+  m_ZStream.next_in = (Bytef*)m_szBuffer;
+  m_ZStream.avail_in = 0;
+  m_iWindowPos = 0;
+  m_iWindowSize = 0;
+
+  if (!checkpoint) // no checkpoint before the position, restart at the beginning
   {
-    m_ZStream.next_out = (Bytef*)lpBuffer;
-    m_ZStream.avail_out = iBufSize;
-    iMessage = inflate(&m_ZStream,Z_SYNC_FLUSH);
+    m_iFilePos = 0;
+    m_iZipFilePos = 0;
+    return mFile.Seek(mZipItem.offset,SEEK_SET) == mZipItem.offset;
   }
-  m_bFlush = false;
+
+  if (checkpoint->bits)
+  {
+    // the block starts in the last byte of compressed data consumed
+    unsigned char ch;
+    if (mFile.Seek(mZipItem.offset+checkpoint->in-1,SEEK_SET) < 0 || mFile.Read(&ch,1) != 1)
+      return false;
+    inflatePrime(&m_ZStream, checkpoint->bits, ch >> (8-checkpoint->bits));
+  }
+  else if (mFile.Seek(mZipItem.offset+checkpoint->in,SEEK_SET) < 0)
+    return false;
+
+  inflateSetDictionary(&m_ZStream, checkpoint->data, checkpoint->window);
+  UpdateWindow(checkpoint->data, checkpoint->window);
+  m_iFilePos = checkpoint->out;
+  m_iZipFilePos = checkpoint->in;
+  return true;
+}
+
+void CZipFile::ClearCheckpoints()
+{
+  for (vector<SCheckpoint*>::iterator it = m_checkpoints.begin(); it != m_checkpoints.end(); ++it)
+    delete *it;
+  m_checkpoints.clear();
 }
 
 int CZipFile::UnpackFromMemory(string& strDest, const string& strInput, bool isGZ)
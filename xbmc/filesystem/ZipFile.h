@@ -27,6 +27,8 @@
 #include "File.h"
 #include "ZipManager.h"
 
+#include <vector>
+
 namespace XFILE
 {
   class CZipFile : public IFile
@@ -47,10 +49,28 @@ namespace XFILE
     virtual void Close();
 
     int UnpackFromMemory(std::string& strDest, const std::string& strInput, bool isGZ=false);
+
+    /* number of inflate checkpoints recorded for the open entry */
+    unsigned int GetCheckpointCount() const { return m_checkpoints.size(); }
   private:
+    /* state of the inflate stream at a deflate block boundary, enough to
+     * restart decompression there instead of at the start of the entry */
+    struct SCheckpoint
+    {
+      int64_t out;   // position in uncompressed data
+      int64_t in;    // position in compressed data of the first byte not fully consumed
+      int bits;      // bits of the byte before 'in' that belong to the next block
+      unsigned int window;   // bytes of history in data
+      unsigned char data[32768];
+    };
+
     bool InitDecompress();
     bool FillBuffer();
-    void DestroyBuffer(void* lpBuffer, int iBufSize);
+    void UpdateWindow(const unsigned char* data, unsigned int size);
+    void AddCheckpoint(int64_t iFilePosition);
+    bool RestoreCheckpoint(const SCheckpoint* checkpoint);
+    const SCheckpoint* FindCheckpoint(int64_t iFilePosition) const;
+    void ClearCheckpoints();
     CFile mFile;
     SZipEntry mZipItem;
     int64_t m_iFilePos; // position in _uncompressed_ data read
@@ -62,8 +82,11 @@ namespace XFILE
     char* m_szStartOfStringBuffer; // never allocated!
     int m_iDataInStringBuffer;
     int m_iRead;
-    bool m_bFlush;
-    bool m_bCached;
+
+    std::vector<SCheckpoint*> m_checkpoints;
+    unsigned char m_window[32768]; // last 32k of uncompressed data, circular
+    unsigned int m_iWindowPos;
+    unsigned int m_iWindowSize;
   };
 }
 
@@ -0,0 +1,254 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/BlockCache.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace XFILE;
+
+#define TEST_CACHE_PATH "special://temp/blockcachetest/"
+
+/* stands in for a network file, counts what is read from it */
+class CTestSource : public IFile
+{
+public:
+  CTestSource(unsigned int size, unsigned char seed)
+  {
+    m_position = 0;
+    m_read     = 0;
+    m_data.resize(size);
+    for (unsigned int i = 0; i < size; i++)
+      m_data[i] = (char)(i * 7 + seed + (i >> 12));
+  }
+
+  virtual bool Open(const CURL& url)                         { m_position = 0; return true; }
+  virtual bool Exists(const CURL& url)                       { return true; }
+  virtual int  Stat(const CURL& url, struct __stat64* buffer) { return -1; }
+  virtual void Close()                                       { }
+  virtual int64_t GetPosition()                              { return m_position; }
+  virtual int64_t GetLength()                                { return m_data.size(); }
+
+  virtual unsigned int Read(void* lpBuf, int64_t uiBufSize)
+  {
+    /* hand out odd sized pieces like a network file would */
+    int64_t size = std::min<int64_t>(std::min<int64_t>(uiBufSize, 50000), m_data.size() - m_position);
+    if (size <= 0)
+      return 0;
+    memcpy(lpBuf, &m_data[m_position], (size_t)size);
+    m_position += size;
+    m_read     += size;
+    return (unsigned int)size;
+  }
+
+  virtual int64_t Seek(int64_t iFilePosition, int iWhence = SEEK_SET)
+  {
+    if (iWhence != SEEK_SET || iFilePosition < 0 || iFilePosition > (int64_t)m_data.size())
+      return -1;
+    m_position = iFilePosition;
+    return m_position;
+  }
+
+  std::vector<char> m_data;
+  int64_t           m_position;
+  int64_t           m_read;
+};
+
+class TestBlockCache : public testing::Test
+{
+protected:
+  TestBlockCache()
+  {
+    RemoveCache();
+  }
+
+  ~TestBlockCache()
+  {
+    m_cache.Close();
+    RemoveCache();
+  }
+
+  void RemoveCache()
+  {
+    CFile::Delete(URIUtils::AddFileToFolder(TEST_CACHE_PATH, "index.dat"));
+    CFile::Delete(URIUtils::AddFileToFolder(TEST_CACHE_PATH, "blocks.dat"));
+    CDirectory::Remove(TEST_CACHE_PATH);
+  }
+
+  /* reads all of source through the cache in chunks, like CFileCache does */
+  bool ReadAll(CTestSource& source, const CBlockCache::SKey& key, int64_t start = 0)
+  {
+    CBlockCacheReader reader(m_cache);
+    reader.Open(&source, &key, source.GetLength());
+    if (!reader.IsCaching() || reader.Seek(start) != start)
+      return false;
+
+    std::vector<char> buffer(64 * 1024);
+    int64_t position = start;
+    int     read;
+    while ((read = reader.Read(&buffer[0], buffer.size())) > 0)
+    {
+      if (memcmp(&buffer[0], &source.m_data[(size_t)position], read))
+        return false;
+      position += read;
+    }
+    return read == 0 && position == source.GetLength();
+  }
+
+  CBlockCache m_cache;
+};
+
+TEST_F(TestBlockCache, ReadTwice)
+{
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 16 * CBlockCache::BLOCK_SIZE));
+
+  /* not a multiple of the block size, the last block is short */
+  CTestSource source(5 * CBlockCache::BLOCK_SIZE + 1234, 1);
+  CBlockCache::SKey key = CBlockCache::GetKey("smb://server/share/movie.mkv", source.GetLength(), 1000);
+
+  EXPECT_TRUE(ReadAll(source, key));
+  EXPECT_EQ(source.GetLength(), source.m_read);
+
+  source.m_read = 0;
+  EXPECT_TRUE(ReadAll(source, key));
+  EXPECT_EQ(0, source.m_read);
+
+  SBlockCacheStats stats;
+  m_cache.GetStats(stats);
+  EXPECT_EQ(6U, stats.hits);
+  EXPECT_EQ(6U, stats.misses);
+  EXPECT_EQ(6U, stats.blocks);
+  EXPECT_EQ((uint64_t)source.GetLength(), stats.bytesSaved);
+  EXPECT_EQ((uint64_t)source.GetLength(), stats.bytesStored);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRate());
+}
+
+TEST_F(TestBlockCache, SeekIntoBlock)
+{
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 16 * CBlockCache::BLOCK_SIZE));
+
+  CTestSource source(4 * CBlockCache::BLOCK_SIZE, 2);
+  CBlockCache::SKey key = CBlockCache::GetKey("nfs://server/movie.mkv", source.GetLength(), 1000);
+
+  /* starting in the middle of a block still stores it complete */
+  EXPECT_TRUE(ReadAll(source, key, CBlockCache::BLOCK_SIZE + 4321));
+  EXPECT_TRUE(m_cache.Contains(key, 1));
+  EXPECT_FALSE(m_cache.Contains(key, 0));
+
+  source.m_read = 0;
+  EXPECT_TRUE(ReadAll(source, key));
+  EXPECT_EQ(CBlockCache::BLOCK_SIZE, source.m_read);
+}
+
+TEST_F(TestBlockCache, Eviction)
+{
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 4 * CBlockCache::BLOCK_SIZE));
+
+  CTestSource first(3 * CBlockCache::BLOCK_SIZE, 3);
+  CTestSource second(3 * CBlockCache::BLOCK_SIZE, 4);
+  CBlockCache::SKey firstKey  = CBlockCache::GetKey("http://host/first.mkv", first.GetLength(), 0);
+  CBlockCache::SKey secondKey = CBlockCache::GetKey("http://host/second.mkv", second.GetLength(), 0);
+
+  EXPECT_TRUE(ReadAll(first, firstKey));
+  EXPECT_TRUE(ReadAll(second, secondKey));
+
+  /* the oldest blocks of the first file made room for the second */
+  SBlockCacheStats stats;
+  m_cache.GetStats(stats);
+  EXPECT_EQ(4U, stats.blocks);
+  EXPECT_EQ(2U, stats.evictions);
+  EXPECT_FALSE(m_cache.Contains(firstKey, 0));
+  EXPECT_FALSE(m_cache.Contains(firstKey, 1));
+  EXPECT_TRUE(m_cache.Contains(firstKey, 2));
+
+  /* the block that survived is still read from the cache */
+  first.m_read = 0;
+  EXPECT_TRUE(ReadAll(first, firstKey, 2 * CBlockCache::BLOCK_SIZE));
+  EXPECT_EQ(0, first.m_read);
+
+  /* reads after eviction are still right, partly from the source */
+  EXPECT_TRUE(ReadAll(first, firstKey));
+  EXPECT_TRUE(ReadAll(second, secondKey));
+  EXPECT_TRUE(ReadAll(first, firstKey));
+}
+
+TEST_F(TestBlockCache, FileChange)
+{
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 16 * CBlockCache::BLOCK_SIZE));
+
+  CTestSource before(2 * CBlockCache::BLOCK_SIZE, 5);
+  EXPECT_TRUE(ReadAll(before, CBlockCache::GetKey("smb://server/share/movie.mkv", before.GetLength(), 1000)));
+
+  /* same url and size, rewritten later with other content */
+  CTestSource after(2 * CBlockCache::BLOCK_SIZE, 6);
+  EXPECT_TRUE(ReadAll(after, CBlockCache::GetKey("smb://server/share/movie.mkv", after.GetLength(), 2000)));
+  EXPECT_EQ(after.GetLength(), after.m_read);
+}
+
+TEST_F(TestBlockCache, Persistent)
+{
+  CTestSource source(3 * CBlockCache::BLOCK_SIZE + 17, 7);
+  CBlockCache::SKey key = CBlockCache::GetKey("smb://server/share/movie.mkv", source.GetLength(), 1000);
+
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 8 * CBlockCache::BLOCK_SIZE));
+  EXPECT_TRUE(ReadAll(source, key));
+  m_cache.Close();
+
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 8 * CBlockCache::BLOCK_SIZE));
+  source.m_read = 0;
+  EXPECT_TRUE(ReadAll(source, key));
+  EXPECT_EQ(0, source.m_read);
+  m_cache.Close();
+
+  /* a cache of another size starts over */
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 12 * CBlockCache::BLOCK_SIZE));
+  EXPECT_FALSE(m_cache.Contains(key, 0));
+}
+
+TEST_F(TestBlockCache, DamagedBlock)
+{
+  CTestSource source(2 * CBlockCache::BLOCK_SIZE, 8);
+  CBlockCache::SKey key = CBlockCache::GetKey("smb://server/share/movie.mkv", source.GetLength(), 1000);
+
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 8 * CBlockCache::BLOCK_SIZE));
+  EXPECT_TRUE(ReadAll(source, key));
+  m_cache.Close();
+
+  /* overwrite part of the first slot, as if a crash hit the data write */
+  CFile data;
+  ASSERT_TRUE(data.OpenForWrite(URIUtils::AddFileToFolder(TEST_CACHE_PATH, "blocks.dat"), false));
+  char garbage[100];
+  memset(garbage, 0x5a, sizeof(garbage));
+  EXPECT_EQ(1000, data.Seek(1000, SEEK_SET));
+  EXPECT_EQ((int)sizeof(garbage), data.Write(garbage, sizeof(garbage)));
+  data.Close();
+
+  ASSERT_TRUE(m_cache.Open(TEST_CACHE_PATH, 8 * CBlockCache::BLOCK_SIZE));
+  source.m_read = 0;
+  EXPECT_TRUE(ReadAll(source, key));
+  EXPECT_EQ(CBlockCache::BLOCK_SIZE, source.m_read);
+}
@@ -0,0 +1,112 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/CircularCache.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace XFILE;
+
+#define FRONT_SIZE (48 * 1024)
+#define BACK_SIZE  (16 * 1024)
+#define CACHE_SIZE (FRONT_SIZE + BACK_SIZE)
+
+/* writes until the cache takes no more, returns the bytes written */
+static int Fill(CCircularCache& cache)
+{
+  char buffer[4096];
+  memset(buffer, 0x55, sizeof(buffer));
+
+  int total = 0;
+  int written;
+  while ((written = cache.WriteToCache(buffer, sizeof(buffer))) > 0)
+    total += written;
+  return total;
+}
+
+static int Drain(CCircularCache& cache, int size)
+{
+  char buffer[4096];
+  int total = 0;
+  while (total < size)
+  {
+    int read = cache.ReadFromCache(buffer, std::min((int)sizeof(buffer), size - total));
+    if (read <= 0)
+      break;
+    total += read;
+  }
+  return total;
+}
+
+class TestCircularCache : public testing::Test
+{
+protected:
+  TestCircularCache() : cache(FRONT_SIZE, BACK_SIZE)
+  {
+    cache.Open();
+
+    /* half of the buffer read, half still ahead */
+    EXPECT_EQ(CACHE_SIZE, Fill(cache));
+    EXPECT_EQ(CACHE_SIZE / 2, Drain(cache, CACHE_SIZE / 2));
+  }
+
+  ~TestCircularCache()
+  {
+    cache.Close();
+  }
+
+  CCircularCache cache;
+};
+
+TEST_F(TestCircularCache, DefaultBackBuffer)
+{
+  EXPECT_EQ(CACHE_SIZE / 2 - BACK_SIZE, Fill(cache));
+  EXPECT_EQ(CACHE_SIZE - BACK_SIZE, cache.WaitForData(0, 0));
+}
+
+TEST_F(TestCircularCache, ShortReadAheadKeepsHistory)
+{
+  cache.SetReadAhead(BACK_SIZE);
+
+  /* the front is already beyond the read ahead, so nothing read is dropped */
+  EXPECT_EQ(0, Fill(cache));
+  EXPECT_EQ(0, cache.Seek(0));
+}
+
+TEST_F(TestCircularCache, LongReadAheadFillsFront)
+{
+  cache.SetReadAhead(CACHE_SIZE * 2);
+
+  /* only a sixteenth of the buffer stays behind the reader */
+  EXPECT_EQ(CACHE_SIZE / 2 - CACHE_SIZE / 16, Fill(cache));
+  EXPECT_EQ(CACHE_SIZE - CACHE_SIZE / 16, cache.WaitForData(0, 0));
+  EXPECT_EQ(CACHE_RC_ERROR, cache.Seek(0));
+  EXPECT_EQ(CACHE_SIZE / 2 - CACHE_SIZE / 16, cache.Seek(CACHE_SIZE / 2 - CACHE_SIZE / 16));
+}
+
+TEST_F(TestCircularCache, ClearReadAhead)
+{
+  cache.SetReadAhead(CACHE_SIZE * 2);
+  cache.SetReadAhead(0);
+  EXPECT_EQ(CACHE_SIZE / 2 - BACK_SIZE, Fill(cache));
+}
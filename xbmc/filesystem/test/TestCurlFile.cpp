@@ -0,0 +1,405 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/CurlFile.h"
+#include "URL.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+
+#include "gtest/gtest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+using namespace XFILE;
+
+#define TEST_FILE_SIZE (6 * 1024 * 1024 + 12345)
+
+static unsigned char TestByte(int64_t pos)
+{
+  return (unsigned char)((pos * 7) ^ (pos >> 13));
+}
+
+/* a small http server on the loopback serving one generated file, with a
+ * thread per connection so range requests really run side by side */
+class CTestHttpServer : public CThread
+{
+public:
+  enum Mode
+  {
+    RANGES,         // answers range requests with 206
+    NO_RANGES,      // sends no Accept-Ranges at all
+    IGNORES_RANGES  // claims to accept ranges, but always sends the whole file
+  };
+
+  CTestHttpServer(Mode mode) : CThread("TestHttpServer")
+  {
+    m_mode     = mode;
+    m_socket   = -1;
+    m_port     = 0;
+    m_requests = 0;
+    m_ranges   = 0;
+  }
+
+  ~CTestHttpServer()
+  {
+    Stop();
+  }
+
+  bool Start()
+  {
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_socket < 0)
+      return false;
+
+    int yes = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = 0;
+    socklen_t len = sizeof(addr);
+    if (bind(m_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0
+    ||  listen(m_socket, 16) < 0
+    ||  getsockname(m_socket, (struct sockaddr*)&addr, &len) < 0)
+      return false;
+
+    m_port = ntohs(addr.sin_port);
+    Create();
+    return true;
+  }
+
+  void Stop()
+  {
+    StopThread();
+    for (std::vector<CConnection*>::iterator it = m_connections.begin(); it != m_connections.end(); ++it)
+      delete *it;
+    m_connections.clear();
+    if (m_socket >= 0)
+      close(m_socket);
+    m_socket = -1;
+  }
+
+  CStdString GetURL() const
+  {
+    CStdString url;
+    url.Format("http://127.0.0.1:%d/test.bin", m_port);
+    return url;
+  }
+
+  int GetRequests() { CSingleLock lock(m_section); return m_requests; }
+  int GetRanges()   { CSingleLock lock(m_section); return m_ranges; }
+
+protected:
+  class CConnection : public CThread
+  {
+  public:
+    CConnection(CTestHttpServer& server, int socket)
+      : CThread("TestHttpConnection"), m_server(server), m_socket(socket) {}
+
+    ~CConnection()
+    {
+      StopThread();
+      close(m_socket);
+    }
+
+  protected:
+    virtual void Process()
+    {
+      std::string request;
+      char buffer[1024];
+      while (!m_bStop)
+      {
+        size_t end = request.find("\r\n\r\n");
+        if (end == std::string::npos)
+        {
+          if (!Wait(true))
+            return;
+          ssize_t got = recv(m_socket, buffer, sizeof(buffer), 0);
+          if (got <= 0)
+            return;
+          request.append(buffer, got);
+          continue;
+        }
+
+        std::string header = request.substr(0, end);
+        request.erase(0, end + 4);
+        if (!Answer(header))
+          return;
+      }
+    }
+
+  private:
+    bool Wait(bool read)
+    {
+      while (!m_bStop)
+      {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(m_socket, &fds);
+        struct timeval tv = { 0, 100000 };
+        int ready = select(m_socket + 1, read ? &fds : NULL, read ? NULL : &fds, NULL, &tv);
+        if (ready < 0)
+          return false;
+        if (ready > 0)
+          return true;
+      }
+      return false;
+    }
+
+    bool Send(const char* data, size_t size)
+    {
+      while (size)
+      {
+        if (!Wait(false))
+          return false;
+        ssize_t sent = send(m_socket, data, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+          return false;
+        data += sent;
+        size -= sent;
+      }
+      return true;
+    }
+
+    bool Answer(const std::string& header)
+    {
+      bool head = header.compare(0, 5, "HEAD ") == 0;
+
+      int64_t start = 0;
+      int64_t end   = TEST_FILE_SIZE;
+      bool    range = false;
+      size_t  pos   = header.find("\r\nRange: bytes=");
+      if (pos != std::string::npos && m_server.m_mode == RANGES)
+      {
+        const char* value = header.c_str() + pos + 15;
+        char*       next;
+        start = strtoll(value, &next, 10);
+        if (*next == '-' && next[1] >= '0' && next[1] <= '9')
+          end = std::min((int64_t)strtoll(next + 1, NULL, 10) + 1, (int64_t)TEST_FILE_SIZE);
+        range = true;
+      }
+
+      {
+        CSingleLock lock(m_server.m_section);
+        m_server.m_requests++;
+        if (range)
+          m_server.m_ranges++;
+      }
+
+      std::string reply;
+      char line[256];
+      if (range)
+      {
+        sprintf(line, "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %lld-%lld/%d\r\n", (long long)start, (long long)end - 1, TEST_FILE_SIZE);
+        reply += line;
+      }
+      else
+        reply += "HTTP/1.1 200 OK\r\n";
+      if (m_server.m_mode != NO_RANGES)
+        reply += "Accept-Ranges: bytes\r\n";
+      sprintf(line, "Content-Type: application/octet-stream\r\nContent-Length: %lld\r\n\r\n", (long long)(end - start));
+      reply += line;
+      if (!Send(reply.c_str(), reply.size()))
+        return false;
+      if (head)
+        return true;
+
+      char data[16384];
+      for (int64_t p = start; p < end; )
+      {
+        size_t size = (size_t)std::min((int64_t)sizeof(data), end - p);
+        for (size_t i = 0; i < size; i++)
+          data[i] = TestByte(p + i);
+        if (!Send(data, size))
+          return false;
+        p += size;
+      }
+      return true;
+    }
+
+    CTestHttpServer& m_server;
+    int              m_socket;
+  };
+
+  virtual void Process()
+  {
+    while (!m_bStop)
+    {
+      fd_set fds;
+      FD_ZERO(&fds);
+      FD_SET(m_socket, &fds);
+      struct timeval tv = { 0, 100000 };
+      if (select(m_socket + 1, &fds, NULL, NULL, &tv) <= 0)
+        continue;
+
+      int client = accept(m_socket, NULL, NULL);
+      if (client < 0)
+        continue;
+
+      CConnection* connection = new CConnection(*this, client);
+      m_connections.push_back(connection);
+      connection->Create();
+    }
+  }
+
+  Mode                      m_mode;
+  int                       m_socket;
+  int                       m_port;
+  CCriticalSection          m_section;
+  int                       m_requests;
+  int                       m_ranges;
+  std::vector<CConnection*> m_connections;
+};
+
+class TestCurlFile : public testing::Test
+{
+protected:
+  TestCurlFile()
+  {
+    m_connections = g_advancedSettings.m_curlconnections;
+    g_advancedSettings.m_curlconnections = 4;
+  }
+
+  ~TestCurlFile()
+  {
+    g_advancedSettings.m_curlconnections = m_connections;
+  }
+
+  /* reads size bytes at the current position and checks them */
+  static bool ReadAndCheck(CCurlFile& file, int64_t size)
+  {
+    int64_t pos = file.GetPosition();
+    std::vector<unsigned char> buffer(65536);
+    while (size > 0)
+    {
+      unsigned int read = file.Read(&buffer[0], std::min((int64_t)buffer.size(), size));
+      if (!read)
+        return false;
+      for (unsigned int i = 0; i < read; i++)
+      {
+        if (buffer[i] != TestByte(pos + i))
+          return false;
+      }
+      pos  += read;
+      size -= read;
+    }
+    return file.GetPosition() == pos;
+  }
+
+  int m_connections;
+};
+
+TEST_F(TestCurlFile, RangesReadInOrder)
+{
+  CTestHttpServer server(CTestHttpServer::RANGES);
+  ASSERT_TRUE(server.Start());
+
+  CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_EQ(TEST_FILE_SIZE, file.GetLength());
+  EXPECT_TRUE(ReadAndCheck(file, TEST_FILE_SIZE));
+  char last;
+  EXPECT_EQ(0U, file.Read(&last, 1));
+  file.Close();
+
+  /* one range per segment, the first connection is dropped */
+  EXPECT_EQ(7, server.GetRanges());
+}
+
+TEST_F(TestCurlFile, RangesSeek)
+{
+  CTestHttpServer server(CTestHttpServer::RANGES);
+  ASSERT_TRUE(server.Start());
+
+  CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_TRUE(ReadAndCheck(file, 1000));
+
+  /* within what is buffered already */
+  EXPECT_EQ(5000, file.Seek(5000, SEEK_SET));
+  EXPECT_TRUE(ReadAndCheck(file, 3000));
+
+  /* across segments, backwards and up to the end */
+  EXPECT_EQ(3 * 1024 * 1024 + 17, file.Seek(3 * 1024 * 1024 + 17, SEEK_SET));
+  EXPECT_TRUE(ReadAndCheck(file, 2 * 1024 * 1024));
+  EXPECT_EQ(100, file.Seek(100, SEEK_SET));
+  EXPECT_TRUE(ReadAndCheck(file, 1024 * 1024));
+  EXPECT_EQ(TEST_FILE_SIZE - 500, file.Seek(-500, SEEK_END));
+  EXPECT_TRUE(ReadAndCheck(file, 500));
+  file.Close();
+
+  EXPECT_GT(server.GetRanges(), 4);
+}
+
+TEST_F(TestCurlFile, FallbackWithoutAcceptRanges)
+{
+  CTestHttpServer server(CTestHttpServer::NO_RANGES);
+  ASSERT_TRUE(server.Start());
+
+  CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_TRUE(ReadAndCheck(file, TEST_FILE_SIZE));
+  file.Close();
+
+  EXPECT_EQ(1, server.GetRequests());
+  EXPECT_EQ(0, server.GetRanges());
+}
+
+TEST_F(TestCurlFile, FallbackWhenRangeIgnored)
+{
+  CTestHttpServer server(CTestHttpServer::IGNORES_RANGES);
+  ASSERT_TRUE(server.Start());
+
+  CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_TRUE(ReadAndCheck(file, 2 * 1024 * 1024));
+  EXPECT_TRUE(ReadAndCheck(file, TEST_FILE_SIZE - 2 * 1024 * 1024));
+  file.Close();
+
+  EXPECT_EQ(0, server.GetRanges());
+}
+
+TEST_F(TestCurlFile, DisabledByDefault)
+{
+  g_advancedSettings.m_curlconnections = 1;
+
+  CTestHttpServer server(CTestHttpServer::RANGES);
+  ASSERT_TRUE(server.Start());
+
+  CCurlFile file;
+  ASSERT_TRUE(file.Open(CURL(server.GetURL())));
+  EXPECT_TRUE(ReadAndCheck(file, TEST_FILE_SIZE));
+  file.Close();
+
+  EXPECT_EQ(1, server.GetRequests());
+}
@@ -19,6 +19,8 @@
  */
 
 #include "filesystem/Directory.h"
+#include "filesystem/DirectoryCache.h"
+#include "filesystem/File.h"
 #include "filesystem/SpecialProtocol.h"
 #include "FileItem.h"
 #include "utils/URIUtils.h"
@@ -52,3 +54,103 @@ TEST(TestDirectory, General)
   EXPECT_TRUE(XFILE::CDirectory::Remove(tmppath1));
   EXPECT_FALSE(XFILE::CDirectory::Exists(tmppath1));
 }
+
+/* lists a fixed directory, counting how often it is asked to */
+class CTestListingDirectory : public XFILE::IDirectory
+{
+public:
+  CTestListingDirectory() : m_listings(0) {}
+  virtual bool GetDirectory(const CStdString& strPath, CFileItemList &items)
+  {
+    m_listings++;
+    CFileItemPtr item(new CFileItem(URIUtils::AddFileToFolder(strPath, "movie.nfo"), false));
+    item->m_dwSize = 42;
+    items.Add(item);
+    items.Add(CFileItemPtr(new CFileItem(URIUtils::AddFileToFolder(strPath, "movie.avi"), false)));
+    return true;
+  }
+  virtual bool StatFiles(const CStdString& strPath, const std::vector<CStdString>& files,
+                         std::vector<XFILE::SFileStat>& results, CFileItemList &items)
+  {
+    return StatFromListing(strPath, files, results, items);
+  }
+  int m_listings;
+};
+
+TEST(TestDirectory, StatFromListing)
+{
+  CTestListingDirectory dir;
+  std::vector<CStdString> files;
+  std::vector<XFILE::SFileStat> results;
+  CFileItemList items;
+  files.push_back("smb://server/share/movie.nfo");
+  files.push_back("smb://server/share/movie.tbn");
+  files.push_back("smb://server/share/movie.avi");
+
+  EXPECT_TRUE(dir.StatFiles("smb://server/share/", files, results, items));
+  EXPECT_EQ(1, dir.m_listings);
+  ASSERT_EQ(3U, results.size());
+  EXPECT_TRUE(results[0].exists);
+  EXPECT_EQ(42, results[0].stat.st_size);
+  EXPECT_FALSE(results[1].exists);
+  EXPECT_TRUE(results[2].exists);
+  EXPECT_EQ(2, items.Size());
+}
+
+TEST(TestDirectory, StatFiles)
+{
+  CStdString tmppath;
+  CFileItemList items;
+  XFILE::CFile file;
+  std::vector<CStdString> files;
+  std::vector<XFILE::SFileStat> results;
+  tmppath = CSpecialProtocol::TranslatePath("special://temp/");
+  tmppath = URIUtils::AddFileToFolder(tmppath, "TestDirectoryStat");
+  ASSERT_TRUE(XFILE::CDirectory::Create(tmppath));
+  files.push_back(URIUtils::AddFileToFolder(tmppath, "movie.nfo"));
+  files.push_back(URIUtils::AddFileToFolder(tmppath, "movie.tbn"));
+  files.push_back(URIUtils::AddFileToFolder(tmppath, "fanart.jpg"));
+  ASSERT_TRUE(file.OpenForWrite(files[0], true));
+  EXPECT_EQ(5, file.Write("<nfo>", 5));
+  file.Close();
+  ASSERT_TRUE(file.OpenForWrite(files[2], true));
+  EXPECT_EQ(3, file.Write("jpg", 3));
+  file.Close();
+  g_directoryCache.ClearDirectory(tmppath);
+
+  // local files are checked one by one
+  XFILE::CDirectory::ResetStatCounters();
+  XFILE::CDirectory::StatFiles(tmppath, files, results);
+  ASSERT_EQ(3U, results.size());
+  EXPECT_TRUE(results[0].exists);
+  EXPECT_EQ(5, results[0].stat.st_size);
+  EXPECT_FALSE(results[1].exists);
+  EXPECT_TRUE(results[2].exists);
+  EXPECT_EQ(3, results[2].stat.st_size);
+
+  XFILE::CDirectory::SStatCounters counters = XFILE::CDirectory::GetStatCounters();
+  EXPECT_EQ(1U, counters.batches);
+  EXPECT_EQ(3U, counters.files);
+  EXPECT_EQ(3U, counters.roundtrips);
+  EXPECT_EQ(0U, counters.cached);
+
+  // once the directory is cached no round trips are needed
+  EXPECT_TRUE(XFILE::CDirectory::GetDirectory(tmppath, items));
+  XFILE::CDirectory::StatFiles(tmppath, files, results);
+  ASSERT_EQ(3U, results.size());
+  EXPECT_TRUE(results[0].exists);
+  EXPECT_EQ(5, results[0].stat.st_size);
+  EXPECT_FALSE(results[1].exists);
+  EXPECT_TRUE(results[2].exists);
+
+  counters = XFILE::CDirectory::GetStatCounters();
+  EXPECT_EQ(2U, counters.batches);
+  EXPECT_EQ(6U, counters.files);
+  EXPECT_EQ(3U, counters.roundtrips);
+  EXPECT_EQ(1U, counters.cached);
+
+  g_directoryCache.ClearDirectory(tmppath);
+  EXPECT_TRUE(XFILE::CFile::Delete(files[0]));
+  EXPECT_TRUE(XFILE::CFile::Delete(files[2]));
+  EXPECT_TRUE(XFILE::CDirectory::Remove(tmppath));
+}
@@ -0,0 +1,230 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/DirectoryCache.h"
+#include "settings/AdvancedSettings.h"
+#include "FileItem.h"
+
+#include "gtest/gtest.h"
+
+/* a listing of count files in path */
+static void FillListing(const CStdString& path, int count, CFileItemList& items)
+{
+  items.Clear();
+  items.SetPath(path);
+  for (int i = 0; i < count; i++)
+  {
+    CStdString file;
+    file.Format("%s/file%d.avi", path.c_str(), i);
+    CFileItemPtr item(new CFileItem(file, false));
+    item->m_dwSize = i;
+    items.Add(item);
+  }
+}
+
+/* collects the paths it is told about */
+class CTestCacheCallback : public XFILE::IDirectoryCacheCallback
+{
+public:
+  virtual void OnDirectoryInvalidated(const CStdString& strPath)
+  {
+    paths.push_back(strPath);
+  }
+
+  std::vector<CStdString> paths;
+};
+
+class TestDirectoryCache : public testing::Test
+{
+protected:
+  TestDirectoryCache()
+  {
+    m_size = g_advancedSettings.m_dirCacheSize;
+    m_ttl  = g_advancedSettings.m_dirCacheTTL;
+  }
+
+  ~TestDirectoryCache()
+  {
+    g_advancedSettings.m_dirCacheSize = m_size;
+    g_advancedSettings.m_dirCacheTTL  = m_ttl;
+  }
+
+  unsigned int m_size;
+  std::map<CStdString, unsigned int> m_ttl;
+};
+
+TEST_F(TestDirectoryCache, GetDirectory)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("smb://host/share/always", 3, items);
+  cache.SetDirectory("smb://host/share/always/", items, XFILE::DIR_CACHE_ALWAYS);
+  FillListing("smb://host/share/once", 3, items);
+  cache.SetDirectory("smb://host/share/once", items, XFILE::DIR_CACHE_ONCE);
+  FillListing("smb://host/share/never", 3, items);
+  cache.SetDirectory("smb://host/share/never", items, XFILE::DIR_CACHE_NEVER);
+
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/always", cached));
+  ASSERT_EQ(3, cached.Size());
+  EXPECT_STREQ("smb://host/share/always/file2.avi", cached[2]->GetPath().c_str());
+
+  // callers get their own items
+  cached[2]->SetPath("smb://host/share/always/changed.avi");
+  cached.Clear();
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/always", cached));
+  EXPECT_STREQ("smb://host/share/always/file2.avi", cached[2]->GetPath().c_str());
+
+  cached.Clear();
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/once", cached));
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/once", cached, true));
+  EXPECT_EQ(3, cached.Size());
+  cached.Clear();
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/never", cached, true));
+
+  bool inCache;
+  EXPECT_TRUE(cache.FileExists("smb://host/share/once/file1.avi", inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_FALSE(cache.FileExists("smb://host/share/once/file9.avi", inCache));
+  EXPECT_TRUE(inCache);
+  EXPECT_FALSE(cache.FileExists("smb://host/share/never/file1.avi", inCache));
+  EXPECT_FALSE(inCache);
+
+  XFILE::SDirectoryCacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(2U, stats.dirs);
+  EXPECT_EQ(6U, stats.items);
+  EXPECT_GT(stats.bytes, 0U);
+}
+
+TEST_F(TestDirectoryCache, Eviction)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("smb://host/share/a", 100, items);
+  unsigned int size = XFILE::CDirectoryCache::EstimateSize(items);
+
+  // room for two listings
+  g_advancedSettings.m_dirCacheSize = size * 2 + size / 2;
+  cache.SetDirectory("smb://host/share/a", items, XFILE::DIR_CACHE_ONCE);
+  FillListing("smb://host/share/b", 100, items);
+  cache.SetDirectory("smb://host/share/b", items, XFILE::DIR_CACHE_ONCE);
+
+  // a was used last, so b is evicted for c
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/a", cached, true));
+  FillListing("smb://host/share/c", 100, items);
+  cache.SetDirectory("smb://host/share/c", items, XFILE::DIR_CACHE_ONCE);
+
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/a", cached, true));
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/b", cached, true));
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/c", cached, true));
+
+  XFILE::SDirectoryCacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(2U, stats.dirs);
+  EXPECT_EQ(1U, stats.evictions);
+  EXPECT_LE(stats.bytes, stats.maxBytes);
+
+  // listings that are always cached stay
+  FillListing("smb://host/share/always", 100, items);
+  cache.SetDirectory("smb://host/share/always", items, XFILE::DIR_CACHE_ALWAYS);
+  FillListing("smb://host/share/d", 100, items);
+  cache.SetDirectory("smb://host/share/d", items, XFILE::DIR_CACHE_ONCE);
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/always", cached));
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share/d", cached, true));
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/a", cached, true));
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/c", cached, true));
+}
+
+TEST_F(TestDirectoryCache, TTL)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items, cached;
+  g_advancedSettings.m_dirCacheTTL["upnp"] = 1;
+  FillListing("upnp://server/folder", 3, items);
+  cache.SetDirectory("upnp://server/folder", items, XFILE::DIR_CACHE_ALWAYS);
+  FillListing("smb://host/share", 3, items);
+  cache.SetDirectory("smb://host/share", items, XFILE::DIR_CACHE_ALWAYS);
+
+  EXPECT_TRUE(cache.GetDirectory("upnp://server/folder", cached));
+  Sleep(1100);
+  cached.Clear();
+  EXPECT_FALSE(cache.GetDirectory("upnp://server/folder", cached));
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share", cached));
+
+  XFILE::SDirectoryCacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(1U, stats.expirations);
+  EXPECT_EQ(1U, stats.dirs);
+}
+
+TEST_F(TestDirectoryCache, Invalidation)
+{
+  XFILE::CDirectoryCache cache;
+  CTestCacheCallback callback;
+  CFileItemList items, cached;
+  cache.RegisterCallback(&callback);
+
+  FillListing("smb://host/share/a", 3, items);
+  cache.SetDirectory("smb://host/share/a", items, XFILE::DIR_CACHE_ALWAYS);
+  FillListing("smb://host/share/a/b", 3, items);
+  cache.SetDirectory("smb://host/share/a/b", items, XFILE::DIR_CACHE_ALWAYS);
+  FillListing("smb://host/share/c", 3, items);
+  cache.SetDirectory("smb://host/share/c", items, XFILE::DIR_CACHE_ALWAYS);
+
+  cache.ClearFile("smb://host/share/c/file0.avi");
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/c", cached));
+  cache.ClearSubPaths("smb://host/share/a/");
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/a", cached));
+  EXPECT_FALSE(cache.GetDirectory("smb://host/share/a/b", cached));
+  cache.Clear();
+
+  ASSERT_EQ(3U, callback.paths.size());
+  EXPECT_STREQ("smb://host/share/c", callback.paths[0].c_str());
+  EXPECT_STREQ("smb://host/share/a", callback.paths[1].c_str());
+  EXPECT_STREQ("", callback.paths[2].c_str());
+
+  cache.UnregisterCallback(&callback);
+  cache.Clear();
+  EXPECT_EQ(3U, callback.paths.size());
+
+  XFILE::SDirectoryCacheStats stats;
+  cache.GetStats(stats);
+  EXPECT_EQ(0U, stats.dirs);
+  EXPECT_EQ(0U, stats.bytes);
+}
+
+TEST_F(TestDirectoryCache, AddFile)
+{
+  XFILE::CDirectoryCache cache;
+  CFileItemList items, cached;
+  FillListing("smb://host/share", 3, items);
+  cache.SetDirectory("smb://host/share", items, XFILE::DIR_CACHE_ALWAYS);
+
+  XFILE::SDirectoryCacheStats before, after;
+  cache.GetStats(before);
+  cache.AddFile("smb://host/share/new.avi");
+  cache.GetStats(after);
+  EXPECT_GT(after.bytes, before.bytes);
+
+  bool inCache;
+  EXPECT_TRUE(cache.FileExists("smb://host/share/new.avi", inCache));
+  EXPECT_TRUE(cache.GetDirectory("smb://host/share", cached));
+  EXPECT_EQ(4, cached.Size());
+}
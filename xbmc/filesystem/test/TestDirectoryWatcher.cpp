@@ -0,0 +1,99 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "filesystem/Directory.h"
+#include "filesystem/DirectoryWatcher.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+class TestDirectoryWatcher : public testing::Test
+{
+protected:
+  TestDirectoryWatcher()
+  {
+    XFILE::CFile *file = XBMC_CREATETEMPFILE("");
+    m_folder = XBMC_TEMPFILEPATH(file) + ".dir/";
+    XBMC_DELETETEMPFILE(file);
+    XFILE::CDirectory::Create(m_folder);
+  }
+
+  ~TestDirectoryWatcher()
+  {
+    XFILE::CFile::Delete(m_folder + "file");
+    XFILE::CDirectory::Remove(m_folder);
+  }
+
+  static void CreateFile(const CStdString& path)
+  {
+    XFILE::CFile file;
+    ASSERT_TRUE(file.OpenForWrite(path, true));
+    file.Write("x", 1);
+    file.Close();
+  }
+
+  CStdString m_folder;
+};
+
+TEST_F(TestDirectoryWatcher, Remote)
+{
+  EXPECT_FALSE(XFILE::CDirectoryWatcher::IsSupported("smb://server/share/"));
+  EXPECT_FALSE(XFILE::CDirectoryWatcher::IsSupported("nfs://server/export/"));
+
+  XFILE::CDirectoryWatcher watcher;
+  EXPECT_FALSE(watcher.Watch("smb://server/share/"));
+  EXPECT_FALSE(watcher.IsWatched("smb://server/share/"));
+}
+
+#ifdef HAVE_INOTIFY
+TEST_F(TestDirectoryWatcher, Changes)
+{
+  XFILE::CDirectoryWatcher watcher;
+  ASSERT_TRUE(watcher.Watch(m_folder));
+  EXPECT_TRUE(watcher.IsWatched(m_folder));
+  EXPECT_FALSE(watcher.HasChanged(m_folder));
+
+  CreateFile(m_folder + "file");
+  EXPECT_TRUE(watcher.HasChanged(m_folder));
+
+  // watching again starts over
+  EXPECT_TRUE(watcher.Watch(m_folder));
+  EXPECT_FALSE(watcher.HasChanged(m_folder));
+
+  // rewriting a file in place doesn't touch the folder but is a change
+  CreateFile(m_folder + "file");
+  std::set<CStdString> changes;
+  watcher.GetChanges(changes);
+  EXPECT_EQ(1U, changes.size());
+  EXPECT_EQ(1U, changes.count(m_folder));
+  EXPECT_FALSE(watcher.HasChanged(m_folder));
+}
+
+TEST_F(TestDirectoryWatcher, Removed)
+{
+  XFILE::CDirectoryWatcher watcher;
+  ASSERT_TRUE(watcher.Watch(m_folder));
+  XFILE::CDirectory::Remove(m_folder);
+  EXPECT_TRUE(watcher.HasChanged(m_folder));
+  EXPECT_FALSE(watcher.IsWatched(m_folder));
+}
+#endif
@@ -19,6 +19,8 @@
  */
 
 #include "filesystem/File.h"
+#include "filesystem/FileReadRequest.h"
+#include "threads/Atomics.h"
 #include "test/TestUtils.h"
 
 #include <errno.h>
@@ -72,6 +74,94 @@ TEST(TestFile, Read)
   file.Close();
 }
 
+TEST(TestFile, Peek)
+{
+  XFILE::CFile file;
+  const void* data;
+  char buf[20];
+
+  // files that aren't mapped can't be peeked
+  ASSERT_TRUE(file.Open(
+    XBMC_REF_FILE_PATH("/xbmc/filesystem/test/reffile.txt")));
+  EXPECT_EQ(-1, file.Peek(&data, 20));
+  file.Close();
+
+  ASSERT_TRUE(file.Open(
+    XBMC_REF_FILE_PATH("/xbmc/filesystem/test/reffile.txt"), READ_MMAP));
+  int available = file.Peek(&data, 20);
+  if (available < 0)
+    return; // no memory mapping on this platform
+  EXPECT_EQ(20, available);
+  EXPECT_TRUE(!memcmp("About\n-----\nXBMC is ", data, 20));
+  EXPECT_EQ(0, file.GetPosition());
+  file.Consume(20);
+  EXPECT_EQ(20, file.GetPosition());
+
+  // reads and seeks go through the mapping as well
+  EXPECT_EQ(100, file.Seek(100));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_TRUE(!memcmp("ent hub for digital ", buf, sizeof(buf)));
+  EXPECT_EQ(1596, file.Seek(-(int64_t)sizeof(buf), SEEK_END));
+  EXPECT_EQ(20, file.Peek(&data, 100));
+  EXPECT_TRUE(!memcmp("multimedia jukebox.\n", data, 20));
+  file.Consume(20);
+  EXPECT_EQ(0, file.Peek(&data, 100));
+  EXPECT_EQ(0U, file.Read(buf, sizeof(buf)));
+  file.Close();
+}
+
+/* counts the completed reads */
+class CTestReadCallback : public XFILE::IFileReadCallback
+{
+public:
+  CTestReadCallback() : m_completed(0) {}
+  virtual void OnReadComplete(XFILE::CFileReadRequest* request)
+  {
+    AtomicIncrement(&m_completed);
+  }
+  long m_completed;
+};
+
+TEST(TestFile, ReadAsync)
+{
+  XFILE::CFile file;
+  CTestReadCallback callback;
+  char buf[4][20];
+  memset(&buf, 0, sizeof(buf));
+
+  ASSERT_TRUE(file.Open(
+    XBMC_REF_FILE_PATH("/xbmc/filesystem/test/reffile.txt")));
+  XFILE::CFileReadRequest requests[4];
+  requests[0].Set(buf[0], sizeof(buf[0]), 0, &callback);
+  requests[1].Set(buf[1], sizeof(buf[1]), 100, &callback);
+  requests[2].Set(buf[2], sizeof(buf[2]), 1596, &callback);
+  requests[3].Set(buf[3], sizeof(buf[3]), 1606, &callback);
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(file.ReadAsync(&requests[i]));
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(requests[i].Wait(10000));
+  file.WaitAsync();
+
+  EXPECT_EQ(4, callback.m_completed);
+  EXPECT_EQ(20, requests[0].GetResult());
+  EXPECT_TRUE(!memcmp("About\n-----\nXBMC is ", buf[0], sizeof(buf[0])));
+  EXPECT_EQ(20, requests[1].GetResult());
+  EXPECT_TRUE(!memcmp("ent hub for digital ", buf[1], sizeof(buf[1])));
+  EXPECT_EQ(20, requests[2].GetResult());
+  EXPECT_TRUE(!memcmp("multimedia jukebox.\n", buf[2], sizeof(buf[2])));
+  // reads past the end are short
+  EXPECT_EQ(10, requests[3].GetResult());
+  EXPECT_TRUE(!memcmp("jukebox.\n", buf[3] + 1, 9));
+
+  // a complete request can be queued again
+  requests[0].Set(buf[0], sizeof(buf[0]), 220);
+  EXPECT_TRUE(file.ReadAsync(&requests[0]));
+  requests[0].Wait();
+  EXPECT_EQ(20, requests[0].GetResult());
+  EXPECT_TRUE(!memcmp("rs, XBMC is a non-pr", buf[0], sizeof(buf[0])));
+  file.Close();
+}
+
 TEST(TestFile, Write)
 {
   XFILE::CFile *file;
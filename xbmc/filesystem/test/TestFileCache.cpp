@@ -0,0 +1,98 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "filesystem/FileCache.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+#define CHUNK_SIZE (64 * 1024)
+#define MAX_CHUNK  (1024 * 1024)
+/* the default of advancedsettings.xml <network><cachereadahead> */
+#define SECONDS    30
+
+TEST(TestFileCache, ReadAheadTarget)
+{
+  CReadAhead readahead(CHUNK_SIZE, SECONDS);
+  EXPECT_EQ((unsigned)CHUNK_SIZE, readahead.GetChunkSize());
+  EXPECT_EQ((unsigned)MAX_CHUNK, readahead.GetMaxChunkSize());
+
+  // no limit until the reader's rate is known
+  EXPECT_EQ(0u, readahead.GetTarget(0));
+
+  // the seconds at the reader's rate, but never less than a few of the largest reads
+  EXPECT_EQ((uint64_t)SECONDS * 1000000, readahead.GetTarget(1000000));
+  EXPECT_EQ((uint64_t)4 * MAX_CHUNK, readahead.GetTarget(10000));
+
+  // no seconds configured is no limit
+  CReadAhead unlimited(CHUNK_SIZE, 0);
+  EXPECT_EQ(0u, unlimited.GetTarget(1000000));
+}
+
+TEST(TestFileCache, ReadAheadSlowSource)
+{
+  CReadAhead readahead(CHUNK_SIZE, SECONDS);
+
+  // the fill rate is measured over two seconds, this source gives 1.2-1.5 MB/s
+  Sleep(2100);
+  readahead.AddFill(3 * 1024 * 1024);
+  unsigned fill = readahead.GetFillRate();
+  ASSERT_LT(0u, fill);
+
+  // a reader that takes more than half of it gets double the margin
+  EXPECT_EQ((uint64_t)SECONDS * fill * 2, readahead.GetTarget(fill));
+  EXPECT_EQ((uint64_t)SECONDS * (fill / 3), readahead.GetTarget(fill / 3));
+
+  // the reads grow with the source, in whole chunks
+  EXPECT_LE((unsigned)CHUNK_SIZE, readahead.GetChunkSize());
+  EXPECT_GE((unsigned)MAX_CHUNK, readahead.GetChunkSize());
+  EXPECT_EQ(0u, readahead.GetChunkSize() % CHUNK_SIZE);
+}
+
+TEST(TestFileCache, ReadAheadIsAhead)
+{
+  CReadAhead readahead(CHUNK_SIZE, SECONDS);
+  const unsigned consume = 1000000;
+  const int64_t target = (int64_t)readahead.GetTarget(consume);
+
+  EXPECT_FALSE(readahead.IsAhead(0, consume));
+  EXPECT_FALSE(readahead.IsAhead(target - 1, consume));
+
+  // stops at the target and stays stopped until half of it is used
+  EXPECT_TRUE(readahead.IsAhead(target, consume));
+  EXPECT_TRUE(readahead.IsAhead(target / 2, consume));
+  EXPECT_FALSE(readahead.IsAhead(target / 2 - 1, consume));
+
+  // and keeps reading until the target again
+  EXPECT_FALSE(readahead.IsAhead(target - 1, consume));
+  EXPECT_TRUE(readahead.IsAhead(target + 1, consume));
+
+  // a seek behind the cache or an unknown reader rate always reads
+  EXPECT_FALSE(readahead.IsAhead(-1, consume));
+  EXPECT_TRUE(readahead.IsAhead(target, consume));
+  EXPECT_FALSE(readahead.IsAhead(target, 0));
+
+  // and so does a reset
+  EXPECT_TRUE(readahead.IsAhead(target, consume));
+  readahead.Reset();
+  EXPECT_FALSE(readahead.IsAhead(target / 2, consume));
+}
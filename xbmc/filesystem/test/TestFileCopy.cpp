@@ -0,0 +1,146 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/File.h"
+#include "filesystem/FileCopy.h"
+#include "test/TestUtils.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+class TestFileCopy : public testing::Test
+{
+protected:
+  TestFileCopy()
+  {
+    // a few blocks and a bit of the copies
+    m_data.resize(4096 * 10 + 123);
+    for (size_t i = 0; i < m_data.size(); i++)
+      m_data[i] = (uint8_t)(i % 251);
+
+    XFILE::CFile *file = XBMC_CREATETEMPFILE("");
+    m_source = XBMC_TEMPFILEPATH(file);
+    file->Close();
+    delete file;
+    m_dest = m_source + ".copy";
+    WriteFile(m_source, &m_data[0], m_data.size());
+  }
+
+  ~TestFileCopy()
+  {
+    XFILE::CFile::Delete(m_source);
+    XFILE::CFile::Delete(m_dest);
+    XFILE::CFile::Delete(XFILE::CFileCopy::GetPartialPath(m_dest));
+  }
+
+  static void WriteFile(const CStdString& path, const uint8_t* data, size_t size)
+  {
+    XFILE::CFile file;
+    ASSERT_TRUE(file.OpenForWrite(path, true));
+    EXPECT_EQ((int)size, file.Write(data, size));
+    file.Close();
+  }
+
+  bool IsCopy(const CStdString& path)
+  {
+    XFILE::CFile file;
+    std::vector<uint8_t> data(m_data.size() + 1);
+    if (!file.Open(path))
+      return false;
+    unsigned int total = 0, read;
+    while ((read = file.Read(&data[total], data.size() - total)) > 0)
+      total += read;
+    return total == m_data.size() && !memcmp(&data[0], &m_data[0], total);
+  }
+
+  std::vector<uint8_t> m_data;
+  CStdString m_source;
+  CStdString m_dest;
+};
+
+TEST_F(TestFileCopy, Copy)
+{
+  XFILE::CFileCopy copy(m_source, m_dest);
+  copy.SetBlockSize(4096);
+  EXPECT_TRUE(copy.Copy());
+  EXPECT_EQ((int64_t)m_data.size(), copy.GetBytesCopied());
+  EXPECT_TRUE(IsCopy(m_dest));
+}
+
+TEST_F(TestFileCopy, Readers)
+{
+  XFILE::CFileCopy copy(m_source, m_dest);
+  copy.SetBlockSize(4096);
+  copy.SetReaders(4);
+  EXPECT_TRUE(copy.Copy());
+  EXPECT_TRUE(IsCopy(m_dest));
+}
+
+TEST_F(TestFileCopy, Verify)
+{
+  XFILE::CFileCopy copy(m_source, m_dest);
+  copy.SetBlockSize(4096);
+  copy.SetReaders(2);
+  copy.SetVerify(true);
+  EXPECT_TRUE(copy.Copy());
+  EXPECT_NE(0U, copy.GetCRC());
+  EXPECT_TRUE(IsCopy(m_dest));
+}
+
+TEST_F(TestFileCopy, Resume)
+{
+  CStdString partial = XFILE::CFileCopy::GetPartialPath(m_dest);
+  WriteFile(partial, &m_data[0], 10000);
+
+  XFILE::CFileCopy copy(m_source, m_dest);
+  copy.SetBlockSize(4096);
+  copy.SetResume(true);
+  EXPECT_TRUE(copy.Copy());
+  EXPECT_EQ(10000, copy.GetResumedFrom());
+  EXPECT_EQ((int64_t)m_data.size() - 10000, copy.GetBytesCopied());
+  EXPECT_TRUE(IsCopy(m_dest));
+  EXPECT_FALSE(XFILE::CFile::Exists(partial));
+}
+
+TEST_F(TestFileCopy, ResumeOtherFile)
+{
+  // a partial file that doesn't match the source is copied again
+  CStdString partial = XFILE::CFileCopy::GetPartialPath(m_dest);
+  std::vector<uint8_t> other(10000, 'x');
+  WriteFile(partial, &other[0], other.size());
+
+  XFILE::CFileCopy copy(m_source, m_dest);
+  copy.SetBlockSize(4096);
+  copy.SetResume(true);
+  copy.SetVerify(true);
+  EXPECT_TRUE(copy.Copy());
+  EXPECT_EQ(0, copy.GetResumedFrom());
+  EXPECT_TRUE(IsCopy(m_dest));
+}
+
+TEST_F(TestFileCopy, MissingSource)
+{
+  XFILE::CFileCopy copy(m_source + ".missing", m_dest);
+  copy.SetResume(true);
+  EXPECT_FALSE(copy.Copy());
+  EXPECT_FALSE(XFILE::CFile::Exists(m_dest));
+  EXPECT_FALSE(XFILE::CFile::Exists(XFILE::CFileCopy::GetPartialPath(m_dest)));
+}
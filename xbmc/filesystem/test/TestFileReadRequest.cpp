@@ -0,0 +1,135 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "filesystem/FileReadRequest.h"
+#include "filesystem/IFile.h"
+#include "threads/Atomics.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/StdString.h"
+
+#include "gtest/gtest.h"
+
+/* stands in for a network file, every read waits a round trip */
+class CTestLatencyFile : public XFILE::IFile
+{
+public:
+  CTestLatencyFile(int64_t length, unsigned int latency)
+    : m_length(length), m_latency(latency), m_reads(0), m_inFlight(0), m_maxInFlight(0)
+  {
+  }
+
+  static uint8_t Expected(int64_t offset) { return (uint8_t)(offset % 251); }
+
+  virtual bool Open(const CURL& url) { return true; }
+  virtual bool Exists(const CURL& url) { return true; }
+  virtual int Stat(const CURL& url, struct __stat64* buffer) { return -1; }
+  virtual unsigned int Read(void* lpBuf, int64_t uiBufSize) { return 0; }
+  virtual int64_t Seek(int64_t iFilePosition, int iWhence = SEEK_SET) { return -1; }
+  virtual void Close() {}
+  virtual int64_t GetPosition() { return 0; }
+  virtual int64_t GetLength() { return m_length; }
+
+  virtual bool CanReadAt() { return true; }
+  virtual int ReadAt(void* lpBuf, unsigned int uiBufSize, int64_t iOffset)
+  {
+    {
+      CSingleLock lock(m_section);
+      m_maxInFlight = std::max(m_maxInFlight, ++m_inFlight);
+    }
+    Sleep(m_latency);
+    AtomicIncrement(&m_reads);
+    {
+      CSingleLock lock(m_section);
+      m_inFlight--;
+    }
+    if (iOffset >= m_length)
+      return 0;
+    unsigned int size = (unsigned int)std::min<int64_t>(uiBufSize, m_length - iOffset);
+    for (unsigned int i = 0; i < size; i++)
+      ((uint8_t*)lpBuf)[i] = Expected(iOffset + i);
+    return (int)size;
+  }
+
+  int64_t      m_length;
+  unsigned int m_latency;
+  long         m_reads;
+  unsigned int m_inFlight;
+  unsigned int m_maxInFlight;
+  CCriticalSection m_section;
+};
+
+static bool ReadAll(XFILE::CFileReadPipeline& pipeline, int64_t position, int64_t length)
+{
+  uint8_t buf[10000];
+  while (position < length)
+  {
+    int read = pipeline.Read(buf, sizeof(buf), position);
+    if (read <= 0)
+      return false;
+    for (int i = 0; i < read; i++)
+    {
+      if (buf[i] != CTestLatencyFile::Expected(position + i))
+        return false;
+    }
+    position += read;
+  }
+  return pipeline.Read(buf, sizeof(buf), position) == 0;
+}
+
+TEST(TestFileReadRequest, Pipeline)
+{
+  CTestLatencyFile file(100000, 0);
+  XFILE::CFileReadPipeline pipeline(&file, 4, 4096);
+  uint8_t buf[100];
+
+  EXPECT_TRUE(ReadAll(pipeline, 0, file.m_length));
+
+  // seeks restart the pipeline where they went
+  EXPECT_EQ(100, pipeline.Read(buf, sizeof(buf), 50000));
+  EXPECT_EQ(CTestLatencyFile::Expected(50000), buf[0]);
+  EXPECT_EQ(100, pipeline.Read(buf, sizeof(buf), 123));
+  EXPECT_EQ(CTestLatencyFile::Expected(123), buf[0]);
+  EXPECT_EQ(CTestLatencyFile::Expected(222), buf[99]);
+  EXPECT_TRUE(ReadAll(pipeline, 99990, file.m_length));
+  EXPECT_TRUE(ReadAll(pipeline, 5, file.m_length));
+}
+
+TEST(TestFileReadRequest, PipelineDepth)
+{
+  // every depth reads the whole file once and never has more requests
+  // outstanding than asked for, the timings are only printed as they depend
+  // on the machine
+  unsigned int depths[3] = { 1, 2, 4 };
+  for (int i = 0; i < 3; i++)
+  {
+    CTestLatencyFile file(64 * 32768, 10);
+    XFILE::CFileReadPipeline pipeline(&file, depths[i], 32768);
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    EXPECT_TRUE(ReadAll(pipeline, 0, file.m_length));
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+    EXPECT_EQ(64, file.m_reads);
+    EXPECT_GE(depths[i], file.m_maxInFlight);
+    EXPECT_LE(1u, file.m_maxInFlight);
+    std::cout << "depth " << depths[i] << ": " << elapsed << " ms" << std::endl;
+  }
+}
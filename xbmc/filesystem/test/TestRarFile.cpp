@@ -22,15 +22,94 @@
 #ifdef HAS_FILESYSTEM_RAR
 #include "filesystem/Directory.h"
 #include "filesystem/File.h"
+#include "filesystem/RarStoredStream.h"
 #include "settings/GUISettings.h"
 #include "utils/URIUtils.h"
 #include "FileItem.h"
 #include "test/TestUtils.h"
 
 #include <errno.h>
+#include <zlib.h>
 
 #include "gtest/gtest.h"
 
+static void PutRar16(std::string& s, unsigned int v)
+{
+  s += (char)(v & 0xff);
+  s += (char)((v >> 8) & 0xff);
+}
+
+static void PutRar32(std::string& s, uint32_t v)
+{
+  PutRar16(s, v & 0xffff);
+  PutRar16(s, v >> 16);
+}
+
+/* a rar 2.9 block, the header crc is the low half of the crc32 of the rest */
+static std::string RarBlock(unsigned int type, unsigned int flags, const std::string& body)
+{
+  std::string block;
+  block += (char)type;
+  PutRar16(block, flags);
+  PutRar16(block, 7 + body.size());
+  block += body;
+
+  std::string crc;
+  PutRar16(crc, crc32(0, (const Bytef*)block.data(), block.size()) & 0xffff);
+  return crc + block;
+}
+
+/* writes data as a file in a rar archive split evenly over the volumes */
+static bool WriteRarVolumes(const std::vector<CStdString>& volumes, bool newNumbering,
+                            const std::string& name, const std::string& data,
+                            unsigned int method = 0x30)
+{
+  size_t chunk = data.size() / volumes.size();
+  for (size_t i = 0; i < volumes.size(); i++)
+  {
+    bool more = i + 1 < volumes.size();
+    std::string piece = data.substr(i * chunk, more ? chunk : std::string::npos);
+
+    std::string main(6, '\0');
+    unsigned int mainFlags = 0;
+    if (volumes.size() > 1)
+      mainFlags |= 0x0001 | (i == 0 ? 0x0100 : 0) | (newNumbering ? 0x0010 : 0);
+
+    std::string file;
+    PutRar32(file, piece.size());
+    PutRar32(file, data.size());
+    file += (char)0; // host os
+    PutRar32(file, crc32(0, (const Bytef*)piece.data(), piece.size()));
+    PutRar32(file, 0x3d6a0000); // 2010-11-10
+    file += (char)29; // version needed
+    file += (char)method;
+    PutRar16(file, name.size());
+    PutRar32(file, 0x20);
+    file += name;
+    unsigned int fileFlags = 0x8000 | (i > 0 ? 0x0001 : 0) | (more ? 0x0002 : 0);
+
+    std::string volume("Rar!\x1a\x07\x00", 7);
+    volume += RarBlock(0x73, mainFlags, main);
+    volume += RarBlock(0x74, fileFlags, file) + piece;
+    volume += RarBlock(0x7b, more ? 0x0001 : 0, "");
+
+    XFILE::CFile out;
+    if (!out.OpenForWrite(volumes[i], true) ||
+        out.Write(volume.data(), volume.size()) != (int)volume.size())
+      return false;
+    out.Close();
+  }
+  return true;
+}
+
+static std::string RarTestData(size_t size)
+{
+  std::string data;
+  for (size_t i = 0; i < size; i++)
+    data += (char)((i * 7 + i / 251) & 0xff);
+  return data;
+}
+
 TEST(TestRarFile, Read)
 {
   XFILE::CFile file;
@@ -189,4 +268,117 @@ TEST(TestRarFile, CorruptedFile)
   file->Close();
   XBMC_DELETETEMPFILE(file);
 }
+
+TEST(TestRarFile, GetNextVolume)
+{
+  EXPECT_STREQ("/a/movie.part2.rar",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.part1.rar", true).c_str());
+  EXPECT_STREQ("/a/movie.part10.rar",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.part09.rar", true).c_str());
+  EXPECT_STREQ("/a/movie.part10.rar",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.part9.rar", true).c_str());
+  EXPECT_STREQ("/a/movie.r00",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.rar", false).c_str());
+  EXPECT_STREQ("/a/movie.R00",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.RAR", false).c_str());
+  EXPECT_STREQ("/a/movie.r10",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.r09", false).c_str());
+  EXPECT_STREQ("/a/movie.s00",
+    XFILE::CRarStoredStream::GetNextVolume("/a/movie.r99", false).c_str());
+}
+
+TEST(TestRarFile, StoredVolumes)
+{
+  std::vector<CStdString> volumes;
+  volumes.push_back("special://temp/teststored.part1.rar");
+  volumes.push_back("special://temp/teststored.part2.rar");
+  volumes.push_back("special://temp/teststored.part3.rar");
+  std::string data = RarTestData(300000);
+  ASSERT_TRUE(WriteRarVolumes(volumes, true, "dir\\stored.bin", data));
+
+  XFILE::CRarStoredStream stream;
+  ASSERT_TRUE(stream.Open(volumes[0], "dir/stored.bin"));
+  EXPECT_EQ(3U, stream.GetVolumeCount());
+  EXPECT_EQ(300000, stream.GetLength());
+
+  std::string read(data.size(), '\0');
+  EXPECT_EQ(data.size(), stream.Read(&read[0], read.size() + 100));
+  EXPECT_TRUE(read == data);
+  EXPECT_EQ(0U, stream.Read(&read[0], 1));
+
+  // across both volume boundaries, backwards and from the end
+  char buf[250000];
+  EXPECT_EQ(99990, stream.Seek(99990, SEEK_SET));
+  EXPECT_EQ(200000U, stream.Read(buf, 200000));
+  EXPECT_TRUE(!memcmp(buf, data.data() + 99990, 200000));
+  EXPECT_EQ(10, stream.Seek(-299980, SEEK_CUR));
+  EXPECT_EQ(5U, stream.Read(buf, 5));
+  EXPECT_TRUE(!memcmp(buf, data.data() + 10, 5));
+  EXPECT_EQ(299999, stream.Seek(-1, SEEK_END));
+  EXPECT_EQ(1U, stream.Read(buf, 10));
+  EXPECT_EQ(data[299999], buf[0]);
+  EXPECT_EQ(-1, stream.Seek(1, SEEK_END));
+  stream.Close();
+
+  // not the first volume, and a volume missing
+  EXPECT_FALSE(stream.Open(volumes[1], "dir/stored.bin"));
+  EXPECT_TRUE(XFILE::CFile::Delete(volumes[2]));
+  EXPECT_FALSE(stream.Open(volumes[0], "dir/stored.bin"));
+
+  for (size_t i = 0; i < volumes.size(); i++)
+    XFILE::CFile::Delete(volumes[i]);
+}
+
+TEST(TestRarFile, StoredOldNumbering)
+{
+  std::vector<CStdString> volumes;
+  volumes.push_back("special://temp/teststoredold.rar");
+  volumes.push_back("special://temp/teststoredold.r00");
+  std::string data = RarTestData(70001);
+  ASSERT_TRUE(WriteRarVolumes(volumes, false, "stored.bin", data));
+
+  XFILE::CRarStoredStream stream;
+  ASSERT_TRUE(stream.Open(volumes[0], "stored.bin"));
+  EXPECT_EQ(2U, stream.GetVolumeCount());
+  EXPECT_FALSE(stream.Open(volumes[0], "missing.bin"));
+
+  for (size_t i = 0; i < volumes.size(); i++)
+    XFILE::CFile::Delete(volumes[i]);
+}
+
+TEST(TestRarFile, StoredRejectsPacked)
+{
+  std::vector<CStdString> volumes;
+  volumes.push_back("special://temp/testpacked.rar");
+  ASSERT_TRUE(WriteRarVolumes(volumes, false, "packed.bin", RarTestData(1000), 0x33));
+
+  XFILE::CRarStoredStream stream;
+  EXPECT_FALSE(stream.Open(volumes[0], "packed.bin"));
+
+  XFILE::CFile::Delete(volumes[0]);
+}
+
+TEST(TestRarFile, ReadStored)
+{
+  std::vector<CStdString> volumes;
+  volumes.push_back("special://temp/testreadstored.rar");
+  std::string data = RarTestData(5000);
+  ASSERT_TRUE(WriteRarVolumes(volumes, false, "stored.bin", data));
+
+  XFILE::CFile file;
+  CStdString strrarpath;
+  char buf[100];
+  URIUtils::CreateArchivePath(strrarpath, "rar", volumes[0], "stored.bin");
+  ASSERT_TRUE(file.Open(strrarpath));
+  EXPECT_EQ(5000, file.GetLength());
+  EXPECT_EQ(4000, file.Seek(4000, SEEK_SET));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_TRUE(!memcmp(buf, data.data() + 4000, sizeof(buf)));
+  EXPECT_EQ(0, file.Seek(0, SEEK_SET));
+  EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+  EXPECT_TRUE(!memcmp(buf, data.data(), sizeof(buf)));
+  file.Close();
+
+  XFILE::CFile::Delete(volumes[0]);
+}
 #endif /*HAS_FILESYSTEM_RAR*/
@@ -20,15 +20,106 @@
 
 #include "filesystem/Directory.h"
 #include "filesystem/File.h"
+#include "filesystem/ZipFile.h"
 #include "settings/GUISettings.h"
 #include "utils/URIUtils.h"
 #include "FileItem.h"
+#include "URL.h"
 #include "test/TestUtils.h"
 
 #include <errno.h>
+#include <zlib.h>
 
 #include "gtest/gtest.h"
 
+static void PutZip16(std::string& s, unsigned int v)
+{
+  s += (char)(v & 0xff);
+  s += (char)((v >> 8) & 0xff);
+}
+
+static void PutZip32(std::string& s, uint32_t v)
+{
+  PutZip16(s, v & 0xffff);
+  PutZip16(s, v >> 16);
+}
+
+/* writes a zip archive holding data deflated as a single entry */
+static bool WriteDeflatedZip(const CStdString& path, const std::string& name,
+                             const std::string& data)
+{
+  std::string deflated(compressBound(data.size()), '\0');
+  z_stream stream = {};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+  stream.next_in = (Bytef*)data.data();
+  stream.avail_in = data.size();
+  stream.next_out = (Bytef*)&deflated[0];
+  stream.avail_out = deflated.size();
+  int ret = deflate(&stream, Z_FINISH);
+  deflated.resize(stream.total_out);
+  deflateEnd(&stream);
+  if (ret != Z_STREAM_END)
+    return false;
+
+  uint32_t crc = crc32(0, (const Bytef*)data.data(), data.size());
+  std::string entry; // version, flags, method, time, date, crc and sizes
+  PutZip16(entry, 20);
+  PutZip16(entry, 0);
+  PutZip16(entry, 8);
+  PutZip32(entry, 0x3d6a0000);
+  PutZip32(entry, crc);
+  PutZip32(entry, deflated.size());
+  PutZip32(entry, data.size());
+  PutZip16(entry, name.size());
+  PutZip16(entry, 0);
+
+  std::string zip;
+  PutZip32(zip, 0x04034b50);
+  zip += entry + name + deflated;
+
+  std::string central;
+  PutZip32(central, 0x02014b50);
+  PutZip16(central, 20);
+  central += entry;
+  PutZip16(central, 0); // comment
+  PutZip16(central, 0); // disk
+  PutZip16(central, 0); // internal attributes
+  PutZip32(central, 0); // external attributes
+  PutZip32(central, 0); // local header offset
+  central += name;
+
+  std::string end;
+  PutZip32(end, 0x06054b50);
+  PutZip16(end, 0);
+  PutZip16(end, 0);
+  PutZip16(end, 1);
+  PutZip16(end, 1);
+  PutZip32(end, central.size());
+  PutZip32(end, zip.size());
+  PutZip16(end, 0);
+  zip += central + end;
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(path, true))
+    return false;
+  return file.Write(zip.data(), zip.size()) == (int)zip.size();
+}
+
+/* compressible, but not so much that the deflate blocks get huge */
+static std::string ZipTestData(size_t size)
+{
+  std::string data(size, '\0');
+  uint32_t r = 1;
+  for (size_t i = 0; i < size; i++)
+  {
+    r = r * 1103515245 + 12345;
+    data[i] = 'a' + (r >> 16) % 7 + (i / 1000) % 3;
+  }
+  return data;
+}
+
 class TestZipFile : public testing::Test
 {
 protected:
@@ -53,6 +144,29 @@ protected:
   }
 };
 
+/* a deflated zip written for the test, removed again even if the test fails */
+class TestZipFileDeflated : public TestZipFile
+{
+protected:
+  TestZipFileDeflated()
+    : m_zip("special://temp/testseekdeflated.zip"), m_data(ZipTestData(4 * 1024 * 1024 + 123))
+  {
+  }
+
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(WriteDeflatedZip(m_zip, "data.bin", m_data));
+  }
+
+  virtual void TearDown()
+  {
+    XFILE::CFile::Delete(m_zip);
+  }
+
+  CStdString  m_zip;
+  std::string m_data;
+};
+
 TEST_F(TestZipFile, Read)
 {
   XFILE::CFile file;
@@ -211,3 +325,39 @@ TEST_F(TestZipFile, CorruptedFile)
   file->Close();
   XBMC_DELETETEMPFILE(file);
 }
+
+TEST_F(TestZipFileDeflated, Seek)
+{
+  CStdString strpathinzip;
+  const std::string &data = m_data;
+  URIUtils::CreateArchivePath(strpathinzip, "zip", m_zip, "data.bin");
+
+  XFILE::CZipFile file;
+  char buf[4096];
+  ASSERT_TRUE(file.Open(CURL(strpathinzip)));
+  EXPECT_EQ((int64_t)data.size(), file.GetLength());
+  EXPECT_EQ(0U, file.GetCheckpointCount());
+
+  // a first pass through the file indexes it
+  std::string read;
+  unsigned int size;
+  while ((size = file.Read(buf, sizeof(buf))) > 0)
+    read.append(buf, size);
+  EXPECT_TRUE(read == data);
+  EXPECT_LE(3U, file.GetCheckpointCount());
+  unsigned int checkpoints = file.GetCheckpointCount();
+
+  // back to before, between and after checkpoints
+  const int64_t positions[] = { 3500000, 100, 2100000, 1048576, 2100000 - 10, 0 };
+  for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+  {
+    EXPECT_EQ(positions[i], file.Seek(positions[i], SEEK_SET));
+    EXPECT_EQ(sizeof(buf), file.Read(buf, sizeof(buf)));
+    EXPECT_TRUE(!memcmp(buf, data.data() + positions[i], sizeof(buf)));
+  }
+  EXPECT_EQ((int64_t)data.size() - 10, file.Seek(-10, SEEK_END));
+  EXPECT_EQ(10U, file.Read(buf, sizeof(buf)));
+  EXPECT_TRUE(!memcmp(buf, data.data() + data.size() - 10, 10));
+  EXPECT_EQ(checkpoints, file.GetCheckpointCount());
+  file.Close();
+}
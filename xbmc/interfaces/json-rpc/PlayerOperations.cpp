@@ -1327,6 +1327,30 @@ JSONRPC_STATUS CPlayerOperations::GetPropertyValue(PlayerType player, const CStd
         break;
     }
   }
+  else if (property.Equals("cache"))
+  {
+    XFILE::SCacheStatus status;
+    memset(&status, 0, sizeof(status));
+    switch (player)
+    {
+      case Video:
+      case Audio:
+        if (g_application.m_pPlayer)
+          g_application.m_pPlayer->GetCacheStatus(status);
+        break;
+
+      case Picture:
+      default:
+        break;
+    }
+
+    result = CVariant(CVariant::VariantTypeObject);
+    result["level"] = status.readahead ? (int)std::min((uint64_t)100, status.forward * 100 / status.readahead) : 0;
+    result["forward"] = status.forward;
+    result["readahead"] = status.readahead;
+    result["fillrate"] = status.currate;
+    result["consumerate"] = status.consumerate;
+  }
   else
     return InvalidParams;
 
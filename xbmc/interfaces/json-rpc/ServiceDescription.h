@@ -22,7 +22,7 @@
 namespace JSONRPC
 {
   const char* const JSONRPC_SERVICE_ID          = "http://www.xbmc.org/jsonrpc/ServiceDescription.json";
-  const int         JSONRPC_SERVICE_VERSION     = 5;
+  const int         JSONRPC_SERVICE_VERSION     = 6;
   const char* const JSONRPC_SERVICE_DESCRIPTION = "JSON-RPC API of XBMC";
 
   const char* const JSONRPC_SERVICE_TYPES[] = {  
@@ -194,13 +194,24 @@ namespace JSONRPC
         "\"language\": { \"type\": \"string\", \"required\": true }"
       "}"
     "}",
+    "\"Player.Cache\": {"
+      "\"type\": \"object\","
+      "\"description\": \"State of the file cache in front of the player, rates are in bytes per second\","
+      "\"properties\": {"
+        "\"level\": { \"type\": \"integer\", \"minimum\": 0, \"maximum\": 100, \"description\": \"Percentage of the read ahead that is cached\" },"
+        "\"forward\": { \"type\": \"integer\", \"minimum\": 0 },"
+        "\"readahead\": { \"type\": \"integer\", \"minimum\": 0, \"description\": \"Bytes the cache aims to keep ahead, 0 when not limited\" },"
+        "\"fillrate\": { \"type\": \"integer\", \"minimum\": 0 },"
+        "\"consumerate\": { \"type\": \"integer\", \"minimum\": 0 }"
+      "}"
+    "}",
     "\"Player.Property.Name\": {"
       "\"type\": \"string\","
       "\"enum\": [ \"type\", \"partymode\", \"speed\", \"time\", \"percentage\","
                 "\"totaltime\", \"playlistid\", \"position\", \"repeat\", \"shuffled\","
                 "\"canseek\", \"canchangespeed\", \"canmove\", \"canzoom\", \"canrotate\","
                 "\"canshuffle\", \"canrepeat\", \"currentaudiostream\", \"audiostreams\","
-                "\"subtitleenabled\", \"currentsubtitle\", \"subtitles\" ]"
+                "\"subtitleenabled\", \"currentsubtitle\", \"subtitles\", \"cache\" ]"
     "}",
     "\"Player.Property.Value\": {"
       "\"type\": \"object\","
@@ -226,7 +237,8 @@ namespace JSONRPC
         "\"audiostreams\": { \"type\": \"array\", \"items\": { \"$ref\": \"Player.Audio.Stream\" } },"
         "\"subtitleenabled\": { \"type\": \"boolean\" },"
         "\"currentsubtitle\": { \"$ref\": \"Player.Subtitle\" },"
-        "\"subtitles\": { \"type\": \"array\", \"items\": { \"$ref\": \"Player.Subtitle\" } }"
+        "\"subtitles\": { \"type\": \"array\", \"items\": { \"$ref\": \"Player.Subtitle\" } },"
+        "\"cache\": { \"$ref\": \"Player.Cache\" }"
       "}"
     "}",
     "\"Player.Notifications.Item.Type\": {"
@@ -505,7 +505,6 @@ int CMusicDatabase::AddAlbum(const CStdString& strAlbum1, const CStdString &strA
 
 int CMusicDatabase::AddGenre(const CStdString& strGenre1)
 {
-  CStdString strSQL;
   try
   {
     CStdString strGenre = strGenre1;
@@ -524,30 +523,32 @@ int CMusicDatabase::AddGenre(const CStdString& strGenre1)
       return it->second;
 
 
-    strSQL=PrepareSQL("select * from genre where strGenre like '%s'", strGenre.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    dbiplus::Statement *stmt = GetStatement("select idGenre from genre where strGenre like ?");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strGenre);
+    if (!stmt->step())
     {
-      m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into genre (idGenre, strGenre) values( NULL, '%s' )", strGenre.c_str());
-      m_pDS->exec(strSQL.c_str());
+      stmt = GetStatement("insert into genre (idGenre, strGenre) values( NULL, ? )");
+      if (NULL == stmt) return -1;
+      stmt->bind(1, strGenre);
+      stmt->exec();
 
-      int idGenre = (int)m_pDS->lastinsertid();
+      int idGenre = (int)stmt->lastinsertid();
       m_genreCache.insert(pair<CStdString, int>(strGenre1, idGenre));
       return idGenre;
     }
     else
     {
-      int idGenre = m_pDS->fv("idGenre").get_asInt();
+      int idGenre = stmt->fv(0).get_asInt();
       m_genreCache.insert(pair<CStdString, int>(strGenre1, idGenre));
-      m_pDS->close();
+      stmt->reset();
       return idGenre;
     }
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "musicdatabase:unable to addgenre (%s)", strSQL.c_str());
+    CLog::Log(LOGERROR, "musicdatabase:unable to addgenre (%s)", strGenre1.c_str());
   }
 
   return -1;
@@ -555,7 +556,6 @@ int CMusicDatabase::AddGenre(const CStdString& strGenre1)
 
 int CMusicDatabase::AddArtist(const CStdString& strArtist1)
 {
-  CStdString strSQL;
   try
   {
     CStdString strArtist = strArtist1;
@@ -574,30 +574,31 @@ int CMusicDatabase::AddArtist(const CStdString& strArtist1)
     if (it != m_artistCache.end())
       return it->second;//.idArtist;
 
-    strSQL=PrepareSQL("select * from artist where strArtist like '%s'", strArtist.c_str());
-    m_pDS->query(strSQL.c_str());
-
-    if (m_pDS->num_rows() == 0)
+    dbiplus::Statement *stmt = GetStatement("select idArtist from artist where strArtist like ?");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strArtist);
+    if (!stmt->step())
     {
-      m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into artist (idArtist, strArtist) values( NULL, '%s' )", strArtist.c_str());
-      m_pDS->exec(strSQL.c_str());
-      int idArtist = (int)m_pDS->lastinsertid();
+      stmt = GetStatement("insert into artist (idArtist, strArtist) values( NULL, ? )");
+      if (NULL == stmt) return -1;
+      stmt->bind(1, strArtist);
+      stmt->exec();
+      int idArtist = (int)stmt->lastinsertid();
       m_artistCache.insert(pair<CStdString, int>(strArtist1, idArtist));
       return idArtist;
     }
     else
     {
-      int idArtist = (int)m_pDS->fv("idArtist").get_asInt();
+      int idArtist = stmt->fv(0).get_asInt();
       m_artistCache.insert(pair<CStdString, int>(strArtist1, idArtist));
-      m_pDS->close();
+      stmt->reset();
       return idArtist;
     }
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "musicdatabase:unable to addartist (%s)", strSQL.c_str());
+    CLog::Log(LOGERROR, "musicdatabase:unable to addartist (%s)", strArtist1.c_str());
   }
 
   return -1;
@@ -605,18 +606,14 @@ int CMusicDatabase::AddArtist(const CStdString& strArtist1)
 
 bool CMusicDatabase::AddSongArtist(int idArtist, int idSong, bool featured, int iOrder)
 {
-  CStdString strSQL;
-  strSQL=PrepareSQL("replace into song_artist (idArtist, idSong, boolFeatured, iOrder) values(%i,%i,%i,%i)",
-                    idArtist, idSong, featured == true ? 1 : 0, iOrder);
-  return ExecuteQuery(strSQL);
+  return ExecuteLink("replace into song_artist (idArtist, idSong, boolFeatured, iOrder) values(?,?,?,?)",
+                     idArtist, idSong, featured == true ? 1 : 0, iOrder);
 };
 
 bool CMusicDatabase::AddAlbumArtist(int idArtist, int idAlbum, bool featured, int iOrder)
 {
-  CStdString strSQL;
-  strSQL=PrepareSQL("replace into album_artist (idArtist, idAlbum, boolFeatured, iOrder) values(%i,%i,%i,%i)",
-                    idArtist, idAlbum, featured == true ? 1 : 0, iOrder);
-  return ExecuteQuery(strSQL);
+  return ExecuteLink("replace into album_artist (idArtist, idAlbum, boolFeatured, iOrder) values(?,?,?,?)",
+                     idArtist, idAlbum, featured == true ? 1 : 0, iOrder);
 };
 
 bool CMusicDatabase::AddSongGenre(int idGenre, int idSong, int iOrder)
@@ -624,22 +621,42 @@ bool CMusicDatabase::AddSongGenre(int idGenre, int idSong, int iOrder)
   if (idGenre == -1 || idSong == -1)
     return true;
 
-  CStdString strSQL;
-  strSQL=PrepareSQL("replace into song_genre (idGenre, idSong, iOrder) values(%i,%i,%i)",
-                    idGenre, idSong, iOrder);
-  return ExecuteQuery(strSQL);};
+  return ExecuteLink("replace into song_genre (idGenre, idSong, iOrder) values(?,?,?)",
+                     idGenre, idSong, iOrder);
+};
 
 bool CMusicDatabase::AddAlbumGenre(int idGenre, int idAlbum, int iOrder)
 {
   if (idGenre == -1 || idAlbum == -1)
     return true;
-  
-  CStdString strSQL;
-  strSQL=PrepareSQL("replace into album_genre (idGenre, idAlbum, iOrder) values(%i,%i,%i)",
-                    idGenre, idAlbum, iOrder);
-  return ExecuteQuery(strSQL);
+
+  return ExecuteLink("replace into album_genre (idGenre, idAlbum, iOrder) values(?,?,?)",
+                     idGenre, idAlbum, iOrder);
 };
 
+bool CMusicDatabase::ExecuteLink(const char *query, int first, int second, int third, int fourth /* = -1 */)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+
+    dbiplus::Statement *stmt = GetStatement(query);
+    if (NULL == stmt) return false;
+    stmt->bind(1, first);
+    stmt->bind(2, second);
+    stmt->bind(3, third);
+    if (fourth >= 0)
+      stmt->bind(4, fourth);
+    stmt->exec();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - failed to execute query '%s' (%i, %i)", __FUNCTION__, query, first, second);
+  }
+  return false;
+}
+
 bool CMusicDatabase::GetAlbumsByArtist(int idArtist, bool includeFeatured, std::vector<long> &albums)
 {
   try 
@@ -778,7 +795,6 @@ bool CMusicDatabase::GetArtistsBySong(int idSong, bool includeFeatured, std::vec
 
 int CMusicDatabase::AddPath(const CStdString& strPath1)
 {
-  CStdString strSQL;
   try
   {
     CStdString strPath(strPath1);
@@ -794,30 +810,32 @@ int CMusicDatabase::AddPath(const CStdString& strPath1)
     if (it != m_pathCache.end())
       return it->second;
 
-    strSQL=PrepareSQL( "select * from path where strPath='%s'", strPath.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    dbiplus::Statement *stmt = GetStatement("select idPath from path where strPath=?");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strPath);
+    if (!stmt->step())
     {
-      m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into path (idPath, strPath) values( NULL, '%s' )", strPath.c_str());
-      m_pDS->exec(strSQL.c_str());
+      stmt = GetStatement("insert into path (idPath, strPath) values( NULL, ? )");
+      if (NULL == stmt) return -1;
+      stmt->bind(1, strPath);
+      stmt->exec();
 
-      int idPath = (int)m_pDS->lastinsertid();
+      int idPath = (int)stmt->lastinsertid();
       m_pathCache.insert(pair<CStdString, int>(strPath, idPath));
       return idPath;
     }
     else
     {
-      int idPath = m_pDS->fv("idPath").get_asInt();
+      int idPath = stmt->fv(0).get_asInt();
       m_pathCache.insert(pair<CStdString, int>(strPath, idPath));
-      m_pDS->close();
+      stmt->reset();
       return idPath;
     }
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "musicdatabase:unable to addpath (%s)", strSQL.c_str());
+    CLog::Log(LOGERROR, "musicdatabase:unable to addpath (%s)", strPath1.c_str());
   }
 
   return -1;
@@ -2857,9 +2875,9 @@ bool CMusicDatabase::GetArtistsByWhere(const CStdString& strBaseDir, const Filte
     // get data from returned rows
     items.Reserve(results.size());
     const dbiplus::query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
       
       try
@@ -3045,9 +3063,9 @@ bool CMusicDatabase::GetAlbumsByWhere(const CStdString &baseDir, const Filter &f
     // get data from returned rows
     items.Reserve(results.size());
     const dbiplus::query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
       
       try
@@ -3145,9 +3163,9 @@ bool CMusicDatabase::GetSongsByWhere(const CStdString &baseDir, const Filter &fi
     items.Reserve(results.size());
     const dbiplus::query_data &data = m_pDS->get_result_set().records;
     int count = 0;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
       
       try
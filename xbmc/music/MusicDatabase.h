@@ -302,6 +302,12 @@ private:
   virtual void CreateViews();
 
   void SplitString(const CStdString &multiString, std::vector<std::string> &vecStrings, CStdString &extraStrings);
+  /*! \brief Execute a cached statement linking items, binding the ids to its '?' placeholders
+   \param query the statement to execute
+   \param fourth the fourth id, not bound if negative
+   \return true if the statement was executed
+   */
+  bool ExecuteLink(const char *query, int first, int second, int third, int fourth = -1);
   CSong GetSongFromDataset(bool bWithMusicDbPath=false);
   CArtist GetArtistFromDataset(dbiplus::Dataset* pDS, bool needThumb = true);
   CArtist GetArtistFromDataset(const dbiplus::sql_record* const record, bool needThumb = true);
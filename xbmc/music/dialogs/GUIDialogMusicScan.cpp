@@ -25,6 +25,7 @@
 #include "Util.h"
 #include "URL.h"
 #include "guilib/GUIWindowManager.h"
+#include "guilib/LocalizeStrings.h"
 #include "settings/GUISettings.h"
 #include "GUIUserMessages.h"
 #include "threads/SingleLock.h"
@@ -35,6 +36,7 @@ using namespace MUSIC_INFO;
 #define CONTROL_LABELSTATUS     401
 #define CONTROL_LABELDIRECTORY  402
 #define CONTROL_PROGRESS        403
+#define CONTROL_LABELSTATS      404
 
 CGUIDialogMusicScan::CGUIDialogMusicScan(void)
 : CGUIDialog(WINDOW_DIALOG_MUSIC_SCAN, "DialogMusicScan.xml")
@@ -57,6 +59,9 @@ bool CGUIDialogMusicScan::OnMessage(CGUIMessage& message)
       m_strCurrentDir.Empty();
 
       m_fPercentDone=-1.0F;
+      m_filesPerSecond=-1;
+      m_foldersQueued=0;
+      m_filesQueued=0;
 
       UpdateState();
       return true;
@@ -97,6 +102,15 @@ void CGUIDialogMusicScan::OnSetProgress(int currentItem, int itemCount)
   if (m_fPercentDone>100.0F) m_fPercentDone=100.0F;
 }
 
+void CGUIDialogMusicScan::OnSetScanStats(int filesPerSecond, unsigned int foldersQueued, unsigned int filesQueued)
+{
+  CSingleLock lock (m_critical);
+
+  m_filesPerSecond = filesPerSecond;
+  m_foldersQueued = foldersQueued;
+  m_filesQueued = filesQueued;
+}
+
 void CGUIDialogMusicScan::ShowScan()
 {
   m_ScanState = PREPARING;
@@ -143,6 +157,11 @@ void CGUIDialogMusicScan::UpdateState()
 
     SET_CONTROL_LABEL(CONTROL_LABELDIRECTORY, strStrippedPath);
 
+    CStdString strStats;
+    if (m_filesPerSecond > -1)
+      strStats.Format(g_localizeStrings.Get(506), m_filesPerSecond, m_foldersQueued, m_filesQueued);
+    SET_CONTROL_LABEL(CONTROL_LABELSTATS, strStats);
+
     if (m_fPercentDone>-1.0F)
     {
       SET_CONTROL_VISIBLE(CONTROL_PROGRESS);
@@ -153,6 +172,7 @@ void CGUIDialogMusicScan::UpdateState()
   else if (m_ScanState == DOWNLOADING_ALBUM_INFO || m_ScanState == DOWNLOADING_ARTIST_INFO)
   {
     SET_CONTROL_LABEL(CONTROL_LABELDIRECTORY, m_strCurrentDir);
+    SET_CONTROL_LABEL(CONTROL_LABELSTATS, "");
     if (m_fPercentDone>-1.0F)
     {
       SET_CONTROL_VISIBLE(CONTROL_PROGRESS);
@@ -163,6 +183,7 @@ void CGUIDialogMusicScan::UpdateState()
   else
   {
     SET_CONTROL_LABEL(CONTROL_LABELDIRECTORY, "");
+    SET_CONTROL_LABEL(CONTROL_LABELSTATS, "");
     SET_CONTROL_HIDDEN(CONTROL_PROGRESS);
   }
 }
@@ -42,6 +42,7 @@ protected:
   virtual void OnFinished();
   virtual void OnStateChanged(MUSIC_INFO::SCAN_STATE state);
   virtual void OnSetProgress(int currentItem, int itemCount);
+  virtual void OnSetScanStats(int filesPerSecond, unsigned int foldersQueued, unsigned int filesQueued);
 
   MUSIC_INFO::SCAN_STATE m_ScanState;
   CStdString m_strCurrentDir;
@@ -51,4 +52,8 @@ protected:
   float m_fPercentDone;
   int m_currentItem;
   int m_itemCount;
+
+  int m_filesPerSecond;
+  unsigned int m_foldersQueued;
+  unsigned int m_filesQueued;
 };
@@ -21,6 +21,7 @@
 #include "threads/SystemClock.h"
 #include "MusicInfoScanner.h"
 #include "music/tags/MusicInfoTagLoaderFactory.h"
+#include "music/tags/TagLoaderTagLib.h"
 #include "MusicAlbumInfo.h"
 #include "MusicInfoScraper.h"
 #include "filesystem/MusicDatabaseDirectory.h"
@@ -57,6 +58,32 @@ using namespace MUSIC_INFO;
 using namespace XFILE;
 using namespace MUSIC_GRABBER;
 
+// the number of files a worker reads the tags of in one go
+#define SCAN_READ_CHUNK 8
+
+class CMusicInfoScanner::CWorker : public IRunnable
+{
+public:
+  CWorker(CMusicInfoScanner *scanner) : m_scanner(scanner), m_thread(this, "MusicInfoScannerWorker")
+  {
+    m_thread.Create();
+  }
+
+  ~CWorker()
+  {
+    m_thread.StopThread(true);
+  }
+
+  virtual void Run()
+  {
+    m_scanner->ProcessTasks();
+  }
+
+private:
+  CMusicInfoScanner *m_scanner;
+  CThread m_thread;
+};
+
 CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
 {
   m_bRunning = false;
@@ -65,6 +92,12 @@ CMusicInfoScanner::CMusicInfoScanner() : CThread("CMusicInfoScanner")
   m_currentItem=0;
   m_itemCount=0;
   m_flags = 0;
+  m_filesQueued = 0;
+  m_filesRead = 0;
+  m_stopWorkers = false;
+  m_foldersWaiting = 0;
+  m_statsTime = 0;
+  m_statsFiles = 0;
 }
 
 CMusicInfoScanner::~CMusicInfoScanner()
@@ -107,21 +140,7 @@ void CMusicInfoScanner::Process()
       m_bCanInterrupt = false;
       m_needsCleanup = false;
 
-      bool commit = false;
-      bool cancelled = false;
-      while (!cancelled && m_pathsToScan.size())
-      {
-        /*
-         * A copy of the directory path is used because the path supplied is
-         * immediately removed from the m_pathsToScan set in DoScan(). If the
-         * reference points to the entry in the set a null reference error
-         * occurs.
-         */
-        CStdString directory = *m_pathsToScan.begin();
-        if (!DoScan(directory))
-          cancelled = true;
-        commit = !cancelled;
-      }
+      bool commit = !m_pathsToScan.empty() && ScanPaths();
 
       if (commit)
       {
@@ -345,187 +364,420 @@ void CMusicInfoScanner::SetObserver(IMusicInfoScannerObserver* pObserver)
   m_pObserver = pObserver;
 }
 
-bool CMusicInfoScanner::DoScan(const CStdString& strDirectory)
+bool CMusicInfoScanner::ScanPaths()
 {
-  if (m_pObserver)
-    m_pObserver->OnDirectoryChanged(strDirectory);
+  unsigned int threads = std::max(g_advancedSettings.m_musicLibraryScanThreads, 1);
+  unsigned int maxFolders = 4 * threads;
+
+  m_listTasks.clear();
+  m_readTasks.clear();
+  m_foldersListed.clear();
+  m_foldersRead.clear();
+  m_filesQueued = 0;
+  m_filesRead = 0;
+
+  // the paths in the database include the subfolders of others, each folder is
+  // only scanned once however it's found
+  m_foldersToList.assign(m_pathsToScan.begin(), m_pathsToScan.end());
+  m_foldersSeen.clear();
+  m_foldersWaiting = 0;
+  m_statsTime = XbmcThreads::SystemClockMillis();
+  m_statsFiles = 0;
+  unsigned int start = m_statsTime;
+
+  StartWorkers(threads);
 
-  /*
-   * remove this path from the list we're processing. This must be done prior to
-   * the check for file or folder exclusion to prevent an infinite while loop
-   * in Process().
-   */
-  set<CStdString>::iterator it = m_pathsToScan.find(strDirectory);
-  if (it != m_pathsToScan.end())
-    m_pathsToScan.erase(it);
+  CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
+  unsigned int folders = 0; // handed to the workers and not done with yet
+  while (!m_bStop)
+  {
+    while (folders < maxFolders && !m_foldersToList.empty())
+    {
+      CStdString path = m_foldersToList.front();
+      m_foldersToList.pop_front();
+      m_pathsToScan.erase(path);
+      // Discard all excluded files defined by m_musicExcludeRegExps
+      if (!m_foldersSeen.insert(path).second || CUtil::ExcludeFileOrFolder(path, regexps))
+        continue;
+
+      SScanFolder *folder = new SScanFolder;
+      folder->path = path;
+      folder->chunksPending = 0;
+      QueueTask(folder, -1);
+      folders++;
+    }
+    if (folders == 0)
+      break;
 
-  // Discard all excluded files defined by m_musicExcludeRegExps
+    deque<SScanFolder*> listed, read;
+    {
+      CSingleLock lock(m_scanSection);
+      if (m_foldersListed.empty() && m_foldersRead.empty())
+        m_tasksDone.wait(lock, 500);
+      listed.swap(m_foldersListed);
+      read.swap(m_foldersRead);
+    }
+    m_foldersWaiting = listed.size() + read.size();
 
-  CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
+    for (deque<SScanFolder*>::iterator it = listed.begin(); it != listed.end() && !m_bStop; it = listed.erase(it))
+    {
+      if (!OnFolderListed(*it))
+      {
+        delete *it;
+        folders--;
+      }
+    }
+    for (deque<SScanFolder*>::iterator it = read.begin(); it != read.end() && !m_bStop; it = read.erase(it))
+    {
+      SScanFolder *folder = *it;
+      // and then scan in the new information
+      if (RetrieveMusicInfo(*folder) > 0)
+      {
+        if (m_pObserver)
+          m_pObserver->OnDirectoryScanned(folder->path);
+      }
 
-  if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
-    return true;
+      // save information about this folder, unless it was only partly read
+      if (!m_bStop)
+        m_musicDatabase.SetPathHash(folder->path, folder->hash);
+      delete folder;
+      folders--;
+    }
+    ReportStats(false);
 
-  // load subfolder
-  CFileItemList items;
-  CDirectory::GetDirectory(strDirectory, items, g_settings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg");
+    if (m_bStop)
+    { // the folders that weren't done with go along with the queued ones
+      CSingleLock lock(m_scanSection);
+      m_foldersListed.insert(m_foldersListed.end(), listed.begin(), listed.end());
+      m_foldersRead.insert(m_foldersRead.end(), read.begin(), read.end());
+    }
+  }
 
-  // sort and get the path hash.  Note that we don't filter .cue sheet items here as we want
-  // to detect changes in the .cue sheet as well.  The .cue sheet items only need filtering
-  // if we have a changed hash.
-  items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
-  CStdString hash;
-  GetPathHash(items, hash);
+  StopWorkers();
+
+  set<SScanFolder*> leftovers(m_foldersListed.begin(), m_foldersListed.end());
+  leftovers.insert(m_foldersRead.begin(), m_foldersRead.end());
+  for (deque<SScanTask>::iterator it = m_listTasks.begin(); it != m_listTasks.end(); ++it)
+    leftovers.insert(it->folder);
+  for (deque<SScanTask>::iterator it = m_readTasks.begin(); it != m_readTasks.end(); ++it)
+    leftovers.insert(it->folder);
+  for (set<SScanFolder*>::iterator it = leftovers.begin(); it != leftovers.end(); ++it)
+    delete *it;
+  m_listTasks.clear();
+  m_readTasks.clear();
+  m_foldersListed.clear();
+  m_foldersRead.clear();
+  m_foldersToList.clear();
+  m_foldersSeen.clear();
+
+  m_statsTime = start;
+  m_statsFiles = 0;
+  ReportStats(true);
+  return !m_bStop;
+}
+
+void CMusicInfoScanner::StartWorkers(unsigned int threads)
+{
+  m_stopWorkers = false;
+  for (unsigned int i = 0; i < threads; i++)
+    m_workers.push_back(new CWorker(this));
+}
+
+void CMusicInfoScanner::StopWorkers()
+{
+  // the workers finish what they're at (reading tags stops early when cancelled)
+  {
+    CSingleLock lock(m_scanSection);
+    m_stopWorkers = true;
+    m_tasksQueued.notifyAll();
+  }
+  for (vector<CWorker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+    delete *it;
+  m_workers.clear();
+}
+
+void CMusicInfoScanner::QueueTask(SScanFolder *folder, int chunk)
+{
+  SScanTask task;
+  task.folder = folder;
+  task.chunk = chunk;
+
+  CSingleLock lock(m_scanSection);
+  if (chunk < 0)
+    m_listTasks.push_back(task);
+  else
+  {
+    m_readTasks.push_back(task);
+    m_filesQueued += folder->chunks[chunk].end - folder->chunks[chunk].start;
+  }
+  m_tasksQueued.notify();
+}
+
+bool CMusicInfoScanner::OnFolderListed(SScanFolder *folder)
+{
+  if (m_pObserver)
+    m_pObserver->OnDirectoryChanged(folder->path);
+
+  // the subfolders are scanned next, in the order they're listed
+  CFileItemList &items = folder->items;
+  for (int i = items.Size() - 1; i >= 0; --i)
+  {
+    CFileItemPtr pItem = items[i];
+    // if we have a directory item (non-playlist) we then recurse into that folder
+    if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+      m_foldersToList.push_front(pItem->GetPath());
+  }
 
   // check whether we need to rescan or not
   CStdString dbHash;
-  if ((m_flags & SCAN_RESCAN) || !m_musicDatabase.GetPathHash(strDirectory, dbHash) || dbHash != hash)
+  if ((m_flags & SCAN_RESCAN) || !m_musicDatabase.GetPathHash(folder->path, dbHash) || dbHash != folder->hash)
   { // path has changed - rescan
     if (dbHash.IsEmpty())
-      CLog::Log(LOGDEBUG, "%s Scanning dir '%s' as not in the database", __FUNCTION__, strDirectory.c_str());
+      CLog::Log(LOGDEBUG, "%s Scanning dir '%s' as not in the database", __FUNCTION__, folder->path.c_str());
     else
-      CLog::Log(LOGDEBUG, "%s Rescanning dir '%s' due to change", __FUNCTION__, strDirectory.c_str());
+      CLog::Log(LOGDEBUG, "%s Rescanning dir '%s' due to change", __FUNCTION__, folder->path.c_str());
 
     // filter items in the sub dir (for .cue sheet support)
     items.FilterCueItems();
     items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
 
-    // and then scan in the new information
-    if (RetrieveMusicInfo(items, strDirectory) > 0)
-    {
-      if (m_pObserver)
-        m_pObserver->OnDirectoryScanned(strDirectory);
-    }
+    // and then have the workers read the tags
+    QueueChunks(folder);
+    return true;
+  }
+
+  // path is the same - no need to rescan
+  CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, folder->path.c_str());
+  m_currentItem += CountFiles(items, false);  // false for non-recursive
 
-    // save information about this folder
-    m_musicDatabase.SetPathHash(strDirectory, hash);
+  // notify our observer of our progress
+  if (m_pObserver)
+  {
+    if (m_itemCount>0)
+      m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
+    m_pObserver->OnDirectoryScanned(folder->path);
   }
-  else
-  { // path is the same - no need to rescan
-    CLog::Log(LOGDEBUG, "%s Skipping dir '%s' due to no change", __FUNCTION__, strDirectory.c_str());
-    m_currentItem += CountFiles(items, false);  // false for non-recursive
+  return false;
+}
 
-    // notify our observer of our progress
+void CMusicInfoScanner::QueueChunks(SScanFolder *folder)
+{
+  CFileItemList &items = folder->items;
+  for (int start = 0; start < items.Size(); start += SCAN_READ_CHUNK)
+  {
+    SScanChunk chunk;
+    chunk.start = start;
+    chunk.end = std::min(start + SCAN_READ_CHUNK, items.Size());
+    chunk.files = 0;
+    folder->chunks.push_back(chunk);
+  }
+  folder->chunksPending = folder->chunks.size();
+  if (folder->chunks.empty())
+  { // nothing to read, it only needs clearing out in the database
+    CSingleLock lock(m_scanSection);
+    m_foldersRead.push_back(folder);
+    m_tasksDone.notifyAll();
+    return;
+  }
+  for (unsigned int i = 0; i < folder->chunks.size(); i++)
+    QueueTask(folder, i);
+}
+
+void CMusicInfoScanner::ReportStats(bool finished)
+{
+  unsigned int now = XbmcThreads::SystemClockMillis();
+  unsigned int elapsed = now - m_statsTime;
+  if (!finished && elapsed < 1000)
+    return;
+
+  unsigned int filesRead, filesQueued, foldersQueued;
+  {
+    CSingleLock lock(m_scanSection);
+    filesRead = m_filesRead;
+    filesQueued = m_filesQueued;
+    foldersQueued = m_listTasks.size();
+  }
+  foldersQueued += m_foldersToList.size();
+  int rate = elapsed ? (int)((uint64_t)(filesRead - m_statsFiles) * 1000 / elapsed) : 0;
+
+  if (finished)
+    CLog::Log(LOGNOTICE, "%s - Read the tags of %u files at %i files/s", __FUNCTION__, filesRead, rate);
+  else
+  {
     if (m_pObserver)
-    {
-      if (m_itemCount>0)
-        m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
-      m_pObserver->OnDirectoryScanned(strDirectory);
-    }
+      m_pObserver->OnSetScanStats(rate, foldersQueued, filesQueued);
+    if (now / 10000 != m_statsTime / 10000)
+      CLog::Log(LOGDEBUG, "%s - %i files/s, queued: %u folders to list, %u files to read, %u folders waited for the database",
+                __FUNCTION__, rate, foldersQueued, filesQueued, m_foldersWaiting);
   }
+  m_statsTime = now;
+  m_statsFiles = filesRead;
+}
 
-  // now scan the subfolders
-  for (int i = 0; i < items.Size(); ++i)
+void CMusicInfoScanner::ProcessTasks()
+{
+  CSingleLock lock(m_scanSection);
+  while (!m_stopWorkers)
   {
-    CFileItemPtr pItem = items[i];
+    if (m_readTasks.empty() && m_listTasks.empty())
+    {
+      m_tasksQueued.wait(lock);
+      continue;
+    }
 
-    if (m_bStop)
-      break;
-    // if we have a directory item (non-playlist) we then recurse into that folder
-    if (pItem->m_bIsFolder && !pItem->IsParentFolder() && !pItem->IsPlayList())
+    // reading comes first, so that listed folders make their way to the
+    // database rather than pile up
+    bool read = !m_readTasks.empty();
+    SScanTask task = read ? m_readTasks.front() : m_listTasks.front();
+    if (read)
     {
-      CStdString strPath=pItem->GetPath();
-      if (!DoScan(strPath))
-      {
-        m_bStop = true;
-      }
+      m_readTasks.pop_front();
+      SScanChunk &chunk = task.folder->chunks[task.chunk];
+      m_filesQueued -= chunk.end - chunk.start;
+      lock.Leave();
+      ReadTags(*task.folder, chunk);
+      lock.Enter();
+      m_filesRead += chunk.files;
+      if (--task.folder->chunksPending == 0)
+        m_foldersRead.push_back(task.folder);
+    }
+    else
+    {
+      m_listTasks.pop_front();
+      lock.Leave();
+      ListFolder(*task.folder);
+      lock.Enter();
+      m_foldersListed.push_back(task.folder);
     }
+    m_tasksDone.notifyAll();
   }
-
-  return !m_bStop;
 }
 
-int CMusicInfoScanner::RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory)
+void CMusicInfoScanner::ListFolder(SScanFolder &folder)
 {
-  CSongMap songsMap;
-
-  // get all information for all files in current directory from database, and remove them
-  if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
-    m_needsCleanup = true;
+  // load subfolder
+  CDirectory::GetDirectory(folder.path, folder.items, g_settings.m_musicExtensions + "|.jpg|.tbn|.lrc|.cdg");
 
-  VECSONGS songsToAdd;
+  // sort and get the path hash.  Note that we don't filter .cue sheet items here as we want
+  // to detect changes in the .cue sheet as well.  The .cue sheet items only need filtering
+  // if we have a changed hash.
+  folder.items.Sort(SORT_METHOD_LABEL, SortOrderAscending);
+  GetPathHash(folder.items, folder.hash);
+}
 
+void CMusicInfoScanner::ReadTags(SScanFolder &folder, SScanChunk &chunk)
+{
   CStdStringArray regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
 
-  // for every file found, but skip folder
-  for (int i = 0; i < items.Size(); ++i)
+  for (int i = chunk.start; i < chunk.end; ++i)
   {
-    CFileItemPtr pItem = items[i];
-    CStdString strExtension;
-    URIUtils::GetExtension(pItem->GetPath(), strExtension);
+    CFileItemPtr pItem = folder.items[i];
 
     if (m_bStop)
-      return 0;
+      return;
 
     // Discard all excluded files defined by m_musicExcludeRegExps
     if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
       continue;
 
     // dont try reading id3tags for folders, playlists or shoutcast streams
-    if (!pItem->m_bIsFolder && !pItem->IsPlayList() && !pItem->IsPicture() && !pItem->IsLyrics() )
-    {
-      m_currentItem++;
-//      CLog::Log(LOGDEBUG, "%s - Reading tag for: %s", __FUNCTION__, pItem->GetPath().c_str());
+    if (pItem->m_bIsFolder || pItem->IsPlayList() || pItem->IsPicture() || pItem->IsLyrics())
+      continue;
 
-      // grab info from the song
-      CSong *dbSong = songsMap.Find(pItem->GetPath());
+    chunk.files++;
+//    CLog::Log(LOGDEBUG, "%s - Reading tag for: %s", __FUNCTION__, pItem->GetPath().c_str());
 
-      CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
-      if (!tag.Loaded() )
-      { // read the tag from a file
-        auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
-        if (NULL != pLoader.get())
+    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
+    if (!tag.Loaded() )
+    { // read the tag from a file
+      auto_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(pItem->GetPath()));
+      if (NULL != pLoader.get())
+      {
+        // TagLib only works on the file it's given, the other loaders go through codecs,
+        // the cd drive or the database and take turns
+        if (dynamic_cast<CTagLoaderTagLib*>(pLoader.get()))
+          pLoader->Load(pItem->GetPath(), tag);
+        else
+        {
+          CSingleLock lock(m_loaderSection);
           pLoader->Load(pItem->GetPath(), tag);
+        }
       }
+    }
 
-      // if we have the itemcount, notify our
-      // observer with the progress we made
-      if (m_pObserver && m_itemCount>0)
-        m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
+    if (tag.Loaded())
+    {
+      CSong song(tag);
 
-      if (tag.Loaded())
+      // ensure our song has a valid filename or else it will assert in AddSong()
+      if (song.strFileName.IsEmpty())
       {
-        CSong song(tag);
+        // copy filename from path in case UPnP or other tag loaders didn't specify one (FIXME?)
+        song.strFileName = pItem->GetPath();
 
-        // ensure our song has a valid filename or else it will assert in AddSong()
+        // if we still don't have a valid filename, skip the song
         if (song.strFileName.IsEmpty())
         {
-          // copy filename from path in case UPnP or other tag loaders didn't specify one (FIXME?)
-          song.strFileName = pItem->GetPath();
-
-          // if we still don't have a valid filename, skip the song
-          if (song.strFileName.IsEmpty())
-          {
-            // this shouldn't ideally happen!
-            CLog::Log(LOGERROR, "Skipping song since it doesn't seem to have a filename");
-            continue;
-          }
+          // this shouldn't ideally happen!
+          CLog::Log(LOGERROR, "Skipping song since it doesn't seem to have a filename");
+          continue;
         }
+      }
 
-        song.iStartOffset = pItem->m_lStartOffset;
-        song.iEndOffset = pItem->m_lEndOffset;
-        song.strThumb = pItem->GetUserMusicThumb(true);
-        if (dbSong)
-        { // keep the db-only fields intact on rescan...
-          song.iTimesPlayed = dbSong->iTimesPlayed;
-          song.lastPlayed = dbSong->lastPlayed;
-          song.iKaraokeNumber = dbSong->iKaraokeNumber;
-
-          if (song.rating == '0') song.rating = dbSong->rating;
-          if (song.strThumb.empty())
-            song.strThumb = dbSong->strThumb;
-        }
-        songsToAdd.push_back(song);
-//        CLog::Log(LOGDEBUG, "%s - Tag loaded for: %s", __FUNCTION__, pItem->GetPath().c_str());
+      song.iStartOffset = pItem->m_lStartOffset;
+      song.iEndOffset = pItem->m_lEndOffset;
+      song.strThumb = pItem->GetUserMusicThumb(true);
+      chunk.songs.push_back(song);
+      chunk.paths.push_back(pItem->GetPath());
+//      CLog::Log(LOGDEBUG, "%s - Tag loaded for: %s", __FUNCTION__, pItem->GetPath().c_str());
+    }
+    else
+      CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
+  }
+}
+
+int CMusicInfoScanner::RetrieveMusicInfo(SScanFolder &folder)
+{
+  if (m_bStop)
+    return 0;
+
+  const CStdString &strDirectory = folder.path;
+  CSongMap songsMap;
+
+  // get all information for all files in current directory from database, and remove them
+  if (m_musicDatabase.RemoveSongsFromPath(strDirectory, songsMap))
+    m_needsCleanup = true;
+
+  VECSONGS songsToAdd;
+  for (vector<SScanChunk>::iterator chunk = folder.chunks.begin(); chunk != folder.chunks.end(); ++chunk)
+  {
+    m_currentItem += chunk->files;
+    for (unsigned int i = 0; i < chunk->songs.size(); i++)
+    {
+      CSong &song = chunk->songs[i];
+      CSong *dbSong = songsMap.Find(chunk->paths[i]);
+      if (dbSong)
+      { // keep the db-only fields intact on rescan...
+        song.iTimesPlayed = dbSong->iTimesPlayed;
+        song.lastPlayed = dbSong->lastPlayed;
+        song.iKaraokeNumber = dbSong->iKaraokeNumber;
+
+        if (song.rating == '0') song.rating = dbSong->rating;
+        if (song.strThumb.empty())
+          song.strThumb = dbSong->strThumb;
       }
-      else
-        CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
+      songsToAdd.push_back(song);
     }
   }
 
+  // if we have the itemcount, notify our
+  // observer with the progress we made
+  if (m_pObserver && m_itemCount>0)
+    m_pObserver->OnSetProgress(m_currentItem, m_itemCount);
+
   VECALBUMS albums;
   CategoriseAlbums(songsToAdd, albums);
-  FindArtForAlbums(albums, items.GetPath());
+  FindArtForAlbums(albums, folder.items.GetPath());
 
   // finally, add these to the database
   m_musicDatabase.BeginTransaction();
@@ -19,11 +19,17 @@
  *
  */
 #include "threads/Thread.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
 #include "music/MusicDatabase.h"
 #include "MusicAlbumInfo.h"
+#include "FileItem.h"
+
+#include <deque>
 
 class CAlbum;
 class CArtist;
+class TestMusicInfoScannerHelper;
 
 namespace MUSIC_INFO
 {
@@ -37,11 +43,15 @@ public:
   virtual void OnDirectoryChanged(const CStdString& strDirectory) = 0;
   virtual void OnDirectoryScanned(const CStdString& strDirectory) = 0;
   virtual void OnSetProgress(int currentItem, int itemCount)=0;
+  /* how fast the tags of files are read, and how much work waits for the workers */
+  virtual void OnSetScanStats(int filesPerSecond, unsigned int foldersQueued, unsigned int filesQueued) {}
   virtual void OnFinished() = 0;
 };
 
 class CMusicInfoScanner : CThread, public IRunnable
 {
+  friend class ::TestMusicInfoScannerHelper;
+
 public:
   /*! \brief Flags for controlling the scanning process
    */
@@ -105,12 +115,69 @@ public:
 
   std::map<std::string, std::string> GetArtistArtwork(long id, const CArtist *artist = NULL);
 protected:
+  class CWorker;
+  friend class CWorker;
+
+  /* a part of the files of a folder that a worker reads the tags of */
+  struct SScanChunk
+  {
+    int start;
+    int end;
+    int files;                      // files tags were read from
+    VECSONGS songs;
+    std::vector<CStdString> paths;  // the item each song was read from
+  };
+
+  /* a folder on its way through the scan. Workers list it and read its tags,
+   the scanner thread checks it against the database and writes it */
+  struct SScanFolder
+  {
+    CStdString path;
+    CFileItemList items;
+    CStdString hash;
+    std::vector<SScanChunk> chunks;
+    unsigned int chunksPending;
+  };
+
+  struct SScanTask
+  {
+    SScanFolder *folder;
+    int chunk; // -1 to list the folder
+  };
+
   virtual void Process();
-  int RetrieveMusicInfo(CFileItemList& items, const CStdString& strDirectory);
-  int GetPathHash(const CFileItemList &items, CStdString &hash);
+  int RetrieveMusicInfo(SScanFolder &folder);
+  static int GetPathHash(const CFileItemList &items, CStdString &hash);
   void GetAlbumArtwork(long id, const CAlbum &artist);
 
-  bool DoScan(const CStdString& strDirectory);
+  /*! \brief Scan the paths to scan and all folders below them
+   Folders are listed and the tags of their files read by a pool of worker threads,
+   while this thread checks them against the database and writes them in transactions.
+   The folders on their way are bounded, so listings can't pile up in memory.
+   \return false if the scan was cancelled, true otherwise
+   */
+  bool ScanPaths();
+
+  /*! \brief Check a listed folder against the database
+   \param folder the listed folder
+   \return true if the tags of its files are being read, false if the folder is done with
+   */
+  bool OnFolderListed(SScanFolder *folder);
+
+  /*! \brief Have the workers read the tags of the files of a folder, a chunk at a time
+   The folder is handed back through m_foldersRead once all of its chunks are read.
+   \param folder the listed folder
+   */
+  void QueueChunks(SScanFolder *folder);
+  void QueueTask(SScanFolder *folder, int chunk);
+  void StartWorkers(unsigned int threads);
+  void StopWorkers();
+  void ReportStats(bool finished);
+
+  /* run by the workers */
+  void ProcessTasks();
+  void ListFolder(SScanFolder &folder);
+  void ReadTags(SScanFolder &folder, SScanChunk &chunk);
 
   virtual void Run();
   int CountFiles(const CFileItemList& items, bool recursive);
@@ -133,5 +200,26 @@ protected:
   std::vector<long> m_artistsScanned;
   std::vector<long> m_albumsScanned;
   int m_flags;
+
+  // shared with the workers
+  CCriticalSection m_scanSection;
+  XbmcThreads::ConditionVariable m_tasksQueued;
+  XbmcThreads::ConditionVariable m_tasksDone;
+  std::deque<SScanTask> m_listTasks;
+  std::deque<SScanTask> m_readTasks;
+  std::deque<SScanFolder*> m_foldersListed;
+  std::deque<SScanFolder*> m_foldersRead;
+  unsigned int m_filesQueued;   // files in m_readTasks
+  unsigned int m_filesRead;
+  bool m_stopWorkers;
+  std::vector<CWorker*> m_workers;
+  CCriticalSection m_loaderSection; // held by the workers around tag loaders other than TagLib
+
+  // only used by the scanner thread
+  std::deque<CStdString> m_foldersToList; // found, but not handed to the workers yet
+  std::set<CStdString> m_foldersSeen;
+  unsigned int m_foldersWaiting;          // listed or read folders that were waiting for the database
+  unsigned int m_statsTime;
+  unsigned int m_statsFiles;
 };
 }
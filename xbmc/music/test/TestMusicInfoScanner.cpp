@@ -0,0 +1,162 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "music/infoscanner/MusicInfoScanner.h"
+#include "music/tags/MusicInfoTag.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+using namespace MUSIC_INFO;
+
+class TestMusicInfoScannerHelper
+{
+public:
+  typedef CMusicInfoScanner::SScanFolder SScanFolder;
+  typedef CMusicInfoScanner::SScanChunk SScanChunk;
+
+  TestMusicInfoScannerHelper(unsigned int threads)
+  {
+    m_scanner.StartWorkers(threads);
+  }
+
+  ~TestMusicInfoScannerHelper()
+  {
+    m_scanner.StopWorkers();
+    for (std::vector<SScanFolder*>::iterator it = m_folders.begin(); it != m_folders.end(); ++it)
+      delete *it;
+  }
+
+  /* a listed folder of files whose tags are known already, so that they aren't read from disk */
+  SScanFolder *AddFolder(const CStdString &path, int files)
+  {
+    SScanFolder *folder = new SScanFolder;
+    folder->path = path;
+    folder->chunksPending = 0;
+    for (int i = 0; i < files; i++)
+    {
+      CStdString file;
+      file.Format("%s%03i.mp3", path.c_str(), i);
+      CFileItemPtr item(new CFileItem(file, false));
+      CMusicInfoTag &tag = *item->GetMusicInfoTag();
+      tag.SetURL(file);
+      tag.SetTitle(URIUtils::GetFileName(file));
+      tag.SetTrackNumber(i + 1);
+      tag.SetLoaded(true);
+      folder->items.Add(item);
+    }
+    m_folders.push_back(folder);
+    m_scanner.QueueChunks(folder);
+    return folder;
+  }
+
+  /* wait for the workers to hand back the given number of folders */
+  std::vector<SScanFolder*> WaitForFolders(unsigned int count)
+  {
+    std::vector<SScanFolder*> folders;
+    XbmcThreads::EndTime timeout(10000);
+    CSingleLock lock(m_scanner.m_scanSection);
+    while (folders.size() < count && !timeout.IsTimePast())
+    {
+      if (m_scanner.m_foldersRead.empty())
+        m_scanner.m_tasksDone.wait(lock, 100);
+      folders.insert(folders.end(), m_scanner.m_foldersRead.begin(), m_scanner.m_foldersRead.end());
+      m_scanner.m_foldersRead.clear();
+    }
+    return folders;
+  }
+
+  unsigned int FilesRead()
+  {
+    CSingleLock lock(m_scanner.m_scanSection);
+    return m_scanner.m_filesRead;
+  }
+
+  unsigned int FilesQueued()
+  {
+    CSingleLock lock(m_scanner.m_scanSection);
+    return m_scanner.m_filesQueued;
+  }
+
+private:
+  CMusicInfoScanner m_scanner;
+  std::vector<SScanFolder*> m_folders;
+};
+
+static void CheckFolder(const TestMusicInfoScannerHelper::SScanFolder *folder)
+{
+  // the chunks cover the folder in order, and their songs come in the order of the files
+  int next = 0;
+  int files = 0;
+  for (unsigned int i = 0; i < folder->chunks.size(); i++)
+  {
+    const TestMusicInfoScannerHelper::SScanChunk &chunk = folder->chunks[i];
+    EXPECT_EQ(next, chunk.start);
+    EXPECT_EQ(chunk.end - chunk.start, chunk.files);
+    ASSERT_EQ((size_t)chunk.files, chunk.songs.size());
+    ASSERT_EQ(chunk.songs.size(), chunk.paths.size());
+    for (unsigned int j = 0; j < chunk.songs.size(); j++)
+    {
+      const CStdString &path = folder->items[chunk.start + j]->GetPath();
+      EXPECT_STREQ(path.c_str(), chunk.paths[j].c_str());
+      EXPECT_STREQ(path.c_str(), chunk.songs[j].strFileName.c_str());
+      EXPECT_EQ(chunk.start + (int)j + 1, chunk.songs[j].iTrack);
+    }
+    next = chunk.end;
+    files += chunk.files;
+  }
+  EXPECT_EQ(folder->items.Size(), next);
+  EXPECT_EQ(folder->items.Size(), files);
+  EXPECT_EQ(0U, folder->chunksPending);
+}
+
+TEST(TestMusicInfoScanner, ReadTags)
+{
+  TestMusicInfoScannerHelper helper(1);
+  TestMusicInfoScannerHelper::SScanFolder *folder = helper.AddFolder("special://temp/musicscan/a/", 20);
+
+  std::vector<TestMusicInfoScannerHelper::SScanFolder*> folders = helper.WaitForFolders(1);
+  ASSERT_EQ(1U, folders.size());
+  EXPECT_EQ(folder, folders[0]);
+  CheckFolder(folder);
+  EXPECT_EQ(20U, helper.FilesRead());
+  EXPECT_EQ(0U, helper.FilesQueued());
+}
+
+TEST(TestMusicInfoScanner, ReadTagsPool)
+{
+  TestMusicInfoScannerHelper helper(4);
+  std::set<TestMusicInfoScannerHelper::SScanFolder*> queued;
+  queued.insert(helper.AddFolder("special://temp/musicscan/a/", 50));
+  queued.insert(helper.AddFolder("special://temp/musicscan/b/", 0));
+  queued.insert(helper.AddFolder("special://temp/musicscan/c/", 17));
+  queued.insert(helper.AddFolder("special://temp/musicscan/d/", 1));
+
+  // each folder comes back once, whichever workers read its chunks
+  std::vector<TestMusicInfoScannerHelper::SScanFolder*> folders = helper.WaitForFolders(queued.size());
+  ASSERT_EQ(queued.size(), folders.size());
+  EXPECT_EQ(queued, std::set<TestMusicInfoScannerHelper::SScanFolder*>(folders.begin(), folders.end()));
+  for (unsigned int i = 0; i < folders.size(); i++)
+    CheckFolder(folders[i]);
+  EXPECT_EQ(68U, helper.FilesRead());
+  EXPECT_EQ(0U, helper.FilesQueued());
+}
@@ -56,6 +56,7 @@ void CAdvancedSettings::Initialize()
   m_allChannelStereo = false;
   m_streamSilence = false;
   m_audioSinkBufferDurationMsec = 50;
+  m_audioResampleQuality = "";
 
   //default hold time of 25 ms, this allows a 20 hertz sine to pass undistorted
   m_limiterHold = 0.025f;
@@ -104,6 +105,10 @@ void CAdvancedSettings::Initialize()
   m_videoAutoScaleMaxFps = 30.0f;
   m_videoAllowMpeg4VDPAU = false;
   m_videoAllowMpeg4VAAPI = false;  
+  m_videoDecodeThreading = "auto";
+  m_videoDecodeThreads = 0; // 0 is one per cpu
+  m_videoDecodeAhead = 0;
+  m_videoDecodeAheadMemory = 64;
   m_videoDisableBackgroundDeinterlace = false;
   m_videoCaptureUseOcclusionQuery = -1; //-1 is auto detect
   m_DXVACheckCompatibility = false;
@@ -189,6 +194,8 @@ void CAdvancedSettings::Initialize()
   m_sambaclienttimeout = 10;
   m_sambadoscodepage = "";
   m_sambastatfiles = true;
+  m_sambareaddepth = 1;
+  m_sambacontexts = 1;
 
   m_bHTTPDirectoryStatFilesize = false;
 
@@ -206,6 +213,7 @@ void CAdvancedSettings::Initialize()
   m_strMusicLibraryAlbumFormatRight = "";
   m_prioritiseAPEv2tags = false;
   m_musicItemSeparator = " / ";
+  m_musicLibraryScanThreads = 1;
   m_videoItemSeparator = " / ";
 
   m_bVideoLibraryHideAllItems = false;
@@ -251,6 +259,7 @@ void CAdvancedSettings::Initialize()
   m_curlconnecttimeout = 10;
   m_curllowspeedtime = 20;
   m_curlretries = 2;
+  m_curlconnections = 1;
   m_curlDisableIPV6 = false;      //Certain hardware/OS combinations have trouble
                                   //with ipv6.
 
@@ -298,6 +307,16 @@ void CAdvancedSettings::Initialize()
   m_measureRefreshrate = false;
 
   m_cacheMemBufferSize = 1024 * 1024 * 20;
+  m_cacheDiskSize = 0;
+  m_cacheReadAhead = 30;
+  m_mmapLocalFiles = false;
+
+  m_dirCacheSize = 1024 * 1024 * 8;
+  m_dirCacheTTL.clear();
+
+  m_fileCopyReaders = 4;
+  m_fileCopyVerify = false;
+  m_fileCopyResume = true;
 
   m_jsonOutputCompact = true;
   m_jsonTcpPort = 9090;
@@ -391,6 +410,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetBoolean(pElement, "allchannelstereo", m_allChannelStereo);
     XMLUtils::GetBoolean(pElement, "streamsilence", m_streamSilence);
     XMLUtils::GetString(pElement, "transcodeto", m_audioTranscodeTo);
+    XMLUtils::GetString(pElement, "resamplequality", m_audioResampleQuality);
     XMLUtils::GetInt(pElement, "audiosinkbufferdurationmsec", m_audioSinkBufferDurationMsec);
 
     TiXmlElement* pAudioExcludes = pElement->FirstChildElement("excludefromlisting");
@@ -494,6 +514,10 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetFloat(pElement,"autoscalemaxfps",m_videoAutoScaleMaxFps, 0.0f, 1000.0f);
     XMLUtils::GetBoolean(pElement,"allowmpeg4vdpau",m_videoAllowMpeg4VDPAU);
     XMLUtils::GetBoolean(pElement,"allowmpeg4vaapi",m_videoAllowMpeg4VAAPI);    
+    XMLUtils::GetString(pElement,"decodethreading",m_videoDecodeThreading);
+    XMLUtils::GetInt(pElement,"decodethreads",m_videoDecodeThreads, 0, 16);
+    XMLUtils::GetInt(pElement,"decodeahead",m_videoDecodeAhead, 0, 64);
+    XMLUtils::GetInt(pElement,"decodeaheadmemory",m_videoDecodeAheadMemory, 8, 1024);
     XMLUtils::GetBoolean(pElement, "disablebackgrounddeinterlace", m_videoDisableBackgroundDeinterlace);
     XMLUtils::GetInt(pElement, "useocclusionquery", m_videoCaptureUseOcclusionQuery, -1, 1);
 
@@ -634,6 +658,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "albumformatright", m_strMusicLibraryAlbumFormatRight);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
+    XMLUtils::GetInt(pElement, "scanthreads", m_musicLibraryScanThreads, 1, 16);
   }
 
   pElement = pRootElement->FirstChildElement("videolibrary");
@@ -684,8 +709,11 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetInt(pElement, "curlclienttimeout", m_curlconnecttimeout, 1, 1000);
     XMLUtils::GetInt(pElement, "curllowspeedtime", m_curllowspeedtime, 1, 1000);
     XMLUtils::GetInt(pElement, "curlretries", m_curlretries, 0, 10);
+    XMLUtils::GetInt(pElement, "curlconnections", m_curlconnections, 1, 8);
     XMLUtils::GetBoolean(pElement,"disableipv6", m_curlDisableIPV6);
     XMLUtils::GetUInt(pElement, "cachemembuffersize", m_cacheMemBufferSize);
+    XMLUtils::GetUInt(pElement, "diskcachesize", m_cacheDiskSize);
+    XMLUtils::GetUInt(pElement, "cachereadahead", m_cacheReadAhead);
   }
 
   pElement = pRootElement->FirstChildElement("jsonrpc");
@@ -701,6 +729,31 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
     XMLUtils::GetString(pElement,  "doscodepage",   m_sambadoscodepage);
     XMLUtils::GetInt(pElement, "clienttimeout", m_sambaclienttimeout, 5, 100);
     XMLUtils::GetBoolean(pElement, "statfiles", m_sambastatfiles);
+    XMLUtils::GetInt(pElement, "readdepth", m_sambareaddepth, 1, 8);
+    XMLUtils::GetInt(pElement, "contexts", m_sambacontexts, 1, 16);
+  }
+
+  pElement = pRootElement->FirstChildElement("directorycache");
+  if (pElement)
+  {
+    XMLUtils::GetUInt(pElement, "memorysize", m_dirCacheSize);
+    TiXmlElement* pTTL = pElement->FirstChildElement("ttl");
+    while (pTTL)
+    {
+      CStdString protocol = pTTL->Attribute("protocol");
+      protocol.ToLower();
+      if (!protocol.IsEmpty() && pTTL->FirstChild())
+        m_dirCacheTTL[protocol] = strtoul(pTTL->FirstChild()->Value(), NULL, 10);
+      pTTL = pTTL->NextSiblingElement("ttl");
+    }
+  }
+
+  pElement = pRootElement->FirstChildElement("filecopy");
+  if (pElement)
+  {
+    XMLUtils::GetInt(pElement, "readers", m_fileCopyReaders, 1, 16);
+    XMLUtils::GetBoolean(pElement, "verify", m_fileCopyVerify);
+    XMLUtils::GetBoolean(pElement, "resume", m_fileCopyResume);
   }
 
   pElement = pRootElement->FirstChildElement("httpdirectory");
@@ -969,6 +1022,7 @@ void CAdvancedSettings::ParseSettingsFile(const CStdString &file)
   XMLUtils::GetString(pRootElement, "gputempcommand", m_gpuTempCmd);
 
   XMLUtils::GetBoolean(pRootElement, "alwaysontop", m_alwaysOnTop);
+  XMLUtils::GetBoolean(pRootElement, "mmaplocalfiles", m_mmapLocalFiles);
 
   XMLUtils::GetInt(pRootElement, "bginfoloadermaxthreads", m_bgInfoLoaderMaxThreads);
   m_bgInfoLoaderMaxThreads = std::max(1, m_bgInfoLoaderMaxThreads);
@@ -19,6 +19,7 @@
  *
  */
 
+#include <map>
 #include <vector>
 #include "utils/StdString.h"
 #include "utils/GlobalsHandling.h"
@@ -111,6 +112,7 @@ class CAdvancedSettings
     bool m_streamSilence;
     int m_audioSinkBufferDurationMsec;
     CStdString m_audioTranscodeTo;
+    CStdString m_audioResampleQuality;
     float m_limiterHold;
     float m_limiterRelease;
 
@@ -154,6 +156,10 @@ class CAdvancedSettings
     float m_videoAutoScaleMaxFps;
     bool  m_videoAllowMpeg4VDPAU;
     bool  m_videoAllowMpeg4VAAPI;
+    CStdString m_videoDecodeThreading; /* auto, slice or frame threading in the ffmpeg video decoder */
+    int   m_videoDecodeThreads;
+    int   m_videoDecodeAhead;       /* decoded pictures queued ahead of the renderer, 0 disables */
+    int   m_videoDecodeAheadMemory; /* MB the queued pictures may use */
     std::vector<RefreshOverride> m_videoAdjustRefreshOverrides;
     std::vector<RefreshVideoLatency> m_videoRefreshLatency;
     float m_videoDefaultLatency;
@@ -224,6 +230,8 @@ class CAdvancedSettings
     int m_sambaclienttimeout;
     CStdString m_sambadoscodepage;
     bool m_sambastatfiles;
+    int m_sambareaddepth;  // reads outstanding while streaming a file
+    int m_sambacontexts;   // connections the files read through, more than 1 needs a thread safe libsmbclient
 
     bool m_bHTTPDirectoryStatFilesize;
 
@@ -241,6 +249,7 @@ class CAdvancedSettings
     CStdString m_strMusicLibraryAlbumFormatRight;
     bool m_prioritiseAPEv2tags;
     CStdString m_musicItemSeparator;
+    int m_musicLibraryScanThreads;
     CStdString m_videoItemSeparator;
     std::vector<CStdString> m_musicTagsFromFileFilters;
 
@@ -292,6 +301,7 @@ class CAdvancedSettings
     int m_curlconnecttimeout;
     int m_curllowspeedtime;
     int m_curlretries;
+    int m_curlconnections; // range requests in flight per file, 1 disables them
     bool m_curlDisableIPV6;
 
     bool m_fullScreen;
@@ -348,6 +358,17 @@ class CAdvancedSettings
     int  m_guiDirtyRegionNoFlipTimeout;
 
     unsigned int m_cacheMemBufferSize;
+    unsigned int m_cacheDiskSize; // MB of the persistent block cache, 0 disables it
+    unsigned int m_cacheReadAhead; // seconds of playback the cache reads ahead, 0 reads as far as memory allows
+
+    bool m_mmapLocalFiles; // play local files through a memory mapping instead of reads
+
+    unsigned int m_dirCacheSize; // bytes of folder listings the directory cache holds
+    std::map<CStdString, unsigned int> m_dirCacheTTL; // seconds cached listings of a protocol stay valid
+
+    int m_fileCopyReaders;          // ranges of a network file copied at once
+    bool m_fileCopyVerify;          // read copies back and compare their crc
+    bool m_fileCopyResume;          // keep failed copies around to resume them
 
     bool m_jsonOutputCompact;
     unsigned int m_jsonTcpPort;
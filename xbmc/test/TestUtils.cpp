@@ -211,6 +211,16 @@ void CXBMCTestUtils::setTestFileFactoryWriteInputFile(CStdString const& file)
   TestFileFactoryWriteInputFile = file;
 }
 
+std::vector<CStdString> &CXBMCTestUtils::getVideoDecodeFiles()
+{
+  return VideoDecodeFiles;
+}
+
+std::vector<CStdString> &CXBMCTestUtils::getDemuxFiles()
+{
+  return DemuxFiles;
+}
+
 std::vector<CStdString> &CXBMCTestUtils::getAdvancedSettingsFiles()
 {
   return AdvancedSettingsFiles;
@@ -251,6 +261,22 @@ static const char usage[] =
 "  --set-testfilefactory-writeinputfile [FILE]\n"
 "    Set the path to the input file used in the TestFileFactory write tests.\n"
 "\n"
+"  --add-videodecode-file [FILE]\n"
+"    Add a video file to be decoded in the TestDVDVideoCodecFFmpeg\n"
+"    benchmark.\n"
+"\n"
+"  --add-videodecode-files [FILES]\n"
+"    Add multiple video files from a ',' delimited string of files to be\n"
+"    decoded in the TestDVDVideoCodecFFmpeg benchmark.\n"
+"\n"
+"  --add-demux-file [FILE]\n"
+"    Add a local media file to be demuxed in the TestDVDDemuxFFmpeg\n"
+"    benchmark.\n"
+"\n"
+"  --add-demux-files [FILES]\n"
+"    Add multiple local media files from a ',' delimited string of files to\n"
+"    be demuxed in the TestDVDDemuxFFmpeg benchmark.\n"
+"\n"
 "  --add-advancedsettings-file [FILE]\n"
 "    Add an advanced settings file to be loaded in test cases that use them.\n"
 "\n"
@@ -319,6 +345,30 @@ void CXBMCTestUtils::ParseArgs(int argc, char **argv)
     {
       TestFileFactoryWriteInputFile = argv[++i];
     }
+    else if (arg == "--add-videodecode-file")
+    {
+      VideoDecodeFiles.push_back(argv[++i]);
+    }
+    else if (arg == "--add-videodecode-files")
+    {
+      arg = argv[++i];
+      std::vector<std::string> urls = StringUtils::Split(arg, ",");
+      std::vector<std::string>::iterator it;
+      for (it = urls.begin(); it < urls.end(); it++)
+        VideoDecodeFiles.push_back(*it);
+    }
+    else if (arg == "--add-demux-file")
+    {
+      DemuxFiles.push_back(argv[++i]);
+    }
+    else if (arg == "--add-demux-files")
+    {
+      arg = argv[++i];
+      std::vector<std::string> urls = StringUtils::Split(arg, ",");
+      std::vector<std::string>::iterator it;
+      for (it = urls.begin(); it < urls.end(); it++)
+        DemuxFiles.push_back(*it);
+    }
     else if (arg == "--add-advancedsettings-file")
     {
       AdvancedSettingsFiles.push_back(argv[++i]);
@@ -69,6 +69,13 @@ public:
   /* Function to set the input file used in the TestFileFactory.Write tests */
   void setTestFileFactoryWriteInputFile(CStdString const& file);
 
+  /* Function to get the video files used in the TestDVDVideoCodecFFmpeg
+   * benchmark. */
+  std::vector<CStdString> &getVideoDecodeFiles();
+
+  /* Function to get the files used in the TestDVDDemuxFFmpeg benchmark. */
+  std::vector<CStdString> &getDemuxFiles();
+
   /* Function to get advanced settings files. */
   std::vector<CStdString> &getAdvancedSettingsFiles();
 
@@ -95,6 +102,8 @@ private:
   std::vector<CStdString> TestFileFactoryReadUrls;
   std::vector<CStdString> TestFileFactoryWriteUrls;
   CStdString TestFileFactoryWriteInputFile;
+  std::vector<CStdString> VideoDecodeFiles;
+  std::vector<CStdString> DemuxFiles;
 
   std::vector<CStdString> AdvancedSettingsFiles;
   std::vector<CStdString> GUISettingsFiles;
@@ -108,3 +117,9 @@ private:
 #define XBMC_TEMPFILEPATH(a) CXBMCTestUtils::Instance().TempFilePath(a)
 #define XBMC_CREATECORRUPTEDFILE(a, b) \
   CXBMCTestUtils::Instance().CreateCorruptedFile(a, b)
+
+/* number of elements in a static array */
+#define XBMC_ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+/* millions of items per second for the benchmarks, 0 if the clock didn't move */
+#define XBMC_MILLIONS_PER_SECOND(count, elapsed) \
+  ((elapsed) > 0.0f ? (count) / (elapsed) / 1000000.0f : 0.0f)
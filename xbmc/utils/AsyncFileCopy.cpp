@@ -23,6 +23,7 @@
 #include "dialogs/GUIDialogProgress.h"
 #include "guilib/GUIWindowManager.h"
 #include "log.h"
+#include "utils/StringUtils.h"
 #include "utils/TimeUtils.h"
 #include "URL.h"
 
@@ -33,6 +34,7 @@ CAsyncFileCopy::CAsyncFileCopy() : CThread("CAsyncFileCopy")
   m_running = false;
   m_percent = 0;
   m_speed = 0;
+  m_secondsLeft = -1;
 }
 
 CAsyncFileCopy::~CAsyncFileCopy()
@@ -49,6 +51,7 @@ bool CAsyncFileCopy::Copy(const CStdString &from, const CStdString &to, const CS
   m_succeeded = false;
   m_percent = 0;
   m_speed = 0;
+  m_secondsLeft = -1;
   m_running = true;
   CURL url1(from);
   CURL url2(to);
@@ -76,6 +79,8 @@ bool CAsyncFileCopy::Copy(const CStdString &from, const CStdString &to, const CS
     {
       CStdString speedString;
       speedString.Format("%2.2f KB/s", m_speed / 1024);
+      if (m_secondsLeft >= 0)
+        speedString += ", ETA " + StringUtils::SecondsToTimeString(m_secondsLeft);
       dlg->SetHeading(heading);
       dlg->SetLine(0, url1.Get());
       dlg->SetLine(1, url2.Get());
@@ -91,9 +96,15 @@ bool CAsyncFileCopy::Copy(const CStdString &from, const CStdString &to, const CS
 }
 
 bool CAsyncFileCopy::OnFileCallback(void *pContext, int ipercent, float avgSpeed)
+{
+  return OnFileProgress(pContext, ipercent, avgSpeed, -1);
+}
+
+bool CAsyncFileCopy::OnFileProgress(void *pContext, int ipercent, float avgSpeed, int secondsLeft)
 {
   m_percent = ipercent;
   m_speed = avgSpeed;
+  m_secondsLeft = secondsLeft;
   m_event.Set();
   return !m_cancelled;
 }
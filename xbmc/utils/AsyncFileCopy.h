@@ -35,6 +35,7 @@ public:
 
   /// \brief callback from CFile::Cache()
   virtual bool OnFileCallback(void *pContext, int ipercent, float avgSpeed);
+  virtual bool OnFileProgress(void *pContext, int ipercent, float avgSpeed, int secondsLeft);
 
 protected:
   virtual void Process();
@@ -43,6 +44,7 @@ private:
   /// volatile variables as we access these from both threads
   volatile int m_percent;      ///< current percentage (0..100)
   volatile float m_speed;      ///< current speed (in bytes per second)
+  volatile int m_secondsLeft;  ///< time the copy needs to finish, -1 if unknown
   volatile bool m_cancelled;   ///< whether or not we cancelled the operation
   volatile bool m_running;     ///< whether or not the copy operation is still in progress
   
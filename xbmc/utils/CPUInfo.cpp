@@ -45,10 +45,12 @@
 
 #ifdef _WIN32
 #include <intrin.h>
+#include <immintrin.h>
 
 // Defines to help with calls to CPUID
 #define CPUID_INFOTYPE_STANDARD 0x00000001
 #define CPUID_INFOTYPE_EXTENDED 0x80000001
+#define CPUID_INFOTYPE_LEAF7    0x00000007
 
 // Standard Features
 // Bitmasks for the values returned by a call to cpuid with eax=0x00000001
@@ -56,11 +58,20 @@
 #define CPUID_00000001_ECX_SSSE3 (1<<9)
 #define CPUID_00000001_ECX_SSE4  (1<<19)
 #define CPUID_00000001_ECX_SSE42 (1<<20)
+#define CPUID_00000001_ECX_OSXSAVE (1<<27)
+#define CPUID_00000001_ECX_AVX   (1<<28)
 
 #define CPUID_00000001_EDX_MMX   (1<<23)
 #define CPUID_00000001_EDX_SSE   (1<<25)
 #define CPUID_00000001_EDX_SSE2  (1<<26)
 
+// Structured Extended Features
+// Bitmasks for the values returned by a call to cpuid with eax=0x00000007, ecx=0
+#define CPUID_00000007_EBX_AVX2  (1<<5)
+
+// XCR0 bits for the SSE and AVX register state, both have to be enabled by the OS
+#define XCR0_SSE_AVX_STATE       0x6
+
 // Extended Features
 // Bitmasks for the values returned by a call to cpuid with eax=0x80000001
 #define CPUID_80000001_EDX_MMX2     (1<<22)
@@ -160,6 +171,8 @@ CCPUInfo::CCPUInfo(void)
           m_cpuFeatures |= CPU_FEATURE_SSE4;
         else if (0 == strcmp(tok, "SSE4.2"))
           m_cpuFeatures |= CPU_FEATURE_SSE42;
+        else if (0 == strcmp(tok, "AVX1.0"))
+          m_cpuFeatures |= CPU_FEATURE_AVX;
         tok = strtok_r(NULL, " ", &save);
       }
     }
@@ -337,6 +350,10 @@ CCPUInfo::CCPUInfo(void)
               m_cpuFeatures |= CPU_FEATURE_3DNOW;
             else if (0 == strcmp(tok, "3dnowext"))
               m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+            else if (0 == strcmp(tok, "avx"))
+              m_cpuFeatures |= CPU_FEATURE_AVX;
+            else if (0 == strcmp(tok, "avx2"))
+              m_cpuFeatures |= CPU_FEATURE_AVX2;
             tok = strtok_r(NULL, " ", &save);
           }
         }
@@ -644,6 +661,47 @@ CStdString CCPUInfo::GetCoresUsageString() const
   return strCores;
 }
 
+#if defined(TARGET_DARWIN) && (defined(__i386__) || defined(__x86_64__)) && !defined(TARGET_DARWIN_IOS)
+static inline void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+  // ebx may be the PIC register on i386, so it's saved around cpuid
+  __asm__ __volatile__ (
+#if defined(__i386__)
+    "pushl %%ebx\n\t"
+    "cpuid\n\t"
+    "movl %%ebx, %1\n\t"
+    "popl %%ebx"
+    : "=a" (regs[0]), "=r" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+#else
+    "cpuid"
+    : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+#endif
+    : "a" (leaf), "c" (subleaf));
+}
+
+/* same checks as the Windows path: OSXSAVE and AVX in leaf 1, the ymm state
+ * enabled in XCR0, then AVX2 in leaf 7 */
+static bool HasAVX2()
+{
+  unsigned int regs[4];
+  cpuid(0, 0, regs);
+  if (regs[0] < 7)
+    return false;
+
+  cpuid(1, 0, regs);
+  if (!(regs[2] & (1<<27)) || !(regs[2] & (1<<28)))
+    return false;
+
+  unsigned int xcr0, xcr0_high;
+  __asm__ __volatile__ ("xgetbv" : "=a" (xcr0), "=d" (xcr0_high) : "c" (0));
+  if ((xcr0 & 0x6) != 0x6)
+    return false;
+
+  cpuid(7, 0, regs);
+  return (regs[1] & (1<<5)) != 0;
+}
+#endif
+
 void CCPUInfo::ReadCPUFeatures()
 {
 #ifdef _WIN32
@@ -670,6 +728,21 @@ void CCPUInfo::ReadCPUFeatures()
       m_cpuFeatures |= CPU_FEATURE_SSE4;
     if (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_SSE42)
       m_cpuFeatures |= CPU_FEATURE_SSE42;
+
+    // AVX needs the OS to save the ymm registers as well
+    if ((CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_OSXSAVE) &&
+        (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_AVX) &&
+        (_xgetbv(0) & XCR0_SSE_AVX_STATE) == XCR0_SSE_AVX_STATE)
+    {
+      m_cpuFeatures |= CPU_FEATURE_AVX;
+
+      if (MaxStdInfoType >= CPUID_INFOTYPE_LEAF7)
+      {
+        __cpuidex(CPUInfo, CPUID_INFOTYPE_LEAF7, 0);
+        if (CPUInfo[CPUINFO_EBX] & CPUID_00000007_EBX_AVX2)
+          m_cpuFeatures |= CPU_FEATURE_AVX2;
+      }
+    }
   }
 
   __cpuid(CPUInfo, 0x80000000);
@@ -718,9 +791,15 @@ void CCPUInfo::ReadCPUFeatures()
         m_cpuFeatures |= CPU_FEATURE_3DNOW;
       if (strstr(buffer,"3DNOWEXT"))
        m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+      if (strstr(buffer,"AVX1.0"))
+        m_cpuFeatures |= CPU_FEATURE_AVX;
     }
     else
       m_cpuFeatures |= CPU_FEATURE_MMX;
+
+    // AVX2 isn't in machdep.cpu.features, ask cpuid leaf 7
+    if ((m_cpuFeatures & CPU_FEATURE_AVX) && HasAVX2())
+      m_cpuFeatures |= CPU_FEATURE_AVX2;
   #endif
 #elif defined(LINUX)
 // empty on purpose, the implementation is in the constructor
@@ -549,12 +549,9 @@ bool DatabaseUtils::GetDatabaseResults(MediaType mediaType, const FieldList &fie
 
   if (fields.empty())
   {
-    DatabaseResult result;
+    results.reserve(resultSet.records.size() + offset);
     for (unsigned int index = 0; index < resultSet.records.size(); index++)
-    {
-      result[FieldRow] = index + offset;
-      results.push_back(result);
-    }
+      results.Set(results.AddRow(), FieldRow, index + offset);
 
     return true;
   }
@@ -565,84 +562,83 @@ bool DatabaseUtils::GetDatabaseResults(MediaType mediaType, const FieldList &fie
   std::vector<int> fieldIndexLookup;
   fieldIndexLookup.reserve(fields.size());
   for (FieldList::const_iterator it = fields.begin(); it != fields.end(); it++)
-    fieldIndexLookup.push_back(GetFieldIndex(*it, mediaType));
+  {
+    int fieldIndex = GetFieldIndex(*it, mediaType);
+    if (fieldIndex < 0)
+      return false;
+    fieldIndexLookup.push_back(fieldIndex);
+  }
 
   results.reserve(resultSet.records.size() + offset);
+  CVariant value;
   for (unsigned int index = 0; index < resultSet.records.size(); index++)
   {
-    DatabaseResult result;
-    result[FieldRow] = index + offset;
+    unsigned int row = results.AddRow();
+    results.Set(row, FieldRow, index + offset);
 
     unsigned int lookupIndex = 0;
     for (FieldList::const_iterator it = fields.begin(); it != fields.end(); it++)
     {
       int fieldIndex = fieldIndexLookup[lookupIndex++];
-      if (fieldIndex < 0)
-        return false;
-
-      std::pair<Field, CVariant> value;
-      value.first = *it;
-      if (!GetFieldValue(resultSet.records[index]->at(fieldIndex), value.second))
+      if (!GetFieldValue(resultSet.records[index]->at(fieldIndex), value))
         CLog::Log(LOGWARNING, "GetDatabaseResults: unable to retrieve value of field %s", resultSet.record_header[fieldIndex].name.c_str());
 
-      if (value.first == FieldYear &&
+      if (*it == FieldYear &&
          (mediaType == MediaTypeTvShow || mediaType == MediaTypeEpisode))
       {
         CDateTime dateTime;
-        dateTime.SetFromDBDate(value.second.asString());
+        dateTime.SetFromDBDate(value.asString());
         if (dateTime.IsValid())
         {
-          value.second.clear();
-          value.second = dateTime.GetYear();
+          value.clear();
+          value = dateTime.GetYear();
         }
       }
 
-      result.insert(value);
+      results.Set(row, *it, value);
     }
 
-    result[FieldMediaType] = mediaType;
+    results.Set(row, FieldMediaType, mediaType);
     switch (mediaType)
     {
     case MediaTypeMovie:
     case MediaTypeVideoCollection:
     case MediaTypeTvShow:
     case MediaTypeMusicVideo:
-      result[FieldLabel] = result.at(FieldTitle).asString();
+      results.Set(row, FieldLabel, results.Get(row, FieldTitle));
       break;
       
     case MediaTypeEpisode:
     {
       std::ostringstream label;
-      label << (int)(result.at(FieldSeason).asInteger() * 100 + result.at(FieldEpisodeNumber).asInteger());
+      label << (int)(results.Get(row, FieldSeason).asInteger() * 100 + results.Get(row, FieldEpisodeNumber).asInteger());
       label << ". ";
-      label << result.at(FieldTitle).asString();
-      result[FieldLabel] = label.str();
+      label << results.Get(row, FieldTitle).asString();
+      results.Set(row, FieldLabel, label.str());
       break;
     }
 
     case MediaTypeAlbum:
-      result[FieldLabel] = result.at(FieldAlbum).asString();
+      results.Set(row, FieldLabel, results.Get(row, FieldAlbum));
       break;
 
     case MediaTypeSong:
     {
       std::ostringstream label;
-      label << (int)result.at(FieldTrackNumber).asInteger();
+      label << (int)results.Get(row, FieldTrackNumber).asInteger();
       label << ". ";
-      label << result.at(FieldTitle).asString();
-      result[FieldLabel] = label.str();
+      label << results.Get(row, FieldTitle).asString();
+      results.Set(row, FieldLabel, label.str());
       break;
     }
 
     case MediaTypeArtist:
-      result[FieldLabel] = result.at(FieldArtist).asString();
+      results.Set(row, FieldLabel, results.Get(row, FieldArtist));
       break;
 
     default:
       break;
     }
-
-    results.push_back(result);
   }
 
   return true;
@@ -668,3 +664,181 @@ std::string DatabaseUtils::BuildLimitClause(int end, int start /* = 0 */)
 
   return sql.str();
 }
+
+DatabaseResults::DatabaseResults()
+  : m_rows(0), m_reserved(0)
+{ }
+
+void DatabaseResults::reserve(size_t rows)
+{
+  if (rows <= m_reserved)
+    return;
+
+  m_reserved = rows;
+  m_order.reserve(rows);
+  for (std::vector<Column>::iterator it = m_columns.begin(); it != m_columns.end(); it++)
+  {
+    if (!it->cells.empty())
+      it->cells.reserve(rows);
+  }
+}
+
+void DatabaseResults::clear()
+{
+  m_columns.clear();
+  m_order.clear();
+  m_rows = 0;
+  m_reserved = 0;
+}
+
+unsigned int DatabaseResults::AddRow()
+{
+  m_order.push_back(m_rows++);
+  return m_order.size() - 1;
+}
+
+void DatabaseResults::push_back(const DatabaseResult &result)
+{
+  unsigned int index = AddRow();
+  for (DatabaseResult::const_iterator it = result.begin(); it != result.end(); it++)
+    Set(index, it->first, it->second);
+}
+
+void DatabaseResults::Set(unsigned int index, Field field, const CVariant &value)
+{
+  if (index >= m_order.size())
+    return;
+
+  if ((size_t)field >= m_columns.size())
+    m_columns.resize(field + 1);
+
+  SetCell(m_columns[field], m_order[index], value);
+}
+
+CVariant DatabaseResults::Get(unsigned int index, Field field) const
+{
+  if (index >= m_order.size() || (size_t)field >= m_columns.size())
+    return CVariant::ConstNullVariant;
+
+  return GetCell(m_columns[field], m_order[index]);
+}
+
+bool DatabaseResults::Has(Field field) const
+{
+  return (size_t)field < m_columns.size() && !m_columns[field].cells.empty();
+}
+
+DatabaseResult DatabaseResults::at(unsigned int index) const
+{
+  DatabaseResult result;
+  if (index >= m_order.size())
+    return result;
+
+  unsigned int row = m_order[index];
+  for (size_t field = 0; field < m_columns.size(); field++)
+  {
+    const Column &column = m_columns[field];
+    if (row < column.cells.size() && column.cells[row].type != CVariant::VariantTypeConstNull)
+      result.insert(std::make_pair((Field)field, GetCell(column, row)));
+  }
+
+  return result;
+}
+
+void DatabaseResults::GetRow(unsigned int index, const Fields &fields, DatabaseResult &result) const
+{
+  for (Fields::const_iterator it = fields.begin(); it != fields.end(); it++)
+    result[*it] = Get(index, *it);
+}
+
+void DatabaseResults::Reorder(const std::vector<unsigned int> &order)
+{
+  std::vector<unsigned int> rows;
+  rows.reserve(order.size());
+  for (std::vector<unsigned int>::const_iterator it = order.begin(); it != order.end(); it++)
+  {
+    if (*it < m_order.size())
+      rows.push_back(m_order[*it]);
+  }
+
+  m_order.swap(rows);
+}
+
+void DatabaseResults::Limit(int start, int end)
+{
+  if (start > 0 && (size_t)start < m_order.size())
+  {
+    m_order.erase(m_order.begin(), m_order.begin() + start);
+    end -= start;
+  }
+  if (end > 0 && (size_t)end < m_order.size())
+    m_order.erase(m_order.begin() + end, m_order.end());
+}
+
+void DatabaseResults::SetCell(Column &column, unsigned int row, const CVariant &value)
+{
+  if (row >= column.cells.size())
+  {
+    Cell empty;
+    empty.type = CVariant::VariantTypeConstNull;
+    empty.value.index = 0;
+    if (column.cells.capacity() < m_reserved)
+      column.cells.reserve(m_reserved);
+    column.cells.resize(row + 1, empty);
+  }
+
+  Cell &cell = column.cells[row];
+  cell.type = value.type();
+  switch (cell.type)
+  {
+  case CVariant::VariantTypeInteger:
+    cell.value.integer = value.asInteger();
+    break;
+  case CVariant::VariantTypeUnsignedInteger:
+    cell.value.unsignedInteger = value.asUnsignedInteger();
+    break;
+  case CVariant::VariantTypeBoolean:
+    cell.value.boolean = value.asBoolean();
+    break;
+  case CVariant::VariantTypeDouble:
+    cell.value.dvalue = value.asDouble();
+    break;
+  case CVariant::VariantTypeString:
+    cell.value.index = column.strings.size();
+    column.strings.push_back(value.asString());
+    break;
+  case CVariant::VariantTypeNull:
+  case CVariant::VariantTypeConstNull:
+    cell.type = CVariant::VariantTypeConstNull;
+    break;
+  default:
+    cell.value.index = column.values.size();
+    column.values.push_back(value);
+    break;
+  }
+}
+
+CVariant DatabaseResults::GetCell(const Column &column, unsigned int row) const
+{
+  if (row >= column.cells.size())
+    return CVariant::ConstNullVariant;
+
+  const Cell &cell = column.cells[row];
+  switch (cell.type)
+  {
+  case CVariant::VariantTypeInteger:
+    return CVariant(cell.value.integer);
+  case CVariant::VariantTypeUnsignedInteger:
+    return CVariant(cell.value.unsignedInteger);
+  case CVariant::VariantTypeBoolean:
+    return CVariant(cell.value.boolean);
+  case CVariant::VariantTypeDouble:
+    return CVariant(cell.value.dvalue);
+  case CVariant::VariantTypeString:
+    return CVariant(column.strings[cell.value.index]);
+  case CVariant::VariantTypeConstNull:
+    return CVariant::ConstNullVariant;
+  default:
+    return column.values[cell.value.index];
+  }
+}
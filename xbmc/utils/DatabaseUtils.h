@@ -25,7 +25,7 @@
 #include <string>
 #include <vector>
 
-class CVariant;
+#include "utils/Variant.h"
 
 namespace dbiplus
 {
@@ -144,7 +144,85 @@ typedef enum {
 } DatabaseQueryPart;
 
 typedef std::map<Field, CVariant> DatabaseResult;
-typedef std::vector<DatabaseResult> DatabaseResults;
+
+/*!
+ \brief Column oriented storage for the rows of a database query.
+
+ Every field is kept in a column of its own holding the plain values of all
+ rows while strings are pooled per column, so filling, sorting and paging a
+ few thousand items doesn't need a map and a CVariant per value. Sorting and
+ limiting only rearrange the row order, all indices taken by the accessors
+ are positions in that order. Values that were never set are returned as
+ CVariant::ConstNullVariant.
+ */
+class DatabaseResults
+{
+public:
+  DatabaseResults();
+
+  size_t size() const { return m_order.size(); }
+  bool empty() const { return m_order.empty(); }
+  void reserve(size_t rows);
+  void clear();
+
+  /*!
+   \brief Add an empty row at the end
+   \return Index of the new row
+   */
+  unsigned int AddRow();
+  void push_back(const DatabaseResult &result);
+
+  void Set(unsigned int index, Field field, const CVariant &value);
+  CVariant Get(unsigned int index, Field field) const;
+  bool Has(Field field) const;
+
+  /*!
+   \brief Get all values of a row
+   */
+  DatabaseResult at(unsigned int index) const;
+  /*!
+   \brief Get the values of the given fields of a row
+   Fields without a value are set to CVariant::ConstNullVariant.
+   */
+  void GetRow(unsigned int index, const Fields &fields, DatabaseResult &result) const;
+
+  /*!
+   \brief Rearrange the rows
+   \param order Indices of the rows in their new order, rows missing from it are dropped
+   */
+  void Reorder(const std::vector<unsigned int> &order);
+  /*!
+   \brief Only keep the rows from start up to (but not including) end
+   \param end End of the rows to keep, everything from start on is kept if <= 0
+   */
+  void Limit(int start, int end);
+
+private:
+  typedef struct Cell {
+    CVariant::VariantType type;
+    union {
+      int64_t integer;
+      uint64_t unsignedInteger;
+      bool boolean;
+      double dvalue;
+      size_t index; // into the strings or values of the column
+    } value;
+  } Cell;
+
+  typedef struct Column {
+    std::vector<Cell> cells;
+    std::vector<std::string> strings;
+    std::vector<CVariant> values;
+  } Column;
+
+  void SetCell(Column &column, unsigned int row, const CVariant &value);
+  CVariant GetCell(const Column &column, unsigned int row) const;
+
+  std::vector<Column> m_columns;
+  std::vector<unsigned int> m_order;
+  unsigned int m_rows;
+  size_t m_reserved;
+};
 
 class DatabaseUtils
 {
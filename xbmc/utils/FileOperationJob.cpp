@@ -26,6 +26,7 @@
 #include "filesystem/MultiPathDirectory.h"
 #include "filesystem/SpecialProtocol.h"
 #include "log.h"
+#include "StringUtils.h"
 #include "Util.h"
 #include "URIUtils.h"
 #include "URL.h"
@@ -293,6 +294,11 @@ void CFileOperationJob::CFileOperation::Debug()
 }
 
 bool CFileOperationJob::CFileOperation::OnFileCallback(void* pContext, int ipercent, float avgSpeed)
+{
+  return OnFileProgress(pContext, ipercent, avgSpeed, -1);
+}
+
+bool CFileOperationJob::CFileOperation::OnFileProgress(void* pContext, int ipercent, float avgSpeed, int secondsLeft)
 {
   DataHolder *data = (DataHolder *)pContext;
   double current = data->current + ((double)ipercent * data->opWeight * (double)m_time)/ 100.0;
@@ -301,6 +307,8 @@ bool CFileOperationJob::CFileOperation::OnFileCallback(void* pContext, int iperc
     data->base->m_avgSpeed.Format("%.1f MB/s", avgSpeed / 1000000.0f);
   else
     data->base->m_avgSpeed.Format("%.1f KB/s", avgSpeed / 1000.0f);
+  if (secondsLeft >= 0)
+    data->base->m_avgSpeed += ", ETA " + StringUtils::SecondsToTimeString(secondsLeft);
 
   return !data->base->ShouldCancel((unsigned)current, 100);
 }
@@ -56,6 +56,7 @@ private:
     bool ExecuteOperation(CFileOperationJob *base, double &current, double opWeight);
     void Debug();
     virtual bool OnFileCallback(void* pContext, int ipercent, float avgSpeed);
+    virtual bool OnFileProgress(void* pContext, int ipercent, float avgSpeed, int secondsLeft);
   private:
     FileAction m_action;
     CStdString m_strFileA, m_strFileB;
@@ -0,0 +1,101 @@
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SortKey.h"
+
+#include <stdint.h>
+
+using namespace std;
+
+// like AlphaNumericCompare() only this many digits are taken as one number
+#define MAX_DIGITS 15
+
+static void AppendUInt32(string &key, uint32_t value)
+{
+  key += (char)(value >> 24);
+  key += (char)(value >> 16);
+  key += (char)(value >> 8);
+  key += (char)value;
+}
+
+CSortKeyGenerator::CSortKeyGenerator()
+  : m_locale(),
+    m_collate(use_facet< collate<wchar_t> >(m_locale)),
+    m_ctype(use_facet< ctype<wchar_t> >(m_locale))
+{
+  // a number sorts where its first digit would
+  m_digits = GetWeight(L'0');
+}
+
+void CSortKeyGenerator::Generate(const wchar_t *label, string &key)
+{
+  key.clear();
+  if (label == NULL)
+    return;
+
+  for (const wchar_t *c = label; *c != 0; )
+  {
+    if (*c >= L'0' && *c <= L'9')
+    {
+      uint64_t number = 0;
+      const wchar_t *digits = c;
+      while (*c >= L'0' && *c <= L'9' && c < digits + MAX_DIGITS)
+        number = number * 10 + (*c++ - L'0');
+
+      key += m_digits;
+      AppendUInt32(key, (uint32_t)(number >> 32));
+      AppendUInt32(key, (uint32_t)number);
+      continue;
+    }
+
+    key += GetWeight(m_ctype.tolower(*c++));
+  }
+}
+
+string CSortKeyGenerator::Generate(const wstring &label)
+{
+  string key;
+  Generate(label.c_str(), key);
+  return key;
+}
+
+const string& CSortKeyGenerator::GetWeight(wchar_t character)
+{
+  string *weight;
+  if (character >= 0 && character < 128)
+    weight = &m_ascii[character];
+  else
+    weight = &m_weights[character];
+
+  if (weight->empty())
+  {
+    // the collation of a character is a string of its own, every part of it
+    // is stored in 4 bytes and the end is marked by 4 zero bytes, so that a
+    // character whose collation starts with the one of another one sorts
+    // after it like it does when comparing them with the locale
+    wstring collation = m_collate.transform(&character, &character + 1);
+    weight->reserve(collation.size() * 4 + 4);
+    for (wstring::const_iterator it = collation.begin(); it != collation.end(); it++)
+      AppendUInt32(*weight, (uint32_t)*it);
+    AppendUInt32(*weight, 0);
+  }
+
+  return *weight;
+}
@@ -0,0 +1,58 @@
+#pragma once
+/*
+ *      Copyright (C) 2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <locale>
+#include <map>
+#include <string>
+
+/*!
+ \brief Turns labels into binary keys that compare like the labels do in
+ StringUtils::AlphaNumericCompare().
+
+ Comparing two keys with memcmp() (or std::string::compare()) gives the same
+ order as comparing their labels: runs of digits compare by their numerical
+ value, letters are folded to lower case and characters are ordered by the
+ collation of the global locale. Removing articles is up to the caller (see
+ SortUtils::RemoveArticles()), keys are built from the label as it is.
+
+ Building a key walks the label once, so sorting lots of labels should build
+ their keys up front instead of comparing the labels over and over. A
+ generator caches the collation of the characters it has seen and therefore
+ shouldn't be shared between threads.
+ */
+class CSortKeyGenerator
+{
+public:
+  CSortKeyGenerator();
+
+  void Generate(const wchar_t *label, std::string &key);
+  std::string Generate(const std::wstring &label);
+
+private:
+  const std::string& GetWeight(wchar_t character);
+
+  std::locale m_locale;
+  const std::collate<wchar_t> &m_collate;
+  const std::ctype<wchar_t> &m_ctype;
+  std::string m_ascii[128];
+  std::map<wchar_t, std::string> m_weights;
+  std::string m_digits;
+};
@@ -24,6 +24,7 @@
 #include "XBDateTime.h"
 #include "settings/AdvancedSettings.h"
 #include "utils/CharsetConverter.h"
+#include "utils/SortKey.h"
 #include "utils/StdString.h"
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
@@ -405,110 +406,50 @@ string ByChannel(SortAttribute attributes, const SortItem &values)
   return values.at(FieldChannelName).asString();
 }
 
-bool preliminarySort(const SortItem &left, const SortItem &right, bool handleFolder, bool &result, std::wstring &labelLeft, std::wstring &labelRight)
-{
-  // make sure both items have the necessary data to do the sorting
-  SortItem::const_iterator itLeftSort, itRightSort;
-  if ((itLeftSort = left.find(FieldSort)) == left.end())
-  {
-    result = false;
-    return true;
-  }
-  if ((itRightSort = right.find(FieldSort)) == right.end())
-  {
-    result = true;
-    return true;
-  }
+// values of the items that are prepared once before sorting
+typedef struct SortValues {
+  std::vector<std::string> keys; // see CSortKeyGenerator
+  std::vector<SortSpecial> special;
+  std::vector<int> folder; // -1 if unknown, otherwise 0 or 1
+} SortValues;
 
-  // look at special sorting behaviour
-  SortItem::const_iterator itLeft, itRight;
-  SortSpecial leftSortSpecial = SortSpecialNone;
-  SortSpecial rightSortSpecial = SortSpecialNone;
-  if ((itLeft = left.find(FieldSortSpecial)) != left.end() && itLeft->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    leftSortSpecial = (SortSpecial)itLeft->second.asInteger();
-  if ((itRight = right.find(FieldSortSpecial)) != right.end() && itRight->second.asInteger() <= (int64_t)SortSpecialOnBottom)
-    rightSortSpecial = (SortSpecial)itRight->second.asInteger();
-  
-  // one has a special sort
-  if (leftSortSpecial != rightSortSpecial)
-  {
-    // left should be sorted on top
-    // or right should be sorted on bottom
-    // => left is sorted above right
-    if (leftSortSpecial == SortSpecialOnTop ||
-        rightSortSpecial == SortSpecialOnBottom)
-    {
-      result = true;
-      return true;
-    }
-    
-    // otherwise right is sorted above left
-    result = false;
-    return true;
-  }
-  // both have either sort on top or sort on bottom -> leave as-is
-  else if (leftSortSpecial != SortSpecialNone && leftSortSpecial == rightSortSpecial)
-  {
-    result = false;
-    return true;
-  }
+// sorts the indices of the items by their SortValues: items with a special
+// sorting go on top or bottom, folders on top of items that aren't folders
+// and everything else by its sort key
+typedef struct IndexSorter {
+  IndexSorter(const SortValues *values, bool descending, bool handleFolder)
+    : values(values), descending(descending), handleFolder(handleFolder)
+  { }
 
-  if (handleFolder)
+  bool operator()(unsigned int left, unsigned int right) const
   {
-    itLeft = left.find(FieldFolder);
-    itRight = right.find(FieldFolder);
-    if (itLeft != left.end() && itRight != right.end() &&
-        itLeft->second.asBoolean() != itRight->second.asBoolean())
-    {
-      result = itLeft->second.asBoolean();
-      return true;
-    }
+    SortSpecial leftSortSpecial = values->special[left];
+    SortSpecial rightSortSpecial = values->special[right];
+    if (leftSortSpecial != rightSortSpecial)
+      return leftSortSpecial == SortSpecialOnTop || rightSortSpecial == SortSpecialOnBottom;
+    else if (leftSortSpecial != SortSpecialNone)
+      return false;
+
+    if (handleFolder && values->folder[left] >= 0 && values->folder[right] >= 0 &&
+        values->folder[left] != values->folder[right])
+      return values->folder[left] > 0;
+
+    int result = values->keys[left].compare(values->keys[right]);
+    return descending ? result > 0 : result < 0;
   }
 
-  labelLeft = itLeftSort->second.asWideString();
-  labelRight = itRightSort->second.asWideString();
-
-  return false;
-}
-
-bool SorterAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
+  const SortValues *values;
+  bool descending;
+  bool handleFolder;
+} IndexSorter;
 
-bool SorterDescending(const SortItem &left, const SortItem &right)
+static SortSpecial GetSortSpecial(const CVariant &value)
 {
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, true, result, labelLeft, labelRight))
-    return result;
+  int64_t special = value.asInteger();
+  if (special <= (int64_t)SortSpecialOnBottom)
+    return (SortSpecial)special;
 
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
-}
-
-bool SorterIgnoreFoldersAscending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) < 0;
-}
-
-bool SorterIgnoreFoldersDescending(const SortItem &left, const SortItem &right)
-{
-  bool result;
-  std::wstring labelLeft, labelRight;
-  if (preliminarySort(left, right, false, result, labelLeft, labelRight))
-    return result;
-
-  return StringUtils::AlphaNumericCompare(labelLeft.c_str(), labelRight.c_str()) > 0;
+  return SortSpecialNone;
 }
 
 map<SortBy, SortUtils::SortPreparator> fillPreparators()
@@ -643,25 +584,48 @@ void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attribute
     SortPreparator preparator = getPreparator(sortBy);
     if (preparator != NULL)
     {
-      Fields sortingFields = GetFieldsForSorting(sortBy);
+      const Fields &sortingFields = GetFieldsForSorting(sortBy);
+      SortValues values;
+      CSortKeyGenerator keyGenerator;
+
+      size_t count = items.size();
+      values.keys.resize(count);
+      values.special.resize(count, SortSpecialNone);
+      values.folder.resize(count, -1);
+      std::vector<unsigned int> order(count);
 
       // Prepare the string used for sorting and store it under FieldSort
-      for (SortItems::iterator item = items.begin(); item != items.end(); item++)
+      CStdStringW sortLabel;
+      for (unsigned int index = 0; index < count; index++)
       {
+        SortItem &item = items[index];
+        order[index] = index;
+
         // add all fields to the item that are required for sorting if they are currently missing
         for (Fields::const_iterator field = sortingFields.begin(); field != sortingFields.end(); field++)
         {
-          if (item->find(*field) == item->end())
-            item->insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
+          if (item.find(*field) == item.end())
+            item.insert(pair<Field, CVariant>(*field, CVariant::ConstNullVariant));
         }
 
-        CStdStringW sortLabel;
-        g_charsetConverter.utf8ToW(preparator(attributes, *item), sortLabel, false);
-        item->insert(pair<Field, CVariant>(FieldSort, CVariant(sortLabel)));
+        g_charsetConverter.utf8ToW(preparator(attributes, item), sortLabel, false);
+        item[FieldSort] = CVariant(sortLabel);
+        keyGenerator.Generate(sortLabel.c_str(), values.keys[index]);
+
+        SortItem::const_iterator it;
+        if ((it = item.find(FieldSortSpecial)) != item.end())
+          values.special[index] = GetSortSpecial(it->second);
+        if ((it = item.find(FieldFolder)) != item.end())
+          values.folder[index] = it->second.asBoolean() ? 1 : 0;
       }
 
       // Do the sorting
-      std::stable_sort(items.begin(), items.end(), getSorter(sortOrder, attributes));
+      std::stable_sort(order.begin(), order.end(), IndexSorter(&values, sortOrder == SortOrderDescending, !(attributes & SortAttributeIgnoreFolders)));
+
+      SortItems sortedItems(count);
+      for (unsigned int index = 0; index < count; index++)
+        sortedItems[index].swap(items[order[index]]);
+      items.swap(sortedItems);
     }
   }
 
@@ -679,6 +643,64 @@ void SortUtils::Sort(const SortDescription &sortDescription, SortItems& items)
   Sort(sortDescription.sortBy, sortDescription.sortOrder, sortDescription.sortAttributes, items, sortDescription.limitEnd, sortDescription.limitStart);
 }
 
+void SortUtils::Sort(SortBy sortBy, SortOrder sortOrder, SortAttribute attributes, DatabaseResults& items, int limitEnd /* = -1 */, int limitStart /* = 0 */)
+{
+  if (sortBy != SortByNone && items.size() > 1)
+  {
+    // get the matching SortPreparator
+    SortPreparator preparator = getPreparator(sortBy);
+    if (preparator != NULL)
+    {
+      const Fields &sortingFields = GetFieldsForSorting(sortBy);
+      SortValues values;
+      CSortKeyGenerator keyGenerator;
+
+      // items without a folder value are only compared by their label unless
+      // it's needed for sorting (and therefore added as a null value)
+      bool needsFolder = sortingFields.find(FieldFolder) != sortingFields.end();
+      bool hasFolder = needsFolder || items.Has(FieldFolder);
+
+      // prepare the keys used for sorting once per item and
+      // only move the indices of the items around while sorting
+      size_t count = items.size();
+      values.keys.resize(count);
+      values.special.resize(count, SortSpecialNone);
+      values.folder.resize(count, -1);
+      std::vector<unsigned int> order(count);
+
+      SortItem item;
+      CStdStringW sortLabel;
+      for (unsigned int index = 0; index < count; index++)
+      {
+        order[index] = index;
+
+        items.GetRow(index, sortingFields, item);
+        g_charsetConverter.utf8ToW(preparator(attributes, item), sortLabel, false);
+        keyGenerator.Generate(sortLabel.c_str(), values.keys[index]);
+
+        values.special[index] = GetSortSpecial(items.Get(index, FieldSortSpecial));
+        if (hasFolder)
+        {
+          CVariant folder = items.Get(index, FieldFolder);
+          if (!folder.isNull() || needsFolder)
+            values.folder[index] = folder.asBoolean() ? 1 : 0;
+        }
+      }
+
+      // Do the sorting
+      std::stable_sort(order.begin(), order.end(), IndexSorter(&values, sortOrder == SortOrderDescending, !(attributes & SortAttributeIgnoreFolders)));
+      items.Reorder(order);
+    }
+  }
+
+  items.Limit(limitStart, limitEnd);
+}
+
+void SortUtils::Sort(const SortDescription &sortDescription, DatabaseResults& items)
+{
+  Sort(sortDescription.sortBy, sortDescription.sortOrder, sortDescription.sortAttributes, items, sortDescription.limitEnd, sortDescription.limitStart);
+}
+
 bool SortUtils::SortFromDataset(const SortDescription &sortDescription, MediaType mediaType, const std::auto_ptr<dbiplus::Dataset> &dataset, DatabaseResults &results)
 {
   FieldList fields;
@@ -709,14 +731,6 @@ const SortUtils::SortPreparator& SortUtils::getPreparator(SortBy sortBy)
   return m_preparators[SortByNone];
 }
 
-SortUtils::Sorter SortUtils::getSorter(SortOrder sortOrder, SortAttribute attributes)
-{
-  if (attributes & SortAttributeIgnoreFolders)
-    return sortOrder == SortOrderDescending ? SorterIgnoreFoldersDescending : SorterIgnoreFoldersAscending;
-
-  return sortOrder == SortOrderDescending ? SorterDescending : SorterAscending;
-}
-
 const Fields& SortUtils::GetFieldsForSorting(SortBy sortBy)
 {
   map<SortBy, Fields>::const_iterator it = m_sortingFields.find(sortBy);
@@ -21,9 +21,14 @@
 #include "utils/DatabaseUtils.h"
 #include "video/VideoDatabase.h"
 #include "music/MusicDatabase.h"
+#include "dbwrappers/dataset.h"
 #include "dbwrappers/qry_dat.h"
+#include "threads/SystemClock.h"
+#include "utils/SortUtils.h"
 #include "utils/Variant.h"
 
+#include <sstream>
+
 #include "gtest/gtest.h"
 
 class TestDatabaseUtilsHelper
@@ -1386,13 +1391,191 @@ TEST(TestDatabaseUtils, GetFieldValue)
   EXPECT_TRUE(v_string.isString());
 }
 
-/* TODO: Need some way to test this function */
-// TEST(TestDatabaseUtils, GetDatabaseResults)
-// {
-//   static bool GetDatabaseResults(MediaType mediaType, const FieldList &fields,
-//                                  const std::auto_ptr<dbiplus::Dataset> &dataset,
-//                                  DatabaseResults &results);
-// }
+/* holds a result set like the one of a query on one of the library views */
+class CTestDataset : public dbiplus::Dataset
+{
+public:
+  CTestDataset(unsigned int columns)
+  {
+    result.record_header.resize(columns);
+  }
+
+  void AddRecord(const dbiplus::sql_record &record)
+  {
+    result.records.push_back(new dbiplus::sql_record(record));
+  }
+
+  virtual int64_t lastinsertid() { return 0; }
+  virtual long nextid(const char *seq_name) { return 0; }
+  virtual int num_rows() { return result.records.size(); }
+  virtual void open(const std::string &sql) { }
+  virtual void open() { }
+  virtual int exec(const std::string &sql) { return 0; }
+  virtual int exec() { return 0; }
+  virtual const void* getExecRes() { return NULL; }
+  virtual bool query(const char *sql) { return false; }
+
+protected:
+  virtual void make_insert() { }
+  virtual void make_edit() { }
+  virtual void make_deletion() { }
+  virtual void fill_fields() { }
+};
+
+static std::auto_ptr<dbiplus::Dataset> CreateMovies(unsigned int count)
+{
+  int titleIndex = DatabaseUtils::GetFieldIndex(FieldTitle, MediaTypeMovie);
+  int yearIndex = DatabaseUtils::GetFieldIndex(FieldYear, MediaTypeMovie);
+  unsigned int columns = std::max(titleIndex, yearIndex) + 1;
+
+  CTestDataset *dataset = new CTestDataset(columns);
+  dbiplus::sql_record record(columns);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    // titles in no particular order, some of them with an article
+    std::ostringstream title;
+    title << ((i % 7) == 0 ? "The " : "") << "Movie " << (i * 7919) % count;
+    record[titleIndex].set_asString(title.str());
+    record[yearIndex].set_asInt(1950 + i % 60);
+    dataset->AddRecord(record);
+  }
+
+  return std::auto_ptr<dbiplus::Dataset>(dataset);
+}
+
+TEST(TestDatabaseUtils, GetDatabaseResults)
+{
+  std::auto_ptr<dbiplus::Dataset> dataset = CreateMovies(10);
+  FieldList fields;
+  fields.push_back(FieldTitle);
+  fields.push_back(FieldYear);
+
+  DatabaseResults results;
+  results.push_back(DatabaseResult());
+  EXPECT_TRUE(DatabaseUtils::GetDatabaseResults(MediaTypeMovie, fields, dataset, results));
+  ASSERT_EQ(11U, results.size());
+
+  // rows are counted on from the ones already in the results
+  EXPECT_TRUE(results.Get(0, FieldRow).isNull());
+  EXPECT_EQ(1, results.Get(1, FieldRow).asInteger());
+  EXPECT_STREQ("The Movie 0", results.Get(1, FieldTitle).asString().c_str());
+  EXPECT_STREQ("The Movie 0", results.Get(1, FieldLabel).asString().c_str());
+  EXPECT_EQ(1950, results.Get(1, FieldYear).asInteger());
+  EXPECT_EQ(MediaTypeMovie, results.Get(1, FieldMediaType).asInteger());
+  EXPECT_EQ(10, results.Get(10, FieldRow).asInteger());
+  EXPECT_STREQ("Movie 1", results.Get(10, FieldTitle).asString().c_str());
+  EXPECT_TRUE(results.Get(10, FieldArtist).isNull());
+
+  DatabaseResult result = results.at(10);
+  EXPECT_EQ(5U, result.size());
+  EXPECT_EQ(1959, result[FieldYear].asInteger());
+}
+
+TEST(TestDatabaseUtils, DatabaseResults)
+{
+  DatabaseResults results;
+  for (int i = 0; i < 5; i++)
+  {
+    unsigned int index = results.AddRow();
+    EXPECT_EQ((unsigned int)i, index);
+    results.Set(index, FieldRow, i);
+    if (i % 2)
+      results.Set(index, FieldTitle, "odd");
+  }
+  results.Set(1, FieldRating, 2.5);
+  results.Set(2, FieldFolder, true);
+
+  EXPECT_EQ(5U, results.size());
+  EXPECT_TRUE(results.Has(FieldTitle));
+  EXPECT_FALSE(results.Has(FieldArtist));
+  EXPECT_STREQ("odd", results.Get(3, FieldTitle).asString().c_str());
+  EXPECT_TRUE(results.Get(4, FieldTitle).isNull());
+  EXPECT_EQ(2.5, results.Get(1, FieldRating).asDouble());
+  EXPECT_TRUE(results.Get(2, FieldFolder).asBoolean());
+  EXPECT_TRUE(results.Get(5, FieldRow).isNull());
+
+  std::vector<unsigned int> order;
+  order.push_back(4);
+  order.push_back(3);
+  order.push_back(1);
+  order.push_back(0);
+  results.Reorder(order);
+  ASSERT_EQ(4U, results.size());
+  EXPECT_EQ(4, results.Get(0, FieldRow).asInteger());
+  EXPECT_STREQ("odd", results.Get(1, FieldTitle).asString().c_str());
+  EXPECT_EQ(2.5, results.Get(2, FieldRating).asDouble());
+
+  results.Limit(1, 3);
+  ASSERT_EQ(2U, results.size());
+  EXPECT_EQ(3, results.Get(0, FieldRow).asInteger());
+  EXPECT_EQ(1, results.Get(1, FieldRow).asInteger());
+
+  results.clear();
+  EXPECT_TRUE(results.empty());
+  EXPECT_FALSE(results.Has(FieldTitle));
+}
+
+/* fills and sorts the results like the library did with a map per row */
+static void SortMovieMaps(const SortDescription &sorting, const std::auto_ptr<dbiplus::Dataset> &dataset, SortItems &items)
+{
+  FieldList fields;
+  DatabaseUtils::GetSelectFields(SortUtils::GetFieldsForSorting(sorting.sortBy), MediaTypeMovie, fields);
+
+  const dbiplus::result_set &resultSet = dataset->get_result_set();
+  items.reserve(resultSet.records.size());
+  for (unsigned int index = 0; index < resultSet.records.size(); index++)
+  {
+    DatabaseResult result;
+    result[FieldRow] = index;
+    for (FieldList::const_iterator it = fields.begin(); it != fields.end(); it++)
+    {
+      std::pair<Field, CVariant> value;
+      value.first = *it;
+      DatabaseUtils::GetFieldValue(resultSet.records[index]->at(DatabaseUtils::GetFieldIndex(*it, MediaTypeMovie)), value.second);
+      result.insert(value);
+    }
+    result[FieldMediaType] = MediaTypeMovie;
+    result[FieldLabel] = result.at(FieldTitle).asString();
+    items.push_back(result);
+  }
+
+  SortUtils::Sort(sorting, items);
+}
+
+TEST(TestDatabaseUtils, GetMoviesBenchmark)
+{
+  // what VideoLibrary.GetMovies does for a page of movies sorted by title
+  SortDescription sorting;
+  sorting.sortBy = SortByTitle;
+  sorting.sortAttributes = SortAttributeIgnoreArticle;
+  sorting.limitStart = 100;
+  sorting.limitEnd = 150;
+
+  unsigned int counts[3] = { 1000, 10000, 50000 };
+  for (int i = 0; i < 3; i++)
+  {
+    std::auto_ptr<dbiplus::Dataset> dataset = CreateMovies(counts[i]);
+
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    SortItems items;
+    SortMovieMaps(sorting, dataset, items);
+    unsigned int mapTime = XbmcThreads::SystemClockMillis() - start;
+
+    start = XbmcThreads::SystemClockMillis();
+    DatabaseResults results;
+    results.reserve(counts[i]);
+    EXPECT_TRUE(SortUtils::SortFromDataset(sorting, MediaTypeMovie, dataset, results));
+    unsigned int columnTime = XbmcThreads::SystemClockMillis() - start;
+
+    // both end up with the same page
+    ASSERT_EQ(items.size(), results.size());
+    for (unsigned int index = 0; index < results.size(); index++)
+      EXPECT_EQ(items[index][FieldRow].asInteger(), results.Get(index, FieldRow).asInteger());
+
+    std::cout << counts[i] << " movies: " << mapTime << " ms per row maps, "
+              << columnTime << " ms columns" << std::endl;
+  }
+}
 
 TEST(TestDatabaseUtils, BuildLimitClause)
 {
@@ -0,0 +1,147 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threads/SystemClock.h"
+#include "utils/SortKey.h"
+#include "utils/SortUtils.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+static int Sign(int64_t value)
+{
+  return value < 0 ? -1 : (value > 0 ? 1 : 0);
+}
+
+/* labels like the ones of a music or video library */
+static std::vector<std::wstring> CreateLabels(unsigned int count)
+{
+  const wchar_t *words[] = { L"The", L"album", L"Movie", L"a", L"Track", L"(live)", L"Part", L"zz", L"x-ray", L"Zoo" };
+  std::vector<std::wstring> labels;
+  labels.reserve(count);
+  unsigned int seed = 12345;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    std::wostringstream label;
+    unsigned int words_count = 1 + i % 4;
+    for (unsigned int word = 0; word < words_count; word++)
+    {
+      seed = seed * 1103515245 + 12345;
+      label << words[(seed >> 16) % 10];
+      if ((seed >> 8) % 3 == 0)
+        label << L" " << (seed >> 4) % 120;
+      label << L" ";
+    }
+    labels.push_back(label.str());
+  }
+  return labels;
+}
+
+typedef struct KeyLess {
+  KeyLess(const std::vector<std::string> *keys) : keys(keys) { }
+  bool operator()(unsigned int left, unsigned int right) const { return (*keys)[left] < (*keys)[right]; }
+  const std::vector<std::string> *keys;
+} KeyLess;
+
+static bool LessAlphaNumeric(const std::wstring &left, const std::wstring &right)
+{
+  return StringUtils::AlphaNumericCompare(left.c_str(), right.c_str()) < 0;
+}
+
+TEST(TestSortKey, Generate)
+{
+  CSortKeyGenerator generator;
+  const wchar_t *labels[] = { L"", L"a", L"A", L"b", L"a2", L"a10", L"a010", L"a 2", L"Track 9", L"track 10",
+                              L"9", L"10", L"100000000000000000001", L"(x)", L"x1y", L"x1z", L"The Zoo", L"the a" };
+  size_t count = sizeof(labels) / sizeof(labels[0]);
+
+  for (size_t left = 0; left < count; left++)
+  {
+    for (size_t right = 0; right < count; right++)
+    {
+      int expected = Sign(StringUtils::AlphaNumericCompare(labels[left], labels[right]));
+      int actual = Sign(generator.Generate(labels[left]).compare(generator.Generate(labels[right])));
+      EXPECT_EQ(expected, actual) << "comparing \"" << std::string(labels[left], labels[left] + wcslen(labels[left]))
+                                  << "\" with \"" << std::string(labels[right], labels[right] + wcslen(labels[right])) << "\"";
+    }
+  }
+
+  EXPECT_LT(generator.Generate(L"Episode 2"), generator.Generate(L"episode 10"));
+  EXPECT_EQ(generator.Generate(L"ABC 1"), generator.Generate(L"abc 01"));
+}
+
+TEST(TestSortKey, SortBenchmark)
+{
+  std::vector<std::wstring> labels = CreateLabels(50000);
+
+  std::vector<std::wstring> compared(labels);
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  std::stable_sort(compared.begin(), compared.end(), LessAlphaNumeric);
+  unsigned int compareTime = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  CSortKeyGenerator generator;
+  std::vector<std::string> keys(labels.size());
+  std::vector<unsigned int> order(labels.size());
+  for (unsigned int i = 0; i < labels.size(); i++)
+  {
+    generator.Generate(labels[i].c_str(), keys[i]);
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), KeyLess(&keys));
+  unsigned int keyTime = XbmcThreads::SystemClockMillis() - start;
+
+  // both end up in the same order
+  ASSERT_EQ(compared.size(), order.size());
+  for (unsigned int i = 0; i < order.size(); i++)
+    EXPECT_TRUE(compared[i] == labels[order[i]]);
+
+  std::cout << labels.size() << " labels: " << compareTime << " ms comparing labels, "
+            << keyTime << " ms with sort keys" << std::endl;
+}
+
+TEST(TestSortKey, SortUtilsBenchmark)
+{
+  std::vector<std::wstring> labels = CreateLabels(50000);
+  SortItems items(labels.size());
+  for (unsigned int i = 0; i < labels.size(); i++)
+  {
+    items[i][FieldLabel] = labels[i];
+    items[i][FieldId] = i;
+  }
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  SortUtils::Sort(SortByLabel, SortOrderAscending, SortAttributeIgnoreArticle, items);
+  unsigned int sortTime = XbmcThreads::SystemClockMillis() - start;
+
+  ASSERT_EQ(labels.size(), items.size());
+  for (unsigned int i = 1; i < items.size(); i++)
+  {
+    EXPECT_LE(StringUtils::AlphaNumericCompare(items[i - 1][FieldSort].asWideString().c_str(),
+                                               items[i][FieldSort].asWideString().c_str()), 0);
+  }
+
+  std::cout << labels.size() << " items sorted by label in " << sortTime << " ms" << std::endl;
+}
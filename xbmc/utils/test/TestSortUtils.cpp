@@ -115,6 +115,34 @@ TEST(TestSortUtils, Sort_SortDescription)
   EXPECT_STREQ("R Artist", items.at(6)[FieldArtist].asString().c_str());
 }
 
+TEST(TestSortUtils, Sort_DatabaseResults)
+{
+  DatabaseResults items;
+  const char *artists[] = { "M Artist", "B Artist", "R Artist", "I Artist", "A Artist", "G Artist" };
+  for (unsigned int i = 0; i < 6; i++)
+    items.Set(items.AddRow(), FieldArtist, artists[i]);
+
+  // folders are only sorted on top of items that know they are no folder
+  items.Set(0, FieldFolder, true);
+  items.Set(3, FieldSortSpecial, SortSpecialOnBottom);
+
+  SortUtils::Sort(SortByArtist, SortOrderAscending, SortAttributeNone, items);
+
+  ASSERT_EQ(6U, items.size());
+  EXPECT_STREQ("A Artist", items.Get(0, FieldArtist).asString().c_str());
+  EXPECT_STREQ("B Artist", items.Get(1, FieldArtist).asString().c_str());
+  EXPECT_STREQ("G Artist", items.Get(2, FieldArtist).asString().c_str());
+  EXPECT_STREQ("M Artist", items.Get(3, FieldArtist).asString().c_str());
+  EXPECT_STREQ("R Artist", items.Get(4, FieldArtist).asString().c_str());
+  EXPECT_STREQ("I Artist", items.Get(5, FieldArtist).asString().c_str());
+
+  SortUtils::Sort(SortByArtist, SortOrderDescending, SortAttributeNone, items, 3, 1);
+
+  ASSERT_EQ(2U, items.size());
+  EXPECT_STREQ("M Artist", items.Get(0, FieldArtist).asString().c_str());
+  EXPECT_STREQ("G Artist", items.Get(1, FieldArtist).asString().c_str());
+}
+
 TEST(TestSortUtils, GetFieldsForSorting)
 {
   Fields fields;
@@ -331,6 +331,11 @@ bool CVideoDatabase::CreateTables()
     m_pDS->exec("CREATE UNIQUE INDEX ix_taglinks_2 ON taglinks (idMedia, media_type(20), idTag)");
     m_pDS->exec("CREATE INDEX ix_taglinks_3 ON taglinks (media_type(20))");
 
+    CLog::Log(LOGINFO, "create pathjournal table");
+    m_pDS->exec("CREATE TABLE pathjournal (idJournal integer primary key, strPath text, strParentPath text, modified integer, files integer, changed bool)");
+    m_pDS->exec("CREATE UNIQUE INDEX ix_pathjournal_1 ON pathjournal (strPath(255))");
+    m_pDS->exec("CREATE INDEX ix_pathjournal_2 ON pathjournal (strParentPath(255))");
+
     // we create views last to ensure all indexes are rolled in
     CreateViews();
   }
@@ -442,7 +447,6 @@ void CVideoDatabase::CreateViews()
 //********************************************************************************************************************************
 int CVideoDatabase::GetPathId(const CStdString& strPath)
 {
-  CStdString strSQL;
   try
   {
     int idPath=-1;
@@ -455,17 +459,19 @@ int CVideoDatabase::GetPathId(const CStdString& strPath)
 
     URIUtils::AddSlashAtEnd(strPath1);
 
-    strSQL=PrepareSQL("select idPath from path where strPath='%s'",strPath1.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (!m_pDS->eof())
-      idPath = m_pDS->fv("path.idPath").get_asInt();
-
-    m_pDS->close();
+    Statement *stmt = GetStatement("select idPath from path where strPath=?");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strPath1);
+    if (stmt->step())
+    {
+      idPath = stmt->fv(0).get_asInt();
+      stmt->reset();
+    }
     return idPath;
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "%s unable to getpath (%s)", __FUNCTION__, strSQL.c_str());
+    CLog::Log(LOGERROR, "%s unable to getpath (%s)", __FUNCTION__, strPath.c_str());
   }
   return -1;
 }
@@ -607,7 +613,6 @@ bool CVideoDatabase::GetSubPaths(const CStdString &basepath, vector< pair<int,st
 
 int CVideoDatabase::AddPath(const CStdString& strPath, const CStdString &strDateAdded /*= "" */)
 {
-  CStdString strSQL;
   try
   {
     int idPath = GetPathId(strPath);
@@ -624,17 +629,24 @@ int CVideoDatabase::AddPath(const CStdString& strPath, const CStdString &strDate
     URIUtils::AddSlashAtEnd(strPath1);
 
     // only set dateadded if we got one
+    Statement *stmt;
     if (!strDateAdded.empty())
-      strSQL=PrepareSQL("insert into path (idPath, strPath, strContent, strScraper, dateAdded) values (NULL,'%s','','', '%s')", strPath1.c_str(), strDateAdded.c_str());
+    {
+      stmt = GetStatement("insert into path (idPath, strPath, strContent, strScraper, dateAdded) values (NULL,?,'','',?)");
+      if (NULL == stmt) return -1;
+      stmt->bind(2, strDateAdded);
+    }
     else
-      strSQL=PrepareSQL("insert into path (idPath, strPath, strContent, strScraper) values (NULL,'%s','','')", strPath1.c_str());
-    m_pDS->exec(strSQL.c_str());
-    idPath = (int)m_pDS->lastinsertid();
+      stmt = GetStatement("insert into path (idPath, strPath, strContent, strScraper) values (NULL,?,'','')");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strPath1);
+    stmt->exec();
+    idPath = (int)stmt->lastinsertid();
     return idPath;
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "%s unable to addpath (%s)", __FUNCTION__, strSQL.c_str());
+    CLog::Log(LOGERROR, "%s unable to addpath (%s)", __FUNCTION__, strPath.c_str());
   }
   return -1;
 }
@@ -661,10 +673,131 @@ bool CVideoDatabase::GetPathHash(const CStdString &path, CStdString &hash)
   return false;
 }
 
+bool CVideoDatabase::GetPathJournal(const CStdString &path, int64_t &modified, int &files, vector<CStdString> &subPaths)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    subPaths.clear();
+
+    CStdString strSQL = PrepareSQL("select modified, files, changed from pathjournal where strPath='%s'", path.c_str());
+    m_pDS->query(strSQL.c_str());
+    if (m_pDS->num_rows() == 0 || m_pDS->fv("changed").get_asBool())
+    {
+      m_pDS->close();
+      return false;
+    }
+    modified = m_pDS->fv("modified").get_asInt64();
+    files = m_pDS->fv("files").get_asInt();
+    m_pDS->close();
+
+    strSQL = PrepareSQL("select strPath from pathjournal where strParentPath='%s'", path.c_str());
+    m_pDS->query(strSQL.c_str());
+    while (!m_pDS->eof())
+    {
+      subPaths.push_back(m_pDS->fv("strPath").get_asString());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, path.c_str());
+  }
+
+  return false;
+}
+
+bool CVideoDatabase::SetPathJournal(const CStdString &path, int64_t modified, int files, const vector<CStdString> &subPaths)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    BeginTransaction();
+
+    CStdString strSQL = PrepareSQL("select idJournal from pathjournal where strPath='%s'", path.c_str());
+    m_pDS->query(strSQL.c_str());
+    bool exists = m_pDS->num_rows() > 0;
+    m_pDS->close();
+    if (exists)
+      strSQL = PrepareSQL("update pathjournal set modified=%I64d, files=%i, changed=0 where strPath='%s'", modified, files, path.c_str());
+    else
+      strSQL = PrepareSQL("insert into pathjournal (idJournal, strPath, strParentPath, modified, files, changed) values (NULL, '%s', '', %I64d, %i, 0)", path.c_str(), modified, files);
+    m_pDS->exec(strSQL.c_str());
+
+    // forget about the subfolders that are gone, along with everything below them
+    set<CStdString> current(subPaths.begin(), subPaths.end());
+    set<CStdString> known;
+    strSQL = PrepareSQL("select strPath from pathjournal where strParentPath='%s'", path.c_str());
+    m_pDS->query(strSQL.c_str());
+    while (!m_pDS->eof())
+    {
+      known.insert(m_pDS->fv("strPath").get_asString());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    for (set<CStdString>::const_iterator it = known.begin(); it != known.end(); ++it)
+    {
+      if (current.find(*it) == current.end())
+      { // compare the prefix as is, like would take _ and % for wildcards and ignore the case
+        CStdString prefix(*it);
+        URIUtils::AddSlashAtEnd(prefix);
+        m_pDS->exec(PrepareSQL("delete from pathjournal where strPath='%s' or substr(strPath,1,%i)='%s'",
+                               it->c_str(), (int)StringUtils::utf8_strlen(prefix.c_str()), prefix.c_str()));
+      }
+    }
+
+    // new subfolders have to be listed on their own before they can be skipped
+    for (set<CStdString>::const_iterator it = current.begin(); it != current.end(); ++it)
+    {
+      if (known.find(*it) != known.end())
+        continue;
+      strSQL = PrepareSQL("select idJournal from pathjournal where strPath='%s'", it->c_str());
+      m_pDS->query(strSQL.c_str());
+      exists = m_pDS->num_rows() > 0;
+      m_pDS->close();
+      if (exists)
+        strSQL = PrepareSQL("update pathjournal set strParentPath='%s' where strPath='%s'", path.c_str(), it->c_str());
+      else
+        strSQL = PrepareSQL("insert into pathjournal (idJournal, strPath, strParentPath, modified, files, changed) values (NULL, '%s', '%s', 0, 0, 1)", it->c_str(), path.c_str());
+      m_pDS->exec(strSQL.c_str());
+    }
+
+    CommitTransaction();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, path.c_str());
+    RollbackTransaction();
+  }
+
+  return false;
+}
+
+void CVideoDatabase::SetPathChanged(const CStdString &path)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return;
+    if (NULL == m_pDS.get()) return;
+
+    m_pDS->exec(PrepareSQL("update pathjournal set changed=1 where strPath='%s'", path.c_str()));
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, path.c_str());
+  }
+}
+
 //********************************************************************************************************************************
 int CVideoDatabase::AddFile(const CStdString& strFileNameAndPath)
 {
-  CStdString strSQL = "";
   try
   {
     int idFile;
@@ -678,25 +811,28 @@ int CVideoDatabase::AddFile(const CStdString& strFileNameAndPath)
     if (idPath < 0)
       return -1;
 
-    CStdString strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() > 0)
+    Statement *stmt = GetStatement("select idFile from files where strFileName=? and idPath=?");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strFileName);
+    stmt->bind(2, idPath);
+    if (stmt->step())
     {
-      idFile = m_pDS->fv("idFile").get_asInt() ;
-      m_pDS->close();
+      idFile = stmt->fv(0).get_asInt();
+      stmt->reset();
       return idFile;
     }
-    m_pDS->close();
 
-    strSQL=PrepareSQL("insert into files (idFile, idPath, strFileName) values(NULL, %i, '%s')", idPath, strFileName.c_str());
-    m_pDS->exec(strSQL.c_str());
-    idFile = (int)m_pDS->lastinsertid();
+    stmt = GetStatement("insert into files (idFile, idPath, strFileName) values(NULL, ?, ?)");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, idPath);
+    stmt->bind(2, strFileName);
+    stmt->exec();
+    idFile = (int)stmt->lastinsertid();
     return idFile;
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "%s unable to addfile (%s)", __FUNCTION__, strSQL.c_str());
+    CLog::Log(LOGERROR, "%s unable to addfile (%s)", __FUNCTION__, strFileNameAndPath.c_str());
   }
   return -1;
 }
@@ -897,13 +1033,14 @@ int CVideoDatabase::GetFileId(const CStdString& strFilenameAndPath)
     int idPath = GetPathId(strPath);
     if (idPath >= 0)
     {
-      CStdString strSQL;
-      strSQL=PrepareSQL("select idFile from files where strFileName='%s' and idPath=%i", strFileName.c_str(),idPath);
-      m_pDS->query(strSQL.c_str());
-      if (m_pDS->num_rows() > 0)
+      Statement *stmt = GetStatement("select idFile from files where strFileName=? and idPath=?");
+      if (NULL == stmt) return -1;
+      stmt->bind(1, strFileName);
+      stmt->bind(2, idPath);
+      if (stmt->step())
       {
-        int idFile = m_pDS->fv("files.idFile").get_asInt();
-        m_pDS->close();
+        int idFile = stmt->fv(0).get_asInt();
+        stmt->reset();
         return idFile;
       }
     }
@@ -1247,21 +1384,23 @@ int CVideoDatabase::AddToTable(const CStdString& table, const CStdString& firstF
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
 
-    CStdString strSQL = PrepareSQL("select %s from %s where %s like '%s'", firstField.c_str(), table.c_str(), secondField.c_str(), value.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    Statement *stmt = GetStatement(PrepareSQL("select %s from %s where %s like ?", firstField.c_str(), table.c_str(), secondField.c_str()));
+    if (NULL == stmt) return -1;
+    stmt->bind(1, value);
+    if (!stmt->step())
     {
-      m_pDS->close();
       // doesnt exists, add it
-      strSQL = PrepareSQL("insert into %s (%s, %s) values(NULL, '%s')", table.c_str(), firstField.c_str(), secondField.c_str(), value.c_str());      
-      m_pDS->exec(strSQL.c_str());
-      int id = (int)m_pDS->lastinsertid();
+      stmt = GetStatement(PrepareSQL("insert into %s (%s, %s) values(NULL, ?)", table.c_str(), firstField.c_str(), secondField.c_str()));
+      if (NULL == stmt) return -1;
+      stmt->bind(1, value);
+      stmt->exec();
+      int id = (int)stmt->lastinsertid();
       return id;
     }
     else
     {
-      int id = m_pDS->fv(firstField).get_asInt();
-      m_pDS->close();
+      int id = stmt->fv(0).get_asInt();
+      stmt->reset();
       return id;
     }
   }
@@ -1312,25 +1451,31 @@ int CVideoDatabase::AddActor(const CStdString& strActor, const CStdString& thumb
     if (NULL == m_pDB.get()) return -1;
     if (NULL == m_pDS.get()) return -1;
     int idActor = -1;
-    CStdString strSQL=PrepareSQL("select idActor from actors where strActor like '%s'", strActor.c_str());
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    Statement *stmt = GetStatement("select idActor from actors where strActor like ?");
+    if (NULL == stmt) return -1;
+    stmt->bind(1, strActor);
+    if (!stmt->step())
     {
-      m_pDS->close();
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into actors (idActor, strActor, strThumb) values( NULL, '%s','%s')", strActor.c_str(),thumbURLs.c_str());
-      m_pDS->exec(strSQL.c_str());
-      idActor = (int)m_pDS->lastinsertid();
+      stmt = GetStatement("insert into actors (idActor, strActor, strThumb) values( NULL, ?, ?)");
+      if (NULL == stmt) return -1;
+      stmt->bind(1, strActor);
+      stmt->bind(2, thumbURLs);
+      stmt->exec();
+      idActor = (int)stmt->lastinsertid();
     }
     else
     {
-      idActor = m_pDS->fv("idActor").get_asInt();
-      m_pDS->close();
+      idActor = stmt->fv(0).get_asInt();
+      stmt->reset();
       // update the thumb url's
       if (!thumbURLs.IsEmpty())
       {
-        strSQL=PrepareSQL("update actors set strThumb='%s' where idActor=%i",thumbURLs.c_str(),idActor);
-        m_pDS->exec(strSQL.c_str());
+        stmt = GetStatement("update actors set strThumb=? where idActor=?");
+        if (NULL == stmt) return -1;
+        stmt->bind(1, thumbURLs);
+        stmt->bind(2, idActor);
+        stmt->exec();
       }
     }
     // add artwork
@@ -1354,15 +1499,23 @@ void CVideoDatabase::AddLinkToActor(const char *table, int actorID, const char *
     if (NULL == m_pDB.get()) return ;
     if (NULL == m_pDS.get()) return ;
 
-    CStdString strSQL=PrepareSQL("select * from %s where idActor=%i and %s=%i", table, actorID, secondField, secondID);
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    Statement *stmt = GetStatement(PrepareSQL("select * from %s where idActor=? and %s=?", table, secondField));
+    if (NULL == stmt) return ;
+    stmt->bind(1, actorID);
+    stmt->bind(2, secondID);
+    if (!stmt->step())
     {
       // doesnt exists, add it
-      strSQL=PrepareSQL("insert into %s (idActor, %s, strRole, iOrder) values(%i,%i,'%s',%i)", table, secondField, actorID, secondID, role.c_str(), order);
-      m_pDS->exec(strSQL.c_str());
+      stmt = GetStatement(PrepareSQL("insert into %s (idActor, %s, strRole, iOrder) values(?,?,?,?)", table, secondField));
+      if (NULL == stmt) return ;
+      stmt->bind(1, actorID);
+      stmt->bind(2, secondID);
+      stmt->bind(3, role);
+      stmt->bind(4, order);
+      stmt->exec();
     }
-    m_pDS->close();
+    else
+      stmt->reset();
   }
   catch (...)
   {
@@ -1377,20 +1530,33 @@ void CVideoDatabase::AddToLinkTable(const char *table, const char *firstField, i
     if (NULL == m_pDB.get()) return ;
     if (NULL == m_pDS.get()) return ;
 
-    CStdString strSQL = PrepareSQL("select * from %s where %s=%i and %s=%i", table, firstField, firstID, secondField, secondID);
-    if (typeField != NULL && type != NULL)
-      strSQL += PrepareSQL(" and %s='%s'", typeField, type);
-    m_pDS->query(strSQL.c_str());
-    if (m_pDS->num_rows() == 0)
+    bool hasType = typeField != NULL && type != NULL;
+    CStdString strSQL = PrepareSQL("select * from %s where %s=? and %s=?", table, firstField, secondField);
+    if (hasType)
+      strSQL += PrepareSQL(" and %s=?", typeField);
+    Statement *stmt = GetStatement(strSQL);
+    if (NULL == stmt) return ;
+    stmt->bind(1, firstID);
+    stmt->bind(2, secondID);
+    if (hasType)
+      stmt->bind(3, type);
+    if (!stmt->step())
     {
       // doesnt exists, add it
-      if (typeField == NULL || type == NULL)
-        strSQL = PrepareSQL("insert into %s (%s,%s) values(%i,%i)", table, firstField, secondField, firstID, secondID);
+      if (!hasType)
+        strSQL = PrepareSQL("insert into %s (%s,%s) values(?,?)", table, firstField, secondField);
       else
-        strSQL = PrepareSQL("insert into %s (%s,%s,%s) values(%i,%i,'%s')", table, firstField, secondField, typeField, firstID, secondID, type);
-      m_pDS->exec(strSQL.c_str());
+        strSQL = PrepareSQL("insert into %s (%s,%s,%s) values(?,?,?)", table, firstField, secondField, typeField);
+      stmt = GetStatement(strSQL);
+      if (NULL == stmt) return ;
+      stmt->bind(1, firstID);
+      stmt->bind(2, secondID);
+      if (hasType)
+        stmt->bind(3, type);
+      stmt->exec();
     }
-    m_pDS->close();
+    else
+      stmt->reset();
   }
   catch (...)
   {
@@ -4093,6 +4259,12 @@ bool CVideoDatabase::UpdateOldVersion(int iVersion)
     }
     m_pDS->exec("DROP TABLE IF EXISTS setlinkmovie");
   }
+  if (iVersion < 69)
+  {
+    m_pDS->exec("CREATE TABLE pathjournal (idJournal integer primary key, strPath text, strParentPath text, modified integer, files integer, changed bool)");
+    m_pDS->exec("CREATE UNIQUE INDEX ix_pathjournal_1 ON pathjournal (strPath(255))");
+    m_pDS->exec("CREATE INDEX ix_pathjournal_2 ON pathjournal (strParentPath(255))");
+  }
   // always recreate the view after any table change
   CreateViews();
   return true;
@@ -5661,9 +5833,9 @@ bool CVideoDatabase::GetMoviesByWhere(const CStdString& strBaseDir, const Filter
     // get data from returned rows
     items.Reserve(results.size());
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       if (targetRow < (unsigned int)setItems.Size())
       {
         items.Add(setItems[targetRow]);
@@ -5772,9 +5944,9 @@ bool CVideoDatabase::GetTvShowsByWhere(const CStdString& strBaseDir, const Filte
     // get data from returned rows
     items.Reserve(results.size());
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
       
       CVideoInfoTag movie = GetDetailsForTvShow(record, false);
@@ -6084,9 +6256,9 @@ bool CVideoDatabase::GetEpisodesByWhere(const CStdString& strBaseDir, const Filt
     CLabelFormatter formatter("%H. %T", "");
 
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
 
       CVideoInfoTag movie = GetDetailsForEpisode(record);
@@ -6934,9 +7106,9 @@ bool CVideoDatabase::GetMusicVideosByWhere(const CStdString &baseDir, const Filt
     items.Reserve(results.size());
     // get songs from returned subtable
     const query_data &data = m_pDS->get_result_set().records;
-    for (DatabaseResults::const_iterator it = results.begin(); it != results.end(); it++)
+    for (unsigned int index = 0; index < results.size(); index++)
     {
-      unsigned int targetRow = (unsigned int)it->at(FieldRow).asInteger();
+      unsigned int targetRow = (unsigned int)results.Get(index, FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
       
       CVideoInfoTag musicvideo = GetDetailsForMusicVideo(record);
@@ -525,6 +525,32 @@ public:
   bool GetPaths(std::set<CStdString> &paths);
   bool GetPathsForTvShow(int idShow, std::set<int>& paths);
 
+  /*! \brief Get what the scanner recorded about a folder when it last listed it.
+   \param path the folder
+   \param modified [out] modification time of the folder before it was listed
+   \param files [out] number of files that were hashed for the folder
+   \param subPaths [out] subfolders found in the folder
+   \return true if the folder has been recorded and not marked as changed since, false otherwise
+   \sa SetPathJournal, SetPathChanged
+   */
+  bool GetPathJournal(const CStdString &path, int64_t &modified, int &files, std::vector<CStdString> &subPaths);
+
+  /*! \brief Record a folder the scanner has listed.
+   Subfolders that are gone are forgotten along with everything below them, new ones are
+   recorded as changed until they have been listed themselves.
+   \param path the folder
+   \param modified modification time of the folder before it was listed
+   \param files number of files that were hashed for the folder
+   \param subPaths subfolders found in the folder
+   \return true on success, false otherwise
+   */
+  bool SetPathJournal(const CStdString &path, int64_t modified, int files, const std::vector<CStdString> &subPaths);
+
+  /*! \brief Mark a folder as changed so that the scanner lists it the next time.
+   \param path the folder
+   */
+  void SetPathChanged(const CStdString &path);
+
   /*! \brief retrieve subpaths of a given path.  Assumes a heirarchical folder structure
    \param basepath the root path to retrieve subpaths for
    \param subpaths the returned subpaths
@@ -803,7 +829,7 @@ private:
    */
   bool LookupByFolders(const CStdString &path, bool shows = false);
 
-  virtual int GetMinVersion() const { return 68; };
+  virtual int GetMinVersion() const { return 69; };
   virtual int GetExportVersion() const { return 1; };
   const char *GetBaseDBName() const { return "MyVideos"; };
 
@@ -22,6 +22,7 @@
 #include "FileItem.h"
 #include "VideoInfoScanner.h"
 #include "addons/AddonManager.h"
+#include "filesystem/Directory.h"
 #include "filesystem/DirectoryCache.h"
 #include "Util.h"
 #include "NfoFile.h"
@@ -64,6 +65,9 @@ namespace VIDEO
     m_itemCount = 0;
     m_bClean = false;
     m_scanAll = false;
+    m_dirsVisited = 0;
+    m_dirsSkipped = 0;
+    m_filesHashed = 0;
   }
 
   CVideoInfoScanner::~CVideoInfoScanner()
@@ -84,10 +88,14 @@ namespace VIDEO
       m_bCanInterrupt = true;
 
       CLog::Log(LOGNOTICE, "VideoInfoScanner: Starting scan ..");
+      CDirectory::ResetStatCounters();
 
       // Reset progress vars
       m_currentItem = 0;
       m_itemCount = -1;
+      m_dirsVisited = 0;
+      m_dirsSkipped = 0;
+      m_filesHashed = 0;
 
       SetPriority(GetMinPriority());
 
@@ -123,9 +131,15 @@ namespace VIDEO
       }
 
       m_database.Close();
+      m_seriesFolders.clear();
 
       tick = XbmcThreads::SystemClockMillis() - tick;
       CLog::Log(LOGNOTICE, "VideoInfoScanner: Finished scan. Scanning for video info took %s", StringUtils::SecondsToTimeString(tick / 1000).c_str());
+      CLog::Log(LOGNOTICE, "VideoInfoScanner: Listed %u directories and hashed %u files, skipped %u unchanged directories",
+                m_dirsVisited, m_filesHashed, m_dirsSkipped);
+      CDirectory::SStatCounters counters = CDirectory::GetStatCounters();
+      CLog::Log(LOGDEBUG, "VideoInfoScanner: Checked %u local files in %u batches, %u from the directory cache and %u from listings, saving %u round trips",
+                counters.files, counters.batches, counters.cached, counters.listings, counters.files - counters.roundtrips);
       ANNOUNCEMENT::CAnnouncementManager::Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanFinished");
       
       m_bRunning = false;
@@ -211,6 +225,9 @@ namespace VIDEO
     CFileItemList items;
     bool foundDirectly = false;
     bool bSkip = false;
+    bool listed = false;
+    bool hashStored = false;
+    int64_t listedTime = 0;
 
     SScanSettings settings;
     ScraperPtr info = m_database.GetScraperForPath(strDirectory, settings, foundDirectly);
@@ -233,16 +250,46 @@ namespace VIDEO
       if (m_pObserver)
         m_pObserver->OnStateChanged(content == CONTENT_MOVIES ? FETCHING_MOVIE_INFO : FETCHING_MUSICVIDEO_INFO);
 
-      CStdString fastHash = GetFastHash(strDirectory);
-      if (m_database.GetPathHash(strDirectory, dbHash) && !fastHash.IsEmpty() && fastHash == dbHash)
+      bool haveHash = m_database.GetPathHash(strDirectory, dbHash);
+      int64_t modified = 0;
+      int files = 0;
+      vector<CStdString> subPaths;
+      bool journaled = haveHash && !dbHash.IsEmpty() && m_database.GetPathJournal(strDirectory, modified, files, subPaths);
+      if (journaled && IsUnchanged(strDirectory, modified))
+      { // nothing changed since the folder was last listed - only its subfolders need looking at
+        CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' due to no change (journal)", strDirectory.c_str());
+        hash = dbHash;
+        bSkip = true;
+        m_dirsSkipped++;
+        for (vector<CStdString>::const_iterator subPath = subPaths.begin(); subPath != subPaths.end(); ++subPath)
+        {
+          CFileItemPtr item(new CFileItem(*subPath, true));
+          items.Add(item);
+        }
+      }
+      bool changed = false;
+      if (!bSkip)
+      { // the watcher sees changes that don't show in the modified time, the fast hash can't be trusted then
+        changed = m_watcher.HasChanged(strDirectory);
+        m_watcher.Watch(strDirectory);
+        listedTime = GetModificationTime(strDirectory);
+      }
+      CStdString fastHash = GetFastHash(listedTime);
+      if (!bSkip && !changed && haveHash && !fastHash.IsEmpty() && fastHash == dbHash)
       { // fast hashes match - no need to process anything
         CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping dir '%s' due to no change (fasthash)", strDirectory.c_str());
         hash = fastHash;
         bSkip = true;
+        m_dirsSkipped++;
       }
       if (!bSkip)
       { // need to fetch the folder
+        if (journaled) // until it's recorded again
+          m_database.SetPathChanged(strDirectory);
         CDirectory::GetDirectory(strDirectory, items, g_settings.m_videoExtensions);
+        m_dirsVisited++;
+        m_filesHashed += items.Size();
+        listed = true;
         items.Stack();
         // compute hash
         GetPathHash(items, hash);
@@ -307,6 +354,7 @@ namespace VIDEO
         if (!m_bStop && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
         {
           m_database.SetPathHash(strDirectory, hash);
+          hashStored = true;
           m_pathsToClean.insert(m_database.GetPathId(strDirectory));
           CLog::Log(LOGDEBUG, "VideoInfoScanner: Finished adding information from dir %s", strDirectory.c_str());
         }
@@ -317,9 +365,22 @@ namespace VIDEO
         CLog::Log(LOGDEBUG, "VideoInfoScanner: No (new) information was found in dir %s", strDirectory.c_str());
       }
     }
-    else if (hash != dbHash && (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS))
+    else if (content == CONTENT_MOVIES || content == CONTENT_MUSICVIDEOS)
     { // update the hash either way - we may have changed the hash to a fast version
-      m_database.SetPathHash(strDirectory, hash);
+      if (hash != dbHash)
+        m_database.SetPathHash(strDirectory, hash);
+      hashStored = true;
+    }
+
+    if (listed && hashStored && !hash.IsEmpty())
+    { // record what the hash was computed from, so the folder needn't be listed again while it's unchanged
+      vector<CStdString> subPaths;
+      for (int i = 0; i < items.Size(); ++i)
+      {
+        if (items[i]->m_bIsFolder && !items[i]->IsParentFolder() && !items[i]->IsPlayList())
+          subPaths.push_back(items[i]->GetPath());
+      }
+      m_database.SetPathJournal(strDirectory, listedTime, items.Size(), subPaths);
     }
 
     if (m_pObserver)
@@ -454,7 +515,7 @@ namespace VIDEO
     {
       INFO_RET ret = RetrieveInfoForEpisodes(pItem, idTvShow, info2, useLocal, pDlgProgress);
       if (ret == INFO_ADDED)
-        m_database.SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
+        SetSeriesPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
       return ret;
     }
 
@@ -485,7 +546,7 @@ namespace VIDEO
       {
         INFO_RET ret = RetrieveInfoForEpisodes(pItem, lResult, info2, useLocal, pDlgProgress);
         if (ret == INFO_ADDED)
-          m_database.SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
+          SetSeriesPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
         return ret;
       }
       return INFO_ADDED;
@@ -510,7 +571,7 @@ namespace VIDEO
     {
       INFO_RET ret = RetrieveInfoForEpisodes(pItem, lResult, info2, useLocal, pDlgProgress);
       if (ret == INFO_ADDED)
-        m_database.SetPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
+        SetSeriesPathHash(pItem->GetPath(), pItem->GetProperty("hash").asString());
     }
     return INFO_ADDED;
   }
@@ -631,11 +692,31 @@ namespace VIDEO
 
     if (item->m_bIsFolder)
     {
-      CUtil::GetRecursiveListing(item->GetPath(), items, g_settings.m_videoExtensions, true);
       CStdString hash, dbHash;
-      int numFilesInFolder = GetPathHash(items, hash);
+      int numFilesInFolder = 0;
+      unsigned int folders = 0;
+      bool haveHash = m_database.GetPathHash(item->GetPath(), dbHash);
+      bool unchanged = haveHash && !dbHash.IsEmpty() && IsTreeUnchanged(item->GetPath(), numFilesInFolder, folders);
+      if (unchanged)
+      {
+        CLog::Log(LOGDEBUG, "VideoInfoScanner: Skipping show '%s' due to no change (journal)", item->GetPath().c_str());
+        m_dirsSkipped += folders;
+      }
+      else
+      {
+        if (haveHash) // until it's recorded again
+          m_database.SetPathChanged(item->GetPath());
+        vector<SJournalFolder> journal;
+        GetSeriesListing(item->GetPath(), items, journal);
+        numFilesInFolder = GetPathHash(items, hash);
+        journal[0].files = numFilesInFolder;
+        m_seriesFolders[item->GetPath()].swap(journal);
+        unchanged = haveHash && dbHash == hash;
+        if (unchanged)
+          SetSeriesPathHash(item->GetPath(), hash);
+      }
 
-      if (m_database.GetPathHash(item->GetPath(), dbHash) && dbHash == hash)
+      if (unchanged)
       {
         m_currentItem += numFilesInFolder;
 
@@ -1556,7 +1637,7 @@ namespace VIDEO
     return items.GetFolderCount() == 0;
   }
 
-  CStdString CVideoInfoScanner::GetFastHash(const CStdString &directory) const
+  int64_t CVideoInfoScanner::GetModificationTime(const CStdString &directory)
   {
     struct __stat64 buffer;
     if (XFILE::CFile::Stat(directory, &buffer) == 0)
@@ -1564,14 +1645,95 @@ namespace VIDEO
       int64_t time = buffer.st_mtime;
       if (!time)
         time = buffer.st_ctime;
-      if (time)
+      return time;
+    }
+    return 0;
+  }
+
+  CStdString CVideoInfoScanner::GetFastHash(int64_t time)
+  {
+    if (time)
+    {
+      CStdString hash;
+      hash.Format("fast%"PRId64, time);
+      return hash;
+    }
+    return "";
+  }
+
+  void CVideoInfoScanner::GetSeriesListing(const CStdString &path, CFileItemList &items, vector<SJournalFolder> &folders)
+  {
+    SJournalFolder folder;
+    folder.strPath = path;
+    m_watcher.Watch(path);
+    folder.modified = GetModificationTime(path);
+
+    CFileItemList listing;
+    CDirectory::GetDirectory(path, listing, g_settings.m_videoExtensions);
+    m_dirsVisited++;
+    m_filesHashed += listing.Size();
+
+    size_t index = folders.size();
+    folders.push_back(folder);
+    for (int i = 0; i < listing.Size(); ++i)
+    {
+      CFileItemPtr pItem = listing[i];
+      if (!pItem->m_bIsFolder)
       {
-        CStdString hash;
-        hash.Format("fast%"PRId64, time);
-        return hash;
+        items.Add(pItem);
+        folders[index].files++;
       }
+      else if (URIUtils::IsInPath(pItem->GetPath(), path))
+      {
+        folders[index].subPaths.push_back(pItem->GetPath());
+        GetSeriesListing(pItem->GetPath(), items, folders);
+      }
+      else // archives are listed along with the folder they're in
+        CUtil::GetRecursiveListing(pItem->GetPath(), items, g_settings.m_videoExtensions, true);
     }
-    return "";
+  }
+
+  void CVideoInfoScanner::SetSeriesPathHash(const CStdString &path, const CStdString &hash)
+  {
+    m_database.SetPathHash(path, hash);
+
+    map<CStdString, vector<SJournalFolder> >::iterator it = m_seriesFolders.find(path);
+    if (it == m_seriesFolders.end())
+      return;
+    if (!hash.IsEmpty())
+    {
+      for (vector<SJournalFolder>::const_iterator folder = it->second.begin(); folder != it->second.end(); ++folder)
+        m_database.SetPathJournal(folder->strPath, folder->modified, folder->files, folder->subPaths);
+    }
+    m_seriesFolders.erase(it);
+  }
+
+  bool CVideoInfoScanner::IsUnchanged(const CStdString &path, int64_t modified)
+  {
+    // the watcher only sees changes made through this machine, so it can only tell
+    // about a change early - the modified time has the final say
+    bool changed = m_watcher.HasChanged(path);
+
+    // watch before the stat, so that nothing changes unnoticed in between
+    m_watcher.Watch(path);
+    return !changed && modified && GetModificationTime(path) == modified;
+  }
+
+  bool CVideoInfoScanner::IsTreeUnchanged(const CStdString &path, int &files, unsigned int &folders)
+  {
+    int64_t modified;
+    vector<CStdString> subPaths;
+    if (!m_database.GetPathJournal(path, modified, files, subPaths) || !IsUnchanged(path, modified))
+      return false;
+    folders++;
+
+    for (vector<CStdString>::const_iterator subPath = subPaths.begin(); subPath != subPaths.end(); ++subPath)
+    {
+      int subFiles;
+      if (!IsTreeUnchanged(*subPath, subFiles, folders))
+        return false;
+    }
+    return true;
   }
 
   void CVideoInfoScanner::GetSeasonThumbs(const CVideoInfoTag &show, map<int, string> &art, bool useLocal)
@@ -1630,8 +1792,52 @@ namespace VIDEO
     }
   }
 
+  void CVideoInfoScanner::PrefetchLocalFiles(const CFileItem &item) const
+  {
+    // only remote shares pay a round trip per check, and stacks and archives are
+    // looked up outside of the item's folder
+    if (!item.IsRemote() || item.IsInternetStream() || item.IsStack() ||
+        URIUtils::IsInRAR(item.GetPath()) || URIUtils::IsInZIP(item.GetPath()))
+      return;
+
+    CStdString strPath;
+    vector<CStdString> names;
+    if (item.m_bIsFolder)
+    {
+      strPath = item.GetPath();
+      names.push_back("tvshow.nfo");
+      names.push_back("movie.nfo");
+      CStdStringArray thumbs;
+      StringUtils::SplitString(g_advancedSettings.m_dvdThumbs, "|", thumbs);
+      names.insert(names.end(), thumbs.begin(), thumbs.end());
+    }
+    else
+    {
+      URIUtils::GetDirectory(item.GetPath(), strPath);
+      CStdString strFile = URIUtils::GetFileName(item.GetPath());
+      names.push_back(URIUtils::ReplaceExtension(strFile, ".nfo"));
+      names.push_back(URIUtils::ReplaceExtension(strFile, ".tbn"));
+      names.push_back(URIUtils::ReplaceExtension(strFile, "-fanart.jpg"));
+      names.push_back("movie.nfo");
+      names.push_back("movie.tbn");
+    }
+
+    CStdStringArray fanarts;
+    StringUtils::SplitString(g_advancedSettings.m_fanartImages, "|", fanarts);
+    names.insert(names.end(), fanarts.begin(), fanarts.end());
+
+    vector<CStdString> files;
+    for (unsigned int i = 0; i < names.size(); i++)
+      files.push_back(URIUtils::AddFileToFolder(strPath, names[i]));
+
+    vector<SFileStat> results;
+    CDirectory::StatFiles(strPath, files, results);
+  }
+
   CNfoFile::NFOResult CVideoInfoScanner::CheckForNFOFile(CFileItem* pItem, bool bGrabAny, ScraperPtr& info, CScraperUrl& scrUrl)
   {
+    PrefetchLocalFiles(*pItem);
+
     CStdString strNfoFile;
     if (info->Content() == CONTENT_MOVIES || info->Content() == CONTENT_MUSICVIDEOS
         || (info->Content() == CONTENT_TVSHOWS && !pItem->m_bIsFolder))
@@ -23,8 +23,10 @@
 #include "addons/Scraper.h"
 #include "NfoFile.h"
 #include "XBDateTime.h"
+#include "filesystem/DirectoryWatcher.h"
 
 class CRegExp;
+class TestVideoInfoScannerHelper;
 
 namespace VIDEO
 {
@@ -48,6 +50,15 @@ namespace VIDEO
     CDateTime cDate;
   } SEpisode;
 
+  /*! \brief A folder as recorded in the path journal, see CVideoDatabase::SetPathJournal */
+  typedef struct SJournalFolder
+  {
+    CStdString strPath;
+    int64_t modified;
+    int files;
+    std::vector<CStdString> subPaths;
+  } SJournalFolder;
+
   typedef std::vector<SEpisode> EPISODES;
 
   enum SCAN_STATE { PREPARING = 0, REMOVING_OLD, CLEANING_UP_DATABASE, FETCHING_MOVIE_INFO, FETCHING_MUSICVIDEO_INFO, FETCHING_TVSHOW_INFO, COMPRESSING_DATABASE, WRITING_CHANGES };
@@ -76,6 +87,8 @@ namespace VIDEO
 
   class CVideoInfoScanner : CThread
   {
+    friend class ::TestVideoInfoScannerHelper;
+
   public:
     CVideoInfoScanner();
     virtual ~CVideoInfoScanner();
@@ -194,14 +207,19 @@ namespace VIDEO
 
     static int GetPathHash(const CFileItemList &items, CStdString &hash);
 
-    /*! \brief Retrieve a "fast" hash of the given directory (if available)
-     Performs a stat() on the directory, and uses modified time to create a "fast"
-     hash of the folder. If no modified time is available, the create time is used,
-     and if neither are available, an empty hash is returned.
-     \param directory folder to hash
-     \return the hash of the folder of the form "fast<datetime>"
+    /*! \brief Retrieve the modified time of the given directory (if available)
+     Performs a stat() on the directory. If no modified time is available, the create time
+     is used, and if neither are available, 0 is returned.
+     \param directory folder to stat
+     \return the modified time of the folder
      */
-    CStdString GetFastHash(const CStdString &directory) const;
+    static int64_t GetModificationTime(const CStdString &directory);
+
+    /*! \brief Retrieve a "fast" hash of a directory from its modified time
+     \param time modified time of the folder, as returned by GetModificationTime
+     \return the hash of the folder of the form "fast<datetime>", empty if the time is unknown
+     */
+    static CStdString GetFastHash(int64_t time);
 
     /*! \brief Decide whether a folder listing could use the "fast" hash
      Fast hashing can be done whenever the folder contains no scannable subfolders, as the
@@ -227,11 +245,50 @@ namespace VIDEO
     INFO_RET OnProcessSeriesFolder(EPISODES& files, const ADDON::ScraperPtr &scraper, bool useLocal, int idShow, const CStdString& strShowTitle, CGUIDialogProgress* pDlgProgress = NULL);
 
     void EnumerateSeriesFolder(CFileItem* item, EPISODES& episodeList);
+
+    /*! \brief Recursively list a series folder, recording the folders on the way for the journal.
+     Folders are watched (where possible) and stat()ed before they are listed, so a change made while
+     listing shows up the next time.
+     \param path the folder to list
+     \param items [out] the files found in the folder and its subfolders
+     \param folders [out] the folders listed, the first one is path
+     */
+    void GetSeriesListing(const CStdString &path, CFileItemList &items, std::vector<SJournalFolder> &folders);
+
+    /*! \brief Store the hash of a series folder along with the journal of the folders it was computed from.
+     \param path the series folder
+     \param hash the hash of the folder
+     */
+    void SetSeriesPathHash(const CStdString &path, const CStdString &hash);
+
+    /*! \brief Check the journal for whether a folder is unchanged since it was last listed.
+     The folder is compared by modified time, and is watched from now on. A change the watcher
+     saw counts even if it didn't show in the modified time.
+     \param path the folder
+     \param modified modified time of the folder recorded in the journal
+     \return true if the folder doesn't need to be listed again, false otherwise
+     */
+    bool IsUnchanged(const CStdString &path, int64_t modified);
+
+    /*! \brief Check the journal for whether a folder and all of its subfolders are unchanged.
+     \param path the folder
+     \param files [out] number of files recorded for the folder
+     \param folders [in/out] incremented by the number of folders checked
+     \return true if none of the folders need to be listed again, false otherwise
+     */
+    bool IsTreeUnchanged(const CStdString &path, int &files, unsigned int &folders);
     bool EnumerateEpisodeItem(const CFileItemPtr item, EPISODES& episodeList);
     bool ProcessItemByVideoInfoTag(const CFileItemPtr item, EPISODES &episodeList);
 
     CStdString GetnfoFile(CFileItem *item, bool bGrabAny=false) const;
 
+    /*! \brief Check the local files of an item (nfo, tbn, fanart) in one batch.
+     On remote shares this lists the item's folder once, so the checks that follow
+     are answered from the directory cache rather than one round trip each.
+     \param item a media item.
+     */
+    void PrefetchLocalFiles(const CFileItem &item) const;
+
     /*! \brief Retrieve the parent folder of an item, accounting for stacks and files in rars.
      \param item a media item.
      \return the folder that contains the item.
@@ -251,6 +308,12 @@ namespace VIDEO
     std::set<CStdString> m_pathsToCount;
     std::set<int> m_pathsToClean;
     CNfoFile m_nfoReader;
+
+    XFILE::CDirectoryWatcher m_watcher;
+    std::map<CStdString, std::vector<SJournalFolder> > m_seriesFolders; // folders listed for series whose hash isn't stored yet
+    unsigned int m_dirsVisited;
+    unsigned int m_dirsSkipped;
+    unsigned int m_filesHashed;
   };
 }
 
@@ -0,0 +1,108 @@
+/*
+ *      Copyright (C) 2005-2012 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "video/VideoInfoScanner.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+
+#include "gtest/gtest.h"
+
+class TestVideoInfoScannerHelper
+{
+public:
+  static bool IsUnchanged(VIDEO::CVideoInfoScanner &scanner, const CStdString &path, int64_t modified)
+  {
+    return scanner.IsUnchanged(path, modified);
+  }
+
+  static int64_t GetModificationTime(const CStdString &path)
+  {
+    return VIDEO::CVideoInfoScanner::GetModificationTime(path);
+  }
+};
+
+class TestVideoInfoScanner : public testing::Test
+{
+protected:
+  TestVideoInfoScanner()
+  {
+    XFILE::CFile *file = XBMC_CREATETEMPFILE("");
+    m_folder = XBMC_TEMPFILEPATH(file) + ".dir/";
+    XBMC_DELETETEMPFILE(file);
+    XFILE::CDirectory::Create(m_folder);
+  }
+
+  ~TestVideoInfoScanner()
+  {
+    XFILE::CFile::Delete(m_folder + "movie.avi");
+    XFILE::CDirectory::Remove(m_folder);
+  }
+
+  CStdString m_folder;
+};
+
+TEST_F(TestVideoInfoScanner, Unchanged)
+{
+  VIDEO::CVideoInfoScanner scanner;
+  int64_t modified = TestVideoInfoScannerHelper::GetModificationTime(m_folder);
+  ASSERT_NE(0, modified);
+
+  EXPECT_TRUE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+  // the folder may be watched by now, that mustn't make a difference
+  EXPECT_TRUE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+
+  // nothing recorded
+  EXPECT_FALSE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, 0));
+}
+
+TEST_F(TestVideoInfoScanner, Changed)
+{
+  VIDEO::CVideoInfoScanner scanner;
+  int64_t modified = TestVideoInfoScannerHelper::GetModificationTime(m_folder);
+  ASSERT_NE(0, modified);
+  EXPECT_TRUE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+
+  // a change the watcher can't see, like one made by another machine on a network mount
+  EXPECT_FALSE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified - 1));
+
+  // a change within the same second only shows through the watcher, if there is one
+  XFILE::CFile file;
+  ASSERT_TRUE(file.OpenForWrite(m_folder + "movie.avi", true));
+  file.Close();
+  modified = TestVideoInfoScannerHelper::GetModificationTime(m_folder);
+  if (XFILE::CDirectoryWatcher::IsSupported(m_folder))
+    EXPECT_FALSE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+
+  // after which the folder is unchanged again
+  EXPECT_TRUE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+}
+
+TEST_F(TestVideoInfoScanner, Missing)
+{
+  VIDEO::CVideoInfoScanner scanner;
+  int64_t modified = TestVideoInfoScannerHelper::GetModificationTime(m_folder);
+  ASSERT_NE(0, modified);
+  EXPECT_TRUE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+
+  XFILE::CDirectory::Remove(m_folder);
+  EXPECT_FALSE(TestVideoInfoScannerHelper::IsUnchanged(scanner, m_folder, modified));
+}
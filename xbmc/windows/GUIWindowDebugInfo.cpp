@@ -32,6 +32,7 @@
 #include "guilib/GUIWindowManager.h"
 #include "guilib/GUIControlProfiler.h"
 #include "GUIInfoManager.h"
+#include "filesystem/DirectoryCache.h"
 #include "utils/Variant.h"
 
 #include <climits>
@@ -111,6 +112,11 @@ void CGUIWindowDebugInfo::Process(unsigned int currentTime, CDirtyRegionList &di
     info.Format("LOG: %sxbmc.log\nMEM: %"PRIu64"/%"PRIu64" KB - FPS: %2.1f fps\nCPU: %s (CPU-XBMC %4.2f%%%s)", g_settings.m_logFolder.c_str(),
                 stat.ullAvailPhys/1024, stat.ullTotalPhys/1024, g_infoManager.GetFPS(), strCores.c_str(), dCPU, profiling.c_str());
 #endif
+    XFILE::SDirectoryCacheStats dirStats;
+    g_directoryCache.GetStats(dirStats);
+    info.AppendFormat("\nDIR: %u folders, %"PRIu64"/%"PRIu64" KB - hits: %.1f%% (%"PRIu64"/%"PRIu64")",
+                      dirStats.dirs, dirStats.bytes / 1024, dirStats.maxBytes / 1024, dirStats.HitRate() * 100.0,
+                      dirStats.hits, dirStats.hits + dirStats.misses);
   }
 
   // render the skin debug info